@@ -0,0 +1,1094 @@
+/**
+ * @file analyze_matrix.c
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Structure analysis and storage format selection for matvec.
+ *
+ * Scans A in parallel, a block of rows per thread, for:
+ *   - density, and the row-length distribution (min, max, mean,
+ *     coefficient of variation, empty rows)
+ *   - band profile: lower and upper bandwidth, and the profile (sum over
+ *     rows of the distance from the first entry to the diagonal)
+ *   - block fill: the share of stored entries in the nonzero b x b
+ *     blocks (default 4 x 4)
+ *   - symmetry of the pattern and of the values (square A: each row
+ *     merged with the same column, from a threaded transpose)
+ *   - Toeplitz structure (each row the one above shifted right)
+ *   - locality of x: entries whose column is farther from the diagonal
+ *     than half the last-level cache holds of x
+ *   - index compressibility: the gaps between the columns of each row
+ *     too wide for a byte of DCSR code (sparse.h)
+ *   - distinct values, with zero if A has unstored entries (at most 257
+ *     are counted; a stored zero may be counted twice)
+ *   - entries that are not 1 or -1, and the -1s (bit matrices)
+ *
+ * The statistics feed a cost model that predicts the time of y = A * x
+ * in each storage format the matvec programs accept:
+ *   dense     dense_entry * m * n
+ *   csr       csr_entry * nnz + csr_far * far + csr_row * m, with far
+ *             the entries that miss x in cache (0 if x fits in half of
+ *             it)
+ *   toeplitz  fft_point * 3 N log2 N (three FFTs of size N >= m + n - 1),
+ *             only for Toeplitz A (pth_toeplitz)
+ *   dcsr      dcsr_entry * nnz + dcsr_escape * escapes + csr_far * far +
+ *             dcsr_row * m, with escapes the gaps between columns too
+ *             wide for one byte; only for rows with sorted columns
+ *   codebook  cb4_entry * m * n with at most 16 values, cb8_entry * m * n
+ *             with at most 256 (codebook.h, one table for all of A)
+ *   bitmat    bin_entry * m * n for entries in {0, 1}, ter_entry * m * n
+ *             for {-1, 0, 1} (bitmat.h), with x not binary
+ * Coefficients are in thread-seconds: predictions divide them by the
+ * thread count. They are calibrated for this host with -c, which times
+ * the threaded kernels on synthetic matrices (dense; banded CSR and
+ * DCSR with short and long rows; CSR with random columns and an x
+ * larger than the cache; DCSR with escaped gaps; the dense matrix as
+ * 4- and 8-bit codebooks and as binary and ternary bit matrices) and
+ * saves them as
+ * "name value" lines. fft_point is not timed:
+ * it is taken as 4 dense entries, a complex butterfly per point.
+ * Without -c or -m, built-in defaults are used.
+ *
+ * The analysis and the predictions are printed to stdout, with the
+ * format of least predicted time; -o writes A in that format. A may be
+ * in any of the formats above, or CSC or COO, so a file written with
+ * -o can be analyzed again.
+ *
+ * Timing data is output to stderr in CSV format:
+ *   M,N,P,Nnz,Format,Predicted,Time_Analyze,Time_Convert
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "quinn.h"
+#include "timer.h"
+#include "mat_format.h"
+#include "sparse.h"
+#include "semiring.h"
+#include "codebook.h"
+#include "bitmat.h"
+
+/* Candidate formats, in the order they are reported */
+#define CAND_DENSE    0
+#define CAND_CSR      1
+#define CAND_TOEPLITZ 2
+#define CAND_DCSR     3
+#define CAND_CODEBOOK 4
+#define CAND_BITMAT   5
+#define CAND_COUNT    6
+
+/* Runs of each kernel during calibration; the fastest is kept */
+#define CALIBRATE_REPS 5
+
+/* Cost model coefficients, in thread-seconds */
+typedef struct {
+    double dense_entry;    /* per entry of a dense A */
+    double csr_entry;      /* per CSR entry whose x is in cache */
+    double csr_far;        /* extra per CSR entry whose x is not */
+    double csr_row;        /* per CSR row */
+    double dcsr_entry;     /* per DCSR entry whose x is in cache */
+    double dcsr_escape;    /* extra per escaped DCSR gap */
+    double dcsr_row;       /* per DCSR row */
+    double cb4_entry;      /* per entry of a 4-bit codebook A */
+    double cb8_entry;      /* per entry of an 8-bit codebook A */
+    double bin_entry;      /* per entry of a binary bit matrix A */
+    double ter_entry;      /* per entry of a ternary bit matrix A */
+    double fft_point;      /* per point of each FFT stage */
+} Model;
+
+/* One thread's share of the analysis */
+typedef struct {
+    long nnz;
+    long min_row, max_row;     /* shortest and longest row */
+    double sum_sq;             /* sum of squared row lengths */
+    long empty_rows;
+    long lower, upper;         /* max i - j and max j - i over entries */
+    long profile;
+    long blocks;               /* nonzero block_size x block_size blocks */
+    long far;                  /* entries outside the x window */
+    long asym_pattern;         /* entries with no transposed entry */
+    long asym_value;           /* ... or one with another value */
+    long not_toeplitz;         /* rows that are not the row above shifted */
+    long unsorted_rows;        /* rows whose columns decrease */
+    long escapes;              /* gaps too wide for a DCSR byte */
+    long not_unit;             /* entries that are not 1 or -1 */
+    long negative;             /* entries that are -1 */
+    long values;               /* distinct values (totals only) */
+} Stats;
+
+const char* cand_names[CAND_COUNT] = {"dense", "csr", "toeplitz", "dcsr", "codebook",
+                                     "bitmat"};
+
+/* Global variables */
+int thread_count;
+Csr A;
+Csc T;                         /* A by columns, to compare with its rows */
+int block_size = 4;
+long window;                   /* half-width of the x window, in entries */
+Stats* stats;                  /* one per thread */
+Csr* bench_csr;                /* operands of Pth_bench */
+Dcsr* bench_dcsr;
+Codebook* bench_book;
+Bitmat* bench_bits;
+double* bench_dense;
+int bench_rows, bench_cols;
+double *bench_x, *bench_y;
+
+/* Function prototypes */
+void Usage(char* prog_name);
+int Read_matrix(char* filename, double** A_p, int* m_p, int* n_p);
+int Write_matrix(char* filename, double* A, int rows, int cols);
+int Read_toeplitz(char* filename, double** A_p, int* m_p, int* n_p);
+int Write_toeplitz(char* filename, Csr* S);
+long Cache_bytes(void);
+void Model_defaults(Model* model);
+int Model_read(char* filename, Model* model);
+int Model_write(char* filename, Model* model);
+void Calibrate(Model* model);
+void Make_synthetic(Csr* S, int rows, int cols, int per_row, int stride);
+double Time_sparse(Csr* S, int coded);
+double Time_codebook(int values);
+double Time_bitmat(int ternary);
+double Time_kernel(void);
+int Shifted_row(int i);
+void Analyze(Stats* total);
+double Predict(int cand, Model* model, Stats* s);
+int Convert(int cand, char* filename);
+void* Pth_analyze(void* rank);
+void* Pth_bench(void* rank);
+
+int main(int argc, char* argv[]) {
+    int opt, format, rows, cols, cand, best, status;
+    char *model_in = NULL, *model_out = NULL, *file_out = NULL;
+    double* dense = NULL;
+    double start_analyze, end_analyze, start_convert = 0.0, end_convert = 0.0;
+    double predicted[CAND_COUNT], mean, cv;
+    Model model;
+    Stats s;
+    Csc csc;
+    Dcsr dcsr;
+    Codebook book;
+    Bitmat bits;
+
+    /* Parse options */
+    while ((opt = getopt(argc, argv, "c:m:o:b:")) != -1) {
+        switch (opt) {
+            case 'c': model_out = optarg; break;
+            case 'm': model_in = optarg; break;
+            case 'o': file_out = optarg; break;
+            case 'b': block_size = atoi(optarg); break;
+            default:
+                Usage(argv[0]);
+                exit(1);
+        }
+    }
+
+    /* Check command line arguments: with -c, A may be left out */
+    if ((argc - optind != 2 && !(model_out != NULL && argc - optind == 1)) ||
+        block_size <= 0 || (model_in != NULL && model_out != NULL)) {
+        Usage(argv[0]);
+        exit(1);
+    }
+
+    /* Get number of threads */
+    thread_count = atoi(argv[argc - 1]);
+    if (thread_count <= 0) {
+        fprintf(stderr, "Error: Number of threads must be positive\n");
+        exit(1);
+    }
+
+    /* Cost model: calibrated here, read, or the defaults */
+    Model_defaults(&model);
+    if (model_out != NULL) {
+        Calibrate(&model);
+        if (Model_write(model_out, &model) != 0) {
+            fprintf(stderr, "Error: Failed to write cost model to %s\n", model_out);
+            exit(1);
+        }
+        printf("%s: dense_entry %.3e, csr_entry %.3e, csr_far %.3e, csr_row %.3e,\n",
+               model_out, model.dense_entry, model.csr_entry, model.csr_far, model.csr_row);
+        printf("  dcsr_entry %.3e, dcsr_escape %.3e, dcsr_row %.3e,\n",
+               model.dcsr_entry, model.dcsr_escape, model.dcsr_row);
+        printf("  cb4_entry %.3e, cb8_entry %.3e, bin_entry %.3e, ter_entry %.3e s\n",
+               model.cb4_entry, model.cb8_entry, model.bin_entry, model.ter_entry);
+        if (argc - optind == 1) return 0;
+    } else if (model_in != NULL && Model_read(model_in, &model) != 0) {
+        fprintf(stderr, "Error: Failed to read cost model from %s\n", model_in);
+        exit(1);
+    }
+
+    /* Read A as CSR, with duplicates of a COO file summed */
+    format = Sparse_format(argv[optind]);
+    if (format == MAT_FORMAT_DENSE) {
+        status = Read_matrix(argv[optind], &dense, &rows, &cols);
+        if (status == 0) status = Csr_from_dense(dense, rows, cols, thread_count, &A);
+        free(dense);
+    } else if (format == MAT_FORMAT_CSR) {
+        status = Csr_read(argv[optind], &A);
+    } else if (format == MAT_FORMAT_CSC) {
+        status = Csc_read(argv[optind], &csc);
+        if (status == 0) {
+            status = Csr_from_csc(&csc, thread_count, &A);
+            Csc_free(&csc);
+        }
+    } else if (format == MAT_FORMAT_COO) {
+        status = Csr_from_coo(argv[optind], COO_SUM_DUPLICATES, COO_DEFAULT_CHUNK_BYTES,
+                              thread_count, &A);
+    } else if (format == MAT_FORMAT_DCSR) {
+        status = Dcsr_read(argv[optind], &dcsr);
+        if (status == 0) {
+            status = Dcsr_to_csr(&dcsr, &A);
+            Dcsr_free(&dcsr);
+        }
+    } else if (format == MAT_FORMAT_TOEPLITZ) {
+        status = Read_toeplitz(argv[optind], &dense, &rows, &cols);
+        if (status == 0) status = Csr_from_dense(dense, rows, cols, thread_count, &A);
+        free(dense);
+    } else if (format == MAT_FORMAT_BITMAT) {
+        status = Bitmat_read(argv[optind], &bits);
+        if (status == 0) {
+            dense = Bitmat_to_dense(&bits);
+            status = dense != NULL ? Csr_from_dense(dense, bits.rows, bits.cols, thread_count, &A)
+                                   : -1;
+            free(dense);
+            Bitmat_free(&bits);
+        }
+    } else if (format == MAT_FORMAT_CODEBOOK) {
+        status = Codebook_read(argv[optind], &book);
+        if (status == 0) {
+            dense = Codebook_to_dense(&book);
+            status = dense != NULL ? Csr_from_dense(dense, book.rows, book.cols, thread_count, &A)
+                                   : -1;
+            free(dense);
+            Codebook_free(&book);
+        }
+    } else {
+        status = -1;
+    }
+    if (status != 0) {
+        fprintf(stderr, "Error: Failed to read matrix A from %s\n", argv[optind]);
+        exit(1);
+    }
+
+    /* Scan A */
+    window = Cache_bytes() / sizeof(double) / 2;
+    GET_TIME(start_analyze);
+    Analyze(&s);
+    GET_TIME(end_analyze);
+
+    /* Predict, and pick the fastest format */
+    for (cand = 0; cand < CAND_COUNT; cand++) predicted[cand] = Predict(cand, &model, &s);
+    best = CAND_CSR;
+    for (cand = 0; cand < CAND_COUNT; cand++) {
+        if (predicted[cand] >= 0.0 && predicted[cand] < predicted[best]) best = cand;
+    }
+
+    /* Report */
+    mean = A.rows > 0 ? (double)s.nnz / A.rows : 0.0;
+    cv = mean > 0.0 ? sqrt(MAX(s.sum_sq / A.rows - mean * mean, 0.0)) / mean : 0.0;
+    printf("%s: %d x %d, %ld stored entries (density %.3g%%)\n", argv[optind], A.rows, A.cols,
+           s.nnz, 100.0 * s.nnz / ((double)A.rows * A.cols));
+    printf("  row lengths:  min %ld, max %ld, mean %.2f, cv %.2f, empty %ld\n",
+           s.min_row, s.max_row, mean, cv, s.empty_rows);
+    printf("  band:         lower %ld, upper %ld, profile %ld\n", s.lower, s.upper, s.profile);
+    printf("  blocks %dx%d:   %ld nonzero, fill %.3f\n", block_size, block_size, s.blocks,
+           s.blocks > 0 ? (double)s.nnz / ((double)s.blocks * block_size * block_size) : 0.0);
+    if (A.rows == A.cols) {
+        printf("  symmetry:     pattern %s, values %s\n", s.asym_pattern == 0 ? "yes" : "no",
+               s.asym_value == 0 ? "yes" : "no");
+    } else {
+        printf("  symmetry:     not square\n");
+    }
+    printf("  toeplitz:     %s\n", s.not_toeplitz == 0 ? "yes" : "no");
+    printf("  dcsr gaps:    %.1f%% escaped%s\n",
+           s.nnz > A.rows ? 100.0 * s.escapes / (s.nnz - A.rows + s.empty_rows) : 0.0,
+           s.unsorted_rows > 0 ? " (rows unsorted)" : "");
+    if (s.values > CODEBOOK_MAX_VALUES) printf("  values:       more than %d\n", CODEBOOK_MAX_VALUES);
+    else printf("  values:       %ld distinct\n", s.values);
+    printf("  bits:         %s\n", s.not_unit > 0 ? "no" : s.negative > 0 ? "ternary" : "binary");
+    printf("  x locality:   %.1f%% of entries outside a %ld-entry window%s\n",
+           s.nnz > 0 ? 100.0 * s.far / s.nnz : 0.0, 2 * window,
+           (long)A.cols <= window ? " (x fits in cache)" : "");
+    printf("  predicted:   ");
+    for (cand = 0; cand < CAND_COUNT; cand++) {
+        if (predicted[cand] >= 0.0) printf(" %s %.3e s", cand_names[cand], predicted[cand]);
+        else printf(" %s -", cand_names[cand]);
+    }
+    printf("\n  recommended:  %s\n", cand_names[best]);
+
+    /* Convert */
+    if (file_out != NULL) {
+        GET_TIME(start_convert);
+        if (Convert(best, file_out) != 0) {
+            fprintf(stderr, "Error: Failed to write %s\n", file_out);
+            exit(1);
+        }
+        GET_TIME(end_convert);
+    }
+
+    /* Print timing results to stderr */
+    fprintf(stderr, "%d,%d,%d,%ld,%s,%e,%e,%e\n", A.rows, A.cols, thread_count, s.nnz,
+            cand_names[best], predicted[best], end_analyze - start_analyze,
+            end_convert - start_convert);
+
+    /* Clean up */
+    Csr_free(&A);
+    free(stats);
+
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Usage
+ * Purpose:   Print usage message
+*/
+void Usage(char* prog_name) {
+    fprintf(stderr, "Usage: %s [options] <file_A> <num_threads>\n", prog_name);
+    fprintf(stderr, "       %s -c <model> <num_threads>\n", prog_name);
+    fprintf(stderr, "  Analyzes the structure of A and recommends a storage format\n");
+    fprintf(stderr, "  -c model  calibrate the cost model on this host and save it\n");
+    fprintf(stderr, "  -m model  use a saved cost model\n");
+    fprintf(stderr, "  -o file   write A in the recommended format\n");
+    fprintf(stderr, "  -b size   block size for the block fill ratio (default 4)\n");
+    fprintf(stderr, "  Example: %s -m host.model -o A.best A.mat 4\n", prog_name);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Read_matrix
+ * Purpose:   Read a binary matrix file
+*/
+int Read_matrix(char* filename, double** A_p, int* m_p, int* n_p) {
+    FILE* fp;
+    int rows, cols;
+    double* A;
+
+    fp = fopen(filename, "rb");
+    if (fp == NULL) return -1;
+
+    if (fread(&rows, sizeof(int), 1, fp) != 1 ||
+        fread(&cols, sizeof(int), 1, fp) != 1) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (rows <= 0 || cols <= 0) {
+        fclose(fp);
+        return -1;
+    }
+
+    A = (double*)malloc((size_t)rows * cols * sizeof(double));
+    if (A == NULL) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (fread(A, sizeof(double), (size_t)rows * cols, fp) != (size_t)rows * cols) {
+        free(A);
+        fclose(fp);
+        return -1;
+    }
+
+    fclose(fp);
+    *A_p = A;
+    *m_p = rows;
+    *n_p = cols;
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Write_matrix
+ * Purpose:   Write a binary matrix file
+*/
+int Write_matrix(char* filename, double* A, int rows, int cols) {
+    FILE* fp;
+
+    fp = fopen(filename, "wb");
+    if (fp == NULL) return -1;
+
+    if (fwrite(&rows, sizeof(int), 1, fp) != 1 ||
+        fwrite(&cols, sizeof(int), 1, fp) != 1) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (fwrite(A, sizeof(double), (size_t)rows * cols, fp) != (size_t)rows * cols) {
+        fclose(fp);
+        return -1;
+    }
+
+    fclose(fp);
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Read_toeplitz
+ * Purpose:   Read a Toeplitz file, expanded to a dense matrix
+ * Return:    0 on success, -1 on error
+*/
+int Read_toeplitz(char* filename, double** A_p, int* m_p, int* n_p) {
+    FILE* fp;
+    Toeplitz_header header;
+    double *col, *row, *M = NULL;
+    int i, j, status = -1;
+
+    fp = fopen(filename, "rb");
+    if (fp == NULL) return -1;
+    if (fread(&header, sizeof(header), 1, fp) != 1 ||
+        header.magic != MAT_FORMAT_TOEPLITZ || header.rows <= 0 || header.cols <= 0 ||
+        (header.kind != MAT_TOEPLITZ && header.kind != MAT_CIRCULANT) ||
+        (header.kind == MAT_CIRCULANT && header.rows != header.cols)) {
+        fclose(fp);
+        return -1;
+    }
+
+    col = (double*)malloc(header.rows * sizeof(double));
+    row = (double*)malloc(header.cols * sizeof(double));
+    if (col != NULL && row != NULL &&
+        fread(col, sizeof(double), header.rows, fp) == (size_t)header.rows &&
+        (header.kind == MAT_CIRCULANT ||
+         fread(row, sizeof(double), header.cols, fp) == (size_t)header.cols)) {
+        M = (double*)malloc((size_t)header.rows * header.cols * sizeof(double));
+    }
+    if (M != NULL) {
+        for (i = 0; i < header.rows; i++) {
+            for (j = 0; j < header.cols; j++) {
+                if (header.kind == MAT_CIRCULANT) {
+                    M[(size_t)i * header.cols + j] = col[(i - j + header.rows) % header.rows];
+                } else {
+                    M[(size_t)i * header.cols + j] = i >= j ? col[i - j] : row[j - i];
+                }
+            }
+        }
+        *A_p = M;
+        *m_p = header.rows;
+        *n_p = header.cols;
+        status = 0;
+    }
+
+    fclose(fp);
+    free(col);
+    free(row);
+    return status;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Write_toeplitz
+ * Purpose:   Write a Toeplitz S in the Toeplitz format, as circulant
+ *            when each row is the previous one rotated right
+*/
+int Write_toeplitz(char* filename, Csr* S) {
+    FILE* fp;
+    Toeplitz_header header;
+    double *col, *row;
+    int i, j, status;
+    long k;
+
+    col = (double*)calloc(S->rows, sizeof(double));
+    row = (double*)calloc(S->cols, sizeof(double));
+    if (col == NULL || row == NULL) {
+        free(col);
+        free(row);
+        return -1;
+    }
+    for (i = 0; i < S->rows; i++) {
+        k = S->row_ptr[i];
+        if (k < S->row_ptr[i + 1] && S->col_idx[k] == 0) col[i] = S->val[k];
+    }
+    for (k = S->row_ptr[0]; k < S->row_ptr[1]; k++) row[S->col_idx[k]] = S->val[k];
+
+    header.magic = MAT_FORMAT_TOEPLITZ;
+    header.rows = S->rows;
+    header.cols = S->cols;
+    header.kind = S->rows == S->cols ? MAT_CIRCULANT : MAT_TOEPLITZ;
+    for (j = 1; j < S->cols && header.kind == MAT_CIRCULANT; j++) {
+        if (row[j] != col[S->cols - j]) header.kind = MAT_TOEPLITZ;
+    }
+
+    status = -1;
+    fp = fopen(filename, "wb");
+    if (fp != NULL) {
+        if (fwrite(&header, sizeof(header), 1, fp) == 1 &&
+            fwrite(col, sizeof(double), S->rows, fp) == (size_t)S->rows &&
+            (header.kind == MAT_CIRCULANT ||
+             fwrite(row, sizeof(double), S->cols, fp) == (size_t)S->cols)) {
+            status = 0;
+        }
+        if (fclose(fp) != 0) status = -1;
+    }
+    free(col);
+    free(row);
+    return status;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Cache_bytes
+ * Purpose:   Size of the last-level cache, 8 MB if unknown
+*/
+long Cache_bytes(void) {
+    long bytes = -1;
+
+#ifdef _SC_LEVEL3_CACHE_SIZE
+    bytes = sysconf(_SC_LEVEL3_CACHE_SIZE);
+#endif
+#ifdef _SC_LEVEL2_CACHE_SIZE
+    if (bytes <= 0) bytes = sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+    return bytes > 0 ? bytes : 8L << 20;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Model_defaults
+ * Purpose:   Coefficients of a typical host, for an uncalibrated model
+*/
+void Model_defaults(Model* model) {
+    model->dense_entry = 6.0e-10;
+    model->csr_entry = 1.2e-9;
+    model->csr_far = 6.0e-9;
+    model->csr_row = 2.0e-9;
+    model->dcsr_entry = 1.2e-9;
+    model->dcsr_escape = 1.5e-9;
+    model->dcsr_row = 3.0e-9;
+    model->cb4_entry = 2.0e-10;
+    model->cb8_entry = 4.0e-10;
+    model->bin_entry = 2.5e-10;
+    model->ter_entry = 3.0e-10;
+    model->fft_point = 4 * model->dense_entry;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Model_read
+ * Purpose:   Read "name value" lines of a saved model; unknown names
+ *            are skipped, missing ones keep their defaults
+*/
+int Model_read(char* filename, Model* model) {
+    FILE* fp;
+    char name[64];
+    double value;
+
+    fp = fopen(filename, "r");
+    if (fp == NULL) return -1;
+    while (fscanf(fp, "%63s %lf", name, &value) == 2) {
+        if (strcmp(name, "dense_entry") == 0) model->dense_entry = value;
+        else if (strcmp(name, "csr_entry") == 0) model->csr_entry = value;
+        else if (strcmp(name, "csr_far") == 0) model->csr_far = value;
+        else if (strcmp(name, "csr_row") == 0) model->csr_row = value;
+        else if (strcmp(name, "dcsr_entry") == 0) model->dcsr_entry = value;
+        else if (strcmp(name, "dcsr_escape") == 0) model->dcsr_escape = value;
+        else if (strcmp(name, "dcsr_row") == 0) model->dcsr_row = value;
+        else if (strcmp(name, "cb4_entry") == 0) model->cb4_entry = value;
+        else if (strcmp(name, "cb8_entry") == 0) model->cb8_entry = value;
+        else if (strcmp(name, "bin_entry") == 0) model->bin_entry = value;
+        else if (strcmp(name, "ter_entry") == 0) model->ter_entry = value;
+        else if (strcmp(name, "fft_point") == 0) model->fft_point = value;
+    }
+    if (!feof(fp)) {
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Model_write
+ * Purpose:   Save a model as "name value" lines
+*/
+int Model_write(char* filename, Model* model) {
+    FILE* fp;
+
+    fp = fopen(filename, "w");
+    if (fp == NULL) return -1;
+    fprintf(fp, "dense_entry %e\n", model->dense_entry);
+    fprintf(fp, "csr_entry %e\n", model->csr_entry);
+    fprintf(fp, "csr_far %e\n", model->csr_far);
+    fprintf(fp, "csr_row %e\n", model->csr_row);
+    fprintf(fp, "dcsr_entry %e\n", model->dcsr_entry);
+    fprintf(fp, "dcsr_escape %e\n", model->dcsr_escape);
+    fprintf(fp, "dcsr_row %e\n", model->dcsr_row);
+    fprintf(fp, "cb4_entry %e\n", model->cb4_entry);
+    fprintf(fp, "cb8_entry %e\n", model->cb8_entry);
+    fprintf(fp, "bin_entry %e\n", model->bin_entry);
+    fprintf(fp, "ter_entry %e\n", model->ter_entry);
+    fprintf(fp, "fft_point %e\n", model->fft_point);
+    return fclose(fp) == 0 ? 0 : -1;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Calibrate
+ * Purpose:   Fit the model to the threaded kernels on this host: a
+ *            dense matrix; two banded matrices with the same entries in
+ *            short and long rows, as CSR and DCSR (per entry and per
+ *            row); a CSR matrix with random columns over an x four
+ *            times the cache, up to 256 MB (the extra cost of a miss);
+ *            a DCSR matrix whose gaps all need an escape; and the dense
+ *            matrix coded with 16 and 256 values and as bit matrices
+*/
+void Calibrate(Model* model) {
+    Csr S;
+    int rows_short = 1 << 18, rows_long = 1 << 14, rows_far = 1 << 17;
+    int cols_far = (int)MIN(MAX(Cache_bytes() / 2, 1L << 22), 1L << 25);
+    double t_short[2], t_long[2], t_far, t_escape;
+    long nnz;
+    int i;
+
+    /* Dense */
+    bench_rows = 2048;
+    bench_cols = 4096;
+    bench_dense = (double*)malloc((size_t)bench_rows * bench_cols * sizeof(double));
+    bench_x = (double*)malloc(cols_far * sizeof(double));
+    bench_y = (double*)malloc(rows_short * sizeof(double));
+    if (bench_dense == NULL || bench_x == NULL || bench_y == NULL) {
+        fprintf(stderr, "Error: Cannot allocate memory for calibration\n");
+        exit(1);
+    }
+    for (i = 0; i < cols_far; i++) bench_x[i] = 1.0 + (double)(i % 7);
+    for (nnz = 0; nnz < (long)bench_rows * bench_cols; nnz++) bench_dense[nnz] = 1.0;
+    model->dense_entry = Time_kernel() * thread_count / ((double)bench_rows * bench_cols);
+    model->cb4_entry = Time_codebook(16) / ((double)bench_rows * bench_cols);
+    model->cb8_entry = Time_codebook(256) / ((double)bench_rows * bench_cols);
+    model->bin_entry = Time_bitmat(0) / ((double)bench_rows * bench_cols);
+    model->ter_entry = Time_bitmat(1) / ((double)bench_rows * bench_cols);
+    free(bench_dense);
+    bench_dense = NULL;
+
+    /* Banded: t = entry * nnz + row * rows, for CSR and DCSR */
+    Make_synthetic(&S, rows_short, rows_short, 16, 1);
+    t_short[0] = Time_sparse(&S, 0);
+    t_short[1] = Time_sparse(&S, 1);
+    nnz = S.nnz;
+    Csr_free(&S);
+    Make_synthetic(&S, rows_long, rows_long, 256, 1);
+    t_long[0] = Time_sparse(&S, 0);
+    t_long[1] = Time_sparse(&S, 1);
+    Csr_free(&S);
+    model->csr_row = MAX((t_short[0] - t_long[0]) / (rows_short - rows_long), 0.0);
+    model->csr_entry = MAX((t_long[0] - model->csr_row * rows_long) / nnz, 0.0);
+    model->dcsr_row = MAX((t_short[1] - t_long[1]) / (rows_short - rows_long), 0.0);
+    model->dcsr_entry = MAX((t_long[1] - model->dcsr_row * rows_long) / nnz, 0.0);
+
+    /* Random columns over a large x */
+    Make_synthetic(&S, rows_far, cols_far, 32, 0);
+    t_far = Time_sparse(&S, 0);
+    model->csr_far = MAX((t_far - model->csr_entry * S.nnz - model->csr_row * rows_far) / S.nnz,
+                         0.0);
+    Csr_free(&S);
+
+    /* Gaps of 300 columns: every gap but the first of a row escapes */
+    Make_synthetic(&S, rows_short, rows_short, 16, 300);
+    t_escape = Time_sparse(&S, 1);
+    model->dcsr_escape = MAX((t_escape - model->dcsr_entry * S.nnz - model->dcsr_row * rows_short) /
+                             (S.nnz - rows_short), 0.0);
+    Csr_free(&S);
+
+    model->fft_point = 4 * model->dense_entry;
+    free(bench_x);
+    free(bench_y);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Make_synthetic
+ * Purpose:   A rows x cols CSR matrix of ones with per_row entries in
+ *            each row: stride columns apart around the diagonal, or at
+ *            random columns for stride 0
+*/
+void Make_synthetic(Csr* S, int rows, int cols, int per_row, int stride) {
+    unsigned seed = 1;
+    long start, k;
+    int i;
+
+    if (Csr_alloc(S, rows, cols, (long)rows * per_row) != 0) {
+        fprintf(stderr, "Error: Cannot allocate memory for calibration\n");
+        exit(1);
+    }
+    for (i = 0; i <= rows; i++) S->row_ptr[i] = (long)i * per_row;
+    for (i = 0; i < rows; i++) {
+        start = (long)i * cols / rows - (long)per_row * stride / 2;
+        start = MIN(MAX(start, 0), cols - 1 - (long)(per_row - 1) * stride);
+        for (k = 0; k < per_row; k++) {
+            S->col_idx[(long)i * per_row + k] =
+                stride == 0 ? (int)(rand_r(&seed) % cols) : (int)(start + k * stride);
+            S->val[(long)i * per_row + k] = 1.0;
+        }
+    }
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Time_sparse
+ * Purpose:   Thread-seconds of a product with S as CSR, or as DCSR
+*/
+double Time_sparse(Csr* S, int coded) {
+    Dcsr D;
+    double t;
+
+    if (!coded) {
+        bench_csr = S;
+        t = Time_kernel();
+        bench_csr = NULL;
+    } else {
+        if (Dcsr_from_csr(S, thread_count, &D) != 0) {
+            fprintf(stderr, "Error: Cannot allocate memory for calibration\n");
+            exit(1);
+        }
+        bench_dcsr = &D;
+        t = Time_kernel();
+        bench_dcsr = NULL;
+        Dcsr_free(&D);
+    }
+    return t * thread_count;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Time_codebook
+ * Purpose:   Thread-seconds of a product with the dense calibration
+ *            matrix refilled with the given number of values and coded
+*/
+double Time_codebook(int values) {
+    Codebook book;
+    long k;
+    double t;
+
+    for (k = 0; k < (long)bench_rows * bench_cols; k++) bench_dense[k] = (double)(k * 7 % values);
+    if (Codebook_from_dense(bench_dense, bench_rows, bench_cols, bench_rows, thread_count,
+                            &book) != 0) {
+        fprintf(stderr, "Error: Cannot allocate memory for calibration\n");
+        exit(1);
+    }
+    bench_book = &book;
+    t = Time_kernel();
+    bench_book = NULL;
+    Codebook_free(&book);
+    return t * thread_count;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Time_bitmat
+ * Purpose:   Thread-seconds of a product with the dense calibration
+ *            matrix refilled with 0s and 1s (and -1s) and packed
+*/
+double Time_bitmat(int ternary) {
+    Bitmat bits;
+    long k;
+    double t;
+
+    for (k = 0; k < (long)bench_rows * bench_cols; k++) {
+        bench_dense[k] = ternary ? (double)(k * 7 % 3) - 1.0 : (double)(k * 7 % 3 != 0);
+    }
+    if (Bitmat_from_dense(bench_dense, bench_rows, bench_cols, thread_count, &bits) != 0) {
+        fprintf(stderr, "Error: Cannot allocate memory for calibration\n");
+        exit(1);
+    }
+    bench_bits = &bits;
+    t = Time_kernel();
+    bench_bits = NULL;
+    Bitmat_free(&bits);
+    return t * thread_count;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Time_kernel
+ * Purpose:   Fastest of CALIBRATE_REPS threaded runs of Pth_bench
+*/
+double Time_kernel(void) {
+    pthread_t* thread_handles;
+    long thread;
+    int r;
+    double start, end, best = -1.0;
+
+    thread_handles = (pthread_t*)malloc(thread_count * sizeof(pthread_t));
+    if (thread_handles == NULL) {
+        fprintf(stderr, "Error: Cannot allocate memory for thread handles\n");
+        exit(1);
+    }
+    for (r = 0; r < CALIBRATE_REPS; r++) {
+        GET_TIME(start);
+        for (thread = 0; thread < thread_count; thread++) {
+            pthread_create(&thread_handles[thread], NULL, Pth_bench, (void*)thread);
+        }
+        for (thread = 0; thread < thread_count; thread++) {
+            pthread_join(thread_handles[thread], NULL);
+        }
+        GET_TIME(end);
+        if (best < 0.0 || end - start < best) best = end - start;
+    }
+    free(thread_handles);
+    return best;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Shifted_row
+ * Purpose:   Whether row i of A is row i - 1 shifted right by one
+ *            (column 0 starts a new diagonal, the last column of row
+ *            i - 1 falls off)
+*/
+int Shifted_row(int i) {
+    long p = A.row_ptr[i - 1], p_end = A.row_ptr[i];
+    long q = A.row_ptr[i], q_end = A.row_ptr[i + 1];
+
+    if (q < q_end && A.col_idx[q] == 0) q++;
+    for (; p < p_end && A.col_idx[p] < A.cols - 1; p++, q++) {
+        if (q >= q_end || A.col_idx[q] != A.col_idx[p] + 1 || A.val[q] != A.val[p]) return 0;
+    }
+    return q == q_end;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Analyze
+ * Purpose:   Scan A with the threads and combine their statistics
+*/
+void Analyze(Stats* total) {
+    pthread_t* thread_handles;
+    long thread;
+    Stats* s;
+
+    memset(&T, 0, sizeof(T));
+    stats = (Stats*)calloc(thread_count, sizeof(Stats));
+    thread_handles = (pthread_t*)malloc(thread_count * sizeof(pthread_t));
+    if (stats == NULL || thread_handles == NULL ||
+        (A.rows == A.cols && Csc_from_csr(&A, thread_count, &T) != 0)) {
+        fprintf(stderr, "Error: Cannot allocate memory for the analysis\n");
+        exit(1);
+    }
+    for (thread = 0; thread < thread_count; thread++) {
+        pthread_create(&thread_handles[thread], NULL, Pth_analyze, (void*)thread);
+    }
+    for (thread = 0; thread < thread_count; thread++) {
+        pthread_join(thread_handles[thread], NULL);
+    }
+    free(thread_handles);
+    Csc_free(&T);
+
+    memset(total, 0, sizeof(*total));
+    total->min_row = A.cols;
+    for (thread = 0; thread < thread_count; thread++) {
+        s = &stats[thread];
+        if (s->min_row < 0) {
+            fprintf(stderr, "Error: Cannot allocate memory for the analysis\n");
+            exit(1);
+        }
+        total->nnz += s->nnz;
+        total->min_row = MIN(total->min_row, s->min_row);
+        total->max_row = MAX(total->max_row, s->max_row);
+        total->sum_sq += s->sum_sq;
+        total->empty_rows += s->empty_rows;
+        total->lower = MAX(total->lower, s->lower);
+        total->upper = MAX(total->upper, s->upper);
+        total->profile += s->profile;
+        total->blocks += s->blocks;
+        total->far += s->far;
+        total->asym_pattern += s->asym_pattern;
+        total->asym_value += s->asym_value;
+        total->not_toeplitz += s->not_toeplitz;
+        total->unsorted_rows += s->unsorted_rows;
+        total->escapes += s->escapes;
+        total->not_unit += s->not_unit;
+        total->negative += s->negative;
+    }
+
+    /* The stored values as an nnz x 1 matrix, one table for all */
+    total->values = CODEBOOK_MAX_VALUES + 1;
+    if (A.nnz > 0 && A.nnz <= 0x7fffffff) {
+        total->values = Codebook_distinct(A.val, (int)A.nnz, 1, (int)A.nnz, thread_count);
+        if (total->values < 0) {
+            fprintf(stderr, "Error: Cannot allocate memory for the analysis\n");
+            exit(1);
+        }
+    } else if (A.nnz == 0) {
+        total->values = 0;
+    }
+    if (A.nnz < (long)A.rows * A.cols) total->values++;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Predict
+ * Purpose:   Predicted time of y = A * x in a candidate format, -1 if
+ *            the format cannot hold A
+*/
+double Predict(int cand, Model* model, Stats* s) {
+    long far = (long)A.cols <= window ? 0 : s->far;
+    double size;
+
+    switch (cand) {
+        case CAND_DENSE:
+            return model->dense_entry * A.rows * (double)A.cols / thread_count;
+        case CAND_CSR:
+            return (model->csr_entry * s->nnz + model->csr_far * far +
+                    model->csr_row * A.rows) / thread_count;
+        case CAND_DCSR:
+            if (s->unsorted_rows != 0) return -1.0;
+            return (model->dcsr_entry * s->nnz + model->dcsr_escape * s->escapes +
+                    model->csr_far * far + model->dcsr_row * A.rows) / thread_count;
+        case CAND_CODEBOOK:
+            if (s->values > CODEBOOK_MAX_VALUES) return -1.0;
+            return (s->values <= 16 ? model->cb4_entry : model->cb8_entry) * A.rows *
+                   (double)A.cols / thread_count;
+        case CAND_BITMAT:
+            if (s->not_unit != 0) return -1.0;
+            return (s->negative > 0 ? model->ter_entry : model->bin_entry) * A.rows *
+                   (double)A.cols / thread_count;
+        case CAND_TOEPLITZ:
+            if (s->not_toeplitz != 0) return -1.0;
+            for (size = 1.0; size < (double)A.rows + A.cols - 1; size *= 2) { }
+            return model->fft_point * 3 * size * log2(MAX(size, 2.0)) / thread_count;
+    }
+    return -1.0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Convert
+ * Purpose:   Write A in a candidate format
+*/
+int Convert(int cand, char* filename) {
+    double* dense;
+    Dcsr D;
+    Codebook book;
+    Bitmat bits;
+    int status;
+
+    switch (cand) {
+        case CAND_DENSE:
+            dense = Csr_to_dense(&A);
+            if (dense == NULL) return -1;
+            status = Write_matrix(filename, dense, A.rows, A.cols);
+            free(dense);
+            return status;
+        case CAND_CSR:
+            return Csr_write(filename, &A);
+        case CAND_TOEPLITZ:
+            return Write_toeplitz(filename, &A);
+        case CAND_DCSR:
+            if (Dcsr_from_csr(&A, thread_count, &D) != 0) return -1;
+            status = Dcsr_write(filename, &D);
+            Dcsr_free(&D);
+            return status;
+        case CAND_CODEBOOK:
+            dense = Csr_to_dense(&A);
+            if (dense == NULL) return -1;
+            status = Codebook_from_dense(dense, A.rows, A.cols, A.rows, thread_count, &book);
+            free(dense);
+            if (status != 0) return -1;
+            status = Codebook_write(filename, &book);
+            Codebook_free(&book);
+            return status;
+        case CAND_BITMAT:
+            dense = Csr_to_dense(&A);
+            if (dense == NULL) return -1;
+            status = Bitmat_from_dense(dense, A.rows, A.cols, thread_count, &bits);
+            free(dense);
+            if (status != 0) return -1;
+            status = Bitmat_write(filename, &bits);
+            Bitmat_free(&bits);
+            return status;
+    }
+    return -1;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Pth_analyze
+ * Purpose:   Thread function: statistics of a block of block rows,
+ *            with a stamp per block column to count nonzero blocks.
+ *            Sets min_row to -1 on allocation failure.
+*/
+void* Pth_analyze(void* rank) {
+    long my_rank = (long)rank;
+    Stats* s = &stats[my_rank];
+    int block_rows = (A.rows + block_size - 1) / block_size;
+    int first_block = BLOCK_LOW(my_rank, thread_count, block_rows);
+    int last_block = BLOCK_HIGH(my_rank, thread_count, block_rows);
+    int i, j, b, center, unsorted;
+    long k, length, q;
+    int* mark;
+
+    s->min_row = A.cols;
+    mark = (int*)malloc(((A.cols + block_size - 1) / block_size) * sizeof(int));
+    if (mark == NULL) {
+        s->min_row = -1;
+        return NULL;
+    }
+    memset(mark, 0xff, ((A.cols + block_size - 1) / block_size) * sizeof(int));
+
+    for (b = first_block; b <= last_block; b++) {
+        for (i = b * block_size; i < MIN((b + 1) * block_size, A.rows); i++) {
+            length = A.row_ptr[i + 1] - A.row_ptr[i];
+            s->nnz += length;
+            s->min_row = MIN(s->min_row, length);
+            s->max_row = MAX(s->max_row, length);
+            s->sum_sq += (double)length * length;
+            if (length == 0) s->empty_rows++;
+            else if (A.col_idx[A.row_ptr[i]] < i) s->profile += i - A.col_idx[A.row_ptr[i]];
+            if (i > 0 && !Shifted_row(i)) s->not_toeplitz++;
+
+            center = (int)((long)i * A.cols / A.rows);
+            unsorted = 0;
+            for (k = A.row_ptr[i]; k < A.row_ptr[i + 1]; k++) {
+                j = A.col_idx[k];
+                s->lower = MAX(s->lower, i - j);
+                s->upper = MAX(s->upper, j - i);
+                if (labs((long)j - center) > window) s->far++;
+                if (A.val[k] == -1.0) s->negative++;
+                else if (A.val[k] != 1.0) s->not_unit++;
+                if (k > A.row_ptr[i]) {
+                    if (j < A.col_idx[k - 1]) unsorted++;
+                    else if (j - A.col_idx[k - 1] >= DCSR_ESCAPE16) s->escapes++;
+                }
+                if (mark[j / block_size] != b) {
+                    mark[j / block_size] = b;
+                    s->blocks++;
+                }
+            }
+            if (unsorted) s->unsorted_rows++;
+
+            /* Row i against column i: entry (i, j) against (j, i) */
+            if (A.rows != A.cols) continue;
+            q = T.col_ptr[i];
+            for (k = A.row_ptr[i]; k < A.row_ptr[i + 1]; k++) {
+                while (q < T.col_ptr[i + 1] && T.row_idx[q] < A.col_idx[k]) q++;
+                if (q == T.col_ptr[i + 1] || T.row_idx[q] != A.col_idx[k]) {
+                    s->asym_pattern++;
+                    s->asym_value++;
+                } else if (T.val[q] != A.val[k]) {
+                    s->asym_value++;
+                }
+            }
+        }
+    }
+
+    free(mark);
+    return NULL;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Pth_bench
+ * Purpose:   Thread function: this thread's rows of the calibration
+ *            product
+*/
+void* Pth_bench(void* rank) {
+    long my_rank = (long)rank;
+    int rows = bench_csr != NULL ? bench_csr->rows :
+               bench_dcsr != NULL ? bench_dcsr->rows :
+               bench_book != NULL ? bench_book->rows :
+               bench_bits != NULL ? bench_bits->rows : bench_rows;
+    int first_row = BLOCK_LOW(my_rank, thread_count, rows);
+    int last_row = BLOCK_HIGH(my_rank, thread_count, rows);
+
+    if (bench_csr != NULL) {
+        Semiring_csr_rows(SR_PLUS_TIMES, bench_csr, bench_x, bench_y, first_row, last_row);
+    } else if (bench_dcsr != NULL) {
+        Semiring_dcsr_rows(SR_PLUS_TIMES, bench_dcsr, bench_x, bench_y, first_row, last_row);
+    } else if (bench_book != NULL) {
+        Codebook_rows(bench_book, bench_x, bench_y, first_row, last_row);
+    } else if (bench_bits != NULL) {
+        Bitmat_rows(bench_bits, bench_x, bench_y, first_row, last_row);
+    } else {
+        Semiring_dense_rows(SR_PLUS_TIMES, bench_dense, bench_cols, bench_x, bench_y,
+                            first_row, last_row);
+    }
+    return NULL;
+}
@@ -0,0 +1,489 @@
+/**
+ * @file bitmat.c
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Bit-packed binary {0, 1} and ternary {-1, 0, 1} matrices.
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "quinn.h"
+#include "mat_format.h"
+#include "bitmat.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BITMAT_X86 1
+#endif
+
+/* Work shared with the packing threads */
+typedef struct {
+    const double* A;
+    Bitmat* B;
+    int thread_count;
+    long rank;
+    int negative;      /* found a -1 */
+    int other;         /* found a value that is not 0, 1 or -1 */
+} Pack_task;
+
+/* Sum of the x_j selected by a row's plus words, minus those selected
+   by its minus words (NULL for none) */
+typedef double (*Row_fn)(const uint64_t* plus, const uint64_t* minus, const double* x, int words);
+
+/* The same for a packed binary x */
+typedef double (*Bits_fn)(const uint64_t* plus, const uint64_t* minus, const uint64_t* x,
+                          int words);
+
+typedef struct {
+    const char* name;
+    Row_fn row;
+    Bits_fn bits;
+} Bitmat_kernel;
+
+/* Function prototypes */
+void* Pth_pack(void* arg);
+const Bitmat_kernel* Select_bitmat_kernel(void);
+double Row_c(const uint64_t* plus, const uint64_t* minus, const double* x, int words);
+double Bits_c(const uint64_t* plus, const uint64_t* minus, const uint64_t* x, int words);
+#ifdef BITMAT_X86
+double Row_avx2(const uint64_t* plus, const uint64_t* minus, const double* x, int words);
+double Row_avx512(const uint64_t* plus, const uint64_t* minus, const double* x, int words);
+double Bits_popcnt(const uint64_t* plus, const uint64_t* minus, const uint64_t* x, int words);
+#endif
+
+static const Bitmat_kernel kernel_c = {"c", Row_c, Bits_c};
+#ifdef BITMAT_X86
+static const Bitmat_kernel kernel_avx2 = {"avx2", Row_avx2, Bits_popcnt};
+static const Bitmat_kernel kernel_avx512 = {"avx512", Row_avx512, Bits_popcnt};
+#endif
+
+/*-------------------------------------------------------------------
+ * Function:  Bitmat_from_dense
+ * Purpose:   Pack both planes in parallel, then drop the minus plane
+ *            if no -1 was found
+*/
+int Bitmat_from_dense(const double* A, int rows, int cols, int thread_count, Bitmat* B) {
+    pthread_t* thread_handles;
+    Pack_task* tasks;
+    long thread;
+    int negative = 0, other = 0;
+
+    memset(B, 0, sizeof(*B));
+    if (rows <= 0 || cols <= 0 || thread_count <= 0) return -1;
+    B->rows = rows;
+    B->cols = cols;
+    B->kind = BITMAT_TERNARY;
+    B->words = CEILING(cols, 64);
+    B->plus = (uint64_t*)malloc((size_t)rows * B->words * sizeof(uint64_t));
+    B->minus = (uint64_t*)malloc((size_t)rows * B->words * sizeof(uint64_t));
+
+    thread_count = MIN(thread_count, rows);
+    thread_handles = (pthread_t*)malloc(thread_count * sizeof(pthread_t));
+    tasks = (Pack_task*)malloc(thread_count * sizeof(Pack_task));
+    if (B->plus == NULL || B->minus == NULL || thread_handles == NULL || tasks == NULL) {
+        free(thread_handles);
+        free(tasks);
+        Bitmat_free(B);
+        return -1;
+    }
+
+    for (thread = 0; thread < thread_count; thread++) {
+        tasks[thread].A = A;
+        tasks[thread].B = B;
+        tasks[thread].thread_count = thread_count;
+        tasks[thread].rank = thread;
+        tasks[thread].negative = 0;
+        tasks[thread].other = 0;
+        pthread_create(&thread_handles[thread], NULL, Pth_pack, &tasks[thread]);
+    }
+    for (thread = 0; thread < thread_count; thread++) {
+        pthread_join(thread_handles[thread], NULL);
+        negative |= tasks[thread].negative;
+        other |= tasks[thread].other;
+    }
+    free(thread_handles);
+    free(tasks);
+
+    if (other) {
+        Bitmat_free(B);
+        return 1;
+    }
+    if (!negative) {
+        free(B->minus);
+        B->minus = NULL;
+        B->kind = BITMAT_BINARY;
+    }
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Bitmat_to_dense
+ * Purpose:   Expand the bits to doubles
+*/
+double* Bitmat_to_dense(const Bitmat* B) {
+    double* A = (double*)malloc((size_t)B->rows * B->cols * sizeof(double));
+    const uint64_t *plus, *minus;
+    int i, j;
+
+    if (A == NULL) return NULL;
+    for (i = 0; i < B->rows; i++) {
+        plus = B->plus + (size_t)i * B->words;
+        minus = B->minus != NULL ? B->minus + (size_t)i * B->words : NULL;
+        for (j = 0; j < B->cols; j++) {
+            A[(size_t)i * B->cols + j] = (plus[j >> 6] >> (j & 63)) & 1 ? 1.0 :
+                                         minus != NULL && (minus[j >> 6] >> (j & 63)) & 1 ? -1.0
+                                                                                          : 0.0;
+        }
+    }
+    return A;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Bitmat_read
+ * Purpose:   Read a bit matrix file; bits past the last column and
+ *            entries set in both planes are rejected
+*/
+int Bitmat_read(char* filename, Bitmat* B) {
+    FILE* fp;
+    Bitmat_header header;
+    size_t count, k;
+    uint64_t pad;
+
+    memset(B, 0, sizeof(*B));
+    fp = fopen(filename, "rb");
+    if (fp == NULL) return -1;
+
+    if (fread(&header, sizeof(header), 1, fp) != 1 || header.magic != MAT_FORMAT_BITMAT ||
+        header.rows <= 0 || header.cols <= 0 ||
+        (header.kind != BITMAT_BINARY && header.kind != BITMAT_TERNARY)) {
+        fclose(fp);
+        return -1;
+    }
+    B->rows = header.rows;
+    B->cols = header.cols;
+    B->kind = header.kind;
+    B->words = CEILING(B->cols, 64);
+    count = (size_t)B->rows * B->words;
+    B->plus = (uint64_t*)malloc(count * sizeof(uint64_t));
+    if (B->kind == BITMAT_TERNARY) B->minus = (uint64_t*)malloc(count * sizeof(uint64_t));
+    if (B->plus == NULL || (B->kind == BITMAT_TERNARY && B->minus == NULL) ||
+        fread(B->plus, sizeof(uint64_t), count, fp) != count ||
+        (B->minus != NULL && fread(B->minus, sizeof(uint64_t), count, fp) != count)) {
+        Bitmat_free(B);
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+
+    pad = B->cols % 64 == 0 ? 0 : ~0ULL << (B->cols % 64);
+    for (k = 0; k < count; k++) {
+        if ((k % B->words == (size_t)B->words - 1 &&
+             ((B->plus[k] & pad) != 0 || (B->minus != NULL && (B->minus[k] & pad) != 0))) ||
+            (B->minus != NULL && (B->plus[k] & B->minus[k]) != 0)) {
+            Bitmat_free(B);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Bitmat_write
+ * Purpose:   Write a bit matrix file
+*/
+int Bitmat_write(char* filename, Bitmat* B) {
+    FILE* fp;
+    Bitmat_header header;
+    size_t count = (size_t)B->rows * B->words;
+
+    header.magic = MAT_FORMAT_BITMAT;
+    header.rows = B->rows;
+    header.cols = B->cols;
+    header.kind = B->kind;
+
+    fp = fopen(filename, "wb");
+    if (fp == NULL) return -1;
+    if (fwrite(&header, sizeof(header), 1, fp) != 1 ||
+        fwrite(B->plus, sizeof(uint64_t), count, fp) != count ||
+        (B->minus != NULL && fwrite(B->minus, sizeof(uint64_t), count, fp) != count)) {
+        fclose(fp);
+        return -1;
+    }
+    return fclose(fp) == 0 ? 0 : -1;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Bitmat_free
+ * Purpose:   Release a bit matrix
+*/
+void Bitmat_free(Bitmat* B) {
+    free(B->plus);
+    free(B->minus);
+    B->plus = NULL;
+    B->minus = NULL;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Bitmat_pack_vector
+ * Purpose:   Pack a binary x into words, as a row is packed
+*/
+uint64_t* Bitmat_pack_vector(const double* x, int n) {
+    uint64_t* bits = (uint64_t*)calloc(CEILING(n, 64), sizeof(uint64_t));
+    int j;
+
+    if (bits == NULL) return NULL;
+    for (j = 0; j < n; j++) {
+        if (x[j] == 1.0) {
+            bits[j >> 6] |= 1ULL << (j & 63);
+        } else if (x[j] != 0.0) {
+            free(bits);
+            return NULL;
+        }
+    }
+    return bits;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Bitmat_rows
+ * Purpose:   y_i = sum of x_j over the 1s of row i, less the sum over
+ *            its -1s, for rows first_row..last_row
+*/
+void Bitmat_rows(const Bitmat* A, const double* x, double* y, int first_row, int last_row) {
+    Row_fn row = Select_bitmat_kernel()->row;
+    size_t offset;
+    int i;
+
+    for (i = first_row; i <= last_row; i++) {
+        offset = (size_t)i * A->words;
+        y[i] = row(A->plus + offset, A->minus != NULL ? A->minus + offset : NULL, x, A->words);
+    }
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Bitmat_rows_bits
+ * Purpose:   Bitmat_rows for a packed binary x, by popcounts
+*/
+void Bitmat_rows_bits(const Bitmat* A, const uint64_t* x, double* y, int first_row,
+                      int last_row) {
+    Bits_fn bits = Select_bitmat_kernel()->bits;
+    size_t offset;
+    int i;
+
+    for (i = first_row; i <= last_row; i++) {
+        offset = (size_t)i * A->words;
+        y[i] = bits(A->plus + offset, A->minus != NULL ? A->minus + offset : NULL, x, A->words);
+    }
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Bitmat_kernel_name
+ * Purpose:   Name of the row kernel in use
+*/
+const char* Bitmat_kernel_name(void) {
+    return Select_bitmat_kernel()->name;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Select_bitmat_kernel
+ * Purpose:   Pick the widest row kernel the CPU supports
+*/
+const Bitmat_kernel* Select_bitmat_kernel(void) {
+#ifdef BITMAT_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("popcnt")) {
+        return &kernel_avx512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) return &kernel_avx2;
+#endif
+    return &kernel_c;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Pth_pack
+ * Purpose:   Thread function: pack this thread's rows into both planes
+*/
+void* Pth_pack(void* arg) {
+    Pack_task* t = (Pack_task*)arg;
+    Bitmat* B = t->B;
+    int first_row = BLOCK_LOW(t->rank, t->thread_count, B->rows);
+    int last_row = BLOCK_HIGH(t->rank, t->thread_count, B->rows);
+    uint64_t *plus, *minus;
+    const double* a;
+    int i, j;
+
+    for (i = first_row; i <= last_row; i++) {
+        a = t->A + (size_t)i * B->cols;
+        plus = B->plus + (size_t)i * B->words;
+        minus = B->minus + (size_t)i * B->words;
+        memset(plus, 0, B->words * sizeof(uint64_t));
+        memset(minus, 0, B->words * sizeof(uint64_t));
+        for (j = 0; j < B->cols; j++) {
+            if (a[j] == 1.0) {
+                plus[j >> 6] |= 1ULL << (j & 63);
+            } else if (a[j] == -1.0) {
+                minus[j >> 6] |= 1ULL << (j & 63);
+                t->negative = 1;
+            } else if (a[j] != 0.0) {
+                t->other = 1;
+                return NULL;
+            }
+        }
+    }
+    return NULL;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Row_c / Bits_c
+ * Purpose:   Portable kernels: walk the set bits, or popcount
+*/
+double Row_c(const uint64_t* plus, const uint64_t* minus, const double* x, int words) {
+    double sum = 0.0;
+    uint64_t bits;
+    int w;
+
+    for (w = 0; w < words; w++) {
+        for (bits = plus[w]; bits != 0; bits &= bits - 1) sum += x[w * 64 + __builtin_ctzll(bits)];
+        if (minus == NULL) continue;
+        for (bits = minus[w]; bits != 0; bits &= bits - 1) sum -= x[w * 64 + __builtin_ctzll(bits)];
+    }
+    return sum;
+}
+
+double Bits_c(const uint64_t* plus, const uint64_t* minus, const uint64_t* x, int words) {
+    long count = 0;
+    int w;
+
+    for (w = 0; w < words; w++) {
+        count += __builtin_popcountll(plus[w] & x[w]);
+        if (minus != NULL) count -= __builtin_popcountll(minus[w] & x[w]);
+    }
+    return (double)count;
+}
+
+#ifdef BITMAT_X86
+
+/*-------------------------------------------------------------------
+ * Function:  Row_avx2
+ * Purpose:   Each nibble of a word selects 4 lanes of x through a
+ *            table of lane masks, and flips the sign of those under a
+ *            -1; masked loads never touch x past the last column
+*/
+#define M_ 0LL
+#define S_ -1LL
+static const long long nibble_mask[16][4] __attribute__((aligned(32))) = {
+    {M_, M_, M_, M_}, {S_, M_, M_, M_}, {M_, S_, M_, M_}, {S_, S_, M_, M_},
+    {M_, M_, S_, M_}, {S_, M_, S_, M_}, {M_, S_, S_, M_}, {S_, S_, S_, M_},
+    {M_, M_, M_, S_}, {S_, M_, M_, S_}, {M_, S_, M_, S_}, {S_, S_, M_, S_},
+    {M_, M_, S_, S_}, {S_, M_, S_, S_}, {M_, S_, S_, S_}, {S_, S_, S_, S_}};
+#undef M_
+#undef S_
+
+#define AVX2_NIBBLE(acc, k) \
+    acc = _mm256_add_pd(acc, _mm256_maskload_pd(xw + (k), \
+              _mm256_load_si256((const __m256i*)nibble_mask[(p >> (k)) & 15])));
+#define AVX2_TERNARY_NIBBLE(acc, k) \
+    xv = _mm256_maskload_pd(xw + (k), \
+             _mm256_load_si256((const __m256i*)nibble_mask[((p | m) >> (k)) & 15])); \
+    sign = _mm256_and_pd(_mm256_load_pd((const double*)nibble_mask[(m >> (k)) & 15]), \
+                         negative_zero); \
+    acc = _mm256_add_pd(acc, _mm256_xor_pd(xv, sign));
+
+__attribute__((target("avx2")))
+double Row_avx2(const uint64_t* plus, const uint64_t* minus, const double* x, int words) {
+    const __m256d negative_zero = _mm256_set1_pd(-0.0);
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    __m256d acc2 = _mm256_setzero_pd(), acc3 = _mm256_setzero_pd(), xv, sign;
+    __m128d s;
+    uint64_t p, m;
+    const double* xw;
+    int w, k;
+
+    for (w = 0; w < words; w++) {
+        p = plus[w];
+        m = minus != NULL ? minus[w] : 0;
+        xw = x + (size_t)w * 64;
+        if (m == 0) {
+            if (p == 0) continue;
+            for (k = 0; k < 64; k += 16) {
+                AVX2_NIBBLE(acc0, k) AVX2_NIBBLE(acc1, k + 4)
+                AVX2_NIBBLE(acc2, k + 8) AVX2_NIBBLE(acc3, k + 12)
+            }
+        } else {
+            for (k = 0; k < 64; k += 16) {
+                AVX2_TERNARY_NIBBLE(acc0, k) AVX2_TERNARY_NIBBLE(acc1, k + 4)
+                AVX2_TERNARY_NIBBLE(acc2, k + 8) AVX2_TERNARY_NIBBLE(acc3, k + 12)
+            }
+        }
+    }
+    acc0 = _mm256_add_pd(_mm256_add_pd(acc0, acc1), _mm256_add_pd(acc2, acc3));
+    s = _mm_add_pd(_mm256_castpd256_pd128(acc0), _mm256_extractf128_pd(acc0, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Row_avx512
+ * Purpose:   Each byte of a word is the mask of 8 lanes of x: loaded
+ *            where either plane is set and negated where minus is, so
+ *            each lane costs one add; four accumulators hide its latency
+*/
+#define AVX512_BYTE(acc, k) \
+    p8 = (__mmask8)(p >> (k)); \
+    acc = _mm512_add_pd(acc, _mm512_maskz_loadu_pd(p8, xw + (k)));
+#define AVX512_TERNARY_BYTE(acc, k) \
+    p8 = (__mmask8)(p >> (k)); \
+    m8 = (__mmask8)(m >> (k)); \
+    xv = _mm512_maskz_loadu_pd(p8 | m8, xw + (k)); \
+    acc = _mm512_add_pd(acc, _mm512_mask_sub_pd(xv, m8, _mm512_setzero_pd(), xv));
+
+__attribute__((target("avx512f")))
+double Row_avx512(const uint64_t* plus, const uint64_t* minus, const double* x, int words) {
+    __m512d acc0 = _mm512_setzero_pd(), acc1 = _mm512_setzero_pd();
+    __m512d acc2 = _mm512_setzero_pd(), acc3 = _mm512_setzero_pd(), xv;
+    __mmask8 p8, m8;
+    uint64_t p, m;
+    const double* xw;
+    int w;
+
+    for (w = 0; w < words; w++) {
+        p = plus[w];
+        m = minus != NULL ? minus[w] : 0;
+        xw = x + (size_t)w * 64;
+        if (m == 0) {
+            if (p == 0) continue;
+            AVX512_BYTE(acc0, 0) AVX512_BYTE(acc1, 8) AVX512_BYTE(acc2, 16) AVX512_BYTE(acc3, 24)
+            AVX512_BYTE(acc0, 32) AVX512_BYTE(acc1, 40) AVX512_BYTE(acc2, 48) AVX512_BYTE(acc3, 56)
+        } else {
+            AVX512_TERNARY_BYTE(acc0, 0) AVX512_TERNARY_BYTE(acc1, 8)
+            AVX512_TERNARY_BYTE(acc2, 16) AVX512_TERNARY_BYTE(acc3, 24)
+            AVX512_TERNARY_BYTE(acc0, 32) AVX512_TERNARY_BYTE(acc1, 40)
+            AVX512_TERNARY_BYTE(acc2, 48) AVX512_TERNARY_BYTE(acc3, 56)
+        }
+    }
+    return _mm512_reduce_add_pd(_mm512_add_pd(_mm512_add_pd(acc0, acc1),
+                                              _mm512_add_pd(acc2, acc3)));
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Bits_popcnt
+ * Purpose:   Bits_c with the popcnt instruction
+*/
+__attribute__((target("popcnt")))
+double Bits_popcnt(const uint64_t* plus, const uint64_t* minus, const uint64_t* x, int words) {
+    long count = 0;
+    int w;
+
+    for (w = 0; w < words; w++) {
+        count += __builtin_popcountll(plus[w] & x[w]);
+        if (minus != NULL) count -= __builtin_popcountll(minus[w] & x[w]);
+    }
+    return (double)count;
+}
+
+#endif /* BITMAT_X86 */
@@ -0,0 +1,670 @@
+/**
+ * @file codebook.c
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Dense matrices stored as codes into tables of distinct values.
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "quinn.h"
+#include "mat_format.h"
+#include "codebook.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CODEBOOK_X86 1
+#endif
+
+/* Open-addressed set of up to CODEBOOK_MAX_VALUES values, keyed by
+   their bits; a value's code is the order it was added in */
+#define SET_SLOTS 512
+
+typedef struct {
+    uint64_t key[SET_SLOTS];
+    short code[SET_SLOTS];       /* -1: empty slot */
+    int count;
+    double value[CODEBOOK_MAX_VALUES];
+} Value_set;
+
+/* Work shared with the collecting and coding threads; each thread has
+ * a block of rows. Collecting, it keeps the values of each panel's
+ * slice of its rows in slice_value (at most CODEBOOK_MAX_VALUES + 1
+ * counted, CODEBOOK_MAX_VALUES kept).
+*/
+typedef struct {
+    const double* A;
+    int rows, cols, panel_rows;
+    Codebook* C;                 /* coding pass: tables filled in */
+    int thread_count;
+    long rank;
+    int first_panel, last_panel;
+    int* slice_count;
+    double* slice_value;
+    int failed;
+} Code_task;
+
+/* Dot product of one coded row with x */
+typedef double (*Row_fn)(const double* table, const unsigned char* code, const double* x,
+                         int cols);
+
+typedef struct {
+    const char* name;
+    Row_fn row4, row8;           /* 4- and 8-bit codes */
+} Codebook_kernel;
+
+/* Function prototypes */
+void Set_clear(Value_set* s);
+int Set_add(Value_set* s, double v);
+int Collect(const double* A, int rows, int cols, int panel_rows, int thread_count,
+            int* count, double* value);
+int Run_code(Code_task* tasks, int thread_count, void* (*fn)(void*));
+void* Pth_collect(void* arg);
+void* Pth_code(void* arg);
+const Codebook_kernel* Select_codebook_kernel(void);
+double Row4_c(const double* table, const unsigned char* code, const double* x, int cols);
+double Row8_c(const double* table, const unsigned char* code, const double* x, int cols);
+#ifdef CODEBOOK_X86
+double Row4_avx2(const double* table, const unsigned char* code, const double* x, int cols);
+double Row8_avx2(const double* table, const unsigned char* code, const double* x, int cols);
+double Row4_avx512(const double* table, const unsigned char* code, const double* x, int cols);
+double Row8_avx512(const double* table, const unsigned char* code, const double* x, int cols);
+#endif
+
+static const Codebook_kernel kernel_c = {"c", Row4_c, Row8_c};
+#ifdef CODEBOOK_X86
+static const Codebook_kernel kernel_avx2 = {"avx2", Row4_avx2, Row8_avx2};
+static const Codebook_kernel kernel_avx512 = {"avx512", Row4_avx512, Row8_avx512};
+#endif
+
+/*-------------------------------------------------------------------
+ * Function:  Codebook_from_dense
+ * Purpose:   Find each panel's values, then code the rows in parallel
+*/
+int Codebook_from_dense(const double* A, int rows, int cols, int panel_rows, int thread_count,
+                        Codebook* C) {
+    int min_panel = MAX(CEILING(4096, cols), 1);
+    int panels, max_count, p, bits;
+    int* count;
+    double* value;
+    Code_task* tasks;
+    long thread;
+
+    memset(C, 0, sizeof(*C));
+    if (rows <= 0 || cols <= 0 || thread_count <= 0) return -1;
+
+    /* Halve the panels until each has few enough values */
+    if (panel_rows <= 0) {
+        panel_rows = rows;
+        while ((max_count = Codebook_distinct(A, rows, cols, panel_rows, thread_count)) >
+               CODEBOOK_MAX_VALUES && panel_rows > min_panel) {
+            panel_rows = MAX(CEILING(panel_rows, 2), min_panel);
+        }
+        if (max_count < 0) return -1;
+    }
+    panel_rows = MIN(panel_rows, rows);
+
+    panels = CEILING(rows, panel_rows);
+    count = (int*)malloc(panels * sizeof(int));
+    value = (double*)malloc((size_t)panels * CODEBOOK_MAX_VALUES * sizeof(double));
+    if (count == NULL || value == NULL) {
+        free(count);
+        free(value);
+        return -1;
+    }
+    max_count = Collect(A, rows, cols, panel_rows, thread_count, count, value);
+    if (max_count < 0 || max_count > CODEBOOK_MAX_VALUES) {
+        free(count);
+        free(value);
+        return max_count < 0 ? -1 : 1;
+    }
+
+    bits = max_count <= 16 ? 4 : 8;
+    C->rows = rows;
+    C->cols = cols;
+    C->bits = bits;
+    C->panel_rows = panel_rows;
+    C->panels = panels;
+    C->row_bytes = bits == 8 ? cols : (cols + 1) / 2;
+    C->table = (double*)calloc((size_t)panels << bits, sizeof(double));
+    C->code = (unsigned char*)malloc(rows * C->row_bytes);
+    if (C->table == NULL || C->code == NULL) {
+        free(count);
+        free(value);
+        Codebook_free(C);
+        return -1;
+    }
+    for (p = 0; p < panels; p++) {
+        memcpy(C->table + ((size_t)p << bits), value + (size_t)p * CODEBOOK_MAX_VALUES,
+               count[p] * sizeof(double));
+    }
+    free(count);
+    free(value);
+
+    thread_count = MAX(MIN(thread_count, rows), 1);
+    tasks = (Code_task*)malloc(thread_count * sizeof(Code_task));
+    if (tasks == NULL) {
+        Codebook_free(C);
+        return -1;
+    }
+    for (thread = 0; thread < thread_count; thread++) {
+        memset(&tasks[thread], 0, sizeof(Code_task));
+        tasks[thread].A = A;
+        tasks[thread].rows = rows;
+        tasks[thread].cols = cols;
+        tasks[thread].panel_rows = panel_rows;
+        tasks[thread].C = C;
+        tasks[thread].thread_count = thread_count;
+        tasks[thread].rank = thread;
+    }
+    if (Run_code(tasks, thread_count, Pth_code) != 0) {
+        free(tasks);
+        Codebook_free(C);
+        return -1;
+    }
+    free(tasks);
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Codebook_distinct
+ * Purpose:   Most values in a panel, counting up to one past a table
+*/
+int Codebook_distinct(const double* A, int rows, int cols, int panel_rows, int thread_count) {
+    int panels = CEILING(rows, panel_rows);
+    int* count = (int*)malloc(panels * sizeof(int));
+    double* value = (double*)malloc((size_t)panels * CODEBOOK_MAX_VALUES * sizeof(double));
+    int max_count = -1;
+
+    if (count != NULL && value != NULL) {
+        max_count = Collect(A, rows, cols, panel_rows, thread_count, count, value);
+    }
+    free(count);
+    free(value);
+    return max_count;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Codebook_to_dense
+ * Purpose:   Look every code up in its panel's table
+*/
+double* Codebook_to_dense(const Codebook* C) {
+    double* A = (double*)malloc((size_t)C->rows * C->cols * sizeof(double));
+    const double* table;
+    const unsigned char* code;
+    int i, j;
+
+    if (A == NULL) return NULL;
+    for (i = 0; i < C->rows; i++) {
+        table = C->table + ((size_t)(i / C->panel_rows) << C->bits);
+        code = C->code + (size_t)i * C->row_bytes;
+        for (j = 0; j < C->cols; j++) {
+            A[(size_t)i * C->cols + j] = C->bits == 8 ? table[code[j]]
+                                                      : table[(code[j >> 1] >> ((j & 1) * 4)) & 15];
+        }
+    }
+    return A;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Codebook_read
+ * Purpose:   Read a codebook file; every code is a valid index into
+ *            its table, so only the header needs checking
+*/
+int Codebook_read(char* filename, Codebook* C) {
+    FILE* fp;
+    Codebook_header header;
+    size_t table_count, code_bytes;
+
+    memset(C, 0, sizeof(*C));
+    fp = fopen(filename, "rb");
+    if (fp == NULL) return -1;
+
+    if (fread(&header, sizeof(header), 1, fp) != 1 || header.magic != MAT_FORMAT_CODEBOOK ||
+        header.rows <= 0 || header.cols <= 0 || (header.bits != 4 && header.bits != 8) ||
+        header.panel_rows <= 0 || header.panel_rows > header.rows) {
+        fclose(fp);
+        return -1;
+    }
+    C->rows = header.rows;
+    C->cols = header.cols;
+    C->bits = header.bits;
+    C->panel_rows = header.panel_rows;
+    C->panels = CEILING(C->rows, C->panel_rows);
+    C->row_bytes = C->bits == 8 ? C->cols : (C->cols + 1) / 2;
+    table_count = (size_t)C->panels << C->bits;
+    code_bytes = (size_t)C->rows * C->row_bytes;
+    C->table = (double*)malloc(table_count * sizeof(double));
+    C->code = (unsigned char*)malloc(code_bytes);
+    if (C->table == NULL || C->code == NULL ||
+        fread(C->table, sizeof(double), table_count, fp) != table_count ||
+        fread(C->code, 1, code_bytes, fp) != code_bytes) {
+        Codebook_free(C);
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Codebook_write
+ * Purpose:   Write a codebook file
+*/
+int Codebook_write(char* filename, Codebook* C) {
+    FILE* fp;
+    Codebook_header header;
+    size_t table_count = (size_t)C->panels << C->bits;
+    size_t code_bytes = (size_t)C->rows * C->row_bytes;
+
+    memset(&header, 0, sizeof(header));
+    header.magic = MAT_FORMAT_CODEBOOK;
+    header.rows = C->rows;
+    header.cols = C->cols;
+    header.bits = C->bits;
+    header.panel_rows = C->panel_rows;
+
+    fp = fopen(filename, "wb");
+    if (fp == NULL) return -1;
+    if (fwrite(&header, sizeof(header), 1, fp) != 1 ||
+        fwrite(C->table, sizeof(double), table_count, fp) != table_count ||
+        fwrite(C->code, 1, code_bytes, fp) != code_bytes) {
+        fclose(fp);
+        return -1;
+    }
+    return fclose(fp) == 0 ? 0 : -1;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Codebook_free
+ * Purpose:   Release a codebook matrix
+*/
+void Codebook_free(Codebook* C) {
+    free(C->table);
+    free(C->code);
+    C->table = NULL;
+    C->code = NULL;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Codebook_rows
+ * Purpose:   y_i = sum_j table[code_ij] * x_j for rows first_row..last_row
+*/
+void Codebook_rows(const Codebook* A, const double* x, double* y, int first_row, int last_row) {
+    const Codebook_kernel* kern = Select_codebook_kernel();
+    Row_fn row = A->bits == 8 ? kern->row8 : kern->row4;
+    int i;
+
+    for (i = first_row; i <= last_row; i++) {
+        y[i] = row(A->table + ((size_t)(i / A->panel_rows) << A->bits),
+                   A->code + (size_t)i * A->row_bytes, x, A->cols);
+    }
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Codebook_kernel_name
+ * Purpose:   Name of the row kernel in use
+*/
+const char* Codebook_kernel_name(void) {
+    return Select_codebook_kernel()->name;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Select_codebook_kernel
+ * Purpose:   Pick the widest row kernel the CPU supports
+*/
+const Codebook_kernel* Select_codebook_kernel(void) {
+#ifdef CODEBOOK_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return &kernel_avx512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return &kernel_avx2;
+#endif
+    return &kernel_c;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Set_clear
+ * Purpose:   Empty a value set
+*/
+void Set_clear(Value_set* s) {
+    memset(s->code, -1, sizeof(s->code));
+    s->count = 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Set_add
+ * Purpose:   Code of v in the set, adding it if it is new
+ * Return:    the code, or -1 if v is new and the set is full
+*/
+int Set_add(Value_set* s, double v) {
+    uint64_t key;
+    unsigned slot;
+
+    memcpy(&key, &v, sizeof(key));
+    slot = (unsigned)((key * 0x9E3779B97F4A7C15ull) >> 55);
+    while (s->code[slot] >= 0) {
+        if (s->key[slot] == key) return s->code[slot];
+        slot = (slot + 1) & (SET_SLOTS - 1);
+    }
+    if (s->count == CODEBOOK_MAX_VALUES) return -1;
+    s->key[slot] = key;
+    s->code[slot] = (short)s->count;
+    s->value[s->count] = v;
+    return s->count++;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Collect
+ * Purpose:   Values of each panel: the threads collect the values of
+ *            their slices of the panels, which are then merged in
+ *            thread order
+ * Return:    most values in a panel (CODEBOOK_MAX_VALUES + 1 if a
+ *            panel has too many), -1 on allocation failure
+*/
+int Collect(const double* A, int rows, int cols, int panel_rows, int thread_count,
+            int* count, double* value) {
+    int panels = CEILING(rows, panel_rows);
+    Code_task* tasks;
+    Value_set* set;
+    long thread;
+    int p, k, max_count = 0, failed;
+    Code_task* t;
+
+    thread_count = MAX(MIN(thread_count, rows), 1);
+    tasks = (Code_task*)calloc(thread_count, sizeof(Code_task));
+    set = (Value_set*)malloc(sizeof(Value_set));
+    if (tasks == NULL || set == NULL) {
+        free(tasks);
+        free(set);
+        return -1;
+    }
+    for (thread = 0; thread < thread_count; thread++) {
+        t = &tasks[thread];
+        t->A = A;
+        t->rows = rows;
+        t->cols = cols;
+        t->panel_rows = panel_rows;
+        t->thread_count = thread_count;
+        t->rank = thread;
+    }
+    failed = Run_code(tasks, thread_count, Pth_collect);
+
+    for (p = 0; p < panels && !failed; p++) {
+        Set_clear(set);
+        count[p] = 0;
+        for (thread = 0; thread < thread_count && count[p] <= CODEBOOK_MAX_VALUES; thread++) {
+            t = &tasks[thread];
+            if (p < t->first_panel || p > t->last_panel) continue;
+            if (t->slice_count[p - t->first_panel] > CODEBOOK_MAX_VALUES) {
+                count[p] = CODEBOOK_MAX_VALUES + 1;
+                break;
+            }
+            for (k = 0; k < t->slice_count[p - t->first_panel]; k++) {
+                if (Set_add(set, t->slice_value[(size_t)(p - t->first_panel) *
+                                                CODEBOOK_MAX_VALUES + k]) < 0) {
+                    count[p] = CODEBOOK_MAX_VALUES + 1;
+                    break;
+                }
+            }
+            if (count[p] <= CODEBOOK_MAX_VALUES) count[p] = set->count;
+        }
+        memcpy(value + (size_t)p * CODEBOOK_MAX_VALUES, set->value,
+               MIN(count[p], CODEBOOK_MAX_VALUES) * sizeof(double));
+        max_count = MAX(max_count, count[p]);
+    }
+
+    for (thread = 0; thread < thread_count; thread++) {
+        free(tasks[thread].slice_count);
+        free(tasks[thread].slice_value);
+    }
+    free(tasks);
+    free(set);
+    return failed ? -1 : max_count;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Run_code
+ * Purpose:   Run fn on a team of threads, one task each
+ * Return:    0 on success, -1 if a thread failed
+*/
+int Run_code(Code_task* tasks, int thread_count, void* (*fn)(void*)) {
+    pthread_t* thread_handles;
+    long thread;
+    int failed = 0;
+
+    thread_handles = (pthread_t*)malloc(thread_count * sizeof(pthread_t));
+    if (thread_handles == NULL) return -1;
+    for (thread = 0; thread < thread_count; thread++) {
+        pthread_create(&thread_handles[thread], NULL, fn, &tasks[thread]);
+    }
+    for (thread = 0; thread < thread_count; thread++) {
+        pthread_join(thread_handles[thread], NULL);
+        if (tasks[thread].failed) failed = 1;
+    }
+    free(thread_handles);
+    return failed ? -1 : 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Pth_collect
+ * Purpose:   Thread function: collect the values of each panel's slice
+ *            of this thread's rows, stopping a slice at one value past
+ *            a full table
+*/
+void* Pth_collect(void* arg) {
+    Code_task* t = (Code_task*)arg;
+    int first_row = BLOCK_LOW(t->rank, t->thread_count, t->rows);
+    int last_row = BLOCK_HIGH(t->rank, t->thread_count, t->rows);
+    int slices, p, s, lo, hi;
+    size_t k, end;
+    Value_set* set;
+
+    t->first_panel = first_row / t->panel_rows;
+    t->last_panel = last_row / t->panel_rows;
+    slices = t->last_panel - t->first_panel + 1;
+    t->slice_count = (int*)malloc(slices * sizeof(int));
+    t->slice_value = (double*)malloc((size_t)slices * CODEBOOK_MAX_VALUES * sizeof(double));
+    set = (Value_set*)malloc(sizeof(Value_set));
+    if (t->slice_count == NULL || t->slice_value == NULL || set == NULL) {
+        free(set);
+        t->last_panel = t->first_panel - 1;
+        t->failed = 1;
+        return NULL;
+    }
+
+    for (p = t->first_panel; p <= t->last_panel; p++) {
+        s = p - t->first_panel;
+        lo = MAX(first_row, p * t->panel_rows);
+        hi = MIN(last_row, (p + 1) * t->panel_rows - 1);
+        Set_clear(set);
+        t->slice_count[s] = 0;
+        end = (size_t)(hi + 1) * t->cols;
+        for (k = (size_t)lo * t->cols; k < end; k++) {
+            if (Set_add(set, t->A[k]) < 0) {
+                t->slice_count[s] = CODEBOOK_MAX_VALUES + 1;
+                break;
+            }
+        }
+        if (t->slice_count[s] == 0) t->slice_count[s] = set->count;
+        memcpy(t->slice_value + (size_t)s * CODEBOOK_MAX_VALUES, set->value,
+               set->count * sizeof(double));
+    }
+    free(set);
+    return NULL;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Pth_code
+ * Purpose:   Thread function: code this thread's rows against their
+ *            panels' tables
+*/
+void* Pth_code(void* arg) {
+    Code_task* t = (Code_task*)arg;
+    Codebook* C = t->C;
+    int first_row = BLOCK_LOW(t->rank, t->thread_count, t->rows);
+    int last_row = BLOCK_HIGH(t->rank, t->thread_count, t->rows);
+    int i, j, k, p, panel = -1, c;
+    const double* a;
+    unsigned char* code;
+    Value_set* set = (Value_set*)malloc(sizeof(Value_set));
+
+    if (set == NULL) {
+        t->failed = 1;
+        return NULL;
+    }
+    for (i = first_row; i <= last_row; i++) {
+        p = i / C->panel_rows;
+        if (p != panel) {
+            /* Codes in the set are the table's indices */
+            Set_clear(set);
+            for (k = 0; k < (1 << C->bits); k++) {
+                if (Set_add(set, C->table[((size_t)p << C->bits) + k]) != k) break;
+            }
+            panel = p;
+        }
+        a = t->A + (size_t)i * C->cols;
+        code = C->code + (size_t)i * C->row_bytes;
+        if (C->bits == 8) {
+            for (j = 0; j < C->cols; j++) code[j] = (unsigned char)Set_add(set, a[j]);
+        } else {
+            memset(code, 0, C->row_bytes);
+            for (j = 0; j < C->cols; j++) {
+                c = Set_add(set, a[j]);
+                code[j >> 1] |= (unsigned char)(c << ((j & 1) * 4));
+            }
+        }
+    }
+    free(set);
+    return NULL;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Row4_c / Row8_c
+ * Purpose:   Portable row kernels
+*/
+double Row4_c(const double* table, const unsigned char* code, const double* x, int cols) {
+    double sum0 = 0.0, sum1 = 0.0;
+    int j;
+
+    for (j = 0; j + 1 < cols; j += 2) {
+        sum0 += table[code[j >> 1] & 15] * x[j];
+        sum1 += table[code[j >> 1] >> 4] * x[j + 1];
+    }
+    if (j < cols) sum0 += table[code[j >> 1] & 15] * x[j];
+    return sum0 + sum1;
+}
+
+double Row8_c(const double* table, const unsigned char* code, const double* x, int cols) {
+    double sum0 = 0.0, sum1 = 0.0;
+    int j;
+
+    for (j = 0; j + 1 < cols; j += 2) {
+        sum0 += table[code[j]] * x[j];
+        sum1 += table[code[j + 1]] * x[j + 1];
+    }
+    if (j < cols) sum0 += table[code[j]] * x[j];
+    return sum0 + sum1;
+}
+
+#ifdef CODEBOOK_X86
+
+/*-------------------------------------------------------------------
+ * Function:  Row4_avx2 / Row8_avx2
+ * Purpose:   Gather 8 table entries per step; 4-bit codes are split
+ *            into bytes first
+*/
+__attribute__((target("avx2,fma")))
+double Row4_avx2(const double* table, const unsigned char* code, const double* x, int cols) {
+    const __m128i low = _mm_set1_epi8(15);
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    __m128i c, n;
+    __m128d s;
+    int j, word;
+
+    for (j = 0; j + 8 <= cols; j += 8) {
+        memcpy(&word, code + (j >> 1), 4);
+        c = _mm_cvtsi32_si128(word);
+        n = _mm_unpacklo_epi8(_mm_and_si128(c, low), _mm_and_si128(_mm_srli_epi16(c, 4), low));
+        acc0 = _mm256_fmadd_pd(_mm256_i32gather_pd(table, _mm_cvtepu8_epi32(n), 8),
+                               _mm256_loadu_pd(x + j), acc0);
+        acc1 = _mm256_fmadd_pd(_mm256_i32gather_pd(table, _mm_cvtepu8_epi32(_mm_srli_si128(n, 4)), 8),
+                               _mm256_loadu_pd(x + j + 4), acc1);
+    }
+    acc0 = _mm256_add_pd(acc0, acc1);
+    s = _mm_add_pd(_mm256_castpd256_pd128(acc0), _mm256_extractf128_pd(acc0, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s))) +
+           (j < cols ? Row4_c(table, code + (j >> 1), x + j, cols - j) : 0.0);
+}
+
+__attribute__((target("avx2,fma")))
+double Row8_avx2(const double* table, const unsigned char* code, const double* x, int cols) {
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    __m128i c;
+    __m128d s;
+    int j;
+
+    for (j = 0; j + 8 <= cols; j += 8) {
+        c = _mm_loadl_epi64((const __m128i*)(code + j));
+        acc0 = _mm256_fmadd_pd(_mm256_i32gather_pd(table, _mm_cvtepu8_epi32(c), 8),
+                               _mm256_loadu_pd(x + j), acc0);
+        acc1 = _mm256_fmadd_pd(_mm256_i32gather_pd(table, _mm_cvtepu8_epi32(_mm_srli_si128(c, 4)), 8),
+                               _mm256_loadu_pd(x + j + 4), acc1);
+    }
+    acc0 = _mm256_add_pd(acc0, acc1);
+    s = _mm_add_pd(_mm256_castpd256_pd128(acc0), _mm256_extractf128_pd(acc0, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s))) +
+           (j < cols ? Row8_c(table, code + j, x + j, cols - j) : 0.0);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Row4_avx512 / Row8_avx512
+ * Purpose:   16 entries per step: a 4-bit table lives in two registers
+ *            and is looked up with a two-source permute, an 8-bit
+ *            table is gathered from L1
+*/
+__attribute__((target("avx512f")))
+double Row4_avx512(const double* table, const unsigned char* code, const double* x, int cols) {
+    const __m512d t0 = _mm512_loadu_pd(table), t1 = _mm512_loadu_pd(table + 8);
+    const __m128i low = _mm_set1_epi8(15);
+    __m512d acc0 = _mm512_setzero_pd(), acc1 = _mm512_setzero_pd();
+    __m128i c, n;
+    int j;
+
+    for (j = 0; j + 16 <= cols; j += 16) {
+        c = _mm_loadl_epi64((const __m128i*)(code + (j >> 1)));
+        n = _mm_unpacklo_epi8(_mm_and_si128(c, low), _mm_and_si128(_mm_srli_epi16(c, 4), low));
+        acc0 = _mm512_fmadd_pd(_mm512_permutex2var_pd(t0, _mm512_cvtepu8_epi64(n), t1),
+                               _mm512_loadu_pd(x + j), acc0);
+        acc1 = _mm512_fmadd_pd(_mm512_permutex2var_pd(t0, _mm512_cvtepu8_epi64(_mm_srli_si128(n, 8)), t1),
+                               _mm512_loadu_pd(x + j + 8), acc1);
+    }
+    return _mm512_reduce_add_pd(_mm512_add_pd(acc0, acc1)) +
+           (j < cols ? Row4_c(table, code + (j >> 1), x + j, cols - j) : 0.0);
+}
+
+__attribute__((target("avx512f")))
+double Row8_avx512(const double* table, const unsigned char* code, const double* x, int cols) {
+    __m512d acc0 = _mm512_setzero_pd(), acc1 = _mm512_setzero_pd();
+    __m128i c;
+    int j;
+
+    for (j = 0; j + 16 <= cols; j += 16) {
+        c = _mm_loadu_si128((const __m128i*)(code + j));
+        acc0 = _mm512_fmadd_pd(_mm512_i32gather_pd(_mm256_cvtepu8_epi32(c), table, 8),
+                               _mm512_loadu_pd(x + j), acc0);
+        acc1 = _mm512_fmadd_pd(_mm512_i32gather_pd(_mm256_cvtepu8_epi32(_mm_srli_si128(c, 8)), table, 8),
+                               _mm512_loadu_pd(x + j + 8), acc1);
+    }
+    return _mm512_reduce_add_pd(_mm512_add_pd(acc0, acc1)) +
+           (j < cols ? Row8_c(table, code + j, x + j, cols - j) : 0.0);
+}
+
+#endif /* CODEBOOK_X86 */
@@ -0,0 +1,79 @@
+/**
+ * @file codebook.h
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Dense matrices stored as codes into tables of distinct values.
+ *
+ * A matrix with few distinct values (weights snapped to a grid, small
+ * integer stencils) is stored losslessly as one 4- or 8-bit code per
+ * entry into a table of its values: 16x or 8x smaller than doubles.
+ * Rows are cut into panels of panel_rows rows with a table each, so a
+ * matrix with more than 256 values overall can still be coded when
+ * every panel has at most 256. Values are compared by their bits, so
+ * -0.0, +0.0 and NaNs keep their identity.
+ *
+ * The matvec kernel decodes each row against its panel's table, which
+ * stays in L1: y_i = sum_j table[code_ij] * x_j. It is chosen at run
+ * time from the CPU, like the Gemm microkernels: AVX-512 (4-bit tables
+ * held in two registers and looked up with a permute, 8-bit tables by
+ * gather), AVX2 with FMA (gathers) or portable C.
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#ifndef _CODEBOOK_H_
+#define _CODEBOOK_H_
+
+/* Most values a table holds */
+#define CODEBOOK_MAX_VALUES 256
+
+typedef struct {
+    int rows, cols;
+    int bits;              /* 4 or 8 per code */
+    int panel_rows;        /* rows per table; the last panel may be shorter */
+    int panels;
+    long row_bytes;        /* bytes of codes per row; 4-bit codes pair up,
+                              the low nibble first */
+    double* table;         /* panels x (1 << bits) values */
+    unsigned char* code;   /* rows x row_bytes */
+} Codebook;
+
+/* Codebook_from_dense: code a dense rows x cols matrix
+ * panel_rows: rows per table, or 0 to choose: the largest power-of-two
+ *             fraction of the rows whose panels have at most 256 values,
+ *             down to panels of about 4096 entries
+ * Uses 4-bit codes when every panel has at most 16 values.
+ * Returns: 0 on success, 1 if a panel has more than 256 values, -1 on
+ *          allocation failure
+*/
+int Codebook_from_dense(const double* A, int rows, int cols, int panel_rows, int thread_count,
+                        Codebook* C);
+
+/* Codebook_distinct: most distinct values in a panel of panel_rows
+ * rows, counting at most CODEBOOK_MAX_VALUES + 1; -1 on allocation
+ * failure
+*/
+int Codebook_distinct(const double* A, int rows, int cols, int panel_rows, int thread_count);
+
+/* Codebook_to_dense: decode to a newly allocated dense matrix, NULL on error */
+double* Codebook_to_dense(const Codebook* C);
+
+/* Codebook_read / Codebook_write: codebook file I/O (mat_format.h)
+ * Returns: 0 on success, -1 on error
+*/
+int Codebook_read(char* filename, Codebook* C);
+int Codebook_write(char* filename, Codebook* C);
+
+/* Codebook_free: release a codebook matrix */
+void Codebook_free(Codebook* C);
+
+/* Codebook_rows: rows first_row..last_row of y = A * x */
+void Codebook_rows(const Codebook* A, const double* x, double* y, int first_row, int last_row);
+
+/* Codebook_kernel_name: kernel Codebook_rows uses on this CPU, e.g. "avx2" */
+const char* Codebook_kernel_name(void);
+
+#endif /* _CODEBOOK_H_ */
@@ -0,0 +1,408 @@
+/**
+ * @file convert_matrix.c
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Convert matrix files between storage formats.
+ *
+ * The input format is detected from the file (see mat_format.h); the
+ * output format is named on the command line:
+ *   dense   plain .mat file
+ *   csr     compressed sparse rows; zeros are dropped
+ *   csc     compressed sparse columns
+ *   spvec   sparse vector (the matrix must have one column); entries
+ *           repeated at an index are added up
+ *   coo     coordinate triplets
+ *   dcsr    CSR with delta-coded column indices
+ *   codebook  4- or 8-bit codes into tables of the distinct values
+ *           (codebook.h), chosen automatically; fails if a panel of
+ *           rows has more than 256 values
+ *   bitmat  bit planes of a {0, 1} or {-1, 0, 1} matrix (bitmat.h)
+ * Conversions go through CSR, which every sparse format can be built
+ * from, and are threaded (sparse.h). A COO file is streamed in chunks
+ * straight into CSR, or into CSC when that is the output.
+ *
+ * Options for COO input:
+ *   -s        sort each row (column) by index; always done for csr, csc
+ *             and dcsr output, whose indices must increase (mat_format.h)
+ *   -d        sort, and add up entries repeated at the same position
+ *   -z MB     chunk of the file read at a time (default 64)
+ * Option for codebook output:
+ *   -k rows   rows per value table (default: chosen from the matrix)
+ *
+ * A summary line is printed to stdout, with the time to read and
+ * convert the input:
+ *   <file_out>: <rows> x <cols>, <nnz> stored entries, <bytes> bytes, <time> s
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "timer.h"
+#include "mat_format.h"
+#include "mat_io.h"
+#include "sparse.h"
+#include "codebook.h"
+#include "bitmat.h"
+
+/* Function prototypes */
+void Usage(char* prog_name);
+int Read_matrix(char* filename, double** A_p, int* m_p, int* n_p);
+int Write_matrix(char* filename, double* A, int rows, int cols);
+int Csr_from_spvec(Spvec* v, Csr* S);
+int Spvec_from_csr(Csr* S, Spvec* v);
+
+int main(int argc, char* argv[]) {
+    int opt, thread_count = 1, in_format, rows, cols, coo_flags = 0, panel_rows = 0;
+    size_t chunk_bytes = COO_DEFAULT_CHUNK_BYTES;
+    double start, end;
+    char *target, *file_in, *file_out;
+    double* dense = NULL;
+    Csr csr;
+    Csc csc;
+    Dcsr dcsr;
+    Spvec spvec;
+    Codebook book;
+    Bitmat bits;
+    long nnz;
+    struct stat st;
+    int status;
+
+    memset(&csr, 0, sizeof(csr));
+    memset(&csc, 0, sizeof(csc));
+
+    /* Parse options */
+    while ((opt = getopt(argc, argv, "t:sdz:k:")) != -1) {
+        switch (opt) {
+            case 't': thread_count = atoi(optarg); break;
+            case 's': coo_flags |= COO_SORT; break;
+            case 'd': coo_flags |= COO_SUM_DUPLICATES; break;
+            case 'z':
+                if (Io_parse_megabytes(optarg, &chunk_bytes) != 0) {
+                    fprintf(stderr, "Error: -z needs a positive number of MB\n");
+                    Usage(argv[0]);
+                    exit(1);
+                }
+                break;
+            case 'k': panel_rows = atoi(optarg); break;
+            default:
+                Usage(argv[0]);
+                exit(1);
+        }
+    }
+
+    /* Check command line arguments */
+    if (argc - optind != 3 || thread_count <= 0 || panel_rows < 0) {
+        Usage(argv[0]);
+        exit(1);
+    }
+    target = argv[optind];
+    file_in = argv[optind + 1];
+    file_out = argv[optind + 2];
+    if (strcmp(target, "dense") != 0 && strcmp(target, "csr") != 0 &&
+        strcmp(target, "csc") != 0 && strcmp(target, "spvec") != 0 &&
+        strcmp(target, "coo") != 0 && strcmp(target, "dcsr") != 0 &&
+        strcmp(target, "codebook") != 0 && strcmp(target, "bitmat") != 0) {
+        fprintf(stderr, "Error: Unknown output format %s\n", target);
+        exit(1);
+    }
+
+    /* Read the input in whatever format it is in */
+    GET_TIME(start);
+    in_format = Sparse_format(file_in);
+    if (strcmp(target, "csr") == 0 || strcmp(target, "csc") == 0 ||
+        strcmp(target, "dcsr") == 0) {
+        coo_flags |= COO_SORT;
+    }
+    if (strcmp(target, "spvec") == 0) coo_flags |= COO_SUM_DUPLICATES;
+    if (in_format == MAT_FORMAT_DENSE) {
+        status = Read_matrix(file_in, &dense, &rows, &cols);
+    } else if (in_format == MAT_FORMAT_CSR) {
+        status = Csr_read(file_in, &csr);
+    } else if (in_format == MAT_FORMAT_CSC) {
+        status = Csc_read(file_in, &csc);
+        if (status == 0) {
+            status = Csr_from_csc(&csc, thread_count, &csr);
+            Csc_free(&csc);
+        }
+    } else if (in_format == MAT_FORMAT_COO) {
+        if (strcmp(target, "csc") == 0) {
+            status = Csc_from_coo(file_in, coo_flags, chunk_bytes, thread_count, &csc);
+        } else {
+            status = Csr_from_coo(file_in, coo_flags, chunk_bytes, thread_count, &csr);
+        }
+    } else if (in_format == MAT_FORMAT_DCSR) {
+        status = Dcsr_read(file_in, &dcsr);
+        if (status == 0) {
+            status = Dcsr_to_csr(&dcsr, &csr);
+            Dcsr_free(&dcsr);
+        }
+    } else if (in_format == MAT_FORMAT_CODEBOOK) {
+        status = Codebook_read(file_in, &book);
+        if (status == 0) {
+            rows = book.rows;
+            cols = book.cols;
+            dense = Codebook_to_dense(&book);
+            if (dense == NULL) status = -1;
+            Codebook_free(&book);
+        }
+    } else if (in_format == MAT_FORMAT_BITMAT) {
+        status = Bitmat_read(file_in, &bits);
+        if (status == 0) {
+            rows = bits.rows;
+            cols = bits.cols;
+            dense = Bitmat_to_dense(&bits);
+            if (dense == NULL) status = -1;
+            Bitmat_free(&bits);
+        }
+    } else if (in_format == MAT_FORMAT_SPVEC) {
+        status = Spvec_read(file_in, &spvec);
+        if (status == 0) {
+            status = Csr_from_spvec(&spvec, &csr);
+            Spvec_free(&spvec);
+        }
+    } else {
+        fprintf(stderr, "Error: Unsupported matrix format in %s\n", file_in);
+        exit(1);
+    }
+    if (status != 0) {
+        fprintf(stderr, "Error: Failed to read matrix from %s\n", file_in);
+        exit(1);
+    }
+
+    /* Convert and write */
+    if (strcmp(target, "dense") == 0 || strcmp(target, "codebook") == 0 ||
+        strcmp(target, "bitmat") == 0) {
+        if (dense == NULL) {
+            rows = csr.rows;
+            cols = csr.cols;
+            dense = Csr_to_dense(&csr);
+            if (dense == NULL) {
+                fprintf(stderr, "Error: Cannot allocate memory for dense matrix\n");
+                exit(1);
+            }
+        }
+        nnz = (long)rows * cols;
+        if (strcmp(target, "codebook") == 0) {
+            status = Codebook_from_dense(dense, rows, cols, panel_rows, thread_count, &book);
+            if (status != 0) {
+                fprintf(stderr, status > 0 ? "Error: %s has more than 256 values in a panel\n"
+                                           : "Error: Cannot allocate memory for codebook of %s\n",
+                        file_in);
+                exit(1);
+            }
+            GET_TIME(end);
+            status = Codebook_write(file_out, &book);
+            printf("%s: %d-bit codes, %d tables of %d rows, %s kernel\n", file_out, book.bits,
+                   book.panels, book.panel_rows, Codebook_kernel_name());
+            Codebook_free(&book);
+        } else if (strcmp(target, "bitmat") == 0) {
+            status = Bitmat_from_dense(dense, rows, cols, thread_count, &bits);
+            if (status != 0) {
+                fprintf(stderr, status > 0 ? "Error: %s has entries other than 0, 1 and -1\n"
+                                           : "Error: Cannot allocate memory for bit matrix of %s\n",
+                        file_in);
+                exit(1);
+            }
+            GET_TIME(end);
+            status = Bitmat_write(file_out, &bits);
+            printf("%s: %s, %s kernel\n", file_out,
+                   bits.kind == BITMAT_BINARY ? "binary" : "ternary", Bitmat_kernel_name());
+            Bitmat_free(&bits);
+        } else {
+            GET_TIME(end);
+            status = Write_matrix(file_out, dense, rows, cols);
+        }
+    } else if (csc.col_ptr != NULL) {
+        /* Built directly from COO */
+        rows = csc.rows;
+        cols = csc.cols;
+        nnz = csc.nnz;
+        GET_TIME(end);
+        status = Csc_write(file_out, &csc);
+        Csc_free(&csc);
+    } else {
+        if (csr.row_ptr == NULL && Csr_from_dense(dense, rows, cols, thread_count, &csr) != 0) {
+            fprintf(stderr, "Error: Cannot allocate memory for CSR matrix\n");
+            exit(1);
+        }
+        rows = csr.rows;
+        cols = csr.cols;
+        nnz = csr.nnz;
+        if (strcmp(target, "csc") == 0 && Csc_from_csr(&csr, thread_count, &csc) != 0) {
+            fprintf(stderr, "Error: Cannot allocate memory for CSC matrix\n");
+            exit(1);
+        }
+        if (strcmp(target, "dcsr") == 0 && Dcsr_from_csr(&csr, thread_count, &dcsr) != 0) {
+            fprintf(stderr, "Error: Cannot code %s as DCSR: out of memory or unsorted rows\n",
+                    file_in);
+            exit(1);
+        }
+        GET_TIME(end);
+        if (strcmp(target, "csr") == 0) {
+            status = Csr_write(file_out, &csr);
+        } else if (strcmp(target, "coo") == 0) {
+            status = Csr_write_coo(file_out, &csr);
+        } else if (strcmp(target, "dcsr") == 0) {
+            status = Dcsr_write(file_out, &dcsr);
+            Dcsr_free(&dcsr);
+        } else if (strcmp(target, "csc") == 0) {
+            status = Csc_write(file_out, &csc);
+            Csc_free(&csc);
+        } else {
+            if (cols != 1) {
+                fprintf(stderr, "Error: A sparse vector needs one column, %s has %d\n", file_in, cols);
+                exit(1);
+            }
+            if (Spvec_from_csr(&csr, &spvec) != 0) {
+                fprintf(stderr, "Error: Cannot allocate memory for sparse vector\n");
+                exit(1);
+            }
+            status = Spvec_write(file_out, &spvec);
+            Spvec_free(&spvec);
+        }
+    }
+    if (status != 0) {
+        fprintf(stderr, "Error: Failed to write %s\n", file_out);
+        exit(1);
+    }
+
+    printf("%s: %d x %d, %ld stored entries, %ld bytes, %.3f s\n", file_out, rows, cols, nnz,
+           stat(file_out, &st) == 0 ? (long)st.st_size : -1L, end - start);
+
+    /* Clean up */
+    free(dense);
+    Csr_free(&csr);
+
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Usage
+ * Purpose:   Print usage message
+*/
+void Usage(char* prog_name) {
+    fprintf(stderr, "Usage: %s [-t threads] <format> <file_in> <file_out>\n", prog_name);
+    fprintf(stderr, "  Converts a matrix file to format: dense, csr, csc, spvec, coo\n");
+    fprintf(stderr, "  dcsr, codebook or bitmat\n");
+    fprintf(stderr, "  -t threads  threads for the conversion (default 1)\n");
+    fprintf(stderr, "  -s          COO input: sort each row (column); implied for csr,\n");
+    fprintf(stderr, "              csc and dcsr output\n");
+    fprintf(stderr, "  -d          COO input: sort and sum duplicate entries\n");
+    fprintf(stderr, "  -z MB       COO input: chunk size (default 64)\n");
+    fprintf(stderr, "  -k rows     codebook output: rows per value table (default: chosen)\n");
+    fprintf(stderr, "  Example: %s -t 4 csr A.mat A.csr\n", prog_name);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Read_matrix
+ * Purpose:   Read a binary matrix file
+*/
+int Read_matrix(char* filename, double** A_p, int* m_p, int* n_p) {
+    FILE* fp;
+    int rows, cols;
+    double* A;
+
+    fp = fopen(filename, "rb");
+    if (fp == NULL) return -1;
+
+    if (fread(&rows, sizeof(int), 1, fp) != 1 ||
+        fread(&cols, sizeof(int), 1, fp) != 1) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (rows <= 0 || cols <= 0) {
+        fclose(fp);
+        return -1;
+    }
+
+    A = (double*)malloc((size_t)rows * cols * sizeof(double));
+    if (A == NULL) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (fread(A, sizeof(double), (size_t)rows * cols, fp) != (size_t)rows * cols) {
+        free(A);
+        fclose(fp);
+        return -1;
+    }
+
+    fclose(fp);
+    *A_p = A;
+    *m_p = rows;
+    *n_p = cols;
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Write_matrix
+ * Purpose:   Write a matrix to a binary file
+*/
+int Write_matrix(char* filename, double* A, int rows, int cols) {
+    FILE* fp;
+
+    fp = fopen(filename, "wb");
+    if (fp == NULL) return -1;
+
+    if (fwrite(&rows, sizeof(int), 1, fp) != 1 ||
+        fwrite(&cols, sizeof(int), 1, fp) != 1) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (fwrite(A, sizeof(double), (size_t)rows * cols, fp) != (size_t)rows * cols) {
+        fclose(fp);
+        return -1;
+    }
+
+    fclose(fp);
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Csr_from_spvec
+ * Purpose:   View a sparse vector as an n x 1 CSR matrix
+*/
+int Csr_from_spvec(Spvec* v, Csr* S) {
+    long k;
+    int i;
+
+    if (Csr_alloc(S, v->n, 1, v->nnz) != 0) return -1;
+    for (i = 0; i <= v->n; i++) S->row_ptr[i] = 0;
+    for (k = 0; k < v->nnz; k++) {
+        S->row_ptr[v->idx[k] + 1] = 1;
+        S->col_idx[k] = 0;
+        S->val[k] = v->val[k];
+    }
+    for (i = 0; i < v->n; i++) S->row_ptr[i + 1] += S->row_ptr[i];
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Spvec_from_csr
+ * Purpose:   Sparse vector of an n x 1 CSR matrix, adding up any entries
+ *            stored more than once in a row
+*/
+int Spvec_from_csr(Csr* S, Spvec* v) {
+    int i;
+    long k, count = 0;
+
+    if (Spvec_alloc(v, S->rows, S->nnz) != 0) return -1;
+    for (i = 0; i < S->rows; i++) {
+        if (S->row_ptr[i + 1] == S->row_ptr[i]) continue;
+        v->idx[count] = i;
+        v->val[count] = 0.0;
+        for (k = S->row_ptr[i]; k < S->row_ptr[i + 1]; k++) v->val[count] += S->val[k];
+        count++;
+    }
+    v->nnz = count;
+    return 0;
+}
@@ -0,0 +1,387 @@
+/**
+ * @file gemm.c
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Cache-blocked, packed dense matrix-matrix multiply.
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "quinn.h"
+#include "gemm.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define GEMM_X86 1
+#endif
+
+/* Blocking: MC rows of A (L2), KC depth (L1/L2), NC columns of B (L3).
+   MC and NC are multiples of every kernel's MR and NR. */
+#define GEMM_MC 144
+#define GEMM_KC 256
+#define GEMM_NC 4080
+#define GEMM_MR_MAX 8
+#define GEMM_NR_MAX 16
+
+/* C[mr x nr] += A sliver * B sliver over kc */
+typedef void (*Kernel_fn)(int kc, const double* a, const double* b, double* c, int ldc);
+
+typedef struct {
+    const char* name;
+    int mr, nr;
+    Kernel_fn fn;
+} Gemm_kernel;
+
+/* Work shared with the Gemm threads */
+typedef struct {
+    int m, n, k;
+    const double* A;
+    const double* B;
+    double* C;
+    int lda, ldb, ldc;
+    double* B_pack;             /* shared packed B panel */
+    const Gemm_kernel* kern;
+    pthread_barrier_t* barrier;
+    int thread_count;
+    long rank;
+} Gemm_task;
+
+/* Function prototypes */
+const Gemm_kernel* Select_gemm_kernel(void);
+void Kernel_c(int kc, const double* a, const double* b, double* c, int ldc);
+#ifdef GEMM_X86
+void Kernel_avx2(int kc, const double* a, const double* b, double* c, int ldc);
+void Kernel_avx512(int kc, const double* a, const double* b, double* c, int ldc);
+#endif
+void Pack_A(const double* A, int lda, int rows, int kc, int mr, double* dst);
+void Pack_B(const double* B, int ldb, int kc, int cols, int nr, int first, int last, double* dst);
+void* Pth_gemm(void* arg);
+
+static const Gemm_kernel kernel_c = {"c", 4, 4, Kernel_c};
+#ifdef GEMM_X86
+static const Gemm_kernel kernel_avx2 = {"avx2", 6, 8, Kernel_avx2};
+static const Gemm_kernel kernel_avx512 = {"avx512", 8, 16, Kernel_avx512};
+#endif
+
+/*-------------------------------------------------------------------
+ * Function:  Gemm
+ * Purpose:   Threaded C = A * B
+*/
+int Gemm(int m, int n, int k, const double* A, int lda, const double* B, int ldb,
+         double* C, int ldc, int thread_count) {
+    const Gemm_kernel* kern = Select_gemm_kernel();
+    pthread_t* thread_handles;
+    pthread_barrier_t barrier;
+    Gemm_task* tasks;
+    double* B_pack = NULL;
+    size_t pack_bytes;
+    long thread;
+    int i;
+
+    if (m <= 0 || n <= 0 || k <= 0 || thread_count <= 0) return -1;
+
+    pack_bytes = (size_t)GEMM_KC * (GEMM_NC + GEMM_NR_MAX) * sizeof(double);
+    thread_handles = (pthread_t*)malloc(thread_count * sizeof(pthread_t));
+    tasks = (Gemm_task*)malloc(thread_count * sizeof(Gemm_task));
+    if (thread_handles == NULL || tasks == NULL ||
+        posix_memalign((void**)&B_pack, 64, pack_bytes) != 0) {
+        free(thread_handles);
+        free(tasks);
+        return -1;
+    }
+
+    /* Small products are not worth the threads */
+    if ((double)m * n * k < 1e6) thread_count = 1;
+
+    if (thread_count > 1) pthread_barrier_init(&barrier, NULL, thread_count);
+    for (thread = 0; thread < thread_count; thread++) {
+        Gemm_task* t = &tasks[thread];
+        t->m = m;
+        t->n = n;
+        t->k = k;
+        t->A = A;
+        t->B = B;
+        t->C = C;
+        t->lda = lda;
+        t->ldb = ldb;
+        t->ldc = ldc;
+        t->B_pack = B_pack;
+        t->kern = kern;
+        t->barrier = thread_count == 1 ? NULL : &barrier;
+        t->thread_count = thread_count;
+        t->rank = thread;
+    }
+
+    if (thread_count == 1) {
+        Pth_gemm(&tasks[0]);
+    } else {
+        for (thread = 0; thread < thread_count; thread++) {
+            pthread_create(&thread_handles[thread], NULL, Pth_gemm, &tasks[thread]);
+        }
+        for (thread = 0; thread < thread_count; thread++) {
+            pthread_join(thread_handles[thread], NULL);
+        }
+        pthread_barrier_destroy(&barrier);
+    }
+
+    /* Pth_gemm reports allocation failure through m */
+    for (i = 0; i < thread_count; i++) {
+        if (tasks[i].m < 0) m = -1;
+    }
+
+    free(B_pack);
+    free(thread_handles);
+    free(tasks);
+    return m < 0 ? -1 : 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Gemm_kernel_name
+ * Purpose:   Name of the microkernel in use
+*/
+const char* Gemm_kernel_name(void) {
+    return Select_gemm_kernel()->name;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Select_gemm_kernel
+ * Purpose:   Pick the widest microkernel the CPU supports
+*/
+const Gemm_kernel* Select_gemm_kernel(void) {
+#ifdef GEMM_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return &kernel_avx512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return &kernel_avx2;
+#endif
+    return &kernel_c;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Pack_A
+ * Purpose:   Pack rows x kc of A into MR-row slivers, each stored
+ *            column by column; short slivers are padded with zeros
+*/
+void Pack_A(const double* A, int lda, int rows, int kc, int mr, double* dst) {
+    int s, i, p, height;
+
+    for (s = 0; s < rows; s += mr) {
+        height = MIN(mr, rows - s);
+        for (p = 0; p < kc; p++) {
+            for (i = 0; i < height; i++) dst[i] = A[(size_t)(s + i) * lda + p];
+            for (; i < mr; i++) dst[i] = 0.0;
+            dst += mr;
+        }
+    }
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Pack_B
+ * Purpose:   Pack slivers first..last of a kc x cols panel of B into
+ *            NR-column slivers, each stored row by row; the last sliver
+ *            is padded with zeros
+*/
+void Pack_B(const double* B, int ldb, int kc, int cols, int nr, int first, int last,
+            double* dst) {
+    int s, j, p, width;
+
+    for (s = first; s <= last; s++) {
+        double* d = dst + (size_t)s * kc * nr;
+        width = MIN(nr, cols - s * nr);
+        for (p = 0; p < kc; p++) {
+            const double* b = B + (size_t)p * ldb + s * nr;
+            for (j = 0; j < width; j++) d[j] = b[j];
+            for (; j < nr; j++) d[j] = 0.0;
+            d += nr;
+        }
+    }
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Pth_gemm
+ * Purpose:   Thread function: loop over B panels, packing a share of
+ *            each, then update this thread's rows of C block by block
+*/
+void* Pth_gemm(void* arg) {
+    Gemm_task* t = (Gemm_task*)arg;
+    const Gemm_kernel* kern = t->kern;
+    int mr = kern->mr, nr = kern->nr;
+    int slivers = CEILING(t->m, mr), first_row, last_row;
+    int jc, pc, ic, jr, ir, nc, kc, mc, i, j, num_b, height, width;
+    double* A_pack = NULL;
+    double tile[GEMM_MR_MAX * GEMM_NR_MAX];
+
+    /* This thread's rows of C: a block of whole slivers */
+    first_row = BLOCK_LOW(t->rank, t->thread_count, slivers) * mr;
+    last_row = MIN(BLOCK_HIGH(t->rank, t->thread_count, slivers) * mr + mr, t->m) - 1;
+
+    if (posix_memalign((void**)&A_pack, 64, (size_t)GEMM_MC * GEMM_KC * sizeof(double)) != 0) {
+        A_pack = NULL;
+        t->m = -1;
+    }
+
+    for (i = first_row; i <= last_row; i++) {
+        memset(t->C + (size_t)i * t->ldc, 0, t->n * sizeof(double));
+    }
+
+    for (jc = 0; jc < t->n; jc += GEMM_NC) {
+        nc = MIN(GEMM_NC, t->n - jc);
+        num_b = CEILING(nc, nr);
+
+        for (pc = 0; pc < t->k; pc += GEMM_KC) {
+            kc = MIN(GEMM_KC, t->k - pc);
+
+            /* Pack this thread's share of the B panel */
+            Pack_B(t->B + (size_t)pc * t->ldb + jc, t->ldb, kc, nc, nr,
+                   BLOCK_LOW(t->rank, t->thread_count, num_b),
+                   BLOCK_HIGH(t->rank, t->thread_count, num_b), t->B_pack);
+            if (t->barrier != NULL) pthread_barrier_wait(t->barrier);
+
+            for (ic = first_row; A_pack != NULL && ic <= last_row; ic += GEMM_MC) {
+                mc = MIN(GEMM_MC, last_row - ic + 1);
+                Pack_A(t->A + (size_t)ic * t->lda + pc, t->lda, mc, kc, mr, A_pack);
+
+                for (jr = 0; jr < nc; jr += nr) {
+                    const double* b = t->B_pack + (size_t)(jr / nr) * kc * nr;
+                    width = MIN(nr, nc - jr);
+
+                    for (ir = 0; ir < mc; ir += mr) {
+                        const double* a = A_pack + (size_t)(ir / mr) * kc * mr;
+                        double* c = t->C + (size_t)(ic + ir) * t->ldc + jc + jr;
+                        height = MIN(mr, mc - ir);
+
+                        if (height == mr && width == nr) {
+                            kern->fn(kc, a, b, c, t->ldc);
+                            continue;
+                        }
+
+                        /* Edge tile: compute in a buffer, add what fits */
+                        memset(tile, 0, sizeof(tile));
+                        kern->fn(kc, a, b, tile, nr);
+                        for (i = 0; i < height; i++) {
+                            for (j = 0; j < width; j++) {
+                                c[(size_t)i * t->ldc + j] += tile[i * nr + j];
+                            }
+                        }
+                    }
+                }
+            }
+
+            /* The panel is reused for the next pc */
+            if (t->barrier != NULL) pthread_barrier_wait(t->barrier);
+        }
+    }
+
+    free(A_pack);
+    return NULL;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Kernel_c
+ * Purpose:   Portable 4 x 4 microkernel
+*/
+void Kernel_c(int kc, const double* a, const double* b, double* c, int ldc) {
+    double acc[4][4] = {{0.0}};
+    int p, i, j;
+
+    for (p = 0; p < kc; p++) {
+        for (i = 0; i < 4; i++) {
+            for (j = 0; j < 4; j++) {
+                acc[i][j] += a[i] * b[j];
+            }
+        }
+        a += 4;
+        b += 4;
+    }
+    for (i = 0; i < 4; i++) {
+        for (j = 0; j < 4; j++) {
+            c[(size_t)i * ldc + j] += acc[i][j];
+        }
+    }
+}
+
+#ifdef GEMM_X86
+
+/*-------------------------------------------------------------------
+ * Function:  Kernel_avx2
+ * Purpose:   6 x 8 microkernel: 12 ymm accumulators, two rows of B
+ *            vectors and one broadcast of A per step
+*/
+#define AVX2_ROW(i) \
+    a_i = _mm256_broadcast_sd(a + (i)); \
+    c##i##0 = _mm256_fmadd_pd(a_i, b0, c##i##0); \
+    c##i##1 = _mm256_fmadd_pd(a_i, b1, c##i##1);
+#define AVX2_STORE(i) \
+    _mm256_storeu_pd(c + (size_t)(i) * ldc, \
+                     _mm256_add_pd(_mm256_loadu_pd(c + (size_t)(i) * ldc), c##i##0)); \
+    _mm256_storeu_pd(c + (size_t)(i) * ldc + 4, \
+                     _mm256_add_pd(_mm256_loadu_pd(c + (size_t)(i) * ldc + 4), c##i##1));
+
+__attribute__((target("avx2,fma")))
+void Kernel_avx2(int kc, const double* a, const double* b, double* c, int ldc) {
+    __m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+    __m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+    __m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+    __m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+    __m256d c40 = _mm256_setzero_pd(), c41 = _mm256_setzero_pd();
+    __m256d c50 = _mm256_setzero_pd(), c51 = _mm256_setzero_pd();
+    __m256d a_i, b0, b1;
+    int p;
+
+    for (p = 0; p < kc; p++) {
+        b0 = _mm256_loadu_pd(b);
+        b1 = _mm256_loadu_pd(b + 4);
+        AVX2_ROW(0) AVX2_ROW(1) AVX2_ROW(2)
+        AVX2_ROW(3) AVX2_ROW(4) AVX2_ROW(5)
+        a += 6;
+        b += 8;
+    }
+    AVX2_STORE(0) AVX2_STORE(1) AVX2_STORE(2)
+    AVX2_STORE(3) AVX2_STORE(4) AVX2_STORE(5)
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Kernel_avx512
+ * Purpose:   8 x 16 microkernel: 16 zmm accumulators
+*/
+#define AVX512_ROW(i) \
+    a_i = _mm512_set1_pd(a[i]); \
+    c##i##0 = _mm512_fmadd_pd(a_i, b0, c##i##0); \
+    c##i##1 = _mm512_fmadd_pd(a_i, b1, c##i##1);
+#define AVX512_STORE(i) \
+    _mm512_storeu_pd(c + (size_t)(i) * ldc, \
+                     _mm512_add_pd(_mm512_loadu_pd(c + (size_t)(i) * ldc), c##i##0)); \
+    _mm512_storeu_pd(c + (size_t)(i) * ldc + 8, \
+                     _mm512_add_pd(_mm512_loadu_pd(c + (size_t)(i) * ldc + 8), c##i##1));
+
+__attribute__((target("avx512f")))
+void Kernel_avx512(int kc, const double* a, const double* b, double* c, int ldc) {
+    __m512d c00 = _mm512_setzero_pd(), c01 = _mm512_setzero_pd();
+    __m512d c10 = _mm512_setzero_pd(), c11 = _mm512_setzero_pd();
+    __m512d c20 = _mm512_setzero_pd(), c21 = _mm512_setzero_pd();
+    __m512d c30 = _mm512_setzero_pd(), c31 = _mm512_setzero_pd();
+    __m512d c40 = _mm512_setzero_pd(), c41 = _mm512_setzero_pd();
+    __m512d c50 = _mm512_setzero_pd(), c51 = _mm512_setzero_pd();
+    __m512d c60 = _mm512_setzero_pd(), c61 = _mm512_setzero_pd();
+    __m512d c70 = _mm512_setzero_pd(), c71 = _mm512_setzero_pd();
+    __m512d a_i, b0, b1;
+    int p;
+
+    for (p = 0; p < kc; p++) {
+        b0 = _mm512_loadu_pd(b);
+        b1 = _mm512_loadu_pd(b + 8);
+        AVX512_ROW(0) AVX512_ROW(1) AVX512_ROW(2) AVX512_ROW(3)
+        AVX512_ROW(4) AVX512_ROW(5) AVX512_ROW(6) AVX512_ROW(7)
+        a += 8;
+        b += 16;
+    }
+    AVX512_STORE(0) AVX512_STORE(1) AVX512_STORE(2) AVX512_STORE(3)
+    AVX512_STORE(4) AVX512_STORE(5) AVX512_STORE(6) AVX512_STORE(7)
+}
+
+#endif /* GEMM_X86 */
@@ -0,0 +1,37 @@
+/**
+ * @file gemm.h
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Cache-blocked, packed dense matrix-matrix multiply.
+ *
+ * Gemm follows the usual five-loop structure: B is cut into KC x NC
+ * panels (L3) packed into NR-column slivers, A into MC x KC blocks (L2)
+ * packed into MR-row slivers, and a register-tiled MR x NR microkernel
+ * (L1) updates C from one A sliver and one B sliver. The microkernel is
+ * chosen at run time from the CPU: AVX-512 (8 x 16), AVX2 with FMA
+ * (6 x 8) or portable C (4 x 4), so binaries stay portable.
+ *
+ * Threads split the rows of C by MR-row slivers using Quinn's macros,
+ * each packing its own A blocks, and share the packing of every B panel.
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#ifndef _GEMM_H_
+#define _GEMM_H_
+
+/* Gemm: C = A * B for row-major A m x k, B k x n, C m x n
+ * lda, ldb, ldc: row strides of A, B and C in doubles
+ * thread_count:  threads to use
+ * Returns: 0 on success, -1 on error
+*/
+int Gemm(int m, int n, int k, const double* A, int lda, const double* B, int ldb,
+         double* C, int ldc, int thread_count);
+
+/* Gemm_kernel_name: microkernel Gemm uses on this CPU, e.g. "avx2" */
+const char* Gemm_kernel_name(void);
+
+#endif /* _GEMM_H_ */
@@ -11,6 +11,10 @@
  *   - Next 4 bytes: number of columns (int)
  *   - Remaining bytes: matrix data (doubles in row-major order)
  * 
+ * With a shard count, the file is written as a shard manifest plus one
+ * matrix file per row block (see mat_shard.h), and the shards are
+ * generated and written in parallel, one thread per shard.
+ * 
  * @version 1.0
  * @date 2026-02-16
  * 
@@ -22,17 +26,25 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <pthread.h>
+#include "mat_shard.h"
+
+/* Shard layout shared with the writer threads */
+Shard_manifest manifest;
+unsigned int base_seed;
 
 void Usage(char* prog_name);
+int Make_sharded(char* filename, int rows, int cols, int num_shards);
+void* Write_shard(void* rank);
 
 int main(int argc, char* argv[]) {
     FILE* fp;
     int rows, cols;
-    int i, total_elements;
+    int i, total_elements, num_shards = 0;
     double* matrix;
     
     /* Check command line arguments */
-    if (argc != 4) {
+    if (argc != 4 && argc != 5) {
         Usage(argv[0]);
         exit(1);
     }
@@ -40,6 +52,7 @@ int main(int argc, char* argv[]) {
     /* Parse dimensions */
     rows = atoi(argv[2]);
     cols = atoi(argv[3]);
+    if (argc == 5) num_shards = atoi(argv[4]);
     
     /* Validate dimensions */
     if (rows <= 0 || cols <= 0) {
@@ -48,6 +61,17 @@ int main(int argc, char* argv[]) {
         exit(1);
     }
     
+    /* Sharded output */
+    if (argc == 5) {
+        if (num_shards <= 0 || num_shards > rows) {
+            fprintf(stderr, "Error: shards must be between 1 and rows\n");
+            Usage(argv[0]);
+            exit(1);
+        }
+        if (Make_sharded(argv[1], rows, cols, num_shards) != 0) exit(1);
+        return 0;
+    }
+    
     /* Open file for writing */
     fp = fopen(argv[1], "wb");
     if (fp == NULL) {
@@ -104,7 +128,89 @@ int main(int argc, char* argv[]) {
  * Purpose:   Print usage message and exit
  */
 void Usage(char* prog_name) {
-    fprintf(stderr, "Usage: %s <file_name> <rows> <cols>\n", prog_name);
+    fprintf(stderr, "Usage: %s <file_name> <rows> <cols> [shards]\n", prog_name);
     fprintf(stderr, "  Creates a binary matrix file with random double values\n");
+    fprintf(stderr, "  With shards, writes a manifest plus <file_name>.<k> shards\n");
     fprintf(stderr, "  Example: %s A.mat 100 50\n", prog_name);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Make_sharded
+ * Purpose:   Write a sharded matrix: the manifest, then all shards in
+ *            parallel
+ * Return:    0 on success, -1 on error (message already printed)
+ */
+int Make_sharded(char* filename, int rows, int cols, int num_shards) {
+    pthread_t* thread_handles;
+    long shard;
+    void* status;
+    int failed = 0;
+    
+    if (Shard_plan(filename, rows, cols, num_shards, &manifest) != 0 ||
+        Shard_write_manifest(filename, &manifest) != 0) {
+        fprintf(stderr, "Error: Cannot write shard manifest %s\n", filename);
+        return -1;
+    }
+    
+    thread_handles = (pthread_t*)malloc(num_shards * sizeof(pthread_t));
+    if (thread_handles == NULL) {
+        fprintf(stderr, "Error: Cannot allocate memory for thread handles\n");
+        Shard_free_manifest(&manifest);
+        return -1;
+    }
+    
+    base_seed = (unsigned int)time(NULL);
+    for (shard = 0; shard < num_shards; shard++) {
+        pthread_create(&thread_handles[shard], NULL, Write_shard, (void*)shard);
+    }
+    for (shard = 0; shard < num_shards; shard++) {
+        pthread_join(thread_handles[shard], &status);
+        if (status != NULL) {
+            fprintf(stderr, "Error: Failed to write shard %s\n", manifest.shards[shard].path);
+            failed = 1;
+        }
+    }
+    
+    free(thread_handles);
+    Shard_free_manifest(&manifest);
+    return failed ? -1 : 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Write_shard
+ * Purpose:   Thread function: generate and write one shard
+ * Return:    NULL on success, non-NULL on error
+ */
+void* Write_shard(void* rank) {
+    long my_rank = (long)rank;
+    Shard* s = &manifest.shards[my_rank];
+    int header[2];
+    size_t i, total_elements;
+    unsigned int seed = base_seed + 7919 * (unsigned int)my_rank;
+    double* matrix;
+    FILE* fp;
+    
+    header[0] = s->last_row - s->first_row + 1;
+    header[1] = manifest.cols;
+    total_elements = (size_t)header[0] * header[1];
+    
+    matrix = (double*)malloc(total_elements * sizeof(double));
+    if (matrix == NULL) return (void*)1;
+    
+    /* Fill shard with random values between 0.0 and 10.0 */
+    for (i = 0; i < total_elements; i++) {
+        matrix[i] = ((double)rand_r(&seed) / (double)RAND_MAX) * 10.0;
+    }
+    
+    fp = fopen(s->path, "wb");
+    if (fp == NULL ||
+        fwrite(header, sizeof(int), 2, fp) != 2 ||
+        fwrite(matrix, sizeof(double), total_elements, fp) != total_elements) {
+        if (fp != NULL) fclose(fp);
+        free(matrix);
+        return (void*)1;
+    }
+    
+    free(matrix);
+    return fclose(fp) == 0 ? NULL : (void*)1;
 }
\ No newline at end of file
@@ -0,0 +1,377 @@
+/**
+ * @file mat_cache.c
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Persistent shared-memory cache for binary matrix files.
+ *
+ * The cache directory holds two kinds of entries:
+ *   pthmv-c-<fingerprint>  data entry: 4096-byte header (Cache_header,
+ *                          zero padded), then the matrix data
+ *   pthmv-k-<key>          key entry: a Cache_key naming the source
+ *                          file's identity and its data fingerprint
+ * Data entries are sized to a multiple of the directory's block size so
+ * that hugetlbfs mounts, which only accept whole huge pages, work too.
+ *
+ * Entries are built under a temporary name and renamed into place when
+ * complete, so a reader never maps a partially written matrix and two
+ * runs publishing the same matrix at once are harmless.
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/vfs.h>
+#include "mat_cache.h"
+#include "mat_hash.h"
+
+#define CACHE_MAGIC 0x3248434143564d50ULL    /* "PMVCACH2" */
+#define CACHE_HEADER_BYTES 4096
+
+/* Header of a data entry */
+typedef struct {
+    unsigned long long magic;
+    unsigned long long hash;   /* content fingerprint */
+    int rows, cols;
+    size_t map_bytes;          /* size of the whole entry */
+} Cache_header;
+
+/* Key entry: identity of a source file and its fingerprint */
+typedef struct {
+    unsigned long long magic;
+    long long file_size;
+    long long mtime_sec;
+    long long mtime_nsec;
+    unsigned long long hash;   /* fingerprint of the file's data */
+    char path[PATH_MAX];       /* canonical path of the source */
+} Cache_key;
+
+/* Function prototypes */
+unsigned long long Hash_bytes(unsigned long long h, const void* data, size_t bytes);
+int Cache_key_name(char* filename, char* cache_dir, Cache_key* key, char* name, size_t len);
+int Cache_data_name(char* cache_dir, unsigned long long hash, char* name, size_t len);
+int Cache_read_key(char* name, Cache_key* key);
+int Cache_write_key(char* name, Cache_key* key);
+double* Cache_attach(char* name, unsigned long long hash);
+double* Cache_publish(char* filename, char* cache_dir, int thread_count, unsigned long long* hash_p);
+
+/*-------------------------------------------------------------------
+ * Function:  Cache_load_matrix
+ * Purpose:   Map a matrix from the cache, publishing it first when it
+ *            is not cached yet
+*/
+int Cache_load_matrix(char* filename, char* cache_dir, int thread_count,
+                      double** A_p, int* m_p, int* n_p) {
+    Cache_key key;
+    char key_name[PATH_MAX], data_name[PATH_MAX];
+    Cache_header* header;
+    double* A = NULL;
+
+    if (cache_dir == NULL) cache_dir = CACHE_DEFAULT_DIR;
+    if (Cache_key_name(filename, cache_dir, &key, key_name, sizeof(key_name)) != 0) return -1;
+
+    /* Fast path: file seen before and its data entry still present */
+    if (Cache_read_key(key_name, &key) == 0 &&
+        Cache_data_name(cache_dir, key.hash, data_name, sizeof(data_name)) == 0) {
+        A = Cache_attach(data_name, key.hash);
+    }
+
+    /* Read the file into the cache, sharing an existing identical entry */
+    if (A == NULL) {
+        A = Cache_publish(filename, cache_dir, thread_count, &key.hash);
+        if (A == NULL) return -1;
+        Cache_write_key(key_name, &key);
+    }
+
+    header = (Cache_header*)((char*)A - CACHE_HEADER_BYTES);
+    *A_p = A;
+    *m_p = header->rows;
+    *n_p = header->cols;
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Cache_lookup_hash
+ * Purpose:   Fingerprint of a previously published file, if known
+*/
+int Cache_lookup_hash(char* filename, char* cache_dir, unsigned long long* hash_p) {
+    Cache_key key;
+    char key_name[PATH_MAX];
+
+    if (cache_dir == NULL) cache_dir = CACHE_DEFAULT_DIR;
+    if (Cache_key_name(filename, cache_dir, &key, key_name, sizeof(key_name)) != 0 ||
+        Cache_read_key(key_name, &key) != 0) {
+        return -1;
+    }
+    *hash_p = key.hash;
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Cache_matrix_hash
+ * Purpose:   Fingerprint of a matrix returned by Cache_load_matrix
+*/
+unsigned long long Cache_matrix_hash(double* A) {
+    return ((Cache_header*)((char*)A - CACHE_HEADER_BYTES))->hash;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Cache_release
+ * Purpose:   Unmap a matrix returned by Cache_load_matrix
+*/
+void Cache_release(double* A) {
+    Cache_header* header;
+
+    if (A == NULL) return;
+    header = (Cache_header*)((char*)A - CACHE_HEADER_BYTES);
+    munmap(header, header->map_bytes);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Hash_bytes
+ * Purpose:   64-bit FNV-1a hash, continuing from h
+*/
+unsigned long long Hash_bytes(unsigned long long h, const void* data, size_t bytes) {
+    const unsigned char* p = (const unsigned char*)data;
+    size_t i;
+
+    for (i = 0; i < bytes; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Cache_key_name
+ * Purpose:   Identify the source file and build its key entry name
+ * In args:   filename, cache_dir
+ * Out args:  key (identity fields), name
+ * Return:    0 on success, -1 on error
+*/
+int Cache_key_name(char* filename, char* cache_dir, Cache_key* key, char* name, size_t len) {
+    struct stat st;
+    unsigned long long h = 0xcbf29ce484222325ULL;
+
+    memset(key, 0, sizeof(*key));
+    if (realpath(filename, key->path) == NULL || stat(key->path, &st) != 0) return -1;
+    key->magic = CACHE_MAGIC;
+    key->file_size = st.st_size;
+    key->mtime_sec = st.st_mtim.tv_sec;
+    key->mtime_nsec = st.st_mtim.tv_nsec;
+
+    h = Hash_bytes(h, key->path, strlen(key->path));
+    h = Hash_bytes(h, &key->file_size, sizeof(key->file_size));
+    h = Hash_bytes(h, &key->mtime_sec, sizeof(key->mtime_sec));
+    h = Hash_bytes(h, &key->mtime_nsec, sizeof(key->mtime_nsec));
+
+    if (snprintf(name, len, "%s/pthmv-k-%016llx", cache_dir, h) >= (int)len) return -1;
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Cache_data_name
+ * Purpose:   Build the data entry name for a fingerprint
+ * Return:    0 on success, -1 if the name does not fit
+*/
+int Cache_data_name(char* cache_dir, unsigned long long hash, char* name, size_t len) {
+    if (snprintf(name, len, "%s/pthmv-c-%016llx", cache_dir, hash) >= (int)len) return -1;
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Cache_read_key
+ * Purpose:   Read a key entry and check it still describes the file
+ * In/out:    key (identity in, fingerprint out)
+ * Return:    0 if the entry matches, -1 otherwise
+*/
+int Cache_read_key(char* name, Cache_key* key) {
+    FILE* fp;
+    Cache_key stored;
+    int ok;
+
+    fp = fopen(name, "rb");
+    if (fp == NULL) return -1;
+    ok = fread(&stored, sizeof(stored), 1, fp) == 1;
+    fclose(fp);
+
+    if (!ok || stored.magic != CACHE_MAGIC || stored.file_size != key->file_size ||
+        stored.mtime_sec != key->mtime_sec || stored.mtime_nsec != key->mtime_nsec ||
+        strcmp(stored.path, key->path) != 0) {
+        return -1;
+    }
+    key->hash = stored.hash;
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Cache_write_key
+ * Purpose:   Publish a key entry atomically
+ * Return:    0 on success, -1 on error
+*/
+int Cache_write_key(char* name, Cache_key* key) {
+    FILE* fp;
+    char tmp_name[PATH_MAX];
+
+    if (snprintf(tmp_name, sizeof(tmp_name), "%s.%d", name, (int)getpid()) >= (int)sizeof(tmp_name)) {
+        return -1;
+    }
+    fp = fopen(tmp_name, "wb");
+    if (fp == NULL) return -1;
+    if (fwrite(key, sizeof(*key), 1, fp) != 1 || fclose(fp) != 0 ||
+        rename(tmp_name, name) != 0) {
+        unlink(tmp_name);
+        return -1;
+    }
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Cache_attach
+ * Purpose:   Map an existing data entry read-only
+ * In args:   name, hash (expected fingerprint)
+ * Return:    pointer to the matrix data, or NULL if the entry is
+ *            missing or invalid
+*/
+double* Cache_attach(char* name, unsigned long long hash) {
+    int fd;
+    struct stat st;
+    Cache_header* header;
+    void* base;
+
+    fd = open(name, O_RDONLY);
+    if (fd < 0) return NULL;
+    if (fstat(fd, &st) != 0 || st.st_size < CACHE_HEADER_BYTES) {
+        close(fd);
+        return NULL;
+    }
+    base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return NULL;
+
+    header = (Cache_header*)base;
+    if (header->magic != CACHE_MAGIC || header->hash != hash ||
+        header->map_bytes != (size_t)st.st_size ||
+        CACHE_HEADER_BYTES + (size_t)header->rows * header->cols * sizeof(double) > header->map_bytes) {
+        munmap(base, st.st_size);
+        return NULL;
+    }
+    return (double*)((char*)base + CACHE_HEADER_BYTES);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Cache_publish
+ * Purpose:   Read a matrix file straight into a new data entry, then
+ *            fingerprint it. If an entry with the same contents exists
+ *            already, the new copy is dropped and the existing one used.
+ * In args:   filename, cache_dir, thread_count
+ * Out arg:   hash_p (fingerprint)
+ * Return:    pointer to the mapped matrix data, or NULL on error
+*/
+double* Cache_publish(char* filename, char* cache_dir, int thread_count, unsigned long long* hash_p) {
+    FILE* fp;
+    int fd, rows, cols;
+    char tmp_name[PATH_MAX], name[PATH_MAX];
+    struct statfs sfs;
+    size_t data_bytes, map_bytes, block;
+    Cache_header* header;
+    double *data, *shared;
+    void* base;
+
+    /* Read dimensions */
+    fp = fopen(filename, "rb");
+    if (fp == NULL) return NULL;
+    if (fread(&rows, sizeof(int), 1, fp) != 1 ||
+        fread(&cols, sizeof(int), 1, fp) != 1 ||
+        rows <= 0 || cols <= 0) {
+        fclose(fp);
+        return NULL;
+    }
+    data_bytes = (size_t)rows * cols * sizeof(double);
+
+    /* Create the entry under a temporary name */
+    if (snprintf(tmp_name, sizeof(tmp_name), "%s/pthmv-tmp.%d", cache_dir, (int)getpid()) >= (int)sizeof(tmp_name)) {
+        fclose(fp);
+        return NULL;
+    }
+    fd = open(tmp_name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        fclose(fp);
+        return NULL;
+    }
+
+    /* Round up to the directory's block size (huge page on hugetlbfs) */
+    block = fstatfs(fd, &sfs) == 0 && sfs.f_bsize > 0 ? (size_t)sfs.f_bsize : 4096;
+    map_bytes = (CACHE_HEADER_BYTES + data_bytes + block - 1) / block * block;
+
+    if (ftruncate(fd, map_bytes) != 0) {
+        close(fd);
+        unlink(tmp_name);
+        fclose(fp);
+        return NULL;
+    }
+    base = mmap(NULL, map_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        unlink(tmp_name);
+        fclose(fp);
+        return NULL;
+    }
+
+    /* Read the data directly into the shared pages */
+    data = (double*)((char*)base + CACHE_HEADER_BYTES);
+    if (fread(data, 1, data_bytes, fp) != data_bytes) {
+        munmap(base, map_bytes);
+        unlink(tmp_name);
+        fclose(fp);
+        return NULL;
+    }
+    fclose(fp);
+
+    header = (Cache_header*)base;
+    header->magic = CACHE_MAGIC;
+    header->hash = Hash_matrix(data, rows, cols, thread_count);
+    header->rows = rows;
+    header->cols = cols;
+    header->map_bytes = map_bytes;
+    *hash_p = header->hash;
+
+    if (Cache_data_name(cache_dir, header->hash, name, sizeof(name)) != 0) {
+        munmap(base, map_bytes);
+        unlink(tmp_name);
+        return NULL;
+    }
+
+    /* Identical contents already resident: keep that copy */
+    shared = Cache_attach(name, header->hash);
+    if (shared != NULL) {
+        Cache_header* other = (Cache_header*)((char*)shared - CACHE_HEADER_BYTES);
+        int same = other->rows == rows && other->cols == cols &&
+                   memcmp(shared, data, data_bytes) == 0;
+        munmap(base, map_bytes);
+        unlink(tmp_name);
+        if (!same) {
+            /* Fingerprint collision: refuse rather than share wrong data */
+            Cache_release(shared);
+            return NULL;
+        }
+        return shared;
+    }
+
+    /* Publish atomically and hand out a read-only mapping */
+    munmap(base, map_bytes);
+    if (rename(tmp_name, name) != 0) {
+        unlink(tmp_name);
+        return NULL;
+    }
+    return Cache_attach(name, *hash_p);
+}
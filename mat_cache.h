@@ -0,0 +1,57 @@
+/**
+ * @file mat_cache.h
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Persistent shared-memory cache for binary matrix files.
+ *
+ * A matrix loaded through the cache is published as a file in a
+ * memory-backed directory (/dev/shm by default, or a hugetlbfs mount).
+ * Later runs on the same unchanged file map the published copy read-only
+ * instead of reading the file, so startup costs a single mmap.
+ *
+ * Entries are content-addressed: the data entry is named by a content
+ * fingerprint (mat_hash.h), and a small key entry maps a matrix file's
+ * path, modification time and size to that fingerprint. Matrix files
+ * with identical contents under different paths therefore share one
+ * resident copy, whichever program (pth_matrix_vector, the server or the
+ * batch runner) loaded them.
+ *
+ * Entries live until the directory is cleaned or the host reboots;
+ * remove them with: rm /dev/shm/pthmv-*
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#ifndef _MAT_CACHE_H_
+#define _MAT_CACHE_H_
+
+#define CACHE_DEFAULT_DIR "/dev/shm"
+
+/* Cache_load_matrix: map a matrix from the cache, publishing it first
+ * when it is not cached yet
+ * filename:  binary matrix file
+ * cache_dir: directory for cache entries, NULL for CACHE_DEFAULT_DIR
+ * thread_count: threads used to fingerprint a newly read matrix
+ * A_p, m_p, n_p: out, read-only matrix data and dimensions
+ * Returns: 0 on success, -1 on error. A must be released with
+ *          Cache_release, not free.
+*/
+int Cache_load_matrix(char* filename, char* cache_dir, int thread_count,
+                      double** A_p, int* m_p, int* n_p);
+
+/* Cache_lookup_hash: content fingerprint of a matrix file that has
+ * been published before, without reading the file
+ * Returns: 0 and *hash_p if the file is known, -1 otherwise
+*/
+int Cache_lookup_hash(char* filename, char* cache_dir, unsigned long long* hash_p);
+
+/* Cache_matrix_hash: content fingerprint of a mapped cached matrix */
+unsigned long long Cache_matrix_hash(double* A);
+
+/* Cache_release: unmap a matrix returned by Cache_load_matrix */
+void Cache_release(double* A);
+
+#endif /* _MAT_CACHE_H_ */
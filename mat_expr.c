@@ -0,0 +1,500 @@
+/**
+ * @file mat_expr.c
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Evaluator for products of matrices and vectors.
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "quinn.h"
+#include "gemm.h"
+#include "mat_expr.h"
+
+/* Parser state */
+typedef struct {
+    const char* text;
+    const char* pos;
+    Expr* expr;
+} Parser;
+
+/* Work shared with the multiplying threads */
+typedef struct {
+    const double* A;
+    const double* B;
+    double* C;
+    int p, q;
+    int thread_count;
+    long rank;
+} Mult_task;
+
+/* Function prototypes */
+Expr_node* Parse_product(Parser* ps);
+Expr_node* Parse_factor(Parser* ps);
+void Skip_blanks(Parser* ps);
+int Is_name_char(char c);
+Expr_node* New_node(int operand, Expr_node* left, Expr_node* right);
+int Check_dims(Expr* expr, Expr_node* node);
+Expr_node* Build_order(Expr* expr, int* split, int i, int j);
+int Read_operand(Expr_operand* op);
+void* Pth_multiply(void* arg);
+
+/*-------------------------------------------------------------------
+ * Function:  Expr_parse
+ * Purpose:   Parse product := factor ('*' factor)*,
+ *            factor := name | '(' product ')'
+*/
+int Expr_parse(const char* text, Expr* expr) {
+    Parser ps;
+
+    memset(expr, 0, sizeof(*expr));
+    ps.text = text;
+    ps.pos = text;
+    ps.expr = expr;
+
+    expr->written = Parse_product(&ps);
+    if (expr->written != NULL) {
+        Skip_blanks(&ps);
+        if (*ps.pos == '\0') return 0;
+        fprintf(stderr, "Error: Unexpected '%c' at position %d of expression\n",
+                *ps.pos, (int)(ps.pos - text) + 1);
+    }
+    Expr_free(expr);
+    return -1;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Parse_product
+ * Purpose:   Parse factors separated by '*', associating left to right
+*/
+Expr_node* Parse_product(Parser* ps) {
+    Expr_node *node, *right, *product;
+
+    node = Parse_factor(ps);
+    while (node != NULL) {
+        Skip_blanks(ps);
+        if (*ps->pos != '*') break;
+        ps->pos++;
+        right = Parse_factor(ps);
+        if (right == NULL) {
+            Expr_free_tree(node);
+            return NULL;
+        }
+        product = New_node(-1, node, right);
+        if (product == NULL) {
+            Expr_free_tree(node);
+            Expr_free_tree(right);
+            return NULL;
+        }
+        node = product;
+    }
+    return node;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Parse_factor
+ * Purpose:   Parse an operand name or a parenthesized product
+*/
+Expr_node* Parse_factor(Parser* ps) {
+    Expr_node* node;
+    Expr_operand* ops;
+    const char* start;
+    int len;
+
+    Skip_blanks(ps);
+    if (*ps->pos == '(') {
+        ps->pos++;
+        node = Parse_product(ps);
+        if (node == NULL) return NULL;
+        Skip_blanks(ps);
+        if (*ps->pos != ')') {
+            fprintf(stderr, "Error: Expected ')' at position %d of expression\n",
+                    (int)(ps->pos - ps->text) + 1);
+            Expr_free_tree(node);
+            return NULL;
+        }
+        ps->pos++;
+        return node;
+    }
+
+    start = ps->pos;
+    while (Is_name_char(*ps->pos)) ps->pos++;
+    len = (int)(ps->pos - start);
+    if (len == 0) {
+        fprintf(stderr, "Error: Expected a matrix file at position %d of expression\n",
+                (int)(ps->pos - ps->text) + 1);
+        return NULL;
+    }
+
+    /* Append the operand */
+    ops = (Expr_operand*)realloc(ps->expr->operands,
+                                 (ps->expr->num_operands + 1) * sizeof(Expr_operand));
+    if (ops == NULL) return NULL;
+    ps->expr->operands = ops;
+    ops += ps->expr->num_operands;
+    ops->name = (char*)malloc(len + 1);
+    if (ops->name == NULL) return NULL;
+    memcpy(ops->name, start, len);
+    ops->name[len] = '\0';
+    ops->data = NULL;
+    ops->rows = ops->cols = 0;
+
+    node = New_node(ps->expr->num_operands, NULL, NULL);
+    ps->expr->num_operands++;
+    return node;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Skip_blanks / Is_name_char
+ * Purpose:   Lexical helpers
+*/
+void Skip_blanks(Parser* ps) {
+    while (*ps->pos == ' ' || *ps->pos == '\t' || *ps->pos == '\n') ps->pos++;
+}
+
+int Is_name_char(char c) {
+    return c != '\0' && c != ' ' && c != '\t' && c != '\n' &&
+           c != '(' && c != ')' && c != '*';
+}
+
+/*-------------------------------------------------------------------
+ * Function:  New_node
+ * Purpose:   Allocate a tree node
+*/
+Expr_node* New_node(int operand, Expr_node* left, Expr_node* right) {
+    Expr_node* node = (Expr_node*)malloc(sizeof(Expr_node));
+
+    if (node == NULL) return NULL;
+    node->operand = operand;
+    node->left = left;
+    node->right = right;
+    node->rows = node->cols = 0;
+    return node;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Expr_load
+ * Purpose:   Read the operands and check the written tree
+*/
+int Expr_load(Expr* expr) {
+    int k;
+
+    for (k = 0; k < expr->num_operands; k++) {
+        if (Read_operand(&expr->operands[k]) != 0) {
+            fprintf(stderr, "Error: Failed to read matrix from %s\n", expr->operands[k].name);
+            return -1;
+        }
+    }
+    return Check_dims(expr, expr->written);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Check_dims
+ * Purpose:   Fill in node dimensions, reporting the first product whose
+ *            factors do not conform
+*/
+int Check_dims(Expr* expr, Expr_node* node) {
+    if (node->operand >= 0) {
+        node->rows = expr->operands[node->operand].rows;
+        node->cols = expr->operands[node->operand].cols;
+        return 0;
+    }
+    if (Check_dims(expr, node->left) != 0 || Check_dims(expr, node->right) != 0) return -1;
+    if (node->left->cols != node->right->rows) {
+        fprintf(stderr, "Error: Incompatible dimensions for multiplication\n");
+        fprintf(stderr, "  ");
+        Expr_print(stderr, expr, node->left);
+        fprintf(stderr, " is %d x %d, ", node->left->rows, node->left->cols);
+        Expr_print(stderr, expr, node->right);
+        fprintf(stderr, " is %d x %d\n", node->right->rows, node->right->cols);
+        return -1;
+    }
+    node->rows = node->left->rows;
+    node->cols = node->right->cols;
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Expr_optimize
+ * Purpose:   Matrix-chain dynamic program. cost[i][j] is the fewest
+ *            flops to form operands i..j; ties go to the split after
+ *            operand i, so a trailing vector is applied right to left.
+*/
+Expr_node* Expr_optimize(Expr* expr) {
+    int k = expr->num_operands, len, i, j, s;
+    double *cost, c;
+    int *dims, *split;
+    Expr_node* tree;
+
+    cost = (double*)calloc((size_t)k * k, sizeof(double));
+    split = (int*)calloc((size_t)k * k, sizeof(int));
+    dims = (int*)malloc((k + 1) * sizeof(int));
+    if (cost == NULL || split == NULL || dims == NULL) {
+        free(cost);
+        free(split);
+        free(dims);
+        return NULL;
+    }
+
+    /* Operand i is dims[i] x dims[i + 1] */
+    for (i = 0; i < k; i++) dims[i] = expr->operands[i].rows;
+    dims[k] = expr->operands[k - 1].cols;
+
+    for (len = 2; len <= k; len++) {
+        for (i = 0; i + len - 1 < k; i++) {
+            j = i + len - 1;
+            cost[i * k + j] = -1.0;
+            for (s = i; s < j; s++) {
+                c = cost[i * k + s] + cost[(s + 1) * k + j] +
+                    2.0 * dims[i] * dims[s + 1] * dims[j + 1];
+                if (cost[i * k + j] < 0.0 || c < cost[i * k + j]) {
+                    cost[i * k + j] = c;
+                    split[i * k + j] = s;
+                }
+            }
+        }
+    }
+
+    tree = Build_order(expr, split, 0, k - 1);
+    if (tree != NULL && Check_dims(expr, tree) != 0) {
+        Expr_free_tree(tree);
+        tree = NULL;
+    }
+
+    free(cost);
+    free(split);
+    free(dims);
+    return tree;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Build_order
+ * Purpose:   Turn the split table for operands i..j into a tree
+*/
+Expr_node* Build_order(Expr* expr, int* split, int i, int j) {
+    Expr_node *left, *right, *node;
+    int k = expr->num_operands;
+
+    if (i == j) return New_node(i, NULL, NULL);
+
+    left = Build_order(expr, split, i, split[i * k + j]);
+    right = Build_order(expr, split, split[i * k + j] + 1, j);
+    node = left == NULL || right == NULL ? NULL : New_node(-1, left, right);
+    if (node == NULL) {
+        Expr_free_tree(left);
+        Expr_free_tree(right);
+    }
+    return node;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Expr_flops
+ * Purpose:   Sum 2pqr over the products of a tree
+*/
+double Expr_flops(Expr_node* node) {
+    if (node->operand >= 0) return 0.0;
+    return Expr_flops(node->left) + Expr_flops(node->right) +
+           2.0 * node->left->rows * node->left->cols * node->right->cols;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Expr_eval
+ * Purpose:   Evaluate a tree bottom up, freeing intermediates as soon
+ *            as they have been used
+*/
+int Expr_eval(Expr* expr, Expr_node* node, int thread_count,
+              double** result_p, double* flops_p) {
+    double *left = NULL, *right = NULL, *C;
+    const double *A, *B;
+    double left_flops = 0.0, right_flops = 0.0;
+    size_t count;
+    int status = -1;
+
+    *flops_p = 0.0;
+
+    /* A lone operand: copy it so the caller always owns the result */
+    if (node->operand >= 0) {
+        Expr_operand* op = &expr->operands[node->operand];
+        count = (size_t)op->rows * op->cols;
+        C = (double*)malloc(count * sizeof(double));
+        if (C == NULL) return -1;
+        memcpy(C, op->data, count * sizeof(double));
+        *result_p = C;
+        return 0;
+    }
+
+    /* Operands are used in place, subproducts evaluated first */
+    if (node->left->operand >= 0) A = expr->operands[node->left->operand].data;
+    else if (Expr_eval(expr, node->left, thread_count, &left, &left_flops) != 0) return -1;
+    else A = left;
+
+    if (node->right->operand >= 0) B = expr->operands[node->right->operand].data;
+    else if (Expr_eval(expr, node->right, thread_count, &right, &right_flops) != 0) {
+        free(left);
+        return -1;
+    }
+    else B = right;
+
+    C = (double*)malloc((size_t)node->rows * node->cols * sizeof(double));
+    if (C != NULL &&
+        Expr_multiply(A, B, C, node->left->rows, node->left->cols,
+                      node->right->cols, thread_count) == 0) {
+        *result_p = C;
+        *flops_p = left_flops + right_flops +
+                   2.0 * node->left->rows * node->left->cols * node->right->cols;
+        status = 0;
+    } else {
+        free(C);
+    }
+
+    free(left);
+    free(right);
+    return status;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Expr_multiply
+ * Purpose:   Threaded C = A * B: the packed GEMM engine for matrix
+ *            products, row blocks of dot products for a vector B
+*/
+int Expr_multiply(const double* A, const double* B, double* C,
+                  int p, int q, int r, int thread_count) {
+    pthread_t* thread_handles;
+    Mult_task* tasks;
+    long thread;
+
+    if (r > 1) return Gemm(p, r, q, A, q, B, r, C, r, thread_count);
+
+    if (thread_count > p) thread_count = p;
+    thread_handles = (pthread_t*)malloc(thread_count * sizeof(pthread_t));
+    tasks = (Mult_task*)malloc(thread_count * sizeof(Mult_task));
+    if (thread_handles == NULL || tasks == NULL) {
+        free(thread_handles);
+        free(tasks);
+        return -1;
+    }
+
+    for (thread = 0; thread < thread_count; thread++) {
+        tasks[thread].A = A;
+        tasks[thread].B = B;
+        tasks[thread].C = C;
+        tasks[thread].p = p;
+        tasks[thread].q = q;
+        tasks[thread].thread_count = thread_count;
+        tasks[thread].rank = thread;
+        pthread_create(&thread_handles[thread], NULL, Pth_multiply, &tasks[thread]);
+    }
+    for (thread = 0; thread < thread_count; thread++) {
+        pthread_join(thread_handles[thread], NULL);
+    }
+
+    free(thread_handles);
+    free(tasks);
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Pth_multiply
+ * Purpose:   Thread function: compute this thread's block of rows of
+ *            a matrix-vector product
+*/
+void* Pth_multiply(void* arg) {
+    Mult_task* t = (Mult_task*)arg;
+    int i, k;
+    int first_row = BLOCK_LOW(t->rank, t->thread_count, t->p);
+    int last_row = BLOCK_HIGH(t->rank, t->thread_count, t->p);
+
+    for (i = first_row; i <= last_row; i++) {
+        const double* a = t->A + (size_t)i * t->q;
+        double sum = 0.0;
+        for (k = 0; k < t->q; k++) {
+            sum += a[k] * t->B[k];
+        }
+        t->C[i] = sum;
+    }
+    return NULL;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Expr_print
+ * Purpose:   Print a tree with every product parenthesized
+*/
+void Expr_print(FILE* fp, Expr* expr, Expr_node* node) {
+    if (node->operand >= 0) {
+        fprintf(fp, "%s", expr->operands[node->operand].name);
+        return;
+    }
+    fprintf(fp, "(");
+    Expr_print(fp, expr, node->left);
+    fprintf(fp, " * ");
+    Expr_print(fp, expr, node->right);
+    fprintf(fp, ")");
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Read_operand
+ * Purpose:   Read a binary matrix file into an operand
+*/
+int Read_operand(Expr_operand* op) {
+    FILE* fp;
+    int rows, cols;
+    double* A;
+
+    fp = fopen(op->name, "rb");
+    if (fp == NULL) return -1;
+
+    if (fread(&rows, sizeof(int), 1, fp) != 1 ||
+        fread(&cols, sizeof(int), 1, fp) != 1 ||
+        rows <= 0 || cols <= 0) {
+        fclose(fp);
+        return -1;
+    }
+
+    A = (double*)malloc((size_t)rows * cols * sizeof(double));
+    if (A == NULL) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (fread(A, sizeof(double), (size_t)rows * cols, fp) != (size_t)rows * cols) {
+        free(A);
+        fclose(fp);
+        return -1;
+    }
+
+    fclose(fp);
+    op->data = A;
+    op->rows = rows;
+    op->cols = cols;
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Expr_free_tree / Expr_free
+ * Purpose:   Release a tree / an expression with its operands
+*/
+void Expr_free_tree(Expr_node* node) {
+    if (node == NULL) return;
+    Expr_free_tree(node->left);
+    Expr_free_tree(node->right);
+    free(node);
+}
+
+void Expr_free(Expr* expr) {
+    int k;
+
+    for (k = 0; k < expr->num_operands; k++) {
+        free(expr->operands[k].name);
+        free(expr->operands[k].data);
+    }
+    free(expr->operands);
+    Expr_free_tree(expr->written);
+    memset(expr, 0, sizeof(*expr));
+}
@@ -0,0 +1,93 @@
+/**
+ * @file mat_expr.h
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Evaluator for products of matrices and vectors.
+ *
+ * An expression is a product of binary matrix files, optionally
+ * parenthesized, e.g. "(A.mat * B.mat) * x.mat". Operand names are any
+ * run of characters other than blanks, '(', ')' and '*'. Parentheses
+ * give the order as written; products without them associate left to
+ * right.
+ *
+ * Since the product is associative, the evaluator may choose its own
+ * order: Expr_optimize finds the order with the fewest flops using the
+ * classic matrix-chain dynamic program over the operand dimensions.
+ * With a vector at the right end this reduces to repeated matrix-vector
+ * products, never forming a matrix-matrix product.
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#ifndef _MAT_EXPR_H_
+#define _MAT_EXPR_H_
+
+#include <stdio.h>
+
+/* A node of an evaluation tree: an operand or a product of two nodes */
+typedef struct Expr_node {
+    int operand;                /* operand index, -1 for a product */
+    struct Expr_node* left;
+    struct Expr_node* right;
+    int rows, cols;             /* dimensions of the node's value */
+} Expr_node;
+
+/* One matrix or vector of the expression */
+typedef struct {
+    char* name;                 /* file name */
+    double* data;               /* row-major, NULL until loaded */
+    int rows, cols;
+} Expr_operand;
+
+/* A parsed expression */
+typedef struct {
+    int num_operands;
+    Expr_operand* operands;     /* in left-to-right order */
+    Expr_node* written;         /* tree in the order as written */
+} Expr;
+
+/* Expr_parse: parse an expression; operands are not read yet
+ * Returns: 0 on success, -1 on a syntax error (reported to stderr)
+*/
+int Expr_parse(const char* text, Expr* expr);
+
+/* Expr_load: read every operand and check that the written tree is
+ * conformable, filling in node dimensions
+ * Returns: 0 on success, -1 on error (reported to stderr)
+*/
+int Expr_load(Expr* expr);
+
+/* Expr_optimize: tree with the minimum-flop evaluation order
+ * Returns: new tree (free with Expr_free_tree), NULL on error
+*/
+Expr_node* Expr_optimize(Expr* expr);
+
+/* Expr_flops: estimated flops to evaluate a tree (2pqr per product) */
+double Expr_flops(Expr_node* node);
+
+/* Expr_eval: evaluate a tree with a team of threads per product
+ * result_p:  out, newly allocated row-major result
+ * flops_p:   out, flops actually performed
+ * Returns: 0 on success, -1 on allocation failure
+*/
+int Expr_eval(Expr* expr, Expr_node* node, int thread_count,
+              double** result_p, double* flops_p);
+
+/* Expr_multiply: C = A * B for A p x q and B q x r, with Gemm (gemm.h)
+ * when r > 1 and rows of C divided among threads otherwise
+ * Returns: 0 on success, -1 on error
+*/
+int Expr_multiply(const double* A, const double* B, double* C,
+                  int p, int q, int r, int thread_count);
+
+/* Expr_print: print a tree fully parenthesized */
+void Expr_print(FILE* fp, Expr* expr, Expr_node* node);
+
+/* Expr_free_tree / Expr_free: release a tree / an expression */
+void Expr_free_tree(Expr_node* node);
+void Expr_free(Expr* expr);
+
+#endif /* _MAT_EXPR_H_ */
@@ -0,0 +1,130 @@
+/**
+ * @file mat_format.h
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Binary file formats for structured matrices.
+ *
+ * A dense .mat file starts with its number of rows, which is positive.
+ * Structured formats start with a negative format magic instead, so
+ * readers of dense files reject them cleanly and programs that accept
+ * several formats can dispatch on the first int.
+ *
+ * Toeplitz (MAT_FORMAT_TOEPLITZ):
+ *   - Toeplitz_header
+ *   - kind MAT_TOEPLITZ: first column (rows doubles), then first row
+ *     (cols doubles); A[i][j] = col[i - j] for i >= j, row[j - i] otherwise
+ *   - kind MAT_CIRCULANT: square, first column only (rows doubles);
+ *     A[i][j] = col[(i - j) mod n]
+ *
+ * CSR, compressed sparse rows (MAT_FORMAT_CSR):
+ *   - Sparse_header
+ *   - row_ptr: rows + 1 longs; row i's entries are row_ptr[i] .. row_ptr[i+1]-1
+ *   - col_idx: nnz ints, increasing within each row
+ *   - values:  nnz doubles
+ * CSC, compressed sparse columns (MAT_FORMAT_CSC): as CSR with the
+ * roles of rows and columns swapped
+ *   - Sparse_header
+ *   - col_ptr: cols + 1 longs
+ *   - row_idx: nnz ints, increasing within each column
+ *   - values:  nnz doubles
+ *
+ * Sparse vector (MAT_FORMAT_SPVEC), a rows x 1 column vector:
+ *   - Sparse_header with cols = 1
+ *   - index:  nnz ints, increasing
+ *   - values: nnz doubles
+ *
+ * DCSR, delta-compressed CSR (MAT_FORMAT_DCSR), see sparse.h:
+ *   - Sparse_header
+ *   - row_ptr:   rows + 1 longs, into the values
+ *   - code_ptr:  rows + 1 longs, into the code
+ *   - first_col: rows ints, the first column of each row
+ *   - code:      code_ptr[rows] bytes, the gaps between each row's columns
+ *   - values:    nnz doubles
+ *
+ * Codebook (MAT_FORMAT_CODEBOOK), values coded into per-panel tables,
+ * see codebook.h:
+ *   - Codebook_header
+ *   - tables: CEILING(rows, panel_rows) tables of 1 << bits doubles;
+ *     rows i .. i + panel_rows - 1 of panel i / panel_rows use its table
+ *   - codes:  rows x row_bytes bytes, row_bytes = cols for 8-bit codes
+ *     and (cols + 1) / 2 for 4-bit codes, two to a byte, low nibble first
+ *
+ * Bit matrix (MAT_FORMAT_BITMAT), entries in {0, 1} or {-1, 0, 1}, see
+ * bitmat.h; rows are words = CEILING(cols, 64) 64-bit words, bit j % 64
+ * of word j / 64 for column j, unused bits 0:
+ *   - Bitmat_header
+ *   - plus:  rows x words words, set where A[i][j] = 1
+ *   - minus: kind BITMAT_TERNARY only, rows x words words, set where
+ *     A[i][j] = -1
+ *
+ * COO, coordinate triplets (MAT_FORMAT_COO), in any order, possibly
+ * with repeated (row, col) pairs:
+ *   - Sparse_header
+ *   - nnz Coo_entry triplets
+ *
+ * Entries that are not stored are the zero of whatever semiring the
+ * matrix is used with (semiring.h).
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#ifndef _MAT_FORMAT_H_
+#define _MAT_FORMAT_H_
+
+/* Format magics: the first int of a structured matrix file */
+#define MAT_FORMAT_DENSE       0   /* not a magic: a plain .mat file */
+#define MAT_FORMAT_TOEPLITZ   -1
+#define MAT_FORMAT_CSR        -2
+#define MAT_FORMAT_CSC        -3
+#define MAT_FORMAT_SPVEC      -4
+#define MAT_FORMAT_COO        -5
+#define MAT_FORMAT_DCSR       -6
+#define MAT_FORMAT_CODEBOOK   -7
+#define MAT_FORMAT_BITMAT     -8
+#define MAT_FORMAT_INVALID     1   /* not a magic: unreadable file */
+
+/* Toeplitz kinds */
+#define MAT_TOEPLITZ   0
+#define MAT_CIRCULANT  1
+
+/* Header of a Toeplitz file */
+typedef struct {
+    int magic;         /* MAT_FORMAT_TOEPLITZ */
+    int rows, cols;
+    int kind;          /* MAT_TOEPLITZ or MAT_CIRCULANT */
+} Toeplitz_header;
+
+/* Header of a codebook file */
+typedef struct {
+    int magic;         /* MAT_FORMAT_CODEBOOK */
+    int rows, cols;
+    int bits;          /* 4 or 8 per code */
+    int panel_rows;    /* rows per table */
+    int reserved;      /* 0 */
+} Codebook_header;
+
+/* Header of a bit matrix file */
+typedef struct {
+    int magic;         /* MAT_FORMAT_BITMAT */
+    int rows, cols;
+    int kind;          /* BITMAT_BINARY or BITMAT_TERNARY */
+} Bitmat_header;
+
+/* Header of a sparse file */
+typedef struct {
+    int magic;         /* MAT_FORMAT_CSR, _CSC, _SPVEC, _COO or _DCSR */
+    int rows, cols;
+    int reserved;      /* 0 */
+    long nnz;          /* stored entries */
+} Sparse_header;
+
+/* One triplet of a COO file */
+typedef struct {
+    int row, col;
+    double val;
+} Coo_entry;
+
+#endif /* _MAT_FORMAT_H_ */
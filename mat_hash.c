@@ -0,0 +1,141 @@
+/**
+ * @file mat_hash.c
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Parallel content fingerprint of a matrix.
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "quinn.h"
+#include "mat_hash.h"
+
+#define HASH_CHUNK 131072    /* doubles per chunk (1 MB) */
+
+#define ROTL64(v,r) (((v) << (r)) | ((v) >> (64 - (r))))
+
+/* Work shared with the hashing threads */
+typedef struct {
+    const double* data;
+    size_t count;
+    size_t num_chunks;
+    unsigned long long* chunk_hash;
+    int thread_count;
+    long rank;
+} Hash_task;
+
+/* Function prototypes */
+unsigned long long Hash_chunk(const double* data, size_t count, size_t index);
+unsigned long long Hash_mix(unsigned long long h);
+void* Pth_hash(void* arg);
+
+/*-------------------------------------------------------------------
+ * Function:  Hash_matrix
+ * Purpose:   Fingerprint a matrix with a team of threads
+*/
+unsigned long long Hash_matrix(const double* A, int rows, int cols, int thread_count) {
+    size_t count = (size_t)rows * cols;
+    size_t num_chunks = (count + HASH_CHUNK - 1) / HASH_CHUNK, k;
+    unsigned long long h, dims;
+    unsigned long long* chunk_hash;
+    pthread_t* thread_handles;
+    Hash_task* tasks;
+    long thread;
+
+    if (thread_count > (long)num_chunks) thread_count = (int)num_chunks;
+    if (thread_count < 1) thread_count = 1;
+
+    chunk_hash = (unsigned long long*)malloc((num_chunks + 1) * sizeof(unsigned long long));
+    thread_handles = (pthread_t*)malloc(thread_count * sizeof(pthread_t));
+    tasks = (Hash_task*)malloc(thread_count * sizeof(Hash_task));
+
+    dims = ((unsigned long long)rows << 32) | (unsigned int)cols;
+    h = Hash_mix(dims);
+
+    if (chunk_hash == NULL || thread_handles == NULL || tasks == NULL) {
+        /* Out of memory: hash serially, same result */
+        for (k = 0; k < num_chunks; k++) {
+            h = Hash_mix(ROTL64(h, 27) ^ Hash_chunk(A, count, k));
+        }
+        free(chunk_hash);
+        free(thread_handles);
+        free(tasks);
+        return h;
+    }
+
+    for (thread = 0; thread < thread_count; thread++) {
+        tasks[thread].data = A;
+        tasks[thread].count = count;
+        tasks[thread].num_chunks = num_chunks;
+        tasks[thread].chunk_hash = chunk_hash;
+        tasks[thread].thread_count = thread_count;
+        tasks[thread].rank = thread;
+        pthread_create(&thread_handles[thread], NULL, Pth_hash, &tasks[thread]);
+    }
+    for (thread = 0; thread < thread_count; thread++) {
+        pthread_join(thread_handles[thread], NULL);
+    }
+
+    /* Combine chunk hashes in order */
+    for (k = 0; k < num_chunks; k++) {
+        h = Hash_mix(ROTL64(h, 27) ^ chunk_hash[k]);
+    }
+
+    free(chunk_hash);
+    free(thread_handles);
+    free(tasks);
+    return h;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Hash_chunk
+ * Purpose:   Hash chunk index of the data, word by word
+*/
+unsigned long long Hash_chunk(const double* data, size_t count, size_t index) {
+    size_t first = index * HASH_CHUNK;
+    size_t last = MIN(first + HASH_CHUNK, count);
+    unsigned long long h = 0x9e3779b97f4a7c15ULL * (index + 1), w;
+    size_t i;
+
+    for (i = first; i < last; i++) {
+        memcpy(&w, &data[i], sizeof(w));
+        h ^= w * 0x87c37b91114253d5ULL;
+        h = ROTL64(h, 31) * 0x4cf5ad432745937fULL;
+    }
+    return Hash_mix(h ^ (last - first));
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Hash_mix
+ * Purpose:   64-bit finalizer (MurmurHash3 fmix64)
+*/
+unsigned long long Hash_mix(unsigned long long h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Pth_hash
+ * Purpose:   Thread function: hash this thread's block of chunks
+*/
+void* Pth_hash(void* arg) {
+    Hash_task* task = (Hash_task*)arg;
+    size_t k;
+    size_t first = BLOCK_LOW(task->rank, task->thread_count, task->num_chunks);
+    size_t last = BLOCK_HIGH(task->rank, task->thread_count, task->num_chunks);
+
+    for (k = first; k <= last && k < task->num_chunks; k++) {
+        task->chunk_hash[k] = Hash_chunk(task->data, task->count, k);
+    }
+    return NULL;
+}
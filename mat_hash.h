@@ -0,0 +1,26 @@
+/**
+ * @file mat_hash.h
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Parallel content fingerprint of a matrix.
+ *
+ * The fingerprint covers the dimensions and every element. The data is
+ * hashed in fixed-size chunks that threads process independently, and
+ * the chunk hashes are combined in order, so the result does not depend
+ * on the number of threads.
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#ifndef _MAT_HASH_H_
+#define _MAT_HASH_H_
+
+/* Hash_matrix: 64-bit content fingerprint of a rows x cols matrix,
+ * computed with up to thread_count threads
+*/
+unsigned long long Hash_matrix(const double* A, int rows, int cols, int thread_count);
+
+#endif /* _MAT_HASH_H_ */
@@ -0,0 +1,152 @@
+/**
+ * @file mat_io.c
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Panel-wise matrix file reads with page-cache policies.
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "mat_io.h"
+
+const char* policy_names[] = {"default", "willneed", "dontneed", "keep"};
+
+/*-------------------------------------------------------------------
+ * Function:  Io_parse_policy
+ * Purpose:   Map a policy name to its number
+*/
+int Io_parse_policy(const char* name) {
+    int p;
+
+    for (p = IO_POLICY_DEFAULT; p <= IO_POLICY_KEEP; p++) {
+        if (strcmp(name, policy_names[p]) == 0) return p;
+    }
+    return -1;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Io_policy_name
+ * Purpose:   Map a policy number to its name
+*/
+const char* Io_policy_name(int policy) {
+    if (policy < IO_POLICY_DEFAULT || policy > IO_POLICY_KEEP) return "unknown";
+    return policy_names[policy];
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Io_parse_megabytes
+ * Purpose:   Parse a positive whole number of MB into bytes
+*/
+int Io_parse_megabytes(const char* text, size_t* bytes_p) {
+    char* end;
+    long mb;
+
+    errno = 0;
+    mb = strtol(text, &end, 10);
+    if (errno != 0 || end == text || *end != '\0' || mb <= 0 ||
+        (unsigned long)mb > (SIZE_MAX >> 20)) {
+        return -1;
+    }
+    *bytes_p = (size_t)mb << 20;
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Io_read_panels
+ * Purpose:   Read a region of a file in panels, advising the kernel
+ *            about each panel according to policy
+ * In args:   fd, bytes, offset, policy, panel_bytes
+ * Out arg:   buf
+ * Return:    0 on success, -1 on error or short file
+*/
+int Io_read_panels(int fd, void* buf, size_t bytes, off_t offset, int policy, size_t panel_bytes) {
+    char* p = (char*)buf;
+    size_t done = 0, start, len;
+    ssize_t got;
+
+    if (panel_bytes == 0) panel_bytes = IO_DEFAULT_PANEL_BYTES;
+
+    if (policy == IO_POLICY_KEEP) {
+        posix_fadvise(fd, offset, bytes, POSIX_FADV_WILLNEED);
+    } else if (policy != IO_POLICY_DEFAULT) {
+        posix_fadvise(fd, offset, bytes, POSIX_FADV_SEQUENTIAL);
+        if (policy == IO_POLICY_WILLNEED) {
+            posix_fadvise(fd, offset, panel_bytes < bytes ? panel_bytes : bytes,
+                          POSIX_FADV_WILLNEED);
+        }
+    }
+
+    while (done < bytes) {
+        start = done;
+        len = bytes - done < panel_bytes ? bytes - done : panel_bytes;
+
+        /* Start fetching the next panel before consuming this one */
+        if (policy == IO_POLICY_WILLNEED && done + len < bytes) {
+            size_t next = bytes - done - len < panel_bytes ? bytes - done - len : panel_bytes;
+            posix_fadvise(fd, offset + done + len, next, POSIX_FADV_WILLNEED);
+        }
+
+        while (len > 0) {
+            got = pread(fd, p + done, len, offset + done);
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) return -1;
+            done += got;
+            len -= got;
+        }
+
+        /* Release the panel just consumed */
+        if (policy == IO_POLICY_DONTNEED) {
+            posix_fadvise(fd, offset + start, done - start, POSIX_FADV_DONTNEED);
+        }
+    }
+
+    /* Pages still under readahead I/O when their panel was released
+       stay cached; sweep the whole region once more */
+    if (policy == IO_POLICY_DONTNEED) {
+        posix_fadvise(fd, offset, bytes, POSIX_FADV_DONTNEED);
+    }
+
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Io_resident_fraction
+ * Purpose:   Measure how much of a file is in the page cache
+ * Return:    resident fraction in [0, 1], or -1.0 on error
+*/
+double Io_resident_fraction(int fd) {
+    struct stat st;
+    long page = sysconf(_SC_PAGESIZE);
+    size_t pages, resident = 0, k;
+    unsigned char* vec;
+    void* base;
+
+    if (fstat(fd, &st) != 0 || st.st_size == 0) return -1.0;
+    pages = ((size_t)st.st_size + page - 1) / page;
+
+    base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) return -1.0;
+    vec = (unsigned char*)malloc(pages);
+    if (vec == NULL || mincore(base, st.st_size, vec) != 0) {
+        free(vec);
+        munmap(base, st.st_size);
+        return -1.0;
+    }
+
+    for (k = 0; k < pages; k++) resident += vec[k] & 1;
+
+    free(vec);
+    munmap(base, st.st_size);
+    return (double)resident / pages;
+}
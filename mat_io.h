@@ -0,0 +1,57 @@
+/**
+ * @file mat_io.h
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Panel-wise matrix file reads with page-cache policies.
+ *
+ * Reading a huge matrix once through the page cache evicts everything
+ * else on the host. These helpers read the data in panels and advise
+ * the kernel per panel according to a policy:
+ *   default   no advice, kernel readahead heuristics
+ *   willneed  start readahead of the next panel while reading this one
+ *   dontneed  drop each panel from the page cache once it has been read
+ *   keep      prefetch the whole file up front and leave it resident
+ *             for repeated runs
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#ifndef _MAT_IO_H_
+#define _MAT_IO_H_
+
+#include <sys/types.h>
+
+#define IO_POLICY_DEFAULT  0
+#define IO_POLICY_WILLNEED 1
+#define IO_POLICY_DONTNEED 2
+#define IO_POLICY_KEEP     3
+
+#define IO_DEFAULT_PANEL_BYTES (64UL << 20)
+
+/* Io_parse_policy: policy number for a name, -1 if unknown */
+int Io_parse_policy(const char* name);
+
+/* Io_policy_name: name of a policy number */
+const char* Io_policy_name(int policy);
+
+/* Io_parse_megabytes: bytes for a panel or chunk size given in MB (a
+ * -z option); returns 0, or -1 unless text is a positive whole number
+ * whose bytes fit in a size_t
+*/
+int Io_parse_megabytes(const char* text, size_t* bytes_p);
+
+/* Io_read_panels: read bytes bytes at offset of fd into buf in panels
+ * of panel_bytes, applying the page-cache policy
+ * Returns: 0 on success, -1 on error or short file
+*/
+int Io_read_panels(int fd, void* buf, size_t bytes, off_t offset, int policy, size_t panel_bytes);
+
+/* Io_resident_fraction: fraction of fd's pages in the page cache,
+ * or -1.0 if it cannot be determined
+*/
+double Io_resident_fraction(int fd);
+
+#endif /* _MAT_IO_H_ */
@@ -0,0 +1,190 @@
+/**
+ * @file mat_shard.c
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Sharded binary matrix storage: a manifest plus row-block shards.
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "quinn.h"
+#include "mat_io.h"
+#include "mat_shard.h"
+
+/*-------------------------------------------------------------------
+ * Function:  Shard_is_manifest
+ * Purpose:   Check whether a file is a shard manifest
+*/
+int Shard_is_manifest(char* filename) {
+    FILE* fp;
+    char magic[sizeof(SHARD_MAGIC)];
+    int is_manifest;
+
+    fp = fopen(filename, "rb");
+    if (fp == NULL) return 0;
+    is_manifest = fread(magic, 1, sizeof(magic) - 1, fp) == sizeof(magic) - 1 &&
+                  memcmp(magic, SHARD_MAGIC, sizeof(magic) - 1) == 0;
+    fclose(fp);
+    return is_manifest;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Shard_read_manifest
+ * Purpose:   Parse a manifest and check that its shards tile the rows
+ * Return:    0 on success, -1 on error
+*/
+int Shard_read_manifest(char* filename, Shard_manifest* man) {
+    FILE* fp;
+    char magic[16], name[PATH_MAX];
+    const char* slash;
+    int version, k, dir_len;
+
+    memset(man, 0, sizeof(*man));
+    fp = fopen(filename, "r");
+    if (fp == NULL) return -1;
+
+    if (fscanf(fp, "%15s %d", magic, &version) != 2 ||
+        strcmp(magic, SHARD_MAGIC) != 0 || version != 1 ||
+        fscanf(fp, "%d %d %d", &man->rows, &man->cols, &man->num_shards) != 3 ||
+        man->rows <= 0 || man->cols <= 0 || man->num_shards <= 0) {
+        fclose(fp);
+        return -1;
+    }
+
+    man->shards = (Shard*)malloc(man->num_shards * sizeof(Shard));
+    if (man->shards == NULL) {
+        fclose(fp);
+        return -1;
+    }
+
+    /* Shard names are relative to the manifest's directory */
+    slash = strrchr(filename, '/');
+    dir_len = slash == NULL ? 0 : (int)(slash - filename) + 1;
+
+    for (k = 0; k < man->num_shards; k++) {
+        Shard* s = &man->shards[k];
+        if (fscanf(fp, "%4095s %d %d", name, &s->first_row, &s->last_row) != 3 ||
+            s->first_row != (k == 0 ? 0 : man->shards[k - 1].last_row + 1) ||
+            s->last_row < s->first_row ||
+            snprintf(s->path, sizeof(s->path), "%.*s%s", dir_len, filename, name) >= (int)sizeof(s->path)) {
+            Shard_free_manifest(man);
+            fclose(fp);
+            return -1;
+        }
+    }
+    fclose(fp);
+
+    if (man->shards[man->num_shards - 1].last_row != man->rows - 1) {
+        Shard_free_manifest(man);
+        return -1;
+    }
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Shard_free_manifest
+ * Purpose:   Release a parsed manifest
+*/
+void Shard_free_manifest(Shard_manifest* man) {
+    free(man->shards);
+    man->shards = NULL;
+    man->num_shards = 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Shard_plan
+ * Purpose:   Lay out a new sharded matrix using Quinn's macros
+ * Return:    0 on success, -1 on error
+*/
+int Shard_plan(char* filename, int rows, int cols, int num_shards, Shard_manifest* man) {
+    int k;
+
+    if (rows <= 0 || cols <= 0 || num_shards <= 0 || num_shards > rows) return -1;
+
+    man->rows = rows;
+    man->cols = cols;
+    man->num_shards = num_shards;
+    man->shards = (Shard*)malloc(num_shards * sizeof(Shard));
+    if (man->shards == NULL) return -1;
+
+    for (k = 0; k < num_shards; k++) {
+        Shard* s = &man->shards[k];
+        s->first_row = BLOCK_LOW(k, num_shards, rows);
+        s->last_row = BLOCK_HIGH(k, num_shards, rows);
+        if (snprintf(s->path, sizeof(s->path), "%s.%d", filename, k) >= (int)sizeof(s->path)) {
+            Shard_free_manifest(man);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Shard_write_manifest
+ * Purpose:   Write the manifest, naming shards relative to it
+ * Return:    0 on success, -1 on error
+*/
+int Shard_write_manifest(char* filename, Shard_manifest* man) {
+    FILE* fp;
+    const char* slash;
+    int k, dir_len, ok;
+
+    fp = fopen(filename, "w");
+    if (fp == NULL) return -1;
+
+    slash = strrchr(filename, '/');
+    dir_len = slash == NULL ? 0 : (int)(slash - filename) + 1;
+
+    ok = fprintf(fp, "%s 1\n%d %d %d\n", SHARD_MAGIC, man->rows, man->cols, man->num_shards) > 0;
+    for (k = 0; k < man->num_shards && ok; k++) {
+        Shard* s = &man->shards[k];
+        const char* name = strncmp(s->path, filename, dir_len) == 0 ? s->path + dir_len : s->path;
+        ok = fprintf(fp, "%s %d %d\n", name, s->first_row, s->last_row) > 0;
+    }
+
+    if (fclose(fp) != 0 || !ok) return -1;
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Shard_load_rows
+ * Purpose:   Read a range of global rows from the shards that hold it.
+ *            Each call opens its own descriptors, so threads loading
+ *            disjoint ranges read their shards concurrently.
+ * Return:    0 on success, -1 on error
+*/
+int Shard_load_rows(Shard_manifest* man, int first_row, int last_row, double* dst,
+                    int policy, size_t panel_bytes) {
+    int k, fd, lo, hi, header[2];
+    size_t row_bytes = (size_t)man->cols * sizeof(double);
+
+    for (k = 0; k < man->num_shards && first_row <= last_row; k++) {
+        Shard* s = &man->shards[k];
+        if (s->last_row < first_row || s->first_row > last_row) continue;
+
+        lo = MAX(first_row, s->first_row);
+        hi = MIN(last_row, s->last_row);
+
+        fd = open(s->path, O_RDONLY);
+        if (fd < 0) return -1;
+        if (pread(fd, header, sizeof(header), 0) != sizeof(header) ||
+            header[0] != s->last_row - s->first_row + 1 || header[1] != man->cols ||
+            Io_read_panels(fd, dst + (size_t)(lo - first_row) * man->cols,
+                           (size_t)(hi - lo + 1) * row_bytes,
+                           sizeof(header) + (off_t)(lo - s->first_row) * row_bytes,
+                           policy < 0 ? IO_POLICY_DEFAULT : policy, panel_bytes) != 0) {
+            close(fd);
+            return -1;
+        }
+        close(fd);
+    }
+    return 0;
+}
@@ -0,0 +1,75 @@
+/**
+ * @file mat_shard.h
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Sharded binary matrix storage: a manifest plus row-block shards.
+ *
+ * A sharded matrix is a small text manifest naming one ordinary binary
+ * matrix file per row block:
+ *
+ *   MATSHARD 1
+ *   <rows> <cols> <num_shards>
+ *   <shard_file> <first_row> <last_row>
+ *   ...
+ *
+ * Shard k holds rows BLOCK_LOW(k,num_shards,rows)..BLOCK_HIGH(...) in
+ * the usual format (rows/cols header, row-major doubles), so shards can
+ * be written and read independently and in parallel. Shard file names
+ * are relative to the manifest's directory.
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#ifndef _MAT_SHARD_H_
+#define _MAT_SHARD_H_
+
+#include <limits.h>
+#include <stddef.h>
+
+#define SHARD_MAGIC "MATSHARD"
+
+typedef struct {
+    char path[PATH_MAX];   /* shard file, resolved against the manifest */
+    int first_row;         /* first global row in this shard */
+    int last_row;          /* last global row in this shard (inclusive) */
+} Shard;
+
+typedef struct {
+    int rows, cols;
+    int num_shards;
+    Shard* shards;
+} Shard_manifest;
+
+/* Shard_is_manifest: 1 if filename starts with SHARD_MAGIC, else 0 */
+int Shard_is_manifest(char* filename);
+
+/* Shard_read_manifest: parse a manifest
+ * Returns: 0 on success, -1 on error
+*/
+int Shard_read_manifest(char* filename, Shard_manifest* man);
+
+/* Shard_free_manifest: release a parsed manifest */
+void Shard_free_manifest(Shard_manifest* man);
+
+/* Shard_plan: fill man for a new rows x cols matrix split into
+ * num_shards row blocks named <filename>.<k>
+ * Returns: 0 on success, -1 on error
+*/
+int Shard_plan(char* filename, int rows, int cols, int num_shards, Shard_manifest* man);
+
+/* Shard_write_manifest: write the manifest file for man
+ * Returns: 0 on success, -1 on error
+*/
+int Shard_write_manifest(char* filename, Shard_manifest* man);
+
+/* Shard_load_rows: read global rows first_row..last_row into dst from
+ * whichever shards hold them, using the page-cache policy of mat_io.h
+ * Returns: 0 on success, -1 on error
+*/
+int Shard_load_rows(Shard_manifest* man, int first_row, int last_row, double* dst,
+                    int policy, size_t panel_bytes);
+
+#endif /* _MAT_SHARD_H_ */
@@ -0,0 +1,288 @@
+/**
+ * @file matvec_client.c
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Client for the matrix-vector multiplication server.
+ *
+ * This program sends vector x to a running pth_matvec_server one or more
+ * times, with the chosen priority class and deadline, and writes the last
+ * result y to a binary file.
+ *
+ * Latency statistics are output to stderr in CSV format:
+ *   Requests,OK,Busy,Expired,Latency_Mean,Latency_P50,Latency_P99,Latency_Max
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "timer.h"
+#include "matvec_proto.h"
+
+void Usage(char* prog_name);
+int Read_matrix(char* filename, double** A_p, int* m_p, int* n_p);
+int Write_vector(char* filename, double y[], int m);
+int Read_full(int fd, void* buf, size_t bytes);
+int Write_full(int fd, const void* buf, size_t bytes);
+int Compare_doubles(const void* a, const void* b);
+
+int main(int argc, char* argv[]) {
+    double *x = NULL, *y = NULL, *latency = NULL;
+    int m_x, n_x, m_y = 0;
+    int opt, fd, r, repeats = 1, ok = 0, rejected = 0, late = 0;
+    double start, finish, sum = 0.0;
+    struct sockaddr_un addr;
+    Mv_request req;
+    Mv_reply reply;
+
+    memset(&req, 0, sizeof(req));
+    req.magic = MV_MAGIC;
+    req.priority = MV_PRIO_INTERACTIVE;
+
+    /* Parse options */
+    while ((opt = getopt(argc, argv, "p:d:r:")) != -1) {
+        switch (opt) {
+            case 'p':
+                if (strcmp(optarg, "interactive") == 0) req.priority = MV_PRIO_INTERACTIVE;
+                else if (strcmp(optarg, "batch") == 0) req.priority = MV_PRIO_BATCH;
+                else {
+                    Usage(argv[0]);
+                    exit(1);
+                }
+                break;
+            case 'd': req.deadline_ms = atoi(optarg); break;
+            case 'r': repeats = atoi(optarg); break;
+            default:
+                Usage(argv[0]);
+                exit(1);
+        }
+    }
+
+    /* Check command line arguments */
+    if (argc - optind != 3 || repeats <= 0) {
+        Usage(argv[0]);
+        exit(1);
+    }
+
+    /* Read vector x */
+    if (Read_matrix(argv[optind + 1], &x, &m_x, &n_x) != 0) {
+        fprintf(stderr, "Error: Failed to read vector x from %s\n", argv[optind + 1]);
+        exit(1);
+    }
+    if (n_x != 1) {
+        fprintf(stderr, "Error: x must be a column vector (n_x = %d, should be 1)\n", n_x);
+        free(x);
+        exit(1);
+    }
+    req.n = m_x;
+
+    latency = (double*)malloc(repeats * sizeof(double));
+    if (latency == NULL) {
+        fprintf(stderr, "Error: Cannot allocate memory for latencies\n");
+        free(x);
+        exit(1);
+    }
+
+    /* Connect to server */
+    if (strlen(argv[optind]) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Error: Socket path %s is too long\n", argv[optind]);
+        exit(1);
+    }
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, argv[optind]);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        fprintf(stderr, "Error: Cannot connect to %s\n", argv[optind]);
+        free(x);
+        free(latency);
+        exit(1);
+    }
+
+    /* Send requests one at a time */
+    for (r = 0; r < repeats; r++) {
+        GET_TIME(start);
+        if (Write_full(fd, &req, sizeof(req)) != 0 ||
+            Write_full(fd, x, m_x * sizeof(double)) != 0 ||
+            Read_full(fd, &reply, sizeof(reply)) != 0) {
+            fprintf(stderr, "Error: Lost connection to server\n");
+            exit(1);
+        }
+        if (reply.status == MV_OK) {
+            if (y == NULL) {
+                m_y = reply.m;
+                y = (double*)malloc(m_y * sizeof(double));
+                if (y == NULL) {
+                    fprintf(stderr, "Error: Cannot allocate memory for result vector\n");
+                    exit(1);
+                }
+            }
+            if (reply.m != m_y || Read_full(fd, y, m_y * sizeof(double)) != 0) {
+                fprintf(stderr, "Error: Lost connection to server\n");
+                exit(1);
+            }
+        }
+        GET_TIME(finish);
+
+        if (reply.status == MV_OK) {
+            latency[ok++] = finish - start;
+            sum += finish - start;
+        } else if (reply.status == MV_BUSY) {
+            rejected++;
+        } else if (reply.status == MV_EXPIRED) {
+            late++;
+        } else {
+            fprintf(stderr, "Error: Server rejected request (vector length %d)\n", m_x);
+            exit(1);
+        }
+    }
+    close(fd);
+
+    /* Write last result */
+    if (y != NULL && Write_vector(argv[optind + 2], y, m_y) != 0) {
+        fprintf(stderr, "Error: Failed to write result to %s\n", argv[optind + 2]);
+        exit(1);
+    }
+
+    /* Print latency statistics to stderr */
+    qsort(latency, ok, sizeof(double), Compare_doubles);
+    fprintf(stderr, "%d,%d,%d,%d,%e,%e,%e,%e\n", repeats, ok, rejected, late,
+            ok > 0 ? sum / ok : 0.0,
+            ok > 0 ? latency[(ok - 1) / 2] : 0.0,
+            ok > 0 ? latency[(int)(0.99 * (ok - 1))] : 0.0,
+            ok > 0 ? latency[ok - 1] : 0.0);
+
+    /* Clean up */
+    free(x);
+    free(y);
+    free(latency);
+
+    return ok > 0 ? 0 : 2;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Usage
+ * Purpose:   Print usage message
+*/
+void Usage(char* prog_name) {
+    fprintf(stderr, "Usage: %s [options] <socket_path> <file_x> <file_y>\n", prog_name);
+    fprintf(stderr, "  Sends x to a pth_matvec_server and stores the result in y\n");
+    fprintf(stderr, "  -p class  interactive (default) or batch\n");
+    fprintf(stderr, "  -d ms     relative deadline (default: none)\n");
+    fprintf(stderr, "  -r count  number of requests to send (default: 1)\n");
+    fprintf(stderr, "  Example: %s -p interactive -d 10 -r 1000 /tmp/matvec.sock x.mat y.mat\n", prog_name);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Read_matrix
+ * Purpose:   Read a binary matrix file
+*/
+int Read_matrix(char* filename, double** A_p, int* m_p, int* n_p) {
+    FILE* fp;
+    int rows, cols;
+    double* A;
+
+    fp = fopen(filename, "rb");
+    if (fp == NULL) return -1;
+
+    if (fread(&rows, sizeof(int), 1, fp) != 1 ||
+        fread(&cols, sizeof(int), 1, fp) != 1) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (rows <= 0 || cols <= 0) {
+        fclose(fp);
+        return -1;
+    }
+
+    A = (double*)malloc((size_t)rows * cols * sizeof(double));
+    if (A == NULL) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (fread(A, sizeof(double), (size_t)rows * cols, fp) != (size_t)rows * cols) {
+        free(A);
+        fclose(fp);
+        return -1;
+    }
+
+    fclose(fp);
+    *A_p = A;
+    *m_p = rows;
+    *n_p = cols;
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Write_vector
+ * Purpose:   Write a vector to binary file
+*/
+int Write_vector(char* filename, double y[], int m) {
+    FILE* fp;
+    int cols = 1;
+
+    fp = fopen(filename, "wb");
+    if (fp == NULL) return -1;
+
+    if (fwrite(&m, sizeof(int), 1, fp) != 1 ||
+        fwrite(&cols, sizeof(int), 1, fp) != 1) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (fwrite(y, sizeof(double), m, fp) != m) {
+        fclose(fp);
+        return -1;
+    }
+
+    fclose(fp);
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Read_full / Write_full
+ * Purpose:   Transfer exactly bytes bytes on a socket
+ * Return:    0 on success, -1 on error or end of file
+*/
+int Read_full(int fd, void* buf, size_t bytes) {
+    char* p = (char*)buf;
+    while (bytes > 0) {
+        ssize_t got = read(fd, p, bytes);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return -1;
+        p += got;
+        bytes -= got;
+    }
+    return 0;
+}
+
+int Write_full(int fd, const void* buf, size_t bytes) {
+    const char* p = (const char*)buf;
+    while (bytes > 0) {
+        ssize_t put = write(fd, p, bytes);
+        if (put < 0 && errno == EINTR) continue;
+        if (put <= 0) return -1;
+        p += put;
+        bytes -= put;
+    }
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Compare_doubles
+ * Purpose:   qsort comparison for ascending doubles
+*/
+int Compare_doubles(const void* a, const void* b) {
+    double da = *(const double*)a, db = *(const double*)b;
+    return (da > db) - (da < db);
+}
@@ -0,0 +1,53 @@
+/**
+ * @file matvec_proto.h
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Wire protocol shared by the matvec server and its clients.
+ *
+ * A client connects to the server's UNIX domain socket and sends any
+ * number of requests on the connection. Each request is a fixed header
+ * followed by the n doubles of x. The server answers every request with
+ * a fixed reply header, followed by the m doubles of y when the status
+ * is MV_OK.
+ *
+ * All fields are in host byte order (client and server share a host).
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#ifndef _MATVEC_PROTO_H_
+#define _MATVEC_PROTO_H_
+
+#define MV_MAGIC 0x4d56514d    /* "MQVM" */
+
+/* Priority classes, highest first */
+#define MV_PRIO_INTERACTIVE 0
+#define MV_PRIO_BATCH       1
+#define MV_NUM_PRIO         2
+
+/* Reply status codes */
+#define MV_OK          0   /* y follows the reply header */
+#define MV_BUSY        1   /* rejected by admission control, retry later */
+#define MV_EXPIRED     2   /* deadline passed before the product finished */
+#define MV_BAD_REQUEST 3   /* malformed header or wrong vector length */
+
+/* Request header, followed by n doubles */
+typedef struct {
+    int magic;        /* MV_MAGIC */
+    int priority;     /* MV_PRIO_INTERACTIVE or MV_PRIO_BATCH */
+    int deadline_ms;  /* relative deadline in ms, 0 = none */
+    int n;            /* length of x */
+} Mv_request;
+
+/* Reply header, followed by m doubles when status == MV_OK */
+typedef struct {
+    int status;          /* MV_OK, MV_BUSY, MV_EXPIRED, MV_BAD_REQUEST */
+    int m;               /* length of y (0 unless MV_OK) */
+    double queue_time;   /* seconds from admission to first row block */
+    double service_time; /* seconds from admission to completion */
+} Mv_reply;
+
+#endif /* _MATVEC_PROTO_H_ */
@@ -0,0 +1,690 @@
+/**
+ * @file pth_dist_spmv.c
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Distributed sparse matvec with halo exchange over local sockets.
+ *
+ * Computes y = A^k * x (k = 1 unless -i is given; A must then be square)
+ * with P processes that share no memory. Process r owns a block of rows
+ * of A and the same block of x and y (Quinn's macros), and is connected
+ * to every other process by a socket pair.
+ *
+ * At setup each process lists the columns of its rows that fall in
+ * other processes' blocks of x (its halo) and sends each owner the
+ * indices it needs from it. Each iteration then exchanges only those
+ * entries, so the traffic grows with the cut of the row partition, not
+ * with n as broadcasting x would. The exchange runs on a second thread
+ * while the main thread computes the interior rows, whose columns are
+ * all in the process's own block; the boundary rows are computed once
+ * the halo has arrived. The sockets are non-blocking and served with
+ * poll(), so processes that send each other more than a socket buffer
+ * cannot deadlock.
+ *
+ * A is read in any format the sparse conversions accept (dense, CSR,
+ * CSC, COO). It is read once by the parent and inherited by the forked
+ * processes, each of which copies out its own rows and then uses only
+ * those, its block of x and its halo.
+ *
+ * A summary is printed to stdout:
+ *   halo: <entries> x entries per iteration (<pct>% of broadcasting x),
+ *         <interior> of <m> rows interior
+ *
+ * Timing data is output to stderr in CSV format:
+ *   M,N,P,Iters,Halo,Time_Overall,Time_Setup,Time_Work,Time_Wait
+ * where the setup, work and wait times are the largest over the
+ * processes, and Time_Wait is the part of Time_Work spent waiting for
+ * the halo after the interior rows were done.
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include "quinn.h"
+#include "timer.h"
+#include "mat_format.h"
+#include "sparse.h"
+#include "semiring.h"
+
+/* Another process, and the x entries exchanged with it each iteration */
+typedef struct {
+    int fd;                 /* this process's end of the pair */
+    int send_count;         /* entries of my block of x it needs */
+    int* send_idx;          /* ... as indices into my block */
+    double* send_buf;
+    int recv_count;         /* entries of its block I need */
+    int recv_first;         /* ... where they go in the halo */
+} Peer;
+
+/* One transfer in each direction on a socket, made by Exchange */
+typedef struct {
+    int fd;
+    const char* send;
+    size_t send_bytes, sent;
+    char* recv;
+    size_t recv_bytes, received;
+} Transfer;
+
+/* What each process reports to the parent through a pipe */
+typedef struct {
+    int rank;
+    int failed;
+    long halo;              /* x entries received per iteration */
+    int interior;           /* rows needing no halo */
+    double setup, work, wait;
+} Proc_stats;
+
+/* Global variables: the whole problem, read by the parent */
+int proc_count;
+int iterations = 1;
+Csr A;
+double* x = NULL;
+int m, n;
+int** pair_fd;              /* pair_fd[r][q]: r's end of the pair with q */
+
+/* Global variables: this process's share, after the fork */
+int my_rank;
+int first_row, last_row, first_col, last_col, own_cols;
+Csr L;                      /* my rows, interior first; columns index x_ext */
+int* row_of;                /* L's row k is row first_row + row_of[k] of A */
+int interior_count;
+int* halo_col;              /* columns of the halo, sorted (so by owner) */
+int halo_count;
+double* x_ext;              /* my block of x, then the halo */
+double* y_loc;              /* L * x_ext, in L's row order */
+Peer* peers;
+Transfer* transfers;
+int exchange_failed;
+
+/* Function prototypes */
+void Usage(char* prog_name);
+int Read_matrix(char* filename, double** A_p, int* m_p, int* n_p);
+int Read_csr(char* filename, int thread_count);
+int Write_header(char* filename, int rows);
+int Run_process(char* file_y, double* setup_p, double* work_p, double* wait_p);
+int Setup(void);
+int Find_col(int j);
+int Exchange(Transfer* t, int count);
+void* Pth_exchange(void* transfer_list);
+int Compare_int(const void* a, const void* b);
+
+int main(int argc, char* argv[]) {
+    int opt, m_x, n_x, r, q, status, failed = 0, stats_pipe[2];
+    int sv[2];
+    pid_t* pids;
+    Proc_stats st, total;
+    double start_total, end_total;
+    long halo = 0;
+    int interior = 0;
+
+    /* Parse options */
+    while ((opt = getopt(argc, argv, "i:")) != -1) {
+        switch (opt) {
+            case 'i': iterations = atoi(optarg); break;
+            default:
+                Usage(argv[0]);
+                exit(1);
+        }
+    }
+
+    /* Check command line arguments */
+    if (argc - optind != 4 || iterations <= 0) {
+        Usage(argv[0]);
+        exit(1);
+    }
+
+    /* Get number of processes */
+    proc_count = atoi(argv[optind + 3]);
+    if (proc_count <= 0) {
+        fprintf(stderr, "Error: Number of processes must be positive\n");
+        exit(1);
+    }
+
+    GET_TIME(start_total);
+
+    /* Read A and x */
+    if (Read_csr(argv[optind], proc_count) != 0) {
+        fprintf(stderr, "Error: Failed to read matrix A from %s\n", argv[optind]);
+        exit(1);
+    }
+    m = A.rows;
+    n = A.cols;
+    if (Read_matrix(argv[optind + 1], &x, &m_x, &n_x) != 0) {
+        fprintf(stderr, "Error: Failed to read vector x from %s\n", argv[optind + 1]);
+        exit(1);
+    }
+    if (n_x != 1 || m_x != n) {
+        fprintf(stderr, "Error: x must be a %d x 1 vector (it is %d x %d)\n", n, m_x, n_x);
+        exit(1);
+    }
+    if (iterations > 1 && m != n) {
+        fprintf(stderr, "Error: -i needs a square matrix (A is %d x %d)\n", m, n);
+        exit(1);
+    }
+    if (proc_count > MIN(m, n)) {
+        fprintf(stderr, "Error: More processes (%d) than rows or columns of A\n", proc_count);
+        exit(1);
+    }
+
+    /* y's header; each process writes its own block after it */
+    if (Write_header(argv[optind + 2], m) != 0) {
+        fprintf(stderr, "Error: Failed to write result to %s\n", argv[optind + 2]);
+        exit(1);
+    }
+
+    /* A socket pair between every two processes, and a pipe for stats */
+    pair_fd = (int**)malloc(proc_count * sizeof(int*));
+    pids = (pid_t*)malloc(proc_count * sizeof(pid_t));
+    if (pair_fd == NULL || pids == NULL) {
+        fprintf(stderr, "Error: Cannot allocate memory for processes\n");
+        exit(1);
+    }
+    for (r = 0; r < proc_count; r++) {
+        pair_fd[r] = (int*)malloc(proc_count * sizeof(int));
+        if (pair_fd[r] == NULL) {
+            fprintf(stderr, "Error: Cannot allocate memory for processes\n");
+            exit(1);
+        }
+        pair_fd[r][r] = -1;
+        for (q = 0; q < r; q++) {
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+                fprintf(stderr, "Error: Cannot create socket pair: %s\n", strerror(errno));
+                exit(1);
+            }
+            pair_fd[r][q] = sv[0];
+            pair_fd[q][r] = sv[1];
+        }
+    }
+    if (pipe(stats_pipe) != 0) {
+        fprintf(stderr, "Error: Cannot create pipe: %s\n", strerror(errno));
+        exit(1);
+    }
+
+    /* Start the processes; each keeps only its own socket ends */
+    fflush(stdout);
+    for (r = 0; r < proc_count; r++) {
+        pids[r] = fork();
+        if (pids[r] < 0) {
+            fprintf(stderr, "Error: Cannot fork: %s\n", strerror(errno));
+            exit(1);
+        }
+        if (pids[r] == 0) {
+            my_rank = r;
+            close(stats_pipe[0]);
+            for (q = 0; q < proc_count; q++) {
+                for (status = 0; status < proc_count; status++) {
+                    if (q != r && pair_fd[q][status] >= 0) close(pair_fd[q][status]);
+                }
+            }
+            memset(&st, 0, sizeof(st));
+            st.rank = r;
+            st.failed = Run_process(argv[optind + 2], &st.setup, &st.work, &st.wait) != 0;
+            st.halo = halo_count;
+            st.interior = interior_count;
+            if (write(stats_pipe[1], &st, sizeof(st)) != sizeof(st)) st.failed = 1;
+            _exit(st.failed ? 1 : 0);
+        }
+    }
+    close(stats_pipe[1]);
+    for (r = 0; r < proc_count; r++) {
+        for (q = 0; q < proc_count; q++) {
+            if (pair_fd[r][q] >= 0) close(pair_fd[r][q]);
+        }
+    }
+
+    /* Collect the processes' stats */
+    memset(&total, 0, sizeof(total));
+    for (r = 0; r < proc_count; r++) {
+        if (read(stats_pipe[0], &st, sizeof(st)) != sizeof(st)) {
+            failed = 1;
+            break;
+        }
+        if (st.failed) failed = 1;
+        halo += st.halo;
+        interior += st.interior;
+        total.setup = MAX(total.setup, st.setup);
+        total.work = MAX(total.work, st.work);
+        total.wait = MAX(total.wait, st.wait);
+    }
+    close(stats_pipe[0]);
+    for (r = 0; r < proc_count; r++) {
+        if (waitpid(pids[r], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            failed = 1;
+        }
+    }
+    if (failed) {
+        fprintf(stderr, "Error: A process failed\n");
+        exit(1);
+    }
+
+    GET_TIME(end_total);
+
+    printf("halo: %ld x entries per iteration (%.1f%% of broadcasting x), %d of %d rows interior\n",
+           halo, proc_count > 1 ? 100.0 * halo / ((double)(proc_count - 1) * n) : 0.0,
+           interior, m);
+
+    /* Print timing results to stderr */
+    fprintf(stderr, "%d,%d,%d,%d,%ld,%e,%e,%e,%e\n", m, n, proc_count, iterations, halo,
+            end_total - start_total, total.setup, total.work, total.wait);
+
+    /* Clean up */
+    for (r = 0; r < proc_count; r++) free(pair_fd[r]);
+    free(pair_fd);
+    free(pids);
+    Csr_free(&A);
+    free(x);
+
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Usage
+ * Purpose:   Print usage message
+*/
+void Usage(char* prog_name) {
+    fprintf(stderr, "Usage: %s [-i iters] <file_A> <file_x> <file_y> <num_procs>\n", prog_name);
+    fprintf(stderr, "  Computes y = A^iters * x with num_procs processes that exchange\n");
+    fprintf(stderr, "  only the entries of x their rows need\n");
+    fprintf(stderr, "  -i iters  products to chain (default 1; A must be square)\n");
+    fprintf(stderr, "  Example: %s -i 10 A.csr x.mat y.mat 4\n", prog_name);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Read_matrix
+ * Purpose:   Read a binary matrix file
+*/
+int Read_matrix(char* filename, double** A_p, int* m_p, int* n_p) {
+    FILE* fp;
+    int rows, cols;
+    double* M;
+
+    fp = fopen(filename, "rb");
+    if (fp == NULL) return -1;
+
+    if (fread(&rows, sizeof(int), 1, fp) != 1 ||
+        fread(&cols, sizeof(int), 1, fp) != 1) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (rows <= 0 || cols <= 0) {
+        fclose(fp);
+        return -1;
+    }
+
+    M = (double*)malloc((size_t)rows * cols * sizeof(double));
+    if (M == NULL) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (fread(M, sizeof(double), (size_t)rows * cols, fp) != (size_t)rows * cols) {
+        free(M);
+        fclose(fp);
+        return -1;
+    }
+
+    fclose(fp);
+    *A_p = M;
+    *m_p = rows;
+    *n_p = cols;
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Read_csr
+ * Purpose:   Read A into the global CSR matrix, whatever its format,
+ *            with duplicates of a COO file summed
+*/
+int Read_csr(char* filename, int thread_count) {
+    int format = Sparse_format(filename), rows, cols, status;
+    double* dense;
+    Csc csc;
+
+    if (format == MAT_FORMAT_DENSE) {
+        status = Read_matrix(filename, &dense, &rows, &cols);
+        if (status == 0) status = Csr_from_dense(dense, rows, cols, thread_count, &A);
+        if (status == 0) free(dense);
+        return status;
+    }
+    if (format == MAT_FORMAT_CSR) return Csr_read(filename, &A);
+    if (format == MAT_FORMAT_CSC) {
+        if (Csc_read(filename, &csc) != 0) return -1;
+        status = Csr_from_csc(&csc, thread_count, &A);
+        Csc_free(&csc);
+        return status;
+    }
+    if (format == MAT_FORMAT_COO) {
+        return Csr_from_coo(filename, COO_SUM_DUPLICATES, COO_DEFAULT_CHUNK_BYTES, thread_count,
+                            &A);
+    }
+    return -1;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Write_header
+ * Purpose:   Create y's file with its header, sized for rows doubles
+*/
+int Write_header(char* filename, int rows) {
+    int fd, header[2];
+
+    header[0] = rows;
+    header[1] = 1;
+    fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return -1;
+    if (write(fd, header, sizeof(header)) != sizeof(header) ||
+        ftruncate(fd, sizeof(header) + (off_t)rows * sizeof(double)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return close(fd);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Run_process
+ * Purpose:   Body of process my_rank: set up the halo, iterate, and
+ *            write its block of y
+ * Return:    0 on success, -1 on error
+*/
+int Run_process(char* file_y, double* setup_p, double* work_p, double* wait_p) {
+    pthread_t exchanger;
+    double start, end, start_wait;
+    double* y_out;
+    int it, k, fd;
+    size_t bytes;
+
+    first_row = BLOCK_LOW(my_rank, proc_count, m);
+    last_row = BLOCK_HIGH(my_rank, proc_count, m);
+    first_col = BLOCK_LOW(my_rank, proc_count, n);
+    last_col = BLOCK_HIGH(my_rank, proc_count, n);
+    own_cols = last_col - first_col + 1;
+
+    GET_TIME(start);
+    if (Setup() != 0) return -1;
+    GET_TIME(end);
+    *setup_p = end - start;
+
+    *wait_p = 0.0;
+    GET_TIME(start);
+    for (it = 0; it < iterations; it++) {
+        /* Halo in the background, interior rows meanwhile */
+        exchange_failed = 0;
+        if (pthread_create(&exchanger, NULL, Pth_exchange, transfers) != 0) return -1;
+        if (interior_count > 0) {
+            Semiring_csr_rows(SR_PLUS_TIMES, &L, x_ext, y_loc, 0, interior_count - 1);
+        }
+        GET_TIME(start_wait);
+        pthread_join(exchanger, NULL);
+        GET_TIME(end);
+        *wait_p += end - start_wait;
+        if (exchange_failed) {
+            fprintf(stderr, "Error: Process %d: halo exchange failed\n", my_rank);
+            return -1;
+        }
+
+        /* Boundary rows, then y becomes the next x */
+        if (interior_count < L.rows) {
+            Semiring_csr_rows(SR_PLUS_TIMES, &L, x_ext, y_loc, interior_count, L.rows - 1);
+        }
+        if (it + 1 < iterations) {
+            for (k = 0; k < L.rows; k++) x_ext[row_of[k]] = y_loc[k];
+        }
+    }
+    GET_TIME(end);
+    *work_p = end - start;
+
+    /* My block of y, in row order, at its place in the file */
+    y_out = (double*)malloc(MAX(L.rows, 1) * sizeof(double));
+    if (y_out == NULL) return -1;
+    for (k = 0; k < L.rows; k++) y_out[row_of[k]] = y_loc[k];
+    bytes = (size_t)L.rows * sizeof(double);
+    fd = open(file_y, O_WRONLY);
+    if (fd < 0 || pwrite(fd, y_out, bytes, 2 * sizeof(int) + (off_t)first_row * sizeof(double)) !=
+                  (ssize_t)bytes) {
+        fprintf(stderr, "Error: Process %d: failed to write %s\n", my_rank, file_y);
+        if (fd >= 0) close(fd);
+        free(y_out);
+        return -1;
+    }
+    close(fd);
+    free(y_out);
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Setup
+ * Purpose:   Build this process's rows with columns renumbered into
+ *            x_ext (my block, then the sorted halo), interior rows
+ *            first, and agree with every peer on what to exchange
+ * Return:    0 on success, -1 on error
+*/
+int Setup(void) {
+    int rows = last_row - first_row + 1;
+    long k, nnz = A.row_ptr[last_row + 1] - A.row_ptr[first_row], count = 0, dst;
+    int i, j, q, h, interior, boundary;
+    int *is_interior, *counts, *lists;
+
+    /* The halo: remote columns of my rows, sorted and unique */
+    halo_col = (int*)malloc(MAX(nnz, 1) * sizeof(int));
+    is_interior = (int*)malloc(rows * sizeof(int));
+    if (halo_col == NULL || is_interior == NULL) return -1;
+    interior_count = 0;
+    for (i = 0; i < rows; i++) {
+        is_interior[i] = 1;
+        for (k = A.row_ptr[first_row + i]; k < A.row_ptr[first_row + i + 1]; k++) {
+            j = A.col_idx[k];
+            if (j < first_col || j > last_col) {
+                halo_col[count++] = j;
+                is_interior[i] = 0;
+            }
+        }
+        interior_count += is_interior[i];
+    }
+    qsort(halo_col, count, sizeof(int), Compare_int);
+    halo_count = 0;
+    for (k = 0; k < count; k++) {
+        if (halo_count == 0 || halo_col[k] != halo_col[halo_count - 1]) {
+            halo_col[halo_count++] = halo_col[k];
+        }
+    }
+
+    /* My rows, interior first, columns into x_ext */
+    if (Csr_alloc(&L, rows, own_cols + halo_count, nnz) != 0) return -1;
+    row_of = (int*)malloc(MAX(rows, 1) * sizeof(int));
+    x_ext = (double*)malloc((own_cols + halo_count) * sizeof(double));
+    y_loc = (double*)malloc(MAX(rows, 1) * sizeof(double));
+    if (row_of == NULL || x_ext == NULL || y_loc == NULL) return -1;
+    interior = 0;
+    boundary = interior_count;
+    for (i = 0; i < rows; i++) row_of[is_interior[i] ? interior++ : boundary++] = i;
+    L.row_ptr[0] = 0;
+    for (h = 0; h < rows; h++) {
+        i = first_row + row_of[h];
+        dst = L.row_ptr[h];
+        for (k = A.row_ptr[i]; k < A.row_ptr[i + 1]; k++, dst++) {
+            j = A.col_idx[k];
+            L.col_idx[dst] = j >= first_col && j <= last_col ? j - first_col
+                                                              : own_cols + Find_col(j);
+            L.val[dst] = A.val[k];
+        }
+        L.row_ptr[h + 1] = dst;
+    }
+    memcpy(x_ext, x + first_col, own_cols * sizeof(double));
+    free(is_interior);
+
+    /* What I need from each peer: a run of the halo, owners ascending */
+    peers = (Peer*)calloc(proc_count, sizeof(Peer));
+    transfers = (Transfer*)calloc(proc_count, sizeof(Transfer));
+    counts = (int*)malloc(proc_count * sizeof(int));
+    if (peers == NULL || transfers == NULL || counts == NULL) return -1;
+    for (h = 0; h < halo_count; h++) {
+        q = BLOCK_OWNER(halo_col[h], proc_count, n);
+        if (peers[q].recv_count++ == 0) peers[q].recv_first = h;
+    }
+
+    /* Tell each peer how many entries I need, and learn how many it needs */
+    h = 0;
+    for (q = 0; q < proc_count; q++) {
+        if (q == my_rank) continue;
+        peers[q].fd = pair_fd[my_rank][q];
+        if (fcntl(peers[q].fd, F_SETFL, fcntl(peers[q].fd, F_GETFL) | O_NONBLOCK) != 0) return -1;
+        transfers[h].fd = peers[q].fd;
+        transfers[h].send = (const char*)&peers[q].recv_count;
+        transfers[h].send_bytes = sizeof(int);
+        transfers[h].recv = (char*)&counts[q];
+        transfers[h].recv_bytes = sizeof(int);
+        h++;
+    }
+    if (Exchange(transfers, h) != 0) return -1;
+
+    /* Then which ones */
+    h = 0;
+    for (q = 0; q < proc_count; q++) {
+        if (q == my_rank) continue;
+        peers[q].send_count = counts[q];
+        if (counts[q] < 0 || counts[q] > own_cols) return -1;
+        peers[q].send_idx = (int*)malloc(MAX(counts[q], 1) * sizeof(int));
+        peers[q].send_buf = (double*)malloc(MAX(counts[q], 1) * sizeof(double));
+        if (peers[q].send_idx == NULL || peers[q].send_buf == NULL) return -1;
+        memset(&transfers[h], 0, sizeof(Transfer));
+        transfers[h].fd = peers[q].fd;
+        transfers[h].send = (const char*)(halo_col + peers[q].recv_first);
+        transfers[h].send_bytes = peers[q].recv_count * sizeof(int);
+        transfers[h].recv = (char*)peers[q].send_idx;
+        transfers[h].recv_bytes = counts[q] * sizeof(int);
+        h++;
+    }
+    if (Exchange(transfers, h) != 0) return -1;
+    for (q = 0; q < proc_count; q++) {
+        lists = peers[q].send_idx;
+        for (k = 0; k < peers[q].send_count; k++) {
+            if (lists[k] < first_col || lists[k] > last_col) return -1;
+            lists[k] -= first_col;
+        }
+    }
+    free(counts);
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Find_col
+ * Purpose:   Position of remote column j in the sorted halo
+*/
+int Find_col(int j) {
+    int lo = 0, hi = halo_count - 1, mid;
+
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (halo_col[mid] < j) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Exchange
+ * Purpose:   Complete every transfer, sending and receiving on all the
+ *            non-blocking sockets as poll() finds them ready
+ * Return:    0 on success, -1 on error or a peer closing early
+*/
+int Exchange(Transfer* t, int count) {
+    struct pollfd* fds;
+    int* which;
+    int i, ready, pending;
+    ssize_t done;
+
+    fds = (struct pollfd*)malloc(MAX(count, 1) * sizeof(struct pollfd));
+    which = (int*)malloc(MAX(count, 1) * sizeof(int));
+    if (fds == NULL || which == NULL) {
+        free(fds);
+        free(which);
+        return -1;
+    }
+    for (i = 0; i < count; i++) {
+        t[i].sent = 0;
+        t[i].received = 0;
+    }
+
+    for (;;) {
+        pending = 0;
+        for (i = 0; i < count; i++) {
+            if (t[i].sent == t[i].send_bytes && t[i].received == t[i].recv_bytes) continue;
+            fds[pending].fd = t[i].fd;
+            fds[pending].events = (t[i].sent < t[i].send_bytes ? POLLOUT : 0) |
+                                  (t[i].received < t[i].recv_bytes ? POLLIN : 0);
+            which[pending++] = i;
+        }
+        if (pending == 0) break;
+        ready = poll(fds, pending, -1);
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready < 0) break;
+        for (i = 0; i < pending; i++) {
+            Transfer* tr = &t[which[i]];
+            if (fds[i].revents & POLLOUT) {
+                done = write(tr->fd, tr->send + tr->sent, tr->send_bytes - tr->sent);
+                if (done > 0) tr->sent += done;
+                else if (done < 0 && errno != EAGAIN && errno != EINTR) goto fail;
+            }
+            if (fds[i].revents & (POLLIN | POLLHUP)) {
+                done = read(tr->fd, tr->recv + tr->received, tr->recv_bytes - tr->received);
+                if (done > 0) tr->received += done;
+                else if (done == 0 || (errno != EAGAIN && errno != EINTR)) goto fail;
+            }
+            if (fds[i].revents & (POLLERR | POLLNVAL)) goto fail;
+        }
+    }
+    free(fds);
+    free(which);
+    return pending == 0 ? 0 : -1;
+
+fail:
+    free(fds);
+    free(which);
+    return -1;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Pth_exchange
+ * Purpose:   Thread function: send each peer the entries of my block
+ *            of x it needs, and receive my halo straight into x_ext,
+ *            using transfer_list for the per-peer descriptors
+*/
+void* Pth_exchange(void* transfer_list) {
+    Transfer* t = (Transfer*)transfer_list;
+    int q, h = 0, k;
+    Peer* p;
+
+    for (q = 0; q < proc_count; q++) {
+        p = &peers[q];
+        if (q == my_rank || (p->send_count == 0 && p->recv_count == 0)) continue;
+        for (k = 0; k < p->send_count; k++) p->send_buf[k] = x_ext[p->send_idx[k]];
+        t[h].fd = p->fd;
+        t[h].send = (const char*)p->send_buf;
+        t[h].send_bytes = p->send_count * sizeof(double);
+        t[h].recv = (char*)(x_ext + own_cols + p->recv_first);
+        t[h].recv_bytes = p->recv_count * sizeof(double);
+        h++;
+    }
+    if (Exchange(t, h) != 0) exchange_failed = 1;
+    return NULL;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Compare_int
+ * Purpose:   qsort comparison of ints
+*/
+int Compare_int(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
@@ -0,0 +1,186 @@
+/**
+ * @file pth_gemm.c
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Parallel matrix-matrix multiplication C = A * B.
+ *
+ * Multiplies two binary matrix files with the cache-blocked, packed
+ * GEMM engine (gemm.h) instead of a matrix-vector product per column
+ * of B, which would stream A from memory once per column.
+ *
+ * Timing data is output to stderr in CSV format:
+ *   M,N,K,P,Kernel,Time_Overall,Time_Work,GFLOPS
+ * for A M x K and B K x N, where Kernel is the microkernel selected for
+ * this CPU and GFLOPS is 2MNK / Time_Work.
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "timer.h"
+#include "gemm.h"
+
+/* Function prototypes */
+void Usage(char* prog_name);
+int Read_matrix(char* filename, double** A_p, int* m_p, int* n_p);
+int Write_matrix(char* filename, double* A, int rows, int cols);
+
+int main(int argc, char* argv[]) {
+    double *A = NULL, *B = NULL, *C = NULL;
+    int m, k, k_B, n, thread_count;
+    double start_total, end_total, start_work, end_work;
+
+    /* Start overall timing */
+    GET_TIME(start_total);
+
+    /* Check command line arguments */
+    if (argc != 5) {
+        Usage(argv[0]);
+        exit(1);
+    }
+
+    /* Get number of threads */
+    thread_count = atoi(argv[4]);
+    if (thread_count <= 0) {
+        fprintf(stderr, "Error: Number of threads must be positive\n");
+        exit(1);
+    }
+
+    /* Read matrices A and B */
+    if (Read_matrix(argv[1], &A, &m, &k) != 0) {
+        fprintf(stderr, "Error: Failed to read matrix A from %s\n", argv[1]);
+        exit(1);
+    }
+    if (Read_matrix(argv[2], &B, &k_B, &n) != 0) {
+        fprintf(stderr, "Error: Failed to read matrix B from %s\n", argv[2]);
+        free(A);
+        exit(1);
+    }
+
+    /* Check compatibility for matrix multiplication */
+    if (k != k_B) {
+        fprintf(stderr, "Error: Incompatible dimensions for multiplication\n");
+        fprintf(stderr, "  Matrix A is %d x %d, Matrix B is %d x %d\n", m, k, k_B, n);
+        free(A);
+        free(B);
+        exit(1);
+    }
+
+    /* Allocate result matrix C */
+    C = (double*)malloc((size_t)m * n * sizeof(double));
+    if (C == NULL) {
+        fprintf(stderr, "Error: Cannot allocate memory for result matrix\n");
+        free(A);
+        free(B);
+        exit(1);
+    }
+
+    /* Multiply */
+    GET_TIME(start_work);
+    if (Gemm(m, n, k, A, k, B, n, C, n, thread_count) != 0) {
+        fprintf(stderr, "Error: Cannot allocate memory for packing buffers\n");
+        exit(1);
+    }
+    GET_TIME(end_work);
+
+    /* Write result to file */
+    if (Write_matrix(argv[3], C, m, n) != 0) {
+        fprintf(stderr, "Error: Failed to write result to %s\n", argv[3]);
+        exit(1);
+    }
+
+    GET_TIME(end_total);
+
+    /* Print timing results to stderr */
+    fprintf(stderr, "%d,%d,%d,%d,%s,%e,%e,%f\n", m, n, k, thread_count,
+            Gemm_kernel_name(), end_total - start_total, end_work - start_work,
+            2.0 * m * n * k / (end_work - start_work) / 1e9);
+
+    /* Clean up */
+    free(A);
+    free(B);
+    free(C);
+
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Usage
+ * Purpose:   Print usage message
+*/
+void Usage(char* prog_name) {
+    fprintf(stderr, "Usage: %s <file_A> <file_B> <file_C> <num_threads>\n", prog_name);
+    fprintf(stderr, "  Computes C = A * B\n");
+    fprintf(stderr, "  Example: %s A.mat B.mat C.mat 4\n", prog_name);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Read_matrix
+ * Purpose:   Read a binary matrix file
+*/
+int Read_matrix(char* filename, double** A_p, int* m_p, int* n_p) {
+    FILE* fp;
+    int rows, cols;
+    double* A;
+
+    fp = fopen(filename, "rb");
+    if (fp == NULL) return -1;
+
+    if (fread(&rows, sizeof(int), 1, fp) != 1 ||
+        fread(&cols, sizeof(int), 1, fp) != 1) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (rows <= 0 || cols <= 0) {
+        fclose(fp);
+        return -1;
+    }
+
+    A = (double*)malloc((size_t)rows * cols * sizeof(double));
+    if (A == NULL) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (fread(A, sizeof(double), (size_t)rows * cols, fp) != (size_t)rows * cols) {
+        free(A);
+        fclose(fp);
+        return -1;
+    }
+
+    fclose(fp);
+    *A_p = A;
+    *m_p = rows;
+    *n_p = cols;
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Write_matrix
+ * Purpose:   Write a matrix to a binary file
+*/
+int Write_matrix(char* filename, double* A, int rows, int cols) {
+    FILE* fp;
+
+    fp = fopen(filename, "wb");
+    if (fp == NULL) return -1;
+
+    if (fwrite(&rows, sizeof(int), 1, fp) != 1 ||
+        fwrite(&cols, sizeof(int), 1, fp) != 1) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (fwrite(A, sizeof(double), (size_t)rows * cols, fp) != (size_t)rows * cols) {
+        fclose(fp);
+        return -1;
+    }
+
+    fclose(fp);
+    return 0;
+}
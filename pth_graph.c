@@ -0,0 +1,440 @@
+/**
+ * @file pth_graph.c
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Graph algorithms as repeated matvecs over semirings.
+ *
+ * A is the weighted adjacency matrix of a directed graph, stored so
+ * that row i lists the edges into vertex i: A[i][j] is the weight of
+ * the edge j -> i. A may be a dense .mat file, where zeros mean "no
+ * edge", or a CSR or CSC file (see mat_format.h). Each step of an
+ * algorithm is one product over a semiring (semiring.h), divided among
+ * the threads by rows with Quinn's macros:
+ *
+ *   bellman-ford  shortest distances from the source over min-plus:
+ *                 d = min(d, A * d), until d stops changing. A change
+ *                 in round N means a negative cycle.
+ *   bfs           breadth-first levels from the source over or-and:
+ *                 the next frontier is A * frontier, restricted to
+ *                 unvisited vertices (only those rows are computed).
+ *   bfs-push      the same levels, with the frontier kept sparse and
+ *                 expanded by Spmspv (spmspv.h) on A in CSC, masked by
+ *                 the visited vertices: each round's work follows the
+ *                 edges out of the frontier instead of every row.
+ *
+ * For the pull algorithms the thread team lives for the whole run; at
+ * the barrier ending each round one thread combines the per-thread
+ * "changed" flags and swaps the vectors for the next round.
+ *
+ * The output is an N x 1 vector: distances (inf if unreachable) or
+ * levels (-1 if unreachable).
+ *
+ * Timing data is output to stderr in CSV format:
+ *   N,P,Algorithm,Rounds,Time_Overall,Time_Work
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "quinn.h"
+#include "timer.h"
+#include "mat_format.h"
+#include "sparse.h"
+#include "semiring.h"
+#include "spmspv.h"
+
+/* Algorithms */
+#define ALG_BELLMAN_FORD 0
+#define ALG_BFS          1
+#define ALG_BFS_PUSH     2
+
+/* Global variables */
+int thread_count;
+int algorithm;
+int n;                         /* vertices */
+Csr csr;
+Csc csc;                       /* bfs-push only */
+double *cur, *next;            /* distances, or frontiers for bfs */
+double *level;                 /* bfs levels */
+int* changed;                  /* per-thread: did this round change anything */
+int rounds = 0;
+int done = 0;
+int negative_cycle = 0;
+pthread_barrier_t barrier;
+
+/* Function prototypes */
+void Usage(char* prog_name);
+int Read_graph(char* filename);
+int Read_matrix(char* filename, double** A_p, int* m_p, int* n_p);
+int Write_vector(char* filename, double y[], int m);
+int Relax_rows(int first_row, int last_row);
+int Expand_rows(int first_row, int last_row);
+void* Pth_graph(void* rank);
+int Bfs_push(int source);
+
+int main(int argc, char* argv[]) {
+    int opt, source = 0, i;
+    long thread;
+    pthread_t* thread_handles;
+    double start_total, end_total, start_work, end_work;
+
+    /* Start overall timing */
+    GET_TIME(start_total);
+
+    /* Parse options */
+    while ((opt = getopt(argc, argv, "s:")) != -1) {
+        switch (opt) {
+            case 's': source = atoi(optarg); break;
+            default:
+                Usage(argv[0]);
+                exit(1);
+        }
+    }
+
+    /* Check command line arguments */
+    if (argc - optind != 4) {
+        Usage(argv[0]);
+        exit(1);
+    }
+    if (strcmp(argv[optind], "bellman-ford") == 0) algorithm = ALG_BELLMAN_FORD;
+    else if (strcmp(argv[optind], "bfs") == 0) algorithm = ALG_BFS;
+    else if (strcmp(argv[optind], "bfs-push") == 0) algorithm = ALG_BFS_PUSH;
+    else {
+        fprintf(stderr, "Error: Unknown algorithm %s\n", argv[optind]);
+        exit(1);
+    }
+
+    /* Get number of threads */
+    thread_count = atoi(argv[optind + 3]);
+    if (thread_count <= 0) {
+        fprintf(stderr, "Error: Number of threads must be positive\n");
+        exit(1);
+    }
+    thread_handles = (pthread_t*)malloc(thread_count * sizeof(pthread_t));
+    changed = (int*)malloc(thread_count * sizeof(int));
+    if (thread_handles == NULL || changed == NULL) {
+        fprintf(stderr, "Error: Cannot allocate memory for thread handles\n");
+        exit(1);
+    }
+
+    /* Read the graph */
+    if (Read_graph(argv[optind + 1]) != 0) {
+        fprintf(stderr, "Error: Failed to read graph from %s\n", argv[optind + 1]);
+        exit(1);
+    }
+    if (csr.rows != csr.cols) {
+        fprintf(stderr, "Error: Adjacency matrix must be square (%d x %d)\n", csr.rows, csr.cols);
+        exit(1);
+    }
+    n = csr.rows;
+    if (source < 0 || source >= n) {
+        fprintf(stderr, "Error: Source vertex %d out of range 0..%d\n", source, n - 1);
+        exit(1);
+    }
+
+    if (algorithm == ALG_BFS_PUSH && Csc_from_csr(&csr, thread_count, &csc) != 0) {
+        fprintf(stderr, "Error: Cannot allocate memory for CSC matrix\n");
+        exit(1);
+    }
+
+    /* Start from the source alone */
+    cur = (double*)malloc(n * sizeof(double));
+    next = (double*)malloc(n * sizeof(double));
+    level = (double*)malloc(n * sizeof(double));
+    if (cur == NULL || next == NULL || level == NULL) {
+        fprintf(stderr, "Error: Cannot allocate memory for vectors\n");
+        exit(1);
+    }
+    for (i = 0; i < n; i++) {
+        cur[i] = algorithm == ALG_BELLMAN_FORD ? INFINITY : 0.0;
+        level[i] = -1.0;
+    }
+    cur[source] = algorithm == ALG_BELLMAN_FORD ? 0.0 : 1.0;
+    level[source] = 0.0;
+
+    /* Run the rounds */
+    GET_TIME(start_work);
+    if (algorithm == ALG_BFS_PUSH) {
+        if (Bfs_push(source) != 0) {
+            fprintf(stderr, "Error: Cannot allocate memory for the frontier\n");
+            exit(1);
+        }
+    } else {
+        pthread_barrier_init(&barrier, NULL, thread_count);
+        for (thread = 0; thread < thread_count; thread++) {
+            pthread_create(&thread_handles[thread], NULL, Pth_graph, (void*)thread);
+        }
+        for (thread = 0; thread < thread_count; thread++) {
+            pthread_join(thread_handles[thread], NULL);
+        }
+        pthread_barrier_destroy(&barrier);
+    }
+    GET_TIME(end_work);
+
+    if (negative_cycle) {
+        fprintf(stderr, "Error: Negative cycle reachable from vertex %d\n", source);
+        exit(1);
+    }
+
+    /* Write result to file */
+    if (Write_vector(argv[optind + 2], algorithm == ALG_BELLMAN_FORD ? cur : level, n) != 0) {
+        fprintf(stderr, "Error: Failed to write result to %s\n", argv[optind + 2]);
+        exit(1);
+    }
+
+    GET_TIME(end_total);
+
+    /* Print timing results to stderr */
+    fprintf(stderr, "%d,%d,%s,%d,%e,%e\n", n, thread_count, argv[optind], rounds,
+            end_total - start_total, end_work - start_work);
+
+    /* Clean up */
+    Csr_free(&csr);
+    if (algorithm == ALG_BFS_PUSH) Csc_free(&csc);
+    free(cur);
+    free(next);
+    free(level);
+    free(changed);
+    free(thread_handles);
+
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Usage
+ * Purpose:   Print usage message
+*/
+void Usage(char* prog_name) {
+    fprintf(stderr, "Usage: %s [-s source] <algorithm> <file_A> <file_out> <num_threads>\n", prog_name);
+    fprintf(stderr, "  Runs a graph algorithm on adjacency matrix A, where A[i][j]\n");
+    fprintf(stderr, "  is the weight of edge j -> i (dense zeros mean no edge)\n");
+    fprintf(stderr, "  algorithm: bellman-ford (distances), bfs or bfs-push (levels)\n");
+    fprintf(stderr, "  -s source  source vertex (default 0)\n");
+    fprintf(stderr, "  Example: %s -s 0 bfs G.csr levels.mat 4\n", prog_name);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Read_graph
+ * Purpose:   Read A as CSR, compressing a dense matrix
+*/
+int Read_graph(char* filename) {
+    double* A;
+    Csc csc;
+    int rows, cols, status;
+
+    switch (Sparse_format(filename)) {
+        case MAT_FORMAT_CSR:
+            return Csr_read(filename, &csr);
+        case MAT_FORMAT_CSC:
+            if (Csc_read(filename, &csc) != 0) return -1;
+            status = Csr_from_csc(&csc, thread_count, &csr);
+            Csc_free(&csc);
+            return status;
+        case MAT_FORMAT_DENSE:
+            if (Read_matrix(filename, &A, &rows, &cols) != 0) return -1;
+            status = Csr_from_dense(A, rows, cols, thread_count, &csr);
+            free(A);
+            return status;
+        default:
+            return -1;
+    }
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Read_matrix
+ * Purpose:   Read a binary matrix file
+*/
+int Read_matrix(char* filename, double** A_p, int* m_p, int* n_p) {
+    FILE* fp;
+    int rows, cols;
+    double* A;
+
+    fp = fopen(filename, "rb");
+    if (fp == NULL) return -1;
+
+    if (fread(&rows, sizeof(int), 1, fp) != 1 ||
+        fread(&cols, sizeof(int), 1, fp) != 1) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (rows <= 0 || cols <= 0) {
+        fclose(fp);
+        return -1;
+    }
+
+    A = (double*)malloc((size_t)rows * cols * sizeof(double));
+    if (A == NULL) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (fread(A, sizeof(double), (size_t)rows * cols, fp) != (size_t)rows * cols) {
+        free(A);
+        fclose(fp);
+        return -1;
+    }
+
+    fclose(fp);
+    *A_p = A;
+    *m_p = rows;
+    *n_p = cols;
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Write_vector
+ * Purpose:   Write a vector to binary file
+*/
+int Write_vector(char* filename, double y[], int m) {
+    FILE* fp;
+    int cols = 1;
+
+    fp = fopen(filename, "wb");
+    if (fp == NULL) return -1;
+
+    if (fwrite(&m, sizeof(int), 1, fp) != 1 ||
+        fwrite(&cols, sizeof(int), 1, fp) != 1) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (fwrite(y, sizeof(double), m, fp) != m) {
+        fclose(fp);
+        return -1;
+    }
+
+    fclose(fp);
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Relax_rows
+ * Purpose:   One Bellman-Ford round on rows first_row..last_row:
+ *            next = min(cur, A * cur) over min-plus
+ * Return:    1 if any distance improved, 0 otherwise
+*/
+int Relax_rows(int first_row, int last_row) {
+    int i, improved = 0;
+
+    Semiring_csr_rows(SR_MIN_PLUS, &csr, cur, next, first_row, last_row);
+    for (i = first_row; i <= last_row; i++) {
+        if (next[i] < cur[i]) improved = 1;
+        else next[i] = cur[i];
+    }
+    return improved;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Expand_rows
+ * Purpose:   One BFS round on rows first_row..last_row: the unvisited
+ *            vertices with an edge from the frontier form the next
+ *            frontier and get level rounds + 1. Visited rows are skipped,
+ *            so the kernel runs on each stretch of unvisited rows.
+ * Return:    1 if any vertex was reached, 0 otherwise
+*/
+int Expand_rows(int first_row, int last_row) {
+    int i, start, reached = 0;
+
+    i = first_row;
+    while (i <= last_row) {
+        if (level[i] >= 0.0) {
+            next[i++] = 0.0;
+            continue;
+        }
+        start = i;
+        while (i <= last_row && level[i] < 0.0) i++;
+        Semiring_csr_rows(SR_OR_AND, &csr, cur, next, start, i - 1);
+    }
+    for (i = first_row; i <= last_row; i++) {
+        if (next[i] != 0.0) {
+            level[i] = rounds + 1;
+            reached = 1;
+        }
+    }
+    return reached;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Pth_graph
+ * Purpose:   Thread function: run rounds on this thread's rows until
+ *            the serial thread at the end-of-round barrier says to stop
+*/
+void* Pth_graph(void* rank) {
+    long my_rank = (long)rank;
+    int first_row = BLOCK_LOW(my_rank, thread_count, n);
+    int last_row = BLOCK_HIGH(my_rank, thread_count, n);
+    int thread, any;
+    double* tmp;
+
+    while (!done) {
+        if (algorithm == ALG_BFS) changed[my_rank] = Expand_rows(first_row, last_row);
+        else changed[my_rank] = Relax_rows(first_row, last_row);
+
+        /* One thread ends the round */
+        if (pthread_barrier_wait(&barrier) == PTHREAD_BARRIER_SERIAL_THREAD) {
+            any = 0;
+            for (thread = 0; thread < thread_count; thread++) any |= changed[thread];
+            rounds++;
+            tmp = cur;
+            cur = next;
+            next = tmp;
+            if (!any) done = 1;
+            else if (algorithm == ALG_BELLMAN_FORD && rounds >= n) {
+                negative_cycle = 1;
+                done = 1;
+            }
+        }
+        pthread_barrier_wait(&barrier);
+    }
+
+    return NULL;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Bfs_push
+ * Purpose:   BFS levels with a sparse frontier: each round is one
+ *            masked Spmspv over or-and on A in CSC
+ * Return:    0 on success, -1 on allocation failure
+*/
+int Bfs_push(int source) {
+    Spvec frontier, reached;
+    char* visited;
+    long k;
+
+    visited = (char*)calloc(n, sizeof(char));
+    if (visited == NULL || Spvec_alloc(&frontier, n, 1) != 0) {
+        free(visited);
+        return -1;
+    }
+    frontier.idx[0] = source;
+    frontier.val[0] = 1.0;
+    visited[source] = 1;
+
+    while (frontier.nnz > 0) {
+        if (Spmspv(SR_OR_AND, &csc, &frontier, visited, thread_count, &reached) != 0) {
+            Spvec_free(&frontier);
+            free(visited);
+            return -1;
+        }
+        rounds++;
+        for (k = 0; k < reached.nnz; k++) {
+            visited[reached.idx[k]] = 1;
+            level[reached.idx[k]] = rounds;
+        }
+        Spvec_free(&frontier);
+        frontier = reached;
+    }
+
+    Spvec_free(&frontier);
+    free(visited);
+    return 0;
+}
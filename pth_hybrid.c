@@ -0,0 +1,561 @@
+/**
+ * @file pth_hybrid.c
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Hybrid process x thread matrix-vector multiplication, one
+ *        process per NUMA node.
+ *
+ * Computes y = A * x for a dense A like pth_matrix_vector, but splits
+ * the rows between one process per NUMA node first (Quinn's macros) and
+ * only then between threads. Each process is bound to its node's CPUs
+ * with sched_setaffinity before it touches any data, so its block of
+ * A, its own copy of x and its heap are all allocated on that node, and
+ * its threads never read memory across the interconnect or contend
+ * with other nodes' threads for one allocator. Each thread reads its
+ * rows of A from the file itself, so the loads run in parallel too.
+ *
+ * The nodes and their CPUs come from /sys/devices/system/node, limited
+ * to the CPUs this program may run on. Without NUMA information the
+ * machine is one node.
+ *
+ * y is gathered in a shared anonymous mapping that every process
+ * writes its block of rows into, and the parent writes it out. The
+ * processes meet at a process-shared barrier after loading, so
+ * Time_Work covers the same product in every process.
+ *
+ * Timing data is output to stderr in CSV format:
+ *   N,P,Procs,Time_Overall,Time_Load,Time_Work
+ * where P is the total number of threads and Procs the number of
+ * processes. Time_Load is the longest any thread took to load, and
+ * Time_Work runs from the first thread starting its rows to the last
+ * one finishing.
+ *
+ * Options:
+ *   -N procs  processes to use instead of one per node; process p is
+ *             bound to node p mod nodes (e.g. to compare against one
+ *             process, or to split a node)
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "quinn.h"
+#include "timer.h"
+
+#define NODE_DIR "/sys/devices/system/node"
+
+/* Shared by all processes: the gathered y and per-thread results */
+typedef struct {
+    pthread_barrier_t loaded;  /* every thread of every process */
+    int failed;                /* set by a thread that could not load */
+    double* load;              /* per thread, indexed globally */
+    double* start;             /* when each thread began its rows */
+    double* finish;            /* ... and finished them */
+} Shared;
+
+/* Global variables */
+int thread_count;
+int proc_count;
+int m, n;
+char* file_A;
+double* x = NULL;              /* as read by the parent */
+double* y = NULL;              /* shared mapping */
+Shared* shared = NULL;         /* shared mapping */
+int node_count;
+cpu_set_t* node_cpus;
+
+/* Global variables: this process's share, after the fork */
+int my_proc;
+int my_threads;                /* threads in this process */
+int first_thread;              /* global index of its first thread */
+int first_row, my_rows;
+int fd_A;
+double* A_local = NULL;        /* my rows of A */
+double* x_local = NULL;        /* my copy of x */
+
+/* Function prototypes */
+void Usage(char* prog_name);
+int Read_matrix(char* filename, double** A_p, int* m_p, int* n_p);
+int Read_header(char* filename, int* m_p, int* n_p);
+int Write_vector(char* filename, double y[], int m);
+int Read_nodes(void);
+int Parse_cpulist(const char* text, cpu_set_t* set);
+int Read_text(const char* path, char* buf, int size);
+void* Map_shared(size_t bytes);
+int Run_process(void);
+void* Pth_hybrid(void* rank);
+
+int main(int argc, char* argv[]) {
+    int opt, m_x, n_x, p, status, failed = 0, t;
+    pid_t *pids, pid;
+    pthread_barrierattr_t attr;
+    double start_total, end_total, load = 0.0, start_work, end_work;
+    size_t shared_bytes;
+
+    /* Start overall timing */
+    GET_TIME(start_total);
+
+    /* Parse options */
+    proc_count = 0;
+    while ((opt = getopt(argc, argv, "N:")) != -1) {
+        switch (opt) {
+            case 'N':
+                proc_count = atoi(optarg);
+                if (proc_count <= 0) {
+                    fprintf(stderr, "Error: Number of processes must be positive\n");
+                    exit(1);
+                }
+                break;
+            default:
+                Usage(argv[0]);
+                exit(1);
+        }
+    }
+
+    /* Check command line arguments */
+    if (argc - optind != 4) {
+        Usage(argv[0]);
+        exit(1);
+    }
+
+    /* Get number of threads */
+    thread_count = atoi(argv[optind + 3]);
+    if (thread_count <= 0) {
+        fprintf(stderr, "Error: Number of threads must be positive\n");
+        exit(1);
+    }
+
+    /* A's shape only; each thread reads its own rows later */
+    file_A = argv[optind];
+    if (Read_header(file_A, &m, &n) != 0) {
+        fprintf(stderr, "Error: Failed to read dense matrix A from %s\n", file_A);
+        exit(1);
+    }
+    if (Read_matrix(argv[optind + 1], &x, &m_x, &n_x) != 0) {
+        fprintf(stderr, "Error: Failed to read vector x from %s\n", argv[optind + 1]);
+        exit(1);
+    }
+    if (n_x != 1 || m_x != n) {
+        fprintf(stderr, "Error: x must be a %d x 1 vector (it is %d x %d)\n", n, m_x, n_x);
+        exit(1);
+    }
+
+    /* One process per node, each with at least one thread and row */
+    if (Read_nodes() != 0) {
+        fprintf(stderr, "Error: Cannot read the CPUs this program may use\n");
+        exit(1);
+    }
+    if (proc_count == 0) proc_count = node_count;
+    proc_count = MIN(proc_count, MIN(thread_count, m));
+
+    /* y and the barrier, shared with the processes */
+    y = (double*)Map_shared(m * sizeof(double));
+    shared_bytes = sizeof(Shared) + 3 * thread_count * sizeof(double);
+    shared = (Shared*)Map_shared(shared_bytes);
+    pids = (pid_t*)malloc(proc_count * sizeof(pid_t));
+    if (y == NULL || shared == NULL || pids == NULL) {
+        fprintf(stderr, "Error: Cannot allocate shared memory\n");
+        exit(1);
+    }
+    shared->load = (double*)(shared + 1);
+    shared->start = shared->load + thread_count;
+    shared->finish = shared->start + thread_count;
+    pthread_barrierattr_init(&attr);
+    pthread_barrierattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    if (pthread_barrier_init(&shared->loaded, &attr, thread_count) != 0) {
+        fprintf(stderr, "Error: Cannot create process-shared barrier\n");
+        exit(1);
+    }
+    pthread_barrierattr_destroy(&attr);
+
+    /* Start the processes */
+    fflush(stdout);
+    for (p = 0; p < proc_count; p++) {
+        pids[p] = fork();
+        if (pids[p] < 0) {
+            fprintf(stderr, "Error: Cannot fork: %s\n", strerror(errno));
+            for (t = 0; t < p; t++) kill(pids[t], SIGKILL);
+            exit(1);
+        }
+        if (pids[p] == 0) {
+            my_proc = p;
+            _exit(Run_process() == 0 ? 0 : 1);
+        }
+    }
+
+    /* Wait for them; one failing would leave the rest at the barrier */
+    for (p = 0; p < proc_count; p++) {
+        pid = wait(&status);
+        if (pid < 0) break;
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            if (!failed) {
+                for (t = 0; t < proc_count; t++) kill(pids[t], SIGKILL);
+            }
+            failed = 1;
+        }
+    }
+    if (failed || shared->failed) {
+        fprintf(stderr, "Error: A process failed\n");
+        exit(1);
+    }
+    start_work = shared->start[0];
+    end_work = shared->finish[0];
+    for (t = 0; t < thread_count; t++) {
+        load = MAX(load, shared->load[t]);
+        start_work = MIN(start_work, shared->start[t]);
+        end_work = MAX(end_work, shared->finish[t]);
+    }
+
+    /* Write result y */
+    if (Write_vector(argv[optind + 2], y, m) != 0) {
+        fprintf(stderr, "Error: Failed to write result to %s\n", argv[optind + 2]);
+        exit(1);
+    }
+
+    /* Stop overall timing */
+    GET_TIME(end_total);
+
+    /* Print timing results to stderr */
+    fprintf(stderr, "%d,%d,%d,%e,%e,%e\n", m, thread_count, proc_count,
+            end_total - start_total, load, end_work - start_work);
+
+    /* Clean up */
+    pthread_barrier_destroy(&shared->loaded);
+    munmap(shared, shared_bytes);
+    munmap(y, m * sizeof(double));
+    free(node_cpus);
+    free(pids);
+    free(x);
+
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Usage
+ * Purpose:   Print usage message
+*/
+void Usage(char* prog_name) {
+    fprintf(stderr, "Usage: %s [-N procs] <file_A> <file_x> <file_y> <num_threads>\n", prog_name);
+    fprintf(stderr, "  Runs one process per NUMA node, bound to it, splitting num_threads\n");
+    fprintf(stderr, "  and the rows of the dense matrix A between them\n");
+    fprintf(stderr, "  -N procs  use procs processes instead, bound to nodes round robin\n");
+    fprintf(stderr, "  Example: %s A.mat x.mat y.mat 32\n", prog_name);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Read_matrix
+ * Purpose:   Read a binary matrix file
+*/
+int Read_matrix(char* filename, double** A_p, int* m_p, int* n_p) {
+    FILE* fp;
+    int rows, cols;
+    double* M;
+
+    fp = fopen(filename, "rb");
+    if (fp == NULL) return -1;
+
+    if (fread(&rows, sizeof(int), 1, fp) != 1 ||
+        fread(&cols, sizeof(int), 1, fp) != 1) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (rows <= 0 || cols <= 0) {
+        fclose(fp);
+        return -1;
+    }
+
+    M = (double*)malloc((size_t)rows * cols * sizeof(double));
+    if (M == NULL) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (fread(M, sizeof(double), (size_t)rows * cols, fp) != (size_t)rows * cols) {
+        free(M);
+        fclose(fp);
+        return -1;
+    }
+
+    fclose(fp);
+    *A_p = M;
+    *m_p = rows;
+    *n_p = cols;
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Read_header
+ * Purpose:   Read and check a dense matrix file's header: positive
+ *            dimensions (so not a structured format) and a file long
+ *            enough for them
+ * Return:    0 on success, -1 on error
+*/
+int Read_header(char* filename, int* m_p, int* n_p) {
+    FILE* fp;
+    int dims[2];
+    long size;
+
+    fp = fopen(filename, "rb");
+    if (fp == NULL) return -1;
+    if (fread(dims, sizeof(int), 2, fp) != 2 || dims[0] <= 0 || dims[1] <= 0 ||
+        fseek(fp, 0, SEEK_END) != 0) {
+        fclose(fp);
+        return -1;
+    }
+    size = ftell(fp);
+    fclose(fp);
+    if (size < (long)sizeof(dims) + (long)dims[0] * dims[1] * (long)sizeof(double)) return -1;
+
+    *m_p = dims[0];
+    *n_p = dims[1];
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Write_vector
+ * Purpose:   Write a vector to binary file
+*/
+int Write_vector(char* filename, double y[], int m) {
+    FILE* fp;
+    int cols = 1;
+
+    fp = fopen(filename, "wb");
+    if (fp == NULL) return -1;
+
+    if (fwrite(&m, sizeof(int), 1, fp) != 1 ||
+        fwrite(&cols, sizeof(int), 1, fp) != 1) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (fwrite(y, sizeof(double), m, fp) != m) {
+        fclose(fp);
+        return -1;
+    }
+
+    fclose(fp);
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Read_nodes
+ * Purpose:   Fill node_cpus with the CPUs of each NUMA node that this
+ *            program may run on, skipping nodes left with none; one
+ *            node of all its CPUs if the kernel reports no NUMA
+ * Return:    0 on success, -1 on error
+*/
+int Read_nodes(void) {
+    cpu_set_t allowed, nodes, cpus;
+    char path[128], text[4096];
+    int node;
+
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return -1;
+    node_cpus = (cpu_set_t*)malloc(CPU_SETSIZE * sizeof(cpu_set_t));
+    if (node_cpus == NULL) return -1;
+    node_count = 0;
+
+    if (Read_text(NODE_DIR "/online", text, sizeof(text)) == 0 &&
+        Parse_cpulist(text, &nodes) == 0) {
+        for (node = 0; node < CPU_SETSIZE; node++) {
+            if (!CPU_ISSET(node, &nodes)) continue;
+            snprintf(path, sizeof(path), NODE_DIR "/node%d/cpulist", node);
+            if (Read_text(path, text, sizeof(text)) != 0 || Parse_cpulist(text, &cpus) != 0) {
+                continue;
+            }
+            CPU_AND(&node_cpus[node_count], &cpus, &allowed);
+            if (CPU_COUNT(&node_cpus[node_count]) > 0) node_count++;
+        }
+    }
+
+    if (node_count == 0) {
+        node_cpus[0] = allowed;
+        node_count = 1;
+    }
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Parse_cpulist
+ * Purpose:   Parse a kernel list such as "0-3,8,10-11" into a set
+ * Return:    0 on success, -1 if the text is not such a list
+*/
+int Parse_cpulist(const char* text, cpu_set_t* set) {
+    const char* s = text;
+    char* end;
+    long low, high, k;
+
+    CPU_ZERO(set);
+    while (*s != '\0' && *s != '\n') {
+        low = strtol(s, &end, 10);
+        if (end == s) return -1;
+        high = low;
+        s = end;
+        if (*s == '-') {
+            s++;
+            high = strtol(s, &end, 10);
+            if (end == s) return -1;
+            s = end;
+        }
+        if (low < 0 || high < low) return -1;
+        for (k = low; k <= high && k < CPU_SETSIZE; k++) CPU_SET(k, set);
+        if (*s == ',') s++;
+    }
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Read_text
+ * Purpose:   Read a small text file (a /sys attribute) into buf
+ * Return:    0 on success, -1 on error
+*/
+int Read_text(const char* path, char* buf, int size) {
+    FILE* fp;
+    size_t len;
+
+    fp = fopen(path, "r");
+    if (fp == NULL) return -1;
+    len = fread(buf, 1, size - 1, fp);
+    fclose(fp);
+    buf[len] = '\0';
+    return len > 0 ? 0 : -1;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Map_shared
+ * Purpose:   Zeroed memory shared with the processes forked after it
+ * Return:    the mapping, or NULL on error
+*/
+void* Map_shared(size_t bytes) {
+    void* p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    return p == MAP_FAILED ? NULL : p;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Run_process
+ * Purpose:   Body of process my_proc: bind to its node, then run its
+ *            threads over its block of rows
+ * Return:    0 on success, -1 on error
+*/
+int Run_process(void) {
+    pthread_t* thread_handles;
+    long thread;
+    int created;
+
+    my_threads = BLOCK_SIZE(my_proc, proc_count, thread_count);
+    first_thread = BLOCK_LOW(my_proc, proc_count, thread_count);
+    first_row = BLOCK_LOW(my_proc, proc_count, m);
+    my_rows = BLOCK_SIZE(my_proc, proc_count, m);
+
+    /* Bind first, so everything allocated below lands on the node */
+    if (sched_setaffinity(0, sizeof(cpu_set_t), &node_cpus[my_proc % node_count]) != 0) {
+        fprintf(stderr, "Error: Process %d cannot bind to its node: %s\n", my_proc,
+                strerror(errno));
+        shared->failed = 1;
+    }
+
+    /* Allocated here, first touched by the threads that use it */
+    A_local = (double*)malloc((size_t)my_rows * n * sizeof(double));
+    x_local = (double*)malloc(n * sizeof(double));
+    fd_A = open(file_A, O_RDONLY);
+    if (A_local == NULL || x_local == NULL || fd_A < 0) {
+        fprintf(stderr, "Error: Process %d cannot load its rows of A\n", my_proc);
+        shared->failed = 1;
+    }
+
+    /* The threads reach the barrier even on failure, so no one waits forever */
+    thread_handles = (pthread_t*)malloc(my_threads * sizeof(pthread_t));
+    if (thread_handles == NULL) return -1;
+    for (created = 0; created < my_threads; created++) {
+        if (pthread_create(&thread_handles[created], NULL, Pth_hybrid, (void*)(long)created) != 0) {
+            fprintf(stderr, "Error: Process %d cannot create threads\n", my_proc);
+            return -1;
+        }
+    }
+    for (thread = 0; thread < my_threads; thread++) {
+        pthread_join(thread_handles[thread], NULL);
+    }
+
+    free(thread_handles);
+    if (fd_A >= 0) close(fd_A);
+    free(A_local);
+    free(x_local);
+    return shared->failed ? -1 : 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Pth_hybrid
+ * Purpose:   Thread function: load this thread's rows of A (and its
+ *            share of x's copy), wait for every thread of every
+ *            process, then compute its rows of y into the shared y
+*/
+void* Pth_hybrid(void* rank) {
+    long my_rank = (long)rank;
+    long global = first_thread + my_rank;
+    int local_first_row, local_last_row, i, j;
+    int first_x, count_x;
+    double start, end;
+    size_t bytes, done;
+    ssize_t got;
+    char* dst;
+
+    local_first_row = BLOCK_LOW(my_rank, my_threads, my_rows);
+    local_last_row = BLOCK_HIGH(my_rank, my_threads, my_rows);
+
+    /* Load: rows straight from the file into node-local memory */
+    GET_TIME(start);
+    if (!shared->failed) {
+        first_x = BLOCK_LOW(my_rank, my_threads, n);
+        count_x = BLOCK_SIZE(my_rank, my_threads, n);
+        memcpy(x_local + first_x, x + first_x, count_x * sizeof(double));
+
+        dst = (char*)(A_local + (size_t)local_first_row * n);
+        bytes = (size_t)(local_last_row - local_first_row + 1) * n * sizeof(double);
+        for (done = 0; done < bytes; done += got) {
+            got = pread(fd_A, dst + done, bytes - done,
+                        2 * sizeof(int) + ((off_t)(first_row + local_first_row) * n) *
+                        (off_t)sizeof(double) + (off_t)done);
+            if (got <= 0) {
+                if (got < 0 && errno == EINTR) {
+                    got = 0;
+                    continue;
+                }
+                fprintf(stderr, "Error: Process %d cannot read its rows of A\n", my_proc);
+                shared->failed = 1;
+                break;
+            }
+        }
+    }
+    GET_TIME(end);
+    shared->load[global] = end - start;
+
+    pthread_barrier_wait(&shared->loaded);
+    if (shared->failed) return NULL;
+
+    /* Compute assigned rows */
+    GET_TIME(shared->start[global]);
+    for (i = local_first_row; i <= local_last_row; i++) {
+        double sum = 0.0;
+        for (j = 0; j < n; j++) {
+            sum += A_local[(size_t)i * n + j] * x_local[j];
+        }
+        y[first_row + i] = sum;
+    }
+    GET_TIME(shared->finish[global]);
+
+    return NULL;
+}
@@ -0,0 +1,353 @@
+/**
+ * @file pth_mat_chain.c
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Chained matrix-vector products y = A_1 * A_2 * ... * A_k * x.
+ *
+ * The chain is evaluated right to left as k matrix-vector stages, with
+ * every intermediate vector kept in memory. One team of pthreads runs
+ * all stages; each thread owns the same block of rows (Quinn's macros)
+ * of every stage's output.
+ *
+ * Stages are synchronized per row block rather than with a full
+ * barrier. Before a stage, each thread finds the span of nonzero columns
+ * in its rows of the stage's matrix and waits only for the threads that
+ * own that part of the previous stage's output. For dense matrices every
+ * thread needs the whole input vector, so this is a barrier; for banded
+ * or block-diagonal matrices threads run ahead into the next stage as
+ * soon as their neighbors are done, and only the span is multiplied.
+ *
+ * Timing data is output to stderr in CSV format:
+ *   N,P,Stages,Time_Overall,Time_Work,Time_Wait
+ * where Time_Wait is the mean time a thread spent waiting on the
+ * previous stage.
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "quinn.h"
+#include "timer.h"
+
+/* One matrix of the chain */
+typedef struct {
+    double* data;
+    int rows, cols;
+} Stage;
+
+/* Global variables */
+int thread_count;
+int num_stages;
+Stage* stages;          /* stages[s] is applied in step s (A_k first) */
+double** vec;           /* vec[0] = x, vec[s + 1] = output of step s */
+int* stages_done;       /* steps completed by each thread */
+double* wait_time;      /* per-thread time spent waiting */
+pthread_mutex_t done_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t done_cond = PTHREAD_COND_INITIALIZER;
+
+/* Function prototypes */
+void Usage(char* prog_name);
+int Read_matrix(char* filename, double** A_p, int* m_p, int* n_p);
+int Write_vector(char* filename, double y[], int m);
+void Row_span(const double* row, int n, int* first_p, int* last_p);
+void Wait_for_input(int s, int first_col, int last_col);
+void* Pth_chain(void* rank);
+
+int main(int argc, char* argv[]) {
+    int s, k, m_x, n_x;
+    long thread;
+    pthread_t* thread_handles;
+    double start_total, end_total, start_work, end_work, wait_sum = 0.0;
+
+    /* Start overall timing */
+    GET_TIME(start_total);
+
+    /* Check command line arguments */
+    if (argc < 5) {
+        Usage(argv[0]);
+        exit(1);
+    }
+    num_stages = argc - 4;
+
+    /* Get number of threads */
+    thread_count = atoi(argv[argc - 1]);
+    if (thread_count <= 0) {
+        fprintf(stderr, "Error: Number of threads must be positive\n");
+        exit(1);
+    }
+
+    stages = (Stage*)malloc(num_stages * sizeof(Stage));
+    vec = (double**)calloc(num_stages + 1, sizeof(double*));
+    stages_done = (int*)calloc(thread_count, sizeof(int));
+    wait_time = (double*)calloc(thread_count, sizeof(double));
+    thread_handles = (pthread_t*)malloc(thread_count * sizeof(pthread_t));
+    if (stages == NULL || vec == NULL || stages_done == NULL ||
+        wait_time == NULL || thread_handles == NULL) {
+        fprintf(stderr, "Error: Cannot allocate memory for the chain\n");
+        exit(1);
+    }
+
+    /* Read the matrices, A_k first since it is applied first */
+    for (s = 0; s < num_stages; s++) {
+        k = num_stages - s;
+        if (Read_matrix(argv[k], &stages[s].data, &stages[s].rows, &stages[s].cols) != 0) {
+            fprintf(stderr, "Error: Failed to read matrix A_%d from %s\n", k, argv[k]);
+            exit(1);
+        }
+    }
+
+    /* Read vector x (must be a column vector) */
+    if (Read_matrix(argv[argc - 3], &vec[0], &m_x, &n_x) != 0) {
+        fprintf(stderr, "Error: Failed to read vector x from %s\n", argv[argc - 3]);
+        exit(1);
+    }
+    if (n_x != 1) {
+        fprintf(stderr, "Error: x must be a column vector (n_x = %d, should be 1)\n", n_x);
+        exit(1);
+    }
+
+    /* Check that the chain is conformable */
+    for (s = 0; s < num_stages; s++) {
+        int in_len = s == 0 ? m_x : stages[s - 1].rows;
+        if (stages[s].cols != in_len) {
+            k = num_stages - s;
+            fprintf(stderr, "Error: Incompatible dimensions for multiplication\n");
+            if (s == 0) {
+                fprintf(stderr, "  Matrix A_%d is %d x %d, Vector x is %d x 1\n",
+                        k, stages[s].rows, stages[s].cols, m_x);
+            } else {
+                fprintf(stderr, "  Matrix A_%d is %d x %d, Matrix A_%d is %d x %d\n",
+                        k, stages[s].rows, stages[s].cols,
+                        k + 1, stages[s - 1].rows, stages[s - 1].cols);
+            }
+            exit(1);
+        }
+        vec[s + 1] = (double*)malloc((size_t)stages[s].rows * sizeof(double));
+        if (vec[s + 1] == NULL) {
+            fprintf(stderr, "Error: Cannot allocate memory for intermediate vectors\n");
+            exit(1);
+        }
+    }
+
+    /* Run every stage with one team */
+    GET_TIME(start_work);
+    for (thread = 0; thread < thread_count; thread++) {
+        pthread_create(&thread_handles[thread], NULL, Pth_chain, (void*)thread);
+    }
+    for (thread = 0; thread < thread_count; thread++) {
+        pthread_join(thread_handles[thread], NULL);
+        wait_sum += wait_time[thread];
+    }
+    GET_TIME(end_work);
+
+    /* Write result to file */
+    if (Write_vector(argv[argc - 2], vec[num_stages], stages[num_stages - 1].rows) != 0) {
+        fprintf(stderr, "Error: Failed to write result to %s\n", argv[argc - 2]);
+        exit(1);
+    }
+
+    GET_TIME(end_total);
+
+    /* Print timing results to stderr */
+    fprintf(stderr, "%d,%d,%d,%e,%e,%e\n", stages[num_stages - 1].rows, thread_count,
+            num_stages, end_total - start_total, end_work - start_work,
+            wait_sum / thread_count);
+
+    /* Clean up */
+    for (s = 0; s < num_stages; s++) free(stages[s].data);
+    for (s = 0; s <= num_stages; s++) free(vec[s]);
+    free(stages);
+    free(vec);
+    free(stages_done);
+    free(wait_time);
+    free(thread_handles);
+
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Usage
+ * Purpose:   Print usage message
+*/
+void Usage(char* prog_name) {
+    fprintf(stderr, "Usage: %s <file_A_1> ... <file_A_k> <file_x> <file_y> <num_threads>\n", prog_name);
+    fprintf(stderr, "  Computes y = A_1 * A_2 * ... * A_k * x, applying A_k first\n");
+    fprintf(stderr, "  Example: %s A.mat B.mat C.mat x.mat y.mat 4\n", prog_name);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Read_matrix
+ * Purpose:   Read a binary matrix file
+*/
+int Read_matrix(char* filename, double** A_p, int* m_p, int* n_p) {
+    FILE* fp;
+    int rows, cols;
+    double* A;
+
+    fp = fopen(filename, "rb");
+    if (fp == NULL) return -1;
+
+    if (fread(&rows, sizeof(int), 1, fp) != 1 ||
+        fread(&cols, sizeof(int), 1, fp) != 1) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (rows <= 0 || cols <= 0) {
+        fclose(fp);
+        return -1;
+    }
+
+    A = (double*)malloc((size_t)rows * cols * sizeof(double));
+    if (A == NULL) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (fread(A, sizeof(double), (size_t)rows * cols, fp) != (size_t)rows * cols) {
+        free(A);
+        fclose(fp);
+        return -1;
+    }
+
+    fclose(fp);
+    *A_p = A;
+    *m_p = rows;
+    *n_p = cols;
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Write_vector
+ * Purpose:   Write a vector to a binary file
+*/
+int Write_vector(char* filename, double y[], int m) {
+    FILE* fp;
+    int cols = 1;
+
+    fp = fopen(filename, "wb");
+    if (fp == NULL) return -1;
+
+    if (fwrite(&m, sizeof(int), 1, fp) != 1 ||
+        fwrite(&cols, sizeof(int), 1, fp) != 1) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (fwrite(y, sizeof(double), m, fp) != m) {
+        fclose(fp);
+        return -1;
+    }
+
+    fclose(fp);
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Row_span
+ * Purpose:   Find the first and last nonzero column of a row, scanning
+ *            in from both ends (a dense row costs two reads)
+ * Out:       first_p, last_p; first > last for an all-zero row
+*/
+void Row_span(const double* row, int n, int* first_p, int* last_p) {
+    int first = 0, last = n - 1;
+
+    while (first < n && row[first] == 0.0) first++;
+    while (last > first && row[last] == 0.0) last--;
+    *first_p = first;
+    *last_p = first < n ? last : -1;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Wait_for_input
+ * Purpose:   Block until the threads owning elements first_col..last_col
+ *            of step s's input vector have completed step s - 1
+*/
+void Wait_for_input(int s, int first_col, int last_col) {
+    int owner, lo, hi, len;
+
+    if (s == 0 || first_col > last_col) return;
+
+    len = stages[s].cols;
+    lo = BLOCK_OWNER(first_col, thread_count, len);
+    hi = BLOCK_OWNER(last_col, thread_count, len);
+
+    pthread_mutex_lock(&done_mutex);
+    for (owner = lo; owner <= hi; owner++) {
+        while (stages_done[owner] < s) {
+            pthread_cond_wait(&done_cond, &done_mutex);
+        }
+    }
+    pthread_mutex_unlock(&done_mutex);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Pth_chain
+ * Purpose:   Thread function: compute this thread's block of rows of
+ *            every stage, waiting only on the input it actually reads
+*/
+void* Pth_chain(void* rank) {
+    long my_rank = (long)rank;
+    int s, i, j, m, n, first_row, last_row;
+    int span_first, span_last, *first_col, *last_col, max_rows = 0;
+    double start_wait, end_wait;
+
+    for (s = 0; s < num_stages; s++) {
+        max_rows = MAX(max_rows, BLOCK_SIZE(my_rank, thread_count, stages[s].rows));
+    }
+    first_col = (int*)malloc((max_rows + 1) * sizeof(int));
+    last_col = (int*)malloc((max_rows + 1) * sizeof(int));
+    if (first_col == NULL || last_col == NULL) {
+        fprintf(stderr, "Error: Cannot allocate memory for row spans\n");
+        exit(1);
+    }
+
+    for (s = 0; s < num_stages; s++) {
+        const double* A = stages[s].data;
+        const double* x = vec[s];
+        double* y = vec[s + 1];
+
+        m = stages[s].rows;
+        n = stages[s].cols;
+        first_row = BLOCK_LOW(my_rank, thread_count, m);
+        last_row = BLOCK_HIGH(my_rank, thread_count, m);
+
+        /* Span of input this thread reads, found while others finish */
+        span_first = n;
+        span_last = -1;
+        for (i = first_row; i <= last_row; i++) {
+            Row_span(A + (size_t)i * n, n, &first_col[i - first_row], &last_col[i - first_row]);
+            span_first = MIN(span_first, first_col[i - first_row]);
+            span_last = MAX(span_last, last_col[i - first_row]);
+        }
+
+        GET_TIME(start_wait);
+        Wait_for_input(s, span_first, span_last);
+        GET_TIME(end_wait);
+        wait_time[my_rank] += end_wait - start_wait;
+
+        for (i = first_row; i <= last_row; i++) {
+            const double* row = A + (size_t)i * n;
+            double sum = 0.0;
+            for (j = first_col[i - first_row]; j <= last_col[i - first_row]; j++) {
+                sum += row[j] * x[j];
+            }
+            y[i] = sum;
+        }
+
+        /* Publish this block of step s */
+        pthread_mutex_lock(&done_mutex);
+        stages_done[my_rank] = s + 1;
+        pthread_cond_broadcast(&done_cond);
+        pthread_mutex_unlock(&done_mutex);
+    }
+
+    free(first_col);
+    free(last_col);
+    return NULL;
+}
@@ -0,0 +1,172 @@
+/**
+ * @file pth_mat_expr.c
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Evaluate a product of matrices and vectors in its cheapest order.
+ *
+ * The expression (see mat_expr.h) is parsed, its operands read, and the
+ * evaluation order with the fewest flops is chosen from the dimensions,
+ * regardless of how the product was parenthesized. For example
+ * "(A.mat * B.mat) * x.mat" is evaluated as A * (B * x), two
+ * matrix-vector products instead of a matrix-matrix product. Each
+ * product runs on a team of pthreads.
+ *
+ * The order as written and the chosen order are printed to stdout.
+ * Timing data is output to stderr in CSV format:
+ *   M,N,P,Flops_Written,Flops_Optimal,Flops_Saved,Flops_Actual,Time_Overall,Time_Work
+ * where Flops_Written and Flops_Optimal are the estimates for both
+ * orders and Flops_Actual is counted while evaluating. With -n the order
+ * as written is evaluated too, and its columns are appended:
+ *   Time_Written,Actual_Saved
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "timer.h"
+#include "mat_expr.h"
+
+/* Function prototypes */
+void Usage(char* prog_name);
+int Write_matrix(char* filename, double* A, int rows, int cols);
+
+int main(int argc, char* argv[]) {
+    Expr expr;
+    Expr_node* best;
+    double *y, *y_written = NULL;
+    double start_total, end_total, start_work, end_work, start_naive = 0.0, end_naive = 0.0;
+    double flops_written, flops_best, actual, actual_written = 0.0;
+    int opt, thread_count, run_written = 0;
+
+    /* Start overall timing */
+    GET_TIME(start_total);
+
+    /* Parse options */
+    while ((opt = getopt(argc, argv, "n")) != -1) {
+        switch (opt) {
+            case 'n': run_written = 1; break;
+            default:
+                Usage(argv[0]);
+                exit(1);
+        }
+    }
+
+    /* Check command line arguments */
+    if (argc - optind != 3) {
+        Usage(argv[0]);
+        exit(1);
+    }
+
+    /* Get number of threads */
+    thread_count = atoi(argv[optind + 2]);
+    if (thread_count <= 0) {
+        fprintf(stderr, "Error: Number of threads must be positive\n");
+        exit(1);
+    }
+
+    /* Parse the expression and read its operands */
+    if (Expr_parse(argv[optind], &expr) != 0) exit(1);
+    if (Expr_load(&expr) != 0) {
+        Expr_free(&expr);
+        exit(1);
+    }
+
+    /* Choose the order */
+    best = Expr_optimize(&expr);
+    if (best == NULL) {
+        fprintf(stderr, "Error: Cannot allocate memory for the evaluation order\n");
+        Expr_free(&expr);
+        exit(1);
+    }
+    flops_written = Expr_flops(expr.written);
+    flops_best = Expr_flops(best);
+
+    printf("Written: ");
+    Expr_print(stdout, &expr, expr.written);
+    printf("\nOptimal: ");
+    Expr_print(stdout, &expr, best);
+    printf("\n");
+
+    /* Evaluate */
+    GET_TIME(start_work);
+    if (Expr_eval(&expr, best, thread_count, &y, &actual) != 0) {
+        fprintf(stderr, "Error: Cannot allocate memory for the product\n");
+        exit(1);
+    }
+    GET_TIME(end_work);
+
+    if (run_written) {
+        GET_TIME(start_naive);
+        if (Expr_eval(&expr, expr.written, thread_count, &y_written, &actual_written) != 0) {
+            fprintf(stderr, "Error: Cannot allocate memory for the product as written\n");
+            exit(1);
+        }
+        GET_TIME(end_naive);
+        free(y_written);
+    }
+
+    /* Write result to file */
+    if (Write_matrix(argv[optind + 1], y, best->rows, best->cols) != 0) {
+        fprintf(stderr, "Error: Failed to write result to %s\n", argv[optind + 1]);
+        exit(1);
+    }
+
+    GET_TIME(end_total);
+
+    /* Print timing results to stderr */
+    fprintf(stderr, "%d,%d,%d,%.0f,%.0f,%.0f,%.0f,%e,%e", best->rows, best->cols,
+            thread_count, flops_written, flops_best, flops_written - flops_best, actual,
+            end_total - start_total, end_work - start_work);
+    if (run_written) {
+        fprintf(stderr, ",%e,%.0f", end_naive - start_naive, actual_written - actual);
+    }
+    fprintf(stderr, "\n");
+
+    /* Clean up */
+    free(y);
+    Expr_free_tree(best);
+    Expr_free(&expr);
+
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Usage
+ * Purpose:   Print usage message
+*/
+void Usage(char* prog_name) {
+    fprintf(stderr, "Usage: %s [-n] <expression> <file_y> <num_threads>\n", prog_name);
+    fprintf(stderr, "  Evaluates a product of matrix files in the order with fewest flops\n");
+    fprintf(stderr, "  -n  also evaluate the order as written and report the savings\n");
+    fprintf(stderr, "  Example: %s \"(A.mat * B.mat) * x.mat\" y.mat 4\n", prog_name);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Write_matrix
+ * Purpose:   Write a matrix to a binary file
+*/
+int Write_matrix(char* filename, double* A, int rows, int cols) {
+    FILE* fp;
+
+    fp = fopen(filename, "wb");
+    if (fp == NULL) return -1;
+
+    if (fwrite(&rows, sizeof(int), 1, fp) != 1 ||
+        fwrite(&cols, sizeof(int), 1, fp) != 1) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (fwrite(A, sizeof(double), (size_t)rows * cols, fp) != (size_t)rows * cols) {
+        fclose(fp);
+        return -1;
+    }
+
+    fclose(fp);
+    return 0;
+}
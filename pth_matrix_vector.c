@@ -12,6 +12,46 @@
  * 
  * Timing data is output to stderr in CSV format:
  *   N,P,Time_Overall,Time_Work
+ * A may also be a sharded matrix (see mat_shard.h); its shards are then
+ * loaded in parallel, each thread reading the rows it will compute.
+ * A may also be a CSR file (see mat_format.h); each thread then runs
+ * the sparse kernel over its block of rows. A DCSR file (CSR with
+ * delta-coded column indices, sparse.h) runs the decoding kernel, which
+ * reads fewer index bytes. A codebook file (codebook.h) runs a kernel
+ * that looks 4- or 8-bit codes up in tables of A's values; it supports
+ * the plus-times semiring only. So does a bit matrix file (bitmat.h),
+ * whose kernel adds and subtracts the x_j its bits select, or counts
+ * bits when x is binary too (x is then packed inside Time_Work).
+ * 
+ * Optional columns are appended in this order when enabled:
+ *   Time_Prefault (-P), Time_Sync (-s), Policy,Time_Read,Resident (-F),
+ *   Semiring (-R), Time_Permute (-p)
+ * where Resident is the fraction of A's file (or of its shard files,
+ * weighted by size) left in the page cache.
+ *
+ * Options:
+ *   -c        load A through the shared-memory matrix cache (mat_cache.h):
+ *             the first run publishes A, later runs on the unchanged file
+ *             map the published copy instead of reading the file; if
+ *             the cache cannot be used, A is read directly after a warning
+ *   -C dir    like -c, with cache entries in dir (e.g. a hugetlbfs mount)
+ *   -m        compute y directly into a memory-mapped output file whose
+ *             header is written up front, instead of copying it out with
+ *             Write_vector afterwards
+ *   -s        with -m, flush the output file to disk in parallel after
+ *             the product, each thread syncing the pages of its own rows
+ *   -P        prefault A and y in parallel before the product: each thread
+ *             first-touches the rows it will compute, so page faults are
+ *             taken concurrently, pages land on the thread's NUMA node,
+ *             and the fault cost is timed apart from Time_Work
+ *   -F policy page-cache policy for reading A (mat_io.h): default,
+ *             willneed, dontneed or keep
+ *   -z MB     panel size for -F reads (default 64)
+ *   -R name   compute y = A * x over a semiring (semiring.h): plus-times
+ *             (default), min-plus, max-times or or-and
+ *   -p perm   A was reordered by reorder_matrix with permutation perm:
+ *             x is given and y is written in the original order, and
+ *             are permuted to and from A's order around the product
  * 
  * @version 1.0
  * @date 2026-02-16
@@ -22,9 +62,22 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "quinn.h"
 #include "timer.h"
+#include "mat_cache.h"
+#include "mat_io.h"
+#include "mat_shard.h"
+#include "mat_format.h"
+#include "sparse.h"
+#include "semiring.h"
+#include "codebook.h"
+#include "bitmat.h"
 
 /* Global variables */
 int thread_count;
@@ -32,52 +85,207 @@ double *A = NULL;
 double *x = NULL;
 double *y = NULL;
 int m, n;
+int use_cache = 0;
+char* cache_dir = NULL;
+int map_output = 0;
+int sync_output = 0;
+int prefault = 0;
+int io_policy = -1;
+size_t panel_bytes = IO_DEFAULT_PANEL_BYTES;
+int sharded = 0;
+Shard_manifest manifest;
+int format = MAT_FORMAT_DENSE;
+Csr csr;
+Dcsr dcsr;
+Codebook book;
+Bitmat bits;
+uint64_t* x_bits = NULL;       /* x packed, for a bit matrix and binary x */
+int semiring = SR_PLUS_TIMES;
+int semiring_set = 0;
+int* perm = NULL;
 
 /* Function prototypes */
 void Usage(char* prog_name);
 int Read_matrix(char* filename, double** A_p, int* m_p, int* n_p);
+int Open_matrix(char* filename, FILE** fp_p, int* m_p, int* n_p);
+int Read_matrix_data(FILE* fp, double* A, int m, int n);
 int Write_vector(char* filename, double y[], int m);
+int Read_permutation(char* filename, int n, int** perm_p);
+double* Map_vector(char* filename, int m);
+double Resident_fraction(char* filename);
 void* Pth_mat_vect(void* rank);
+void* Pth_sync_output(void* rank);
+void* Pth_prefault(void* rank);
+void* Pth_load_shards(void* rank);
+void Free_A(void);
+void Free_y(void);
 
 int main(int argc, char* argv[]) {
-    int m_x, n_x;
+    int m_x, n_x, opt;
     long thread;
     pthread_t* thread_handles;
     double start_total, end_total, start_work, end_work;
+    double start_sync = 0.0, end_sync = 0.0;
+    double start_fault = 0.0, end_fault = 0.0;
+    double start_read = 0.0, end_read = 0.0;
+    double resident = -1.0;
+    double start_perm, end_perm, time_perm = 0.0;
+    double *x_orig, *y_orig = NULL;
+    char* perm_file = NULL;
+    int i;
+    int failed;
+    void* status;
+    FILE* fp_A = NULL;
     
     /* Start overall timing */
     GET_TIME(start_total);
     
+    /* Parse options */
+    while ((opt = getopt(argc, argv, "cC:msPF:z:R:p:")) != -1) {
+        switch (opt) {
+            case 'c': use_cache = 1; break;
+            case 'C': use_cache = 1; cache_dir = optarg; break;
+            case 'm': map_output = 1; break;
+            case 's': sync_output = 1; break;
+            case 'P': prefault = 1; break;
+            case 'F':
+                io_policy = Io_parse_policy(optarg);
+                if (io_policy < 0) {
+                    fprintf(stderr, "Error: Unknown page-cache policy %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'z':
+                if (Io_parse_megabytes(optarg, &panel_bytes) != 0) {
+                    fprintf(stderr, "Error: -z needs a positive number of MB\n");
+                    Usage(argv[0]);
+                    exit(1);
+                }
+                break;
+            case 'R':
+                semiring = Semiring_parse(optarg);
+                semiring_set = 1;
+                if (semiring < 0) {
+                    fprintf(stderr, "Error: Unknown semiring %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'p': perm_file = optarg; break;
+            default:
+                Usage(argv[0]);
+                exit(1);
+        }
+    }
+    
     /* Check command line arguments */
-    if (argc != 5) {
+    if (argc - optind != 4 || (sync_output && !map_output)) {
         Usage(argv[0]);
         exit(1);
     }
     
     /* Get number of threads */
-    thread_count = atoi(argv[4]);
+    thread_count = atoi(argv[optind + 3]);
     if (thread_count <= 0) {
         fprintf(stderr, "Error: Number of threads must be positive\n");
         exit(1);
     }
     
     /* Read matrix A */
-    if (Read_matrix(argv[1], &A, &m, &n) != 0) {
-        fprintf(stderr, "Error: Failed to read matrix A from %s\n", argv[1]);
+    GET_TIME(start_read);
+    sharded = Shard_is_manifest(argv[optind]);
+    if (!sharded) format = Sparse_format(argv[optind]);
+    if (format == MAT_FORMAT_CSR || format == MAT_FORMAT_DCSR) {
+        if (use_cache || prefault || io_policy >= 0) {
+            fprintf(stderr, "Error: -c, -C, -P and -F apply to dense matrices only\n");
+            exit(1);
+        }
+        if (format == MAT_FORMAT_CSR ? Csr_read(argv[optind], &csr) != 0
+                                     : Dcsr_read(argv[optind], &dcsr) != 0) {
+            fprintf(stderr, "Error: Failed to read sparse matrix A from %s\n", argv[optind]);
+            exit(1);
+        }
+        m = format == MAT_FORMAT_CSR ? csr.rows : dcsr.rows;
+        n = format == MAT_FORMAT_CSR ? csr.cols : dcsr.cols;
+    } else if (format == MAT_FORMAT_CODEBOOK) {
+        if (use_cache || prefault || io_policy >= 0 || semiring != SR_PLUS_TIMES) {
+            fprintf(stderr, "Error: -c, -C, -P, -F and -R do not apply to codebook matrices\n");
+            exit(1);
+        }
+        if (Codebook_read(argv[optind], &book) != 0) {
+            fprintf(stderr, "Error: Failed to read codebook matrix A from %s\n", argv[optind]);
+            exit(1);
+        }
+        m = book.rows;
+        n = book.cols;
+    } else if (format == MAT_FORMAT_BITMAT) {
+        if (use_cache || prefault || io_policy >= 0 || semiring != SR_PLUS_TIMES) {
+            fprintf(stderr, "Error: -c, -C, -P, -F and -R do not apply to bit matrices\n");
+            exit(1);
+        }
+        if (Bitmat_read(argv[optind], &bits) != 0) {
+            fprintf(stderr, "Error: Failed to read bit matrix A from %s\n", argv[optind]);
+            exit(1);
+        }
+        m = bits.rows;
+        n = bits.cols;
+    } else if (format != MAT_FORMAT_DENSE) {
+        fprintf(stderr, "Error: Unsupported matrix format in %s\n", argv[optind]);
+        exit(1);
+    } else if (use_cache && sharded) {
+        fprintf(stderr, "Error: The matrix cache does not support sharded matrices\n");
         exit(1);
     }
     
+    /* The cache only saves a read: if it fails, read A directly */
+    if (format == MAT_FORMAT_DENSE && use_cache &&
+        Cache_load_matrix(argv[optind], cache_dir, thread_count, &A, &m, &n) != 0) {
+        fprintf(stderr, "Warning: Cannot load matrix A from %s through the cache, reading it directly\n",
+                argv[optind]);
+        use_cache = 0;
+    }
+    if (format == MAT_FORMAT_DENSE && !use_cache) {
+        if (sharded) {
+            /* Shards are loaded in parallel once the threads are ready */
+            if (Shard_read_manifest(argv[optind], &manifest) != 0) {
+                fprintf(stderr, "Error: Failed to read shard manifest %s\n", argv[optind]);
+                exit(1);
+            }
+            m = manifest.rows;
+            n = manifest.cols;
+            A = (double*)malloc((size_t)m * n * sizeof(double));
+            if (A == NULL) {
+                fprintf(stderr, "Error: Cannot allocate memory for matrix A\n");
+                exit(1);
+            }
+        } else if (prefault) {
+            /* Data is read after the pages have been prefaulted */
+            if (Open_matrix(argv[optind], &fp_A, &m, &n) != 0) {
+                fprintf(stderr, "Error: Failed to read matrix A from %s\n", argv[optind]);
+                exit(1);
+            }
+            A = (double*)malloc((size_t)m * n * sizeof(double));
+            if (A == NULL) {
+                fprintf(stderr, "Error: Cannot allocate memory for matrix A\n");
+                exit(1);
+            }
+        } else if (Read_matrix(argv[optind], &A, &m, &n) != 0) {
+            fprintf(stderr, "Error: Failed to read matrix A from %s\n", argv[optind]);
+            exit(1);
+        }
+    }
+    GET_TIME(end_read);
+    
     /* Read vector x */
-    if (Read_matrix(argv[2], &x, &m_x, &n_x) != 0) {
-        fprintf(stderr, "Error: Failed to read vector x from %s\n", argv[2]);
-        free(A);
+    if (Read_matrix(argv[optind + 1], &x, &m_x, &n_x) != 0) {
+        fprintf(stderr, "Error: Failed to read vector x from %s\n", argv[optind + 1]);
+        Free_A();
         exit(1);
     }
     
     /* Check that x is a column vector */
     if (n_x != 1) {
         fprintf(stderr, "Error: x must be a column vector (n_x = %d, should be 1)\n", n_x);
-        free(A);
+        Free_A();
         free(x);
         exit(1);
     }
@@ -86,16 +294,30 @@ int main(int argc, char* argv[]) {
     if (n != m_x) {
         fprintf(stderr, "Error: Incompatible dimensions for multiplication\n");
         fprintf(stderr, "  Matrix A is %d x %d, Vector x is %d x 1\n", m, n, m_x);
-        free(A);
+        Free_A();
         free(x);
         exit(1);
     }
     
-    /* Allocate result vector */
-    y = (double*)malloc(m * sizeof(double));
+    /* Read the permutation A was reordered with */
+    if (perm_file != NULL) {
+        if (m != n) {
+            fprintf(stderr, "Error: -p needs a square matrix (A is %d x %d)\n", m, n);
+            exit(1);
+        }
+        if (Read_permutation(perm_file, n, &perm) != 0) {
+            fprintf(stderr, "Error: %s is not a permutation of 0..%d\n", perm_file, n - 1);
+            exit(1);
+        }
+    }
+    
+    /* Allocate result vector, or map it from the output file */
+    if (map_output) y = Map_vector(argv[optind + 2], m);
+    else y = (double*)malloc(m * sizeof(double));
     if (y == NULL) {
-        fprintf(stderr, "Error: Cannot allocate memory for result vector\n");
-        free(A);
+        if (map_output) fprintf(stderr, "Error: Cannot map result file %s\n", argv[optind + 2]);
+        else fprintf(stderr, "Error: Cannot allocate memory for result vector\n");
+        Free_A();
         free(x);
         exit(1);
     }
@@ -104,15 +326,75 @@ int main(int argc, char* argv[]) {
     thread_handles = (pthread_t*)malloc(thread_count * sizeof(pthread_t));
     if (thread_handles == NULL) {
         fprintf(stderr, "Error: Cannot allocate memory for thread handles\n");
-        free(A);
+        Free_A();
         free(x);
-        free(y);
+        Free_y();
         exit(1);
     }
     
+    /* Prefault A and y in parallel, then fill A */
+    if (prefault) {
+        GET_TIME(start_fault);
+        for (thread = 0; thread < thread_count; thread++) {
+            pthread_create(&thread_handles[thread], NULL, Pth_prefault, (void*)thread);
+        }
+        for (thread = 0; thread < thread_count; thread++) {
+            pthread_join(thread_handles[thread], NULL);
+        }
+        GET_TIME(end_fault);
+        
+        if (fp_A != NULL) {
+            GET_TIME(start_read);
+            if (Read_matrix_data(fp_A, A, m, n) != 0) {
+                fprintf(stderr, "Error: Failed to read matrix A from %s\n", argv[optind]);
+                exit(1);
+            }
+            fclose(fp_A);
+            GET_TIME(end_read);
+        }
+    }
+    
+    /* Load shards in parallel */
+    if (sharded) {
+        GET_TIME(start_read);
+        for (thread = 0; thread < thread_count; thread++) {
+            pthread_create(&thread_handles[thread], NULL, Pth_load_shards, (void*)thread);
+        }
+        failed = 0;
+        for (thread = 0; thread < thread_count; thread++) {
+            pthread_join(thread_handles[thread], &status);
+            if (status != NULL) failed = 1;
+        }
+        GET_TIME(end_read);
+        if (failed) {
+            fprintf(stderr, "Error: Failed to read shards of matrix A from %s\n", argv[optind]);
+            exit(1);
+        }
+    }
+    
+    /* Take x to A's order; y is computed in A's order into a buffer */
+    if (perm != NULL) {
+        GET_TIME(start_perm);
+        x_orig = x;
+        y_orig = y;
+        x = (double*)malloc(n * sizeof(double));
+        y = (double*)malloc(m * sizeof(double));
+        if (x == NULL || y == NULL) {
+            fprintf(stderr, "Error: Cannot allocate memory for permuted vectors\n");
+            exit(1);
+        }
+        for (i = 0; i < n; i++) x[i] = x_orig[perm[i]];
+        free(x_orig);
+        GET_TIME(end_perm);
+        time_perm += end_perm - start_perm;
+    }
+    
     /* Start work timing */
     GET_TIME(start_work);
     
+    /* A binary x against a bit matrix is multiplied by popcounts */
+    if (format == MAT_FORMAT_BITMAT) x_bits = Bitmat_pack_vector(x, n);
+    
     /* Create threads */
     for (thread = 0; thread < thread_count; thread++) {
         pthread_create(&thread_handles[thread], NULL, Pth_mat_vect, (void*)thread);
@@ -126,12 +408,34 @@ int main(int argc, char* argv[]) {
     /* End work timing */
     GET_TIME(end_work);
     
-    /* Write result */
-    if (Write_vector(argv[3], y, m) != 0) {
-        fprintf(stderr, "Error: Failed to write result to %s\n", argv[3]);
-        free(A);
-        free(x);
+    /* Return y to the original order */
+    if (perm != NULL) {
+        GET_TIME(start_perm);
+        for (i = 0; i < m; i++) y_orig[perm[i]] = y[i];
         free(y);
+        y = y_orig;
+        GET_TIME(end_perm);
+        time_perm += end_perm - start_perm;
+    }
+    
+    /* Flush mapped output in parallel */
+    if (sync_output) {
+        GET_TIME(start_sync);
+        for (thread = 0; thread < thread_count; thread++) {
+            pthread_create(&thread_handles[thread], NULL, Pth_sync_output, (void*)thread);
+        }
+        for (thread = 0; thread < thread_count; thread++) {
+            pthread_join(thread_handles[thread], NULL);
+        }
+        GET_TIME(end_sync);
+    }
+    
+    /* Write result (already in place when mapped) */
+    if (!map_output && Write_vector(argv[optind + 2], y, m) != 0) {
+        fprintf(stderr, "Error: Failed to write result to %s\n", argv[optind + 2]);
+        Free_A();
+        free(x);
+        Free_y();
         free(thread_handles);
         exit(1);
     }
@@ -139,13 +443,26 @@ int main(int argc, char* argv[]) {
     /* End overall timing */
     GET_TIME(end_total);
     
+    /* Measure how much of A's file (or shards) the read left in the page cache */
+    if (io_policy >= 0) resident = Resident_fraction(argv[optind]);
+    
     /* Print timing results to stderr */
-    fprintf(stderr, "%d,%d,%e,%e\n", m, thread_count, end_total - start_total, end_work - start_work);
+    fprintf(stderr, "%d,%d,%e,%e", m, thread_count, end_total - start_total, end_work - start_work);
+    if (prefault) fprintf(stderr, ",%e", end_fault - start_fault);
+    if (sync_output) fprintf(stderr, ",%e", end_sync - start_sync);
+    if (io_policy >= 0) {
+        fprintf(stderr, ",%s,%e,%.3f", Io_policy_name(io_policy), end_read - start_read, resident);
+    }
+    if (semiring_set) fprintf(stderr, ",%s", Semiring_name(semiring));
+    if (perm != NULL) fprintf(stderr, ",%e", time_perm);
+    fprintf(stderr, "\n");
     
     /* Clean up */
-    free(A);
+    Free_A();
     free(x);
-    free(y);
+    free(x_bits);
+    Free_y();
+    free(perm);
     free(thread_handles);
     
     return 0;
@@ -156,9 +473,21 @@ int main(int argc, char* argv[]) {
  * Purpose:   Print usage message
 */
 void Usage(char* prog_name) {
-    fprintf(stderr, "Usage: %s <file_A> <file_x> <file_y> <num_threads>\n", prog_name);
+    fprintf(stderr, "Usage: %s [options] <file_A> <file_x> <file_y> <num_threads>\n", prog_name);
     fprintf(stderr, "  Multiplies matrix A by vector x using pthreads\n");
     fprintf(stderr, "  Stores result in y and prints timing to stderr\n");
+    fprintf(stderr, "  -c        load A through the shared-memory matrix cache\n");
+    fprintf(stderr, "  -C dir    use dir for cache entries (e.g. hugetlbfs mount)\n");
+    fprintf(stderr, "  -m        compute y directly into a memory-mapped output file\n");
+    fprintf(stderr, "  -s        with -m, flush the output file in parallel\n");
+    fprintf(stderr, "  -P        prefault A and y in parallel, timed separately\n");
+    fprintf(stderr, "  -F policy page-cache policy for reads: default, willneed,\n");
+    fprintf(stderr, "            dontneed or keep\n");
+    fprintf(stderr, "  -z MB     panel size for -F reads (default 64)\n");
+    fprintf(stderr, "  -R name   semiring: plus-times (default), min-plus,\n");
+    fprintf(stderr, "            max-times or or-and\n");
+    fprintf(stderr, "  -p perm   A was reordered with perm (reorder_matrix); x and y\n");
+    fprintf(stderr, "            are in the original order\n");
     fprintf(stderr, "  Example: %s A.mat x.mat y.mat 4\n", prog_name);
 }
 
@@ -171,39 +500,73 @@ int Read_matrix(char* filename, double** A_p, int* m_p, int* n_p) {
     int rows, cols;
     double* A;
     
-    fp = fopen(filename, "rb");
-    if (fp == NULL) return -1;
+    if (Open_matrix(filename, &fp, &rows, &cols) != 0) return -1;
     
-    if (fread(&rows, sizeof(int), 1, fp) != 1 ||
-        fread(&cols, sizeof(int), 1, fp) != 1) {
+    A = (double*)malloc((size_t)rows * cols * sizeof(double));
+    if (A == NULL) {
         fclose(fp);
         return -1;
     }
     
-    if (rows <= 0 || cols <= 0) {
+    if (Read_matrix_data(fp, A, rows, cols) != 0) {
+        free(A);
         fclose(fp);
         return -1;
     }
     
-    A = (double*)malloc(rows * cols * sizeof(double));
-    if (A == NULL) {
+    fclose(fp);
+    *A_p = A;
+    *m_p = rows;
+    *n_p = cols;
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Open_matrix
+ * Purpose:   Open a binary matrix file and read its dimensions, leaving
+ *            the file positioned at the start of the data
+ * Return:    0 on success, -1 on error
+*/
+int Open_matrix(char* filename, FILE** fp_p, int* m_p, int* n_p) {
+    FILE* fp;
+    int rows, cols;
+    
+    fp = fopen(filename, "rb");
+    if (fp == NULL) return -1;
+    
+    if (fread(&rows, sizeof(int), 1, fp) != 1 ||
+        fread(&cols, sizeof(int), 1, fp) != 1) {
         fclose(fp);
         return -1;
     }
     
-    if (fread(A, sizeof(double), rows * cols, fp) != rows * cols) {
-        free(A);
+    if (rows <= 0 || cols <= 0) {
         fclose(fp);
         return -1;
     }
     
-    fclose(fp);
-    *A_p = A;
+    *fp_p = fp;
     *m_p = rows;
     *n_p = cols;
     return 0;
 }
 
+/*-------------------------------------------------------------------
+ * Function:  Read_matrix_data
+ * Purpose:   Read the m x n data of a matrix opened with Open_matrix
+ * Return:    0 on success, -1 on error
+*/
+int Read_matrix_data(FILE* fp, double* A, int m, int n) {
+    /* With a page-cache policy, read in panels past the 8-byte header */
+    if (io_policy >= 0) {
+        return Io_read_panels(fileno(fp), A, (size_t)m * n * sizeof(double),
+                              2 * sizeof(int), io_policy, panel_bytes);
+    }
+    
+    if (fread(A, sizeof(double), (size_t)m * n, fp) != (size_t)m * n) return -1;
+    return 0;
+}
+
 /*-------------------------------------------------------------------
  * Function:  Write_vector
  * Purpose:   Write a vector to binary file
@@ -230,6 +593,110 @@ int Write_vector(char* filename, double y[], int m) {
     return 0;
 }
 
+/*-------------------------------------------------------------------
+ * Function:  Read_permutation
+ * Purpose:   Read a permutation written by reorder_matrix (an n x 1
+ *            vector of indices) and check that it is one
+ * Return:    0 on success, -1 on error
+*/
+int Read_permutation(char* filename, int n, int** perm_p) {
+    double* values;
+    int rows, cols, i, k;
+    int *p, *seen;
+    
+    if (Read_matrix(filename, &values, &rows, &cols) != 0) return -1;
+    p = (int*)malloc(n * sizeof(int));
+    seen = (int*)calloc(n, sizeof(int));
+    if (rows != n || cols != 1 || p == NULL || seen == NULL) {
+        free(values);
+        free(p);
+        free(seen);
+        return -1;
+    }
+    
+    for (i = 0; i < n; i++) {
+        k = (int)values[i];
+        if (values[i] != k || k < 0 || k >= n || seen[k]) break;
+        seen[k] = 1;
+        p[i] = k;
+    }
+    free(values);
+    free(seen);
+    if (i < n) {
+        free(p);
+        return -1;
+    }
+    *perm_p = p;
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Map_vector
+ * Purpose:   Create a binary vector file of length m, write its header
+ *            and map the data area, so results go straight into the
+ *            page cache
+ * Return:    pointer to the mapped vector data, or NULL on error
+*/
+double* Map_vector(char* filename, int m) {
+    int fd;
+    int header[2];
+    size_t bytes = 2 * sizeof(int) + (size_t)m * sizeof(double);
+    char* base;
+    
+    fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return NULL;
+    
+    if (ftruncate(fd, bytes) != 0) {
+        close(fd);
+        return NULL;
+    }
+    
+    base = (char*)mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return NULL;
+    
+    /* Write dimensions (m x 1) */
+    header[0] = m;
+    header[1] = 1;
+    memcpy(base, header, sizeof(header));
+    
+    return (double*)(base + sizeof(header));
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Resident_fraction
+ * Purpose:   Fraction of A's data in the page cache: of its file, or of
+ *            all its shard files weighted by their sizes when A is
+ *            sharded (the manifest itself is not read with -F)
+ * Return:    the fraction, or -1.0 if it cannot be determined
+*/
+double Resident_fraction(char* filename) {
+    struct stat st;
+    double fraction, resident = 0.0, total = 0.0;
+    int fd, k;
+
+    if (!sharded) {
+        fd = open(filename, O_RDONLY);
+        if (fd < 0) return -1.0;
+        fraction = Io_resident_fraction(fd);
+        close(fd);
+        return fraction;
+    }
+
+    for (k = 0; k < manifest.num_shards; k++) {
+        fd = open(manifest.shards[k].path, O_RDONLY);
+        if (fd < 0) return -1.0;
+        if (fstat(fd, &st) != 0 || (fraction = Io_resident_fraction(fd)) < 0.0) {
+            close(fd);
+            return -1.0;
+        }
+        close(fd);
+        resident += fraction * st.st_size;
+        total += st.st_size;
+    }
+    return total > 0.0 ? resident / total : -1.0;
+}
+
 /*-------------------------------------------------------------------
  * Function:  Pth_mat_vect
  * Purpose:   Thread function for parallel matrix-vector multiplication
@@ -244,13 +711,139 @@ void* Pth_mat_vect(void* rank) {
     local_first_row = BLOCK_LOW(my_rank, thread_count, m);
     local_last_row = BLOCK_HIGH(my_rank, thread_count, m);
     
-    /* Compute assigned rows */
+    /* Sparse A, or another semiring: the specialized kernels */
+    if (format == MAT_FORMAT_CSR) {
+        Semiring_csr_rows(semiring, &csr, x, y, local_first_row, local_last_row);
+        return NULL;
+    }
+    if (format == MAT_FORMAT_DCSR) {
+        Semiring_dcsr_rows(semiring, &dcsr, x, y, local_first_row, local_last_row);
+        return NULL;
+    }
+    if (format == MAT_FORMAT_CODEBOOK) {
+        Codebook_rows(&book, x, y, local_first_row, local_last_row);
+        return NULL;
+    }
+    if (format == MAT_FORMAT_BITMAT) {
+        if (x_bits != NULL) Bitmat_rows_bits(&bits, x_bits, y, local_first_row, local_last_row);
+        else Bitmat_rows(&bits, x, y, local_first_row, local_last_row);
+        return NULL;
+    }
+    if (semiring != SR_PLUS_TIMES) {
+        Semiring_dense_rows(semiring, A, n, x, y, local_first_row, local_last_row);
+        return NULL;
+    }
+    
+    /* Compute assigned rows, storing each y[i] once since y may be a
+       shared file mapping */
     for (i = local_first_row; i <= local_last_row; i++) {
-        y[i] = 0.0;
+        double sum = 0.0;
         for (j = 0; j < n; j++) {
-            y[i] += A[i * n + j] * x[j];
+            sum += A[i * n + j] * x[j];
         }
+        y[i] = sum;
     }
     
     return NULL;
 }
+
+/*-------------------------------------------------------------------
+ * Function:  Pth_sync_output
+ * Purpose:   Thread function: write back the pages of the mapped output
+ *            file that hold this thread's rows
+*/
+void* Pth_sync_output(void* rank) {
+    long my_rank = (long)rank;
+    long page = sysconf(_SC_PAGESIZE);
+    char *base, *first, *last;
+    
+    if (BLOCK_SIZE(my_rank, thread_count, m) <= 0) return NULL;
+    
+    /* Byte range of this thread's rows, widened to whole pages */
+    base = (char*)y - 2 * sizeof(int);
+    first = (char*)&y[BLOCK_LOW(my_rank, thread_count, m)];
+    last = (char*)&y[BLOCK_HIGH(my_rank, thread_count, m) + 1];
+    first = base + (first - base) / page * page;
+    
+    msync(first, last - first, MS_SYNC);
+    
+    return NULL;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Pth_prefault
+ * Purpose:   Thread function: fault in the pages of this thread's rows
+ *            of A and y before the product. Private buffers are zeroed,
+ *            which also places them on this thread's NUMA node; a cached
+ *            (read-only, shared) A is only read, one load per page.
+*/
+void* Pth_prefault(void* rank) {
+    long my_rank = (long)rank;
+    long page = sysconf(_SC_PAGESIZE) / sizeof(double);
+    int local_first_row, local_last_row;
+    size_t k, first, last;
+    volatile double sink = 0.0;
+    
+    local_first_row = BLOCK_LOW(my_rank, thread_count, m);
+    local_last_row = BLOCK_HIGH(my_rank, thread_count, m);
+    if (local_last_row < local_first_row) return NULL;
+    
+    first = (size_t)local_first_row * n;
+    last = (size_t)(local_last_row + 1) * n;
+    if (use_cache) {
+        for (k = first; k < last; k += page) sink += A[k];
+    } else {
+        memset(&A[first], 0, (last - first) * sizeof(double));
+    }
+    
+    memset(&y[local_first_row], 0, (local_last_row - local_first_row + 1) * sizeof(double));
+    
+    return NULL;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Pth_load_shards
+ * Purpose:   Thread function: read this thread's rows of a sharded A.
+ *            When the shard count matches the thread count, each thread
+ *            reads exactly one shard.
+ * Return:    NULL on success, non-NULL on error
+*/
+void* Pth_load_shards(void* rank) {
+    long my_rank = (long)rank;
+    int local_first_row, local_last_row;
+    
+    local_first_row = BLOCK_LOW(my_rank, thread_count, m);
+    local_last_row = BLOCK_HIGH(my_rank, thread_count, m);
+    if (local_last_row < local_first_row) return NULL;
+    
+    if (Shard_load_rows(&manifest, local_first_row, local_last_row,
+                        &A[(size_t)local_first_row * n], io_policy, panel_bytes) != 0) {
+        return (void*)1;
+    }
+    return NULL;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Free_A
+ * Purpose:   Release matrix A, whether read, mapped from the cache or
+ *            sparse
+*/
+void Free_A(void) {
+    if (format == MAT_FORMAT_CSR) Csr_free(&csr);
+    else if (format == MAT_FORMAT_DCSR) Dcsr_free(&dcsr);
+    else if (format == MAT_FORMAT_CODEBOOK) Codebook_free(&book);
+    else if (format == MAT_FORMAT_BITMAT) Bitmat_free(&bits);
+    else if (use_cache) Cache_release(A);
+    else free(A);
+    if (sharded) Shard_free_manifest(&manifest);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Free_y
+ * Purpose:   Release result vector y, whether allocated or mapped
+*/
+void Free_y(void) {
+    if (y == NULL) return;
+    if (map_output) munmap((char*)y - 2 * sizeof(int), 2 * sizeof(int) + (size_t)m * sizeof(double));
+    else free(y);
+}
@@ -0,0 +1,582 @@
+/**
+ * @file pth_matvec_batch.c
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Batch matrix-vector multiplication driven by a job manifest.
+ *
+ * This program runs many products y = A * x in one process. The job
+ * manifest is a text file with one job per line:
+ *   <file_A> <file_x> <file_y>
+ * Blank lines and lines starting with '#' are ignored.
+ *
+ * Jobs sharing the same A are grouped so each matrix is read once. A
+ * loader thread prefetches the next group's matrix into a second buffer
+ * while the current group computes, so disk reads overlap computation.
+ * One persistent thread team and one set of buffers (two matrix slots,
+ * x and y) are reused across all jobs; buffers only grow when a larger
+ * job arrives. A may be a plain or a sharded matrix (mat_shard.h).
+ *
+ * With -c (or -C dir), matrices are mapped from the shared-memory matrix
+ * cache (mat_cache.h) instead of read into the slots. Jobs whose matrix
+ * files are known to the cache with identical contents are then grouped
+ * together even under different paths, and share one resident copy.
+ * A matrix the cache cannot serve is read directly after a warning.
+ *
+ * One CSV row per job is output to stderr, in manifest order within each
+ * group:
+ *   Job,A,x,M,N,P,Time_Load,Time_Wait,Time_Work,Status
+ * where Job is the job's line number, Time_Load the loader's time to read
+ * A (on the first job of a group, 0 after), Time_Wait the time the team
+ * stalled waiting for that load, and Status ok or an error tag. A final
+ * summary row follows:
+ *   Jobs,Groups,P,Time_Overall
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "quinn.h"
+#include "timer.h"
+#include "mat_io.h"
+#include "mat_shard.h"
+#include "mat_cache.h"
+
+#define SLOT_FREE    0
+#define SLOT_LOADING 1
+#define SLOT_READY   2
+
+typedef struct {
+    char* file_A;
+    char* file_x;
+    char* file_y;
+    int line;          /* line number in the manifest */
+    int group;         /* index of its group of jobs sharing A */
+    int hash_known;    /* content fingerprint found in the cache */
+    unsigned long long hash;
+} Job;
+
+/* Matrix buffer for one group; the loader fills one while the team
+   computes from the other */
+typedef struct {
+    double* data;
+    size_t capacity;   /* in doubles, 0 while data is a cache mapping */
+    int mapped;        /* data is mapped from the matrix cache */
+    int rows, cols;
+    int group;         /* group loaded into this slot */
+    int state;         /* SLOT_FREE, SLOT_LOADING, SLOT_READY */
+    int failed;
+    double load_time;
+} Slot;
+
+/* Global variables */
+int thread_count;
+double *A = NULL;
+double *x = NULL;
+double *y = NULL;
+int m, n;
+int quit = 0;
+pthread_barrier_t start_barrier, done_barrier;
+
+Job* jobs = NULL;
+int num_jobs = 0, num_groups = 0;
+int* group_first = NULL;           /* first job of each group */
+Slot slots[2];
+pthread_mutex_t slot_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t slot_cond = PTHREAD_COND_INITIALIZER;
+int io_policy = IO_POLICY_DEFAULT;
+size_t panel_bytes = IO_DEFAULT_PANEL_BYTES;
+int use_cache = 0;
+char* cache_dir = NULL;
+
+/* Function prototypes */
+void Usage(char* prog_name);
+int Read_manifest(char* filename);
+int Compare_jobs(const void* a, const void* b);
+int Same_matrix(Job* a, Job* b);
+int Read_matrix_reuse(char* filename, double** A_p, size_t* cap_p, int* m_p, int* n_p);
+int Write_vector(char* filename, double y[], int m);
+int Load_slot(Slot* slot, char* filename);
+void* Loader(void* slot_pair);
+void* Pth_batch_team(void* rank);
+
+int main(int argc, char* argv[]) {
+    int opt, g, j, s, m_x, n_x, y_cap = 0;
+    size_t x_cap = 0;
+    long thread;
+    pthread_t* thread_handles;
+    pthread_t loader;
+    double start_total, end_total, start_wait, end_wait, start_work, end_work;
+    const char* status;
+
+    GET_TIME(start_total);
+
+    /* Parse options */
+    while ((opt = getopt(argc, argv, "F:z:cC:")) != -1) {
+        switch (opt) {
+            case 'F':
+                io_policy = Io_parse_policy(optarg);
+                if (io_policy < 0) {
+                    fprintf(stderr, "Error: Unknown page-cache policy %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'z':
+                if (Io_parse_megabytes(optarg, &panel_bytes) != 0) {
+                    fprintf(stderr, "Error: -z needs a positive number of MB\n");
+                    Usage(argv[0]);
+                    exit(1);
+                }
+                break;
+            case 'c': use_cache = 1; break;
+            case 'C': use_cache = 1; cache_dir = optarg; break;
+            default:
+                Usage(argv[0]);
+                exit(1);
+        }
+    }
+
+    /* Check command line arguments */
+    if (argc - optind != 2) {
+        Usage(argv[0]);
+        exit(1);
+    }
+
+    /* Get number of threads */
+    thread_count = atoi(argv[optind + 1]);
+    if (thread_count <= 0) {
+        fprintf(stderr, "Error: Number of threads must be positive\n");
+        exit(1);
+    }
+
+    /* Read and group jobs */
+    if (Read_manifest(argv[optind]) != 0) {
+        fprintf(stderr, "Error: Failed to read job manifest %s\n", argv[optind]);
+        exit(1);
+    }
+
+    /* Start the thread team and the loader */
+    pthread_barrier_init(&start_barrier, NULL, thread_count + 1);
+    pthread_barrier_init(&done_barrier, NULL, thread_count + 1);
+    thread_handles = (pthread_t*)malloc(thread_count * sizeof(pthread_t));
+    if (thread_handles == NULL) {
+        fprintf(stderr, "Error: Cannot allocate memory for thread handles\n");
+        exit(1);
+    }
+    for (thread = 0; thread < thread_count; thread++) {
+        pthread_create(&thread_handles[thread], NULL, Pth_batch_team, (void*)thread);
+    }
+    memset(slots, 0, sizeof(slots));
+    pthread_create(&loader, NULL, Loader, slots);
+
+    for (g = 0; g < num_groups; g++) {
+        Slot* slot = &slots[g % 2];
+
+        /* Wait for the loader to finish this group's matrix */
+        GET_TIME(start_wait);
+        pthread_mutex_lock(&slot_mutex);
+        while (slot->state != SLOT_READY || slot->group != g) {
+            pthread_cond_wait(&slot_cond, &slot_mutex);
+        }
+        pthread_mutex_unlock(&slot_mutex);
+        GET_TIME(end_wait);
+
+        A = slot->data;
+        m = slot->rows;
+        n = slot->cols;
+
+        for (j = group_first[g]; j < group_first[g + 1]; j++) {
+            start_work = end_work = 0.0;
+            status = "ok";
+
+            if (slot->failed) {
+                status = "bad_A";
+            } else if (Read_matrix_reuse(jobs[j].file_x, &x, &x_cap, &m_x, &n_x) != 0) {
+                status = "bad_x";
+            } else if (n_x != 1 || m_x != n) {
+                status = "dims";
+            } else {
+                if (m > y_cap) {
+                    free(y);
+                    y = (double*)malloc(m * sizeof(double));
+                    y_cap = y == NULL ? 0 : m;
+                }
+                if (y == NULL) {
+                    fprintf(stderr, "Error: Cannot allocate memory for result vector\n");
+                    exit(1);
+                }
+
+                GET_TIME(start_work);
+                pthread_barrier_wait(&start_barrier);
+                pthread_barrier_wait(&done_barrier);
+                GET_TIME(end_work);
+
+                if (Write_vector(jobs[j].file_y, y, m) != 0) status = "write";
+            }
+
+            fprintf(stderr, "%d,%s,%s,%d,%d,%d,%e,%e,%e,%s\n", jobs[j].line,
+                    jobs[j].file_A, jobs[j].file_x, m, n, thread_count,
+                    j == group_first[g] ? slot->load_time : 0.0,
+                    j == group_first[g] ? end_wait - start_wait : 0.0,
+                    end_work - start_work, status);
+        }
+
+        /* Hand the slot back to the loader */
+        pthread_mutex_lock(&slot_mutex);
+        slot->state = SLOT_FREE;
+        pthread_cond_broadcast(&slot_cond);
+        pthread_mutex_unlock(&slot_mutex);
+    }
+
+    /* Stop the team and the loader */
+    quit = 1;
+    pthread_barrier_wait(&start_barrier);
+    for (thread = 0; thread < thread_count; thread++) {
+        pthread_join(thread_handles[thread], NULL);
+    }
+    pthread_join(loader, NULL);
+
+    GET_TIME(end_total);
+    fprintf(stderr, "%d,%d,%d,%e\n", num_jobs, num_groups, thread_count, end_total - start_total);
+
+    /* Clean up */
+    pthread_barrier_destroy(&start_barrier);
+    pthread_barrier_destroy(&done_barrier);
+    for (s = 0; s < 2; s++) {
+        if (slots[s].mapped) Cache_release(slots[s].data);
+        else free(slots[s].data);
+    }
+    for (j = 0; j < num_jobs; j++) free(jobs[j].file_A);
+    free(jobs);
+    free(group_first);
+    free(x);
+    free(y);
+    free(thread_handles);
+
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Usage
+ * Purpose:   Print usage message
+*/
+void Usage(char* prog_name) {
+    fprintf(stderr, "Usage: %s [options] <job_manifest> <num_threads>\n", prog_name);
+    fprintf(stderr, "  Runs every job \"<file_A> <file_x> <file_y>\" in the manifest,\n");
+    fprintf(stderr, "  reading each distinct A once and prefetching the next one\n");
+    fprintf(stderr, "  -F policy page-cache policy for reading A: default, willneed,\n");
+    fprintf(stderr, "            dontneed or keep\n");
+    fprintf(stderr, "  -z MB     panel size for reads (default 64)\n");
+    fprintf(stderr, "  -c        map matrices from the shared-memory matrix cache,\n");
+    fprintf(stderr, "            grouping files with identical contents\n");
+    fprintf(stderr, "  -C dir    use dir for cache entries (e.g. hugetlbfs mount)\n");
+    fprintf(stderr, "  Example: %s -F dontneed jobs.txt 4\n", prog_name);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Read_manifest
+ * Purpose:   Parse the job manifest and group jobs by matrix file
+ * Return:    0 on success, -1 on error
+*/
+int Read_manifest(char* filename) {
+    FILE* fp;
+    char line[3 * 4096 + 16], a[4096], xs[4096], ys[4096];
+    int line_no = 0, cap = 0, j;
+    Job* grown;
+
+    fp = fopen(filename, "r");
+    if (fp == NULL) return -1;
+
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        line_no++;
+        if (sscanf(line, "%4095s", a) != 1 || a[0] == '#') continue;
+        if (sscanf(line, "%4095s %4095s %4095s", a, xs, ys) != 3) {
+            fprintf(stderr, "Error: %s:%d: expected <file_A> <file_x> <file_y>\n", filename, line_no);
+            fclose(fp);
+            return -1;
+        }
+        if (num_jobs == cap) {
+            cap = cap == 0 ? 64 : 2 * cap;
+            grown = (Job*)realloc(jobs, cap * sizeof(Job));
+            if (grown == NULL) {
+                fclose(fp);
+                return -1;
+            }
+            jobs = grown;
+        }
+
+        /* One allocation holds all three names */
+        jobs[num_jobs].file_A = (char*)malloc(strlen(a) + strlen(xs) + strlen(ys) + 3);
+        if (jobs[num_jobs].file_A == NULL) {
+            fclose(fp);
+            return -1;
+        }
+        jobs[num_jobs].file_x = jobs[num_jobs].file_A + strlen(a) + 1;
+        jobs[num_jobs].file_y = jobs[num_jobs].file_x + strlen(xs) + 1;
+        strcpy(jobs[num_jobs].file_A, a);
+        strcpy(jobs[num_jobs].file_x, xs);
+        strcpy(jobs[num_jobs].file_y, ys);
+        jobs[num_jobs].line = line_no;
+        num_jobs++;
+    }
+    fclose(fp);
+    if (num_jobs == 0) return -1;
+
+    /* Group by matrix, keeping manifest order of first appearance */
+    for (j = 0; j < num_jobs; j++) {
+        jobs[j].group = -1;
+        jobs[j].hash_known = use_cache &&
+                             Cache_lookup_hash(jobs[j].file_A, cache_dir, &jobs[j].hash) == 0;
+    }
+    for (j = 0; j < num_jobs; j++) {
+        int k;
+        if (jobs[j].group >= 0) continue;
+        for (k = j; k < num_jobs; k++) {
+            if (jobs[k].group < 0 && Same_matrix(&jobs[k], &jobs[j])) {
+                jobs[k].group = num_groups;
+            }
+        }
+        num_groups++;
+    }
+    qsort(jobs, num_jobs, sizeof(Job), Compare_jobs);
+
+    group_first = (int*)malloc((num_groups + 1) * sizeof(int));
+    if (group_first == NULL) return -1;
+    for (j = num_jobs - 1; j >= 0; j--) group_first[jobs[j].group] = j;
+    group_first[num_groups] = num_jobs;
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Compare_jobs
+ * Purpose:   qsort comparison: by group, then by manifest line
+*/
+int Compare_jobs(const void* a, const void* b) {
+    const Job* ja = (const Job*)a;
+    const Job* jb = (const Job*)b;
+    if (ja->group != jb->group) return ja->group - jb->group;
+    return ja->line - jb->line;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Same_matrix
+ * Purpose:   Decide whether two jobs use the same matrix: the same file,
+ *            or files the cache knows to have identical contents
+*/
+int Same_matrix(Job* a, Job* b) {
+    if (strcmp(a->file_A, b->file_A) == 0) return 1;
+    return a->hash_known && b->hash_known && a->hash == b->hash;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Read_matrix_reuse
+ * Purpose:   Read a binary matrix file into a reusable buffer, growing
+ *            it only when the file holds more elements than its capacity
+ * In/out:    A_p, cap_p (capacity in doubles)
+ * Out args:  m_p (rows), n_p (cols)
+ * Return:    0 on success, -1 on error
+*/
+int Read_matrix_reuse(char* filename, double** A_p, size_t* cap_p, int* m_p, int* n_p) {
+    FILE* fp;
+    int rows, cols;
+
+    fp = fopen(filename, "rb");
+    if (fp == NULL) return -1;
+
+    if (fread(&rows, sizeof(int), 1, fp) != 1 ||
+        fread(&cols, sizeof(int), 1, fp) != 1) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (rows <= 0 || cols <= 0) {
+        fclose(fp);
+        return -1;
+    }
+
+    if ((size_t)rows * cols > *cap_p) {
+        free(*A_p);
+        *A_p = (double*)malloc((size_t)rows * cols * sizeof(double));
+        *cap_p = *A_p == NULL ? 0 : (size_t)rows * cols;
+        if (*A_p == NULL) {
+            fclose(fp);
+            return -1;
+        }
+    }
+
+    if (fread(*A_p, sizeof(double), (size_t)rows * cols, fp) != (size_t)rows * cols) {
+        fclose(fp);
+        return -1;
+    }
+
+    fclose(fp);
+    *m_p = rows;
+    *n_p = cols;
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Write_vector
+ * Purpose:   Write a vector to binary file
+*/
+int Write_vector(char* filename, double y[], int m) {
+    FILE* fp;
+    int cols = 1;
+
+    fp = fopen(filename, "wb");
+    if (fp == NULL) return -1;
+
+    if (fwrite(&m, sizeof(int), 1, fp) != 1 ||
+        fwrite(&cols, sizeof(int), 1, fp) != 1) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (fwrite(y, sizeof(double), m, fp) != m) {
+        fclose(fp);
+        return -1;
+    }
+
+    fclose(fp);
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Load_slot
+ * Purpose:   Read a plain or sharded matrix into a slot, growing its
+ *            buffer only when the matrix is larger than any before,
+ *            or map a plain matrix from the cache (reading it when
+ *            the cache fails)
+ * Return:    0 on success, -1 on error
+*/
+int Load_slot(Slot* slot, char* filename) {
+    Shard_manifest manifest;
+    int fd = -1, header[2], sharded, status;
+    size_t count;
+
+    slot->rows = slot->cols = 0;
+    sharded = Shard_is_manifest(filename);
+
+    /* Plain matrices go through the cache when enabled; a previous
+     * mapping is never reused as a read buffer */
+    if (slot->mapped || (use_cache && !sharded)) {
+        if (slot->mapped) Cache_release(slot->data);
+        else free(slot->data);
+        slot->data = NULL;
+        slot->capacity = 0;
+        slot->mapped = 0;
+    }
+    if (use_cache && !sharded) {
+        if (Cache_load_matrix(filename, cache_dir, thread_count,
+                              &slot->data, &slot->rows, &slot->cols) == 0) {
+            slot->mapped = 1;
+            return 0;
+        }
+        /* The cache only saves a read: read A directly instead */
+        fprintf(stderr, "Warning: Cannot load matrix A from %s through the cache, reading it directly\n", filename);
+    }
+
+    if (sharded) {
+        if (Shard_read_manifest(filename, &manifest) != 0) return -1;
+        header[0] = manifest.rows;
+        header[1] = manifest.cols;
+    } else {
+        fd = open(filename, O_RDONLY);
+        if (fd < 0) return -1;
+        if (pread(fd, header, sizeof(header), 0) != sizeof(header) ||
+            header[0] <= 0 || header[1] <= 0) {
+            close(fd);
+            return -1;
+        }
+    }
+
+    count = (size_t)header[0] * header[1];
+    if (count > slot->capacity) {
+        free(slot->data);
+        slot->data = (double*)malloc(count * sizeof(double));
+        slot->capacity = slot->data == NULL ? 0 : count;
+    }
+
+    if (slot->data == NULL) status = -1;
+    else if (sharded) status = Shard_load_rows(&manifest, 0, header[0] - 1, slot->data, io_policy, panel_bytes);
+    else status = Io_read_panels(fd, slot->data, count * sizeof(double), sizeof(header), io_policy, panel_bytes);
+
+    if (sharded) Shard_free_manifest(&manifest);
+    else close(fd);
+
+    slot->rows = header[0];
+    slot->cols = header[1];
+    return status;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Loader
+ * Purpose:   Thread function: load each group's matrix into the slot
+ *            of slot_pair the team is not using, as soon as that slot
+ *            is free
+*/
+void* Loader(void* slot_pair) {
+    Slot* pair = (Slot*)slot_pair;
+    int g;
+    double start, finish;
+
+    for (g = 0; g < num_groups; g++) {
+        Slot* slot = &pair[g % 2];
+
+        pthread_mutex_lock(&slot_mutex);
+        while (slot->state != SLOT_FREE) pthread_cond_wait(&slot_cond, &slot_mutex);
+        slot->state = SLOT_LOADING;
+        pthread_mutex_unlock(&slot_mutex);
+
+        GET_TIME(start);
+        slot->failed = Load_slot(slot, jobs[group_first[g]].file_A) != 0;
+        GET_TIME(finish);
+        slot->load_time = finish - start;
+        slot->group = g;
+
+        pthread_mutex_lock(&slot_mutex);
+        slot->state = SLOT_READY;
+        pthread_cond_broadcast(&slot_cond);
+        pthread_mutex_unlock(&slot_mutex);
+    }
+
+    return NULL;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Pth_batch_team
+ * Purpose:   Thread function for the persistent team. Rows are split
+ *            with Quinn's macros for every job, since m changes from
+ *            job to job.
+*/
+void* Pth_batch_team(void* rank) {
+    long my_rank = (long)rank;
+    int local_first_row, local_last_row;
+    int i, j;
+
+    while (1) {
+        pthread_barrier_wait(&start_barrier);
+        if (quit) break;
+
+        local_first_row = BLOCK_LOW(my_rank, thread_count, m);
+        local_last_row = BLOCK_HIGH(my_rank, thread_count, m);
+        for (i = local_first_row; i <= local_last_row; i++) {
+            double sum = 0.0;
+            for (j = 0; j < n; j++) {
+                sum += A[(size_t)i * n + j] * x[j];
+            }
+            y[i] = sum;
+        }
+
+        pthread_barrier_wait(&done_barrier);
+    }
+
+    return NULL;
+}
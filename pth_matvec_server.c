@@ -0,0 +1,575 @@
+/**
+ * @file pth_matvec_server.c
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Matrix-vector multiplication server with priority scheduling.
+ *
+ * This program loads a matrix A once and serves products y = A * x to
+ * clients over a UNIX domain socket (see matvec_proto.h).
+ *
+ * Every request is split into row-block tasks of block_rows rows. Worker
+ * threads always take the next block from the highest priority class that
+ * has work, and within a class from the request with the earliest deadline
+ * (requests without a deadline run in arrival order). A large batch product
+ * therefore only delays an interactive request by at most one row block
+ * per worker.
+ *
+ * Admission control estimates how long a new request would wait behind
+ * the rows already queued at its priority or higher, using a running
+ * estimate of the per-row service time. Requests whose estimate exceeds
+ * the latency budget of their class, or their own deadline, are rejected
+ * with MV_BUSY so that clients back off instead of growing the queue.
+ * Requests whose deadline passes while queued are dropped with MV_EXPIRED.
+ *
+ * With -c (or -C dir), A is mapped from the shared-memory matrix cache
+ * (mat_cache.h), so servers and CLI runs on the same matrix contents
+ * share one resident copy. If the cache cannot be used, A is read
+ * directly after a warning.
+ *
+ * On SIGINT/SIGTERM a summary is printed to stderr in CSV format:
+ *   Class,Served,Busy,Expired,Mean_Latency,Max_Latency
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "quinn.h"
+#include "timer.h"
+#include "matvec_proto.h"
+#include "mat_cache.h"
+
+/* One client request; rows are handed out to workers in blocks */
+typedef struct Job {
+    double* x;
+    double* y;
+    int priority;
+    double arrival;           /* admission time */
+    double deadline;          /* absolute deadline, 0 = none */
+    double start;             /* time the first block was started */
+    int next_row;             /* next row not yet handed out */
+    int rows_done;            /* rows finished (or dropped) */
+    int expired;
+    pthread_cond_t done_cond;
+    struct Job* next;
+} Job;
+
+/* Global variables */
+int thread_count;
+double *A = NULL;
+int m, n;
+int block_rows = 0;
+double budget[MV_NUM_PRIO] = {0.0, 0.0};   /* latency budgets in seconds */
+int use_cache = 0;
+char* cache_dir = NULL;
+
+pthread_mutex_t queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t work_cond = PTHREAD_COND_INITIALIZER;
+Job* queue[MV_NUM_PRIO] = {NULL, NULL};
+long queued_rows[MV_NUM_PRIO] = {0, 0};    /* rows not yet handed out */
+double row_time = 0.0;                     /* EWMA of seconds per row */
+
+/* Statistics, protected by queue_mutex */
+long served[MV_NUM_PRIO], busy[MV_NUM_PRIO], expired[MV_NUM_PRIO];
+double total_latency[MV_NUM_PRIO], max_latency[MV_NUM_PRIO];
+
+volatile sig_atomic_t shutting_down = 0;
+
+/* Function prototypes */
+void Usage(char* prog_name);
+int Read_matrix(char* filename, double** A_p, int* m_p, int* n_p);
+int Read_full(int fd, void* buf, size_t bytes);
+int Write_full(int fd, const void* buf, size_t bytes);
+void Enqueue_job(Job* job);
+void Remove_job(Job* job);
+int Admit(int priority, double deadline, double now);
+void* Worker(void* matrix);
+void* Serve_client(void* arg);
+void Handle_signal(int sig);
+void Print_summary(void);
+void Free_A(void);
+
+int main(int argc, char* argv[]) {
+    int listen_fd, opt;
+    long thread;
+    pthread_t* thread_handles;
+    struct sockaddr_un addr;
+    struct sigaction sa;
+    char* socket_path;
+
+    /* Parse options */
+    while ((opt = getopt(argc, argv, "b:i:B:cC:")) != -1) {
+        switch (opt) {
+            case 'b': block_rows = atoi(optarg); break;
+            case 'i': budget[MV_PRIO_INTERACTIVE] = atof(optarg) / 1000.0; break;
+            case 'B': budget[MV_PRIO_BATCH] = atof(optarg) / 1000.0; break;
+            case 'c': use_cache = 1; break;
+            case 'C': use_cache = 1; cache_dir = optarg; break;
+            default:
+                Usage(argv[0]);
+                exit(1);
+        }
+    }
+
+    /* Check command line arguments */
+    if (argc - optind != 3) {
+        Usage(argv[0]);
+        exit(1);
+    }
+    socket_path = argv[optind + 1];
+
+    /* Get number of threads */
+    thread_count = atoi(argv[optind + 2]);
+    if (thread_count <= 0) {
+        fprintf(stderr, "Error: Number of threads must be positive\n");
+        exit(1);
+    }
+
+    /* Read matrix A; the cache only saves a read, so if it fails read A directly */
+    if (use_cache && Cache_load_matrix(argv[optind], cache_dir, thread_count, &A, &m, &n) != 0) {
+        fprintf(stderr, "Warning: Cannot load matrix A from %s through the cache, reading it directly\n",
+                argv[optind]);
+        use_cache = 0;
+    }
+    if (!use_cache && Read_matrix(argv[optind], &A, &m, &n) != 0) {
+        fprintf(stderr, "Error: Failed to read matrix A from %s\n", argv[optind]);
+        exit(1);
+    }
+
+    /* Default block: roughly 64K multiply-adds per task */
+    if (block_rows <= 0) {
+        block_rows = 65536 / n;
+        if (block_rows < 1) block_rows = 1;
+    }
+
+    /* Create listening socket */
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Error: Socket path %s is too long\n", socket_path);
+        Free_A();
+        exit(1);
+    }
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        fprintf(stderr, "Error: Cannot create socket\n");
+        Free_A();
+        exit(1);
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, socket_path);
+    unlink(socket_path);
+    if (bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(listen_fd, 64) != 0) {
+        fprintf(stderr, "Error: Cannot listen on %s\n", socket_path);
+        close(listen_fd);
+        Free_A();
+        exit(1);
+    }
+
+    /* Stop cleanly on SIGINT/SIGTERM; accept() returns EINTR */
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = Handle_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    /* Start worker threads */
+    thread_handles = (pthread_t*)malloc(thread_count * sizeof(pthread_t));
+    if (thread_handles == NULL) {
+        fprintf(stderr, "Error: Cannot allocate memory for thread handles\n");
+        close(listen_fd);
+        Free_A();
+        exit(1);
+    }
+    for (thread = 0; thread < thread_count; thread++) {
+        pthread_create(&thread_handles[thread], NULL, Worker, A);
+    }
+
+    fprintf(stderr, "Serving %d x %d matrix on %s (%d threads, %d rows/block)\n",
+            m, n, socket_path, thread_count, block_rows);
+
+    /* Accept clients, one detached thread per connection */
+    while (!shutting_down) {
+        pthread_t client;
+        int* fd_p;
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        fd_p = (int*)malloc(sizeof(int));
+        if (fd_p == NULL) {
+            close(fd);
+            continue;
+        }
+        *fd_p = fd;
+        if (pthread_create(&client, NULL, Serve_client, fd_p) != 0) {
+            close(fd);
+            free(fd_p);
+            continue;
+        }
+        pthread_detach(client);
+    }
+
+    /* Wake and join workers */
+    pthread_mutex_lock(&queue_mutex);
+    shutting_down = 1;
+    pthread_cond_broadcast(&work_cond);
+    pthread_mutex_unlock(&queue_mutex);
+    for (thread = 0; thread < thread_count; thread++) {
+        pthread_join(thread_handles[thread], NULL);
+    }
+
+    Print_summary();
+
+    /* Clean up */
+    close(listen_fd);
+    unlink(socket_path);
+    free(thread_handles);
+    Free_A();
+
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Usage
+ * Purpose:   Print usage message
+*/
+void Usage(char* prog_name) {
+    fprintf(stderr, "Usage: %s [options] <file_A> <socket_path> <num_threads>\n", prog_name);
+    fprintf(stderr, "  Serves y = A * x requests over a UNIX domain socket\n");
+    fprintf(stderr, "  -b rows  rows per scheduling block (default: ~64K flops)\n");
+    fprintf(stderr, "  -i ms    latency budget for interactive requests (0 = none)\n");
+    fprintf(stderr, "  -B ms    latency budget for batch requests (0 = none)\n");
+    fprintf(stderr, "  -c       map A from the shared-memory matrix cache\n");
+    fprintf(stderr, "  -C dir   use dir for cache entries (e.g. hugetlbfs mount)\n");
+    fprintf(stderr, "  Example: %s -i 5 -B 2000 A.mat /tmp/matvec.sock 4\n", prog_name);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Read_matrix
+ * Purpose:   Read a binary matrix file
+*/
+int Read_matrix(char* filename, double** A_p, int* m_p, int* n_p) {
+    FILE* fp;
+    int rows, cols;
+    double* A;
+
+    fp = fopen(filename, "rb");
+    if (fp == NULL) return -1;
+
+    if (fread(&rows, sizeof(int), 1, fp) != 1 ||
+        fread(&cols, sizeof(int), 1, fp) != 1) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (rows <= 0 || cols <= 0) {
+        fclose(fp);
+        return -1;
+    }
+
+    A = (double*)malloc((size_t)rows * cols * sizeof(double));
+    if (A == NULL) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (fread(A, sizeof(double), (size_t)rows * cols, fp) != (size_t)rows * cols) {
+        free(A);
+        fclose(fp);
+        return -1;
+    }
+
+    fclose(fp);
+    *A_p = A;
+    *m_p = rows;
+    *n_p = cols;
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Read_full / Write_full
+ * Purpose:   Transfer exactly bytes bytes on a socket
+ * Return:    0 on success, -1 on error or end of file
+*/
+int Read_full(int fd, void* buf, size_t bytes) {
+    char* p = (char*)buf;
+    while (bytes > 0) {
+        ssize_t got = read(fd, p, bytes);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return -1;
+        p += got;
+        bytes -= got;
+    }
+    return 0;
+}
+
+int Write_full(int fd, const void* buf, size_t bytes) {
+    const char* p = (const char*)buf;
+    while (bytes > 0) {
+        ssize_t put = write(fd, p, bytes);
+        if (put < 0 && errno == EINTR) continue;
+        if (put <= 0) return -1;
+        p += put;
+        bytes -= put;
+    }
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Enqueue_job
+ * Purpose:   Insert a job into its class queue, ordered by deadline
+ *            (jobs without a deadline last); ties keep arrival order
+ * Note:      Caller holds queue_mutex
+*/
+void Enqueue_job(Job* job) {
+    Job** link = &queue[job->priority];
+
+    while (*link != NULL) {
+        Job* cur = *link;
+        int before;
+        if (job->deadline == 0.0) before = 0;
+        else if (cur->deadline == 0.0) before = 1;
+        else before = job->deadline < cur->deadline;
+        if (before) break;
+        link = &cur->next;
+    }
+    job->next = *link;
+    *link = job;
+    queued_rows[job->priority] += m;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Remove_job
+ * Purpose:   Unlink a job from its class queue
+ * Note:      Caller holds queue_mutex
+*/
+void Remove_job(Job* job) {
+    Job** link = &queue[job->priority];
+
+    while (*link != NULL && *link != job) link = &(*link)->next;
+    if (*link == job) *link = job->next;
+    queued_rows[job->priority] -= m - job->next_row;
+    job->next = NULL;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Admit
+ * Purpose:   Admission control for a new request
+ * In args:   priority, deadline (absolute, 0 = none), now
+ * Return:    1 if the request may be queued, 0 if it should be rejected
+ * Note:      Caller holds queue_mutex. The estimate counts every row
+ *            queued at this priority or higher plus the request itself,
+ *            spread over all workers.
+*/
+int Admit(int priority, double deadline, double now) {
+    long rows_ahead = m;
+    double estimate;
+    int c;
+
+    for (c = 0; c <= priority; c++) rows_ahead += queued_rows[c];
+    estimate = rows_ahead * row_time / thread_count;
+
+    if (budget[priority] > 0.0 && estimate > budget[priority]) return 0;
+    if (deadline != 0.0 && now + estimate > deadline) return 0;
+    return 1;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Worker
+ * Purpose:   Thread function: repeatedly take the next row block of the
+ *            most urgent job and compute it against the shared matrix
+ *            passed in matrix
+*/
+void* Worker(void* matrix) {
+    const double* mat = (const double*)matrix;
+    int i, j, first, last, c;
+    double now, start, finish;
+    Job* job;
+
+    pthread_mutex_lock(&queue_mutex);
+    while (1) {
+        /* Find most urgent job */
+        job = NULL;
+        while (!shutting_down) {
+            for (c = 0; c < MV_NUM_PRIO && job == NULL; c++) job = queue[c];
+            if (job != NULL) break;
+            pthread_cond_wait(&work_cond, &queue_mutex);
+        }
+        if (job == NULL) break;
+
+        /* Drop jobs whose deadline has passed */
+        GET_TIME(now);
+        if (job->deadline != 0.0 && now > job->deadline) {
+            job->expired = 1;
+            job->rows_done += m - job->next_row;
+            Remove_job(job);
+            job->next_row = m;
+            if (job->rows_done == m) pthread_cond_signal(&job->done_cond);
+            continue;
+        }
+
+        /* Claim one row block */
+        if (job->next_row == 0) job->start = now;
+        first = job->next_row;
+        last = MIN(first + block_rows, m) - 1;
+        job->next_row = last + 1;
+        queued_rows[job->priority] -= last - first + 1;
+        if (job->next_row == m) Remove_job(job);
+        pthread_mutex_unlock(&queue_mutex);
+
+        /* Compute assigned rows */
+        GET_TIME(start);
+        for (i = first; i <= last; i++) {
+            double sum = 0.0;
+            for (j = 0; j < n; j++) {
+                sum += mat[(size_t)i * n + j] * job->x[j];
+            }
+            job->y[i] = sum;
+        }
+        GET_TIME(finish);
+
+        pthread_mutex_lock(&queue_mutex);
+
+        /* Update running per-row service time estimate */
+        if (row_time == 0.0) row_time = (finish - start) / (last - first + 1);
+        else row_time = 0.9 * row_time + 0.1 * (finish - start) / (last - first + 1);
+
+        job->rows_done += last - first + 1;
+        if (job->rows_done == m) pthread_cond_signal(&job->done_cond);
+    }
+    pthread_mutex_unlock(&queue_mutex);
+
+    return NULL;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Serve_client
+ * Purpose:   Thread function: read requests from one connection, queue
+ *            them and send back the replies
+*/
+void* Serve_client(void* arg) {
+    int fd = *(int*)arg;
+    Mv_request req;
+    Mv_reply reply;
+    Job job;
+    double now, finish, latency;
+    int admitted;
+
+    free(arg);
+    memset(&job, 0, sizeof(job));
+    pthread_cond_init(&job.done_cond, NULL);
+    job.x = (double*)malloc(n * sizeof(double));
+    job.y = (double*)malloc(m * sizeof(double));
+    if (job.x == NULL || job.y == NULL) goto done;
+
+    while (Read_full(fd, &req, sizeof(req)) == 0) {
+        memset(&reply, 0, sizeof(reply));
+
+        /* Validate request; a bad header ends the connection */
+        if (req.magic != MV_MAGIC || req.n != n ||
+            req.priority < 0 || req.priority >= MV_NUM_PRIO || req.deadline_ms < 0) {
+            reply.status = MV_BAD_REQUEST;
+            Write_full(fd, &reply, sizeof(reply));
+            break;
+        }
+        if (Read_full(fd, job.x, n * sizeof(double)) != 0) break;
+
+        /* Admission control */
+        GET_TIME(now);
+        pthread_mutex_lock(&queue_mutex);
+        job.priority = req.priority;
+        job.arrival = now;
+        job.deadline = req.deadline_ms > 0 ? now + req.deadline_ms / 1000.0 : 0.0;
+        admitted = Admit(job.priority, job.deadline, now);
+        if (admitted) {
+            job.start = 0.0;
+            job.next_row = 0;
+            job.rows_done = 0;
+            job.expired = 0;
+            Enqueue_job(&job);
+            pthread_cond_broadcast(&work_cond);
+            while (job.rows_done < m) pthread_cond_wait(&job.done_cond, &queue_mutex);
+        } else {
+            busy[job.priority]++;
+        }
+        pthread_mutex_unlock(&queue_mutex);
+
+        if (!admitted) {
+            reply.status = MV_BUSY;
+            if (Write_full(fd, &reply, sizeof(reply)) != 0) break;
+            continue;
+        }
+
+        GET_TIME(finish);
+        latency = finish - job.arrival;
+
+        pthread_mutex_lock(&queue_mutex);
+        if (job.expired) {
+            expired[job.priority]++;
+        } else {
+            served[job.priority]++;
+            total_latency[job.priority] += latency;
+            if (latency > max_latency[job.priority]) max_latency[job.priority] = latency;
+        }
+        pthread_mutex_unlock(&queue_mutex);
+
+        reply.status = job.expired ? MV_EXPIRED : MV_OK;
+        reply.m = job.expired ? 0 : m;
+        reply.queue_time = job.start > 0.0 ? job.start - job.arrival : latency;
+        reply.service_time = latency;
+        if (Write_full(fd, &reply, sizeof(reply)) != 0) break;
+        if (!job.expired && Write_full(fd, job.y, m * sizeof(double)) != 0) break;
+    }
+
+done:
+    close(fd);
+    pthread_cond_destroy(&job.done_cond);
+    free(job.x);
+    free(job.y);
+    return NULL;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Handle_signal
+ * Purpose:   Request shutdown of the accept loop
+*/
+void Handle_signal(int sig) {
+    (void)sig;
+    shutting_down = 1;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Print_summary
+ * Purpose:   Print per-class request statistics to stderr
+*/
+void Print_summary(void) {
+    const char* names[MV_NUM_PRIO] = {"interactive", "batch"};
+    int c;
+
+    for (c = 0; c < MV_NUM_PRIO; c++) {
+        fprintf(stderr, "%s,%ld,%ld,%ld,%e,%e\n", names[c], served[c], busy[c],
+                expired[c], served[c] > 0 ? total_latency[c] / served[c] : 0.0,
+                max_latency[c]);
+    }
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Free_A
+ * Purpose:   Release matrix A, whether read or mapped from the cache
+*/
+void Free_A(void) {
+    if (use_cache) Cache_release(A);
+    else free(A);
+}
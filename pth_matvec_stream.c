@@ -0,0 +1,420 @@
+/**
+ * @file pth_matvec_stream.c
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Streaming matrix-vector multiplication over a pipe.
+ *
+ * This program loads a matrix A once, starts a persistent team of
+ * pthreads, and then multiplies every vector frame read from stdin (or
+ * a FIFO) by A, writing the result frames to stdout (or a file/FIFO).
+ *
+ * Frame format is the binary matrix format used by the other programs:
+ *   - 4 bytes: number of rows (int), must equal the columns of A
+ *   - 4 bytes: number of columns k (int), k vectors per frame
+ *   - rows * k doubles in row-major order
+ * Each result frame is an m x k matrix in the same format, so a stream
+ * is simply a concatenation of .mat files.
+ *
+ * With -b, frames that are already waiting in the pipe are gathered into
+ * one micro-batch of up to the given number of vectors, and A is streamed
+ * through the cache once for the whole batch instead of once per vector.
+ *
+ * Rows are distributed among threads with Quinn's macros as in
+ * pth_matrix_vector. Timing data is output to stderr in CSV format:
+ *   N,P,Frames,Vectors,Time_Overall,Latency_Mean,Latency_Max
+ * and with -v one line per frame as:
+ *   Frame,Cols,Batch_Vectors,Latency
+ * where latency runs from the frame being read to its result written.
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "quinn.h"
+#include "timer.h"
+
+/* One input frame waiting in the current micro-batch */
+typedef struct {
+    int cols;          /* vectors in this frame */
+    int offset;        /* index of its first vector in X/Y */
+    double arrival;    /* time the frame was read */
+} Frame;
+
+/* Global variables */
+int thread_count;
+double *A = NULL;
+double *X = NULL;      /* batch vectors, vector-major: X[v*n + j] */
+double *Y = NULL;      /* batch results, vector-major: Y[v*m + i] */
+int m, n;
+int batch_vectors;     /* vectors in the current batch */
+int quit = 0;
+pthread_barrier_t start_barrier, done_barrier;
+
+/* Function prototypes */
+void Usage(char* prog_name);
+int Read_matrix(char* filename, double** A_p, int* m_p, int* n_p);
+int Read_full(int fd, void* buf, size_t bytes);
+int Write_full(int fd, const void* buf, size_t bytes);
+int Input_ready(int fd);
+int Reserve(double** buf_p, int* cap_p, int vectors, int len);
+void* Pth_stream_team(void* rank);
+
+int main(int argc, char* argv[]) {
+    int opt, in_fd = 0, out_fd = 1;
+    int max_batch = 1, verbose = 0;
+    int x_cap = 0, y_cap = 0, frame_cap = 0;
+    int header[2], num_frames, f, v, i, j, eof = 0;
+    long frames_done = 0, vectors_done = 0;
+    long thread;
+    pthread_t* thread_handles;
+    Frame* frames = NULL;
+    double *in_buf = NULL, *out_buf = NULL;
+    size_t in_cap = 0, out_cap = 0;
+    double start_total, end_total, now, latency, latency_sum = 0.0, latency_max = 0.0;
+
+    GET_TIME(start_total);
+
+    /* Parse options */
+    while ((opt = getopt(argc, argv, "b:i:o:v")) != -1) {
+        switch (opt) {
+            case 'b': max_batch = atoi(optarg); break;
+            case 'i':
+                in_fd = open(optarg, O_RDONLY);
+                if (in_fd < 0) {
+                    fprintf(stderr, "Error: Cannot open %s for reading\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'o':
+                out_fd = open(optarg, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+                if (out_fd < 0) {
+                    fprintf(stderr, "Error: Cannot open %s for writing\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'v': verbose = 1; break;
+            default:
+                Usage(argv[0]);
+                exit(1);
+        }
+    }
+
+    /* Check command line arguments */
+    if (argc - optind != 2 || max_batch <= 0) {
+        Usage(argv[0]);
+        exit(1);
+    }
+
+    /* Get number of threads */
+    thread_count = atoi(argv[optind + 1]);
+    if (thread_count <= 0) {
+        fprintf(stderr, "Error: Number of threads must be positive\n");
+        exit(1);
+    }
+
+    /* Read matrix A */
+    if (Read_matrix(argv[optind], &A, &m, &n) != 0) {
+        fprintf(stderr, "Error: Failed to read matrix A from %s\n", argv[optind]);
+        exit(1);
+    }
+
+    /* Start the thread team; it waits at start_barrier between batches */
+    pthread_barrier_init(&start_barrier, NULL, thread_count + 1);
+    pthread_barrier_init(&done_barrier, NULL, thread_count + 1);
+    thread_handles = (pthread_t*)malloc(thread_count * sizeof(pthread_t));
+    if (thread_handles == NULL) {
+        fprintf(stderr, "Error: Cannot allocate memory for thread handles\n");
+        free(A);
+        exit(1);
+    }
+    for (thread = 0; thread < thread_count; thread++) {
+        pthread_create(&thread_handles[thread], NULL, Pth_stream_team, (void*)thread);
+    }
+
+    while (!eof) {
+        /* Gather a micro-batch: block for the first frame, then take
+           further frames only while they are already waiting */
+        num_frames = 0;
+        batch_vectors = 0;
+        do {
+            if (Read_full(in_fd, header, sizeof(header)) != 0) {
+                eof = 1;
+                break;
+            }
+            if (header[0] != n || header[1] <= 0) {
+                fprintf(stderr, "Error: Frame %ld is %d x %d, expected %d x k\n",
+                        frames_done + num_frames, header[0], header[1], n);
+                exit(1);
+            }
+            if (num_frames == frame_cap) {
+                frame_cap = frame_cap == 0 ? 16 : 2 * frame_cap;
+                frames = (Frame*)realloc(frames, frame_cap * sizeof(Frame));
+            }
+            if ((size_t)n * header[1] > in_cap) {
+                in_cap = (size_t)n * header[1];
+                in_buf = (double*)realloc(in_buf, in_cap * sizeof(double));
+            }
+            if (frames == NULL || in_buf == NULL ||
+                Reserve(&X, &x_cap, batch_vectors + header[1], n) != 0) {
+                fprintf(stderr, "Error: Cannot allocate memory for input frames\n");
+                exit(1);
+            }
+            if (Read_full(in_fd, in_buf, (size_t)n * header[1] * sizeof(double)) != 0) {
+                fprintf(stderr, "Error: Truncated frame %ld\n", frames_done + num_frames);
+                exit(1);
+            }
+            GET_TIME(now);
+
+            /* Transpose the row-major n x k frame into the batch */
+            for (v = 0; v < header[1]; v++) {
+                for (j = 0; j < n; j++) {
+                    X[(size_t)(batch_vectors + v) * n + j] = in_buf[(size_t)j * header[1] + v];
+                }
+            }
+            frames[num_frames].cols = header[1];
+            frames[num_frames].offset = batch_vectors;
+            frames[num_frames].arrival = now;
+            num_frames++;
+            batch_vectors += header[1];
+        } while (batch_vectors < max_batch && Input_ready(in_fd));
+
+        if (num_frames == 0) break;
+
+        /* Run the batch on the team */
+        if (Reserve(&Y, &y_cap, batch_vectors, m) != 0) {
+            fprintf(stderr, "Error: Cannot allocate memory for results\n");
+            exit(1);
+        }
+        pthread_barrier_wait(&start_barrier);
+        pthread_barrier_wait(&done_barrier);
+
+        /* Emit one result frame per input frame */
+        for (f = 0; f < num_frames; f++) {
+            int cols = frames[f].cols;
+            if ((size_t)m * cols > out_cap) {
+                out_cap = (size_t)m * cols;
+                out_buf = (double*)realloc(out_buf, out_cap * sizeof(double));
+                if (out_buf == NULL) {
+                    fprintf(stderr, "Error: Cannot allocate memory for output frame\n");
+                    exit(1);
+                }
+            }
+            for (i = 0; i < m; i++) {
+                for (v = 0; v < cols; v++) {
+                    out_buf[(size_t)i * cols + v] = Y[(size_t)(frames[f].offset + v) * m + i];
+                }
+            }
+            header[0] = m;
+            header[1] = cols;
+            if (Write_full(out_fd, header, sizeof(header)) != 0 ||
+                Write_full(out_fd, out_buf, (size_t)m * cols * sizeof(double)) != 0) {
+                fprintf(stderr, "Error: Failed to write result frame %ld\n", frames_done);
+                exit(1);
+            }
+
+            GET_TIME(now);
+            latency = now - frames[f].arrival;
+            latency_sum += latency;
+            if (latency > latency_max) latency_max = latency;
+            if (verbose) {
+                fprintf(stderr, "%ld,%d,%d,%e\n", frames_done, cols, batch_vectors, latency);
+            }
+            frames_done++;
+            vectors_done += cols;
+        }
+    }
+
+    /* Stop the team */
+    quit = 1;
+    pthread_barrier_wait(&start_barrier);
+    for (thread = 0; thread < thread_count; thread++) {
+        pthread_join(thread_handles[thread], NULL);
+    }
+
+    GET_TIME(end_total);
+
+    /* Print timing results to stderr */
+    fprintf(stderr, "%d,%d,%ld,%ld,%e,%e,%e\n", m, thread_count, frames_done, vectors_done,
+            end_total - start_total,
+            frames_done > 0 ? latency_sum / frames_done : 0.0, latency_max);
+
+    /* Clean up */
+    pthread_barrier_destroy(&start_barrier);
+    pthread_barrier_destroy(&done_barrier);
+    free(A);
+    free(X);
+    free(Y);
+    free(frames);
+    free(in_buf);
+    free(out_buf);
+    free(thread_handles);
+
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Usage
+ * Purpose:   Print usage message
+*/
+void Usage(char* prog_name) {
+    fprintf(stderr, "Usage: %s [options] <file_A> <num_threads>\n", prog_name);
+    fprintf(stderr, "  Multiplies every vector frame read from stdin by A and\n");
+    fprintf(stderr, "  writes the result frames to stdout\n");
+    fprintf(stderr, "  -b vectors  micro-batch up to this many waiting vectors (default: 1)\n");
+    fprintf(stderr, "  -i file     read frames from file or FIFO instead of stdin\n");
+    fprintf(stderr, "  -o file     write frames to file or FIFO instead of stdout\n");
+    fprintf(stderr, "  -v          print per-frame latency to stderr\n");
+    fprintf(stderr, "  Example: cat x1.mat x2.mat | %s -b 8 A.mat 4 > y.stream\n", prog_name);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Read_matrix
+ * Purpose:   Read a binary matrix file
+*/
+int Read_matrix(char* filename, double** A_p, int* m_p, int* n_p) {
+    FILE* fp;
+    int rows, cols;
+    double* A;
+
+    fp = fopen(filename, "rb");
+    if (fp == NULL) return -1;
+
+    if (fread(&rows, sizeof(int), 1, fp) != 1 ||
+        fread(&cols, sizeof(int), 1, fp) != 1) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (rows <= 0 || cols <= 0) {
+        fclose(fp);
+        return -1;
+    }
+
+    A = (double*)malloc((size_t)rows * cols * sizeof(double));
+    if (A == NULL) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (fread(A, sizeof(double), (size_t)rows * cols, fp) != (size_t)rows * cols) {
+        free(A);
+        fclose(fp);
+        return -1;
+    }
+
+    fclose(fp);
+    *A_p = A;
+    *m_p = rows;
+    *n_p = cols;
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Read_full / Write_full
+ * Purpose:   Transfer exactly bytes bytes on a pipe or file
+ * Return:    0 on success, -1 on error or end of file
+*/
+int Read_full(int fd, void* buf, size_t bytes) {
+    char* p = (char*)buf;
+    while (bytes > 0) {
+        ssize_t got = read(fd, p, bytes);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return -1;
+        p += got;
+        bytes -= got;
+    }
+    return 0;
+}
+
+int Write_full(int fd, const void* buf, size_t bytes) {
+    const char* p = (const char*)buf;
+    while (bytes > 0) {
+        ssize_t put = write(fd, p, bytes);
+        if (put < 0 && errno == EINTR) continue;
+        if (put <= 0) return -1;
+        p += put;
+        bytes -= put;
+    }
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Input_ready
+ * Purpose:   Check without blocking whether more input is waiting
+ * Return:    1 if a read would not block, 0 otherwise
+*/
+int Input_ready(int fd) {
+    struct pollfd pfd;
+
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    return poll(&pfd, 1, 0) == 1 && (pfd.revents & POLLIN);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Reserve
+ * Purpose:   Grow a vector-major buffer to hold at least the given
+ *            number of vectors of length len
+ * In/out:    buf_p, cap_p (capacity in vectors)
+ * Return:    0 on success, -1 on allocation failure
+*/
+int Reserve(double** buf_p, int* cap_p, int vectors, int len) {
+    double* buf;
+    int cap = *cap_p;
+
+    if (vectors <= cap) return 0;
+    while (cap < vectors) cap = cap == 0 ? vectors : 2 * cap;
+    buf = (double*)realloc(*buf_p, (size_t)cap * len * sizeof(double));
+    if (buf == NULL) return -1;
+    *buf_p = buf;
+    *cap_p = cap;
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Pth_stream_team
+ * Purpose:   Thread function for the persistent team. Each batch, the
+ *            thread computes its block of rows for every batch vector,
+ *            reusing each row of A across the vectors while it is hot.
+*/
+void* Pth_stream_team(void* rank) {
+    long my_rank = (long)rank;
+    int local_first_row, local_last_row;
+    int i, j, v;
+
+    /* Calculate row distribution using Quinn macros */
+    local_first_row = BLOCK_LOW(my_rank, thread_count, m);
+    local_last_row = BLOCK_HIGH(my_rank, thread_count, m);
+
+    while (1) {
+        pthread_barrier_wait(&start_barrier);
+        if (quit) break;
+
+        for (i = local_first_row; i <= local_last_row; i++) {
+            const double* row = A + (size_t)i * n;
+            for (v = 0; v < batch_vectors; v++) {
+                const double* x = X + (size_t)v * n;
+                double sum = 0.0;
+                for (j = 0; j < n; j++) {
+                    sum += row[j] * x[j];
+                }
+                Y[(size_t)v * m + i] = sum;
+            }
+        }
+
+        pthread_barrier_wait(&done_barrier);
+    }
+
+    return NULL;
+}
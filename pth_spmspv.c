@@ -0,0 +1,232 @@
+/**
+ * @file pth_spmspv.c
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Parallel sparse matrix times sparse vector using POSIX threads.
+ *
+ * Computes y = A * x with Spmspv (spmspv.h), which only visits the
+ * columns of A at the nonzeros of x. A should be a CSC file; a dense or
+ * CSR A is column-compressed first, outside the timed work. x may be a
+ * sparse vector file or a dense vector, whose zeros are dropped. y is
+ * written as a sparse vector file (convert_matrix turns it into a
+ * dense one).
+ *
+ * Timing data is output to stderr in CSV format:
+ *   M,P,Nnz_x,Nnz_y,Work,Time_Overall,Time_Work
+ * where Work is the number of entries of A visited.
+ * With -R, a Semiring column is appended.
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "timer.h"
+#include "mat_format.h"
+#include "sparse.h"
+#include "semiring.h"
+#include "spmspv.h"
+
+/* Function prototypes */
+void Usage(char* prog_name);
+int Read_operator(char* filename, int thread_count, Csc* A);
+int Read_operand(char* filename, Spvec* x);
+int Read_matrix(char* filename, double** A_p, int* m_p, int* n_p);
+
+int main(int argc, char* argv[]) {
+    int opt, thread_count, semiring = SR_PLUS_TIMES, semiring_set = 0;
+    long k, work;
+    double start_total, end_total, start_work, end_work;
+    Csc A;
+    Spvec x, y;
+
+    /* Start overall timing */
+    GET_TIME(start_total);
+
+    /* Parse options */
+    while ((opt = getopt(argc, argv, "R:")) != -1) {
+        switch (opt) {
+            case 'R':
+                semiring = Semiring_parse(optarg);
+                semiring_set = 1;
+                if (semiring < 0) {
+                    fprintf(stderr, "Error: Unknown semiring %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            default:
+                Usage(argv[0]);
+                exit(1);
+        }
+    }
+
+    /* Check command line arguments */
+    if (argc - optind != 4) {
+        Usage(argv[0]);
+        exit(1);
+    }
+
+    /* Get number of threads */
+    thread_count = atoi(argv[optind + 3]);
+    if (thread_count <= 0) {
+        fprintf(stderr, "Error: Number of threads must be positive\n");
+        exit(1);
+    }
+
+    /* Read A and x */
+    if (Read_operator(argv[optind], thread_count, &A) != 0) {
+        fprintf(stderr, "Error: Failed to read matrix A from %s\n", argv[optind]);
+        exit(1);
+    }
+    if (Read_operand(argv[optind + 1], &x) != 0) {
+        fprintf(stderr, "Error: Failed to read vector x from %s\n", argv[optind + 1]);
+        exit(1);
+    }
+    if (x.n != A.cols) {
+        fprintf(stderr, "Error: Incompatible dimensions for multiplication\n");
+        fprintf(stderr, "  Matrix A is %d x %d, Vector x is %d x 1\n", A.rows, A.cols, x.n);
+        exit(1);
+    }
+
+    /* Multiply */
+    GET_TIME(start_work);
+    if (Spmspv(semiring, &A, &x, NULL, thread_count, &y) != 0) {
+        fprintf(stderr, "Error: Cannot allocate memory for the product\n");
+        exit(1);
+    }
+    GET_TIME(end_work);
+
+    /* Write result to file */
+    if (Spvec_write(argv[optind + 2], &y) != 0) {
+        fprintf(stderr, "Error: Failed to write result to %s\n", argv[optind + 2]);
+        exit(1);
+    }
+
+    GET_TIME(end_total);
+
+    /* Print timing results to stderr */
+    work = 0;
+    for (k = 0; k < x.nnz; k++) work += A.col_ptr[x.idx[k] + 1] - A.col_ptr[x.idx[k]];
+    fprintf(stderr, "%d,%d,%ld,%ld,%ld,%e,%e", A.rows, thread_count, x.nnz, y.nnz, work,
+            end_total - start_total, end_work - start_work);
+    if (semiring_set) fprintf(stderr, ",%s", Semiring_name(semiring));
+    fprintf(stderr, "\n");
+
+    /* Clean up */
+    Csc_free(&A);
+    Spvec_free(&x);
+    Spvec_free(&y);
+
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Usage
+ * Purpose:   Print usage message
+*/
+void Usage(char* prog_name) {
+    fprintf(stderr, "Usage: %s [-R semiring] <file_A> <file_x> <file_y> <num_threads>\n", prog_name);
+    fprintf(stderr, "  Multiplies sparse matrix A by sparse vector x using pthreads\n");
+    fprintf(stderr, "  A: CSC (or CSR/dense, converted); x: sparse or dense vector\n");
+    fprintf(stderr, "  y is written as a sparse vector\n");
+    fprintf(stderr, "  -R name   semiring: plus-times (default), min-plus,\n");
+    fprintf(stderr, "            max-times or or-and\n");
+    fprintf(stderr, "  Example: %s A.csc x.spv y.spv 4\n", prog_name);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Read_operator
+ * Purpose:   Read A as CSC, compressing a dense or CSR matrix
+*/
+int Read_operator(char* filename, int thread_count, Csc* A) {
+    Csr csr;
+    double* dense;
+    int rows, cols, status;
+
+    switch (Sparse_format(filename)) {
+        case MAT_FORMAT_CSC:
+            return Csc_read(filename, A);
+        case MAT_FORMAT_CSR:
+            if (Csr_read(filename, &csr) != 0) return -1;
+            break;
+        case MAT_FORMAT_DENSE:
+            if (Read_matrix(filename, &dense, &rows, &cols) != 0) return -1;
+            status = Csr_from_dense(dense, rows, cols, thread_count, &csr);
+            free(dense);
+            if (status != 0) return -1;
+            break;
+        default:
+            return -1;
+    }
+    status = Csc_from_csr(&csr, thread_count, A);
+    Csr_free(&csr);
+    return status;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Read_operand
+ * Purpose:   Read x as a sparse vector, compressing a dense vector
+*/
+int Read_operand(char* filename, Spvec* x) {
+    double* dense;
+    int rows, cols, status;
+
+    switch (Sparse_format(filename)) {
+        case MAT_FORMAT_SPVEC:
+            return Spvec_read(filename, x);
+        case MAT_FORMAT_DENSE:
+            if (Read_matrix(filename, &dense, &rows, &cols) != 0) return -1;
+            status = cols == 1 ? Spvec_from_dense(dense, rows, x) : -1;
+            free(dense);
+            return status;
+        default:
+            return -1;
+    }
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Read_matrix
+ * Purpose:   Read a binary matrix file
+*/
+int Read_matrix(char* filename, double** A_p, int* m_p, int* n_p) {
+    FILE* fp;
+    int rows, cols;
+    double* A;
+
+    fp = fopen(filename, "rb");
+    if (fp == NULL) return -1;
+
+    if (fread(&rows, sizeof(int), 1, fp) != 1 ||
+        fread(&cols, sizeof(int), 1, fp) != 1) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (rows <= 0 || cols <= 0) {
+        fclose(fp);
+        return -1;
+    }
+
+    A = (double*)malloc((size_t)rows * cols * sizeof(double));
+    if (A == NULL) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (fread(A, sizeof(double), (size_t)rows * cols, fp) != (size_t)rows * cols) {
+        free(A);
+        fclose(fp);
+        return -1;
+    }
+
+    fclose(fp);
+    *A_p = A;
+    *m_p = rows;
+    *n_p = cols;
+    return 0;
+}
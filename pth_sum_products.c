@@ -0,0 +1,253 @@
+/**
+ * @file pth_sum_products.c
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Fused sum of matrix-vector products y = A_1*x_1 + ... + A_k*x_k.
+ *
+ * All terms are accumulated in one threaded pass: each thread owns a
+ * block of rows (Quinn's macros) and, for each of its rows, sums that
+ * row of every product in a register before storing y[i] once. There is
+ * one thread launch and one write of y regardless of the number of
+ * terms, instead of a run and an add pass per term.
+ *
+ * The matrices must have the same number of rows; each x_k must be a
+ * column vector matching the columns of its A_k.
+ *
+ * Timing data is output to stderr in CSV format:
+ *   N,P,Terms,Time_Overall,Time_Work
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "quinn.h"
+#include "timer.h"
+
+/* One term A_k * x_k */
+typedef struct {
+    double* A;
+    double* x;
+    int cols;
+} Term;
+
+/* Global variables */
+int thread_count;
+int num_terms;
+Term* terms;
+double* y;
+int m;
+
+/* Function prototypes */
+void Usage(char* prog_name);
+int Read_matrix(char* filename, double** A_p, int* m_p, int* n_p);
+int Write_vector(char* filename, double y[], int m);
+void* Pth_sum_products(void* rank);
+
+int main(int argc, char* argv[]) {
+    int t, rows, m_x, n_x;
+    long thread;
+    pthread_t* thread_handles;
+    double start_total, end_total, start_work, end_work;
+
+    /* Start overall timing */
+    GET_TIME(start_total);
+
+    /* Check command line arguments: pairs, then y and thread count */
+    if (argc < 5 || (argc - 3) % 2 != 0) {
+        Usage(argv[0]);
+        exit(1);
+    }
+    num_terms = (argc - 3) / 2;
+
+    /* Get number of threads */
+    thread_count = atoi(argv[argc - 1]);
+    if (thread_count <= 0) {
+        fprintf(stderr, "Error: Number of threads must be positive\n");
+        exit(1);
+    }
+
+    terms = (Term*)calloc(num_terms, sizeof(Term));
+    thread_handles = (pthread_t*)malloc(thread_count * sizeof(pthread_t));
+    if (terms == NULL || thread_handles == NULL) {
+        fprintf(stderr, "Error: Cannot allocate memory for the terms\n");
+        exit(1);
+    }
+
+    /* Read and check the pairs */
+    for (t = 0; t < num_terms; t++) {
+        char* file_A = argv[1 + 2 * t];
+        char* file_x = argv[2 + 2 * t];
+
+        if (Read_matrix(file_A, &terms[t].A, &rows, &terms[t].cols) != 0) {
+            fprintf(stderr, "Error: Failed to read matrix A_%d from %s\n", t + 1, file_A);
+            exit(1);
+        }
+        if (t == 0) {
+            m = rows;
+        } else if (rows != m) {
+            fprintf(stderr, "Error: A_%d has %d rows, A_1 has %d\n", t + 1, rows, m);
+            exit(1);
+        }
+
+        if (Read_matrix(file_x, &terms[t].x, &m_x, &n_x) != 0) {
+            fprintf(stderr, "Error: Failed to read vector x_%d from %s\n", t + 1, file_x);
+            exit(1);
+        }
+        if (n_x != 1 || m_x != terms[t].cols) {
+            fprintf(stderr, "Error: Incompatible dimensions for multiplication\n");
+            fprintf(stderr, "  Matrix A_%d is %d x %d, Vector x_%d is %d x %d\n",
+                    t + 1, rows, terms[t].cols, t + 1, m_x, n_x);
+            exit(1);
+        }
+    }
+
+    /* Allocate result vector y */
+    y = (double*)malloc(m * sizeof(double));
+    if (y == NULL) {
+        fprintf(stderr, "Error: Cannot allocate memory for result vector\n");
+        exit(1);
+    }
+
+    /* Accumulate every term in one pass */
+    GET_TIME(start_work);
+    for (thread = 0; thread < thread_count; thread++) {
+        pthread_create(&thread_handles[thread], NULL, Pth_sum_products, (void*)thread);
+    }
+    for (thread = 0; thread < thread_count; thread++) {
+        pthread_join(thread_handles[thread], NULL);
+    }
+    GET_TIME(end_work);
+
+    /* Write result to file */
+    if (Write_vector(argv[argc - 2], y, m) != 0) {
+        fprintf(stderr, "Error: Failed to write result to %s\n", argv[argc - 2]);
+        exit(1);
+    }
+
+    GET_TIME(end_total);
+
+    /* Print timing results to stderr */
+    fprintf(stderr, "%d,%d,%d,%e,%e\n", m, thread_count, num_terms,
+            end_total - start_total, end_work - start_work);
+
+    /* Clean up */
+    for (t = 0; t < num_terms; t++) {
+        free(terms[t].A);
+        free(terms[t].x);
+    }
+    free(terms);
+    free(y);
+    free(thread_handles);
+
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Usage
+ * Purpose:   Print usage message
+*/
+void Usage(char* prog_name) {
+    fprintf(stderr, "Usage: %s <file_A_1> <file_x_1> [<file_A_2> <file_x_2> ...] <file_y> <num_threads>\n",
+            prog_name);
+    fprintf(stderr, "  Computes y = A_1 * x_1 + A_2 * x_2 + ... in one threaded pass\n");
+    fprintf(stderr, "  Example: %s A.mat x.mat B.mat z.mat y.mat 4\n", prog_name);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Read_matrix
+ * Purpose:   Read a binary matrix file
+*/
+int Read_matrix(char* filename, double** A_p, int* m_p, int* n_p) {
+    FILE* fp;
+    int rows, cols;
+    double* A;
+
+    fp = fopen(filename, "rb");
+    if (fp == NULL) return -1;
+
+    if (fread(&rows, sizeof(int), 1, fp) != 1 ||
+        fread(&cols, sizeof(int), 1, fp) != 1) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (rows <= 0 || cols <= 0) {
+        fclose(fp);
+        return -1;
+    }
+
+    A = (double*)malloc((size_t)rows * cols * sizeof(double));
+    if (A == NULL) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (fread(A, sizeof(double), (size_t)rows * cols, fp) != (size_t)rows * cols) {
+        free(A);
+        fclose(fp);
+        return -1;
+    }
+
+    fclose(fp);
+    *A_p = A;
+    *m_p = rows;
+    *n_p = cols;
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Write_vector
+ * Purpose:   Write a vector to a binary file
+*/
+int Write_vector(char* filename, double y[], int m) {
+    FILE* fp;
+    int cols = 1;
+
+    fp = fopen(filename, "wb");
+    if (fp == NULL) return -1;
+
+    if (fwrite(&m, sizeof(int), 1, fp) != 1 ||
+        fwrite(&cols, sizeof(int), 1, fp) != 1) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (fwrite(y, sizeof(double), m, fp) != m) {
+        fclose(fp);
+        return -1;
+    }
+
+    fclose(fp);
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Pth_sum_products
+ * Purpose:   Thread function: for each of this thread's rows, add up
+ *            that row of every term and store y[i] once
+*/
+void* Pth_sum_products(void* rank) {
+    long my_rank = (long)rank;
+    int i, j, t;
+    int local_first_row = BLOCK_LOW(my_rank, thread_count, m);
+    int local_last_row = BLOCK_HIGH(my_rank, thread_count, m);
+
+    for (i = local_first_row; i <= local_last_row; i++) {
+        double sum = 0.0;
+        for (t = 0; t < num_terms; t++) {
+            const double* row = terms[t].A + (size_t)i * terms[t].cols;
+            const double* x = terms[t].x;
+            for (j = 0; j < terms[t].cols; j++) {
+                sum += row[j] * x[j];
+            }
+        }
+        y[i] = sum;
+    }
+
+    return NULL;
+}
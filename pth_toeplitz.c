@@ -0,0 +1,536 @@
+/**
+ * @file pth_toeplitz.c
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Toeplitz and circulant matrix-vector multiplication by FFT.
+ *
+ * A Toeplitz matrix is constant along its diagonals, so it is defined
+ * by its first row and column and stored in the Toeplitz format of
+ * mat_format.h. The m x n product y = A * x is computed in O(N log N)
+ * by embedding A in a circulant matrix of size N >= m + n - 1 (a power
+ * of two), whose product with the zero-padded x is a cyclic convolution:
+ *   y = IFFT(FFT(c) .* FFT(x))[0 .. m-1]
+ * A circulant matrix whose order is a power of two is used as is.
+ *
+ * The radix-2 FFT is built in: input is scattered in bit-reversed
+ * order, then each of the log2 N butterfly stages is divided among the
+ * threads with Quinn's macros, with a barrier between stages.
+ *
+ * A may also be a dense .mat file; it is then checked for Toeplitz or
+ * circulant structure and rejected if it has none. With -c the detected
+ * structure is written out in the Toeplitz format instead.
+ *
+ * Timing data is output to stderr in CSV format:
+ *   N,P,Kind,FFT_Size,Time_Overall,Time_Work
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <complex.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "quinn.h"
+#include "timer.h"
+#include "mat_format.h"
+
+/* Global variables */
+int thread_count;
+int m, n;                      /* dimensions of A */
+int kind;                      /* MAT_TOEPLITZ or MAT_CIRCULANT */
+double *col = NULL;            /* first column of A, m entries */
+double *row = NULL;            /* first row of A, n entries */
+double *x = NULL, *y = NULL;
+int fft_size, log_size;        /* N = 2^log_size */
+double complex *c_hat, *x_hat, *z, *twiddle;
+double *dense = NULL;          /* dense A while it is being checked */
+double tolerance = 0.0;
+int* not_toeplitz;             /* per-thread detection results */
+pthread_barrier_t barrier;
+
+/* Function prototypes */
+void Usage(char* prog_name);
+int Read_operator(char* filename);
+int Read_toeplitz(FILE* fp);
+int Write_toeplitz(char* filename);
+int Read_matrix(char* filename, double** A_p, int* m_p, int* n_p);
+int Write_vector(char* filename, double y[], int m);
+int Detect_structure(void);
+double Embedding(int k);
+int Bit_reverse(int k);
+void Fft_stages(double complex* a, double complex* b, int inverse, long my_rank);
+void* Pth_detect(void* rank);
+void* Pth_fft_matvec(void* rank);
+
+int main(int argc, char* argv[]) {
+    int opt, convert = 0, m_x, n_x;
+    long thread;
+    pthread_t* thread_handles;
+    double start_total, end_total, start_work, end_work;
+    const char* kind_name;
+
+    /* Start overall timing */
+    GET_TIME(start_total);
+
+    /* Parse options */
+    while ((opt = getopt(argc, argv, "ct:")) != -1) {
+        switch (opt) {
+            case 'c': convert = 1; break;
+            case 't': tolerance = atof(optarg); break;
+            default:
+                Usage(argv[0]);
+                exit(1);
+        }
+    }
+
+    /* Check command line arguments */
+    if (argc - optind != (convert ? 3 : 4)) {
+        Usage(argv[0]);
+        exit(1);
+    }
+
+    /* Get number of threads */
+    thread_count = atoi(argv[argc - 1]);
+    if (thread_count <= 0) {
+        fprintf(stderr, "Error: Number of threads must be positive\n");
+        exit(1);
+    }
+    thread_handles = (pthread_t*)malloc(thread_count * sizeof(pthread_t));
+    if (thread_handles == NULL) {
+        fprintf(stderr, "Error: Cannot allocate memory for thread handles\n");
+        exit(1);
+    }
+
+    /* Read A, detecting the structure of a dense matrix */
+    if (Read_operator(argv[optind]) != 0) {
+        fprintf(stderr, "Error: Failed to read matrix A from %s\n", argv[optind]);
+        exit(1);
+    }
+    if (dense != NULL && Detect_structure() != 0) {
+        fprintf(stderr, "Error: %s is not a Toeplitz matrix\n", argv[optind]);
+        exit(1);
+    }
+
+    if (convert) {
+        if (Write_toeplitz(argv[optind + 1]) != 0) {
+            fprintf(stderr, "Error: Failed to write %s\n", argv[optind + 1]);
+            exit(1);
+        }
+        printf("%s: %d x %d %s, %d of %ld doubles stored\n", argv[optind + 1], m, n,
+               kind == MAT_CIRCULANT ? "circulant" : "Toeplitz",
+               kind == MAT_CIRCULANT ? m : m + n, (long)m * n);
+        free(col);
+        free(row);
+        free(thread_handles);
+        return 0;
+    }
+
+    /* Read vector x (must be a column vector) */
+    if (Read_matrix(argv[optind + 1], &x, &m_x, &n_x) != 0) {
+        fprintf(stderr, "Error: Failed to read vector x from %s\n", argv[optind + 1]);
+        exit(1);
+    }
+    if (n_x != 1 || m_x != n) {
+        fprintf(stderr, "Error: Incompatible dimensions for multiplication\n");
+        fprintf(stderr, "  Matrix A is %d x %d, Vector x is %d x %d\n", m, n, m_x, n_x);
+        exit(1);
+    }
+
+    kind_name = kind == MAT_CIRCULANT ? "circulant" : "toeplitz";
+
+    /* Circulant of power-of-two order is its own embedding */
+    fft_size = 1;
+    log_size = 0;
+    while (fft_size < (kind == MAT_CIRCULANT ? n : m + n - 1)) {
+        fft_size <<= 1;
+        log_size++;
+    }
+    if (kind == MAT_CIRCULANT && fft_size != n) {
+        int k;
+        for (k = 1; k < n; k++) row[k] = col[n - k];
+        kind = MAT_TOEPLITZ;
+        while (fft_size < m + n - 1) {
+            fft_size <<= 1;
+            log_size++;
+        }
+    }
+
+    c_hat = (double complex*)malloc(fft_size * sizeof(double complex));
+    x_hat = (double complex*)malloc(fft_size * sizeof(double complex));
+    z = (double complex*)malloc(fft_size * sizeof(double complex));
+    twiddle = (double complex*)malloc(MAX(fft_size / 2, 1) * sizeof(double complex));
+    y = (double*)malloc(m * sizeof(double));
+    if (c_hat == NULL || x_hat == NULL || z == NULL || twiddle == NULL || y == NULL) {
+        fprintf(stderr, "Error: Cannot allocate memory for the FFT\n");
+        exit(1);
+    }
+
+    /* Multiply */
+    GET_TIME(start_work);
+    pthread_barrier_init(&barrier, NULL, thread_count);
+    for (thread = 0; thread < thread_count; thread++) {
+        pthread_create(&thread_handles[thread], NULL, Pth_fft_matvec, (void*)thread);
+    }
+    for (thread = 0; thread < thread_count; thread++) {
+        pthread_join(thread_handles[thread], NULL);
+    }
+    pthread_barrier_destroy(&barrier);
+    GET_TIME(end_work);
+
+    /* Write result to file */
+    if (Write_vector(argv[optind + 2], y, m) != 0) {
+        fprintf(stderr, "Error: Failed to write result to %s\n", argv[optind + 2]);
+        exit(1);
+    }
+
+    GET_TIME(end_total);
+
+    /* Print timing results to stderr */
+    fprintf(stderr, "%d,%d,%s,%d,%e,%e\n", m, thread_count, kind_name, fft_size,
+            end_total - start_total, end_work - start_work);
+
+    /* Clean up */
+    free(col);
+    free(row);
+    free(x);
+    free(y);
+    free(c_hat);
+    free(x_hat);
+    free(z);
+    free(twiddle);
+    free(thread_handles);
+
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Usage
+ * Purpose:   Print usage message
+*/
+void Usage(char* prog_name) {
+    fprintf(stderr, "Usage: %s [-t tol] <file_A> <file_x> <file_y> <num_threads>\n", prog_name);
+    fprintf(stderr, "       %s -c [-t tol] <file_A> <file_T> <num_threads>\n", prog_name);
+    fprintf(stderr, "  Multiplies a Toeplitz or circulant A by x using the FFT\n");
+    fprintf(stderr, "  -c      convert a dense Toeplitz matrix to the Toeplitz format\n");
+    fprintf(stderr, "  -t tol  largest difference along a diagonal of a dense A (default 0)\n");
+    fprintf(stderr, "  Example: %s -c A.mat A.toe 4 && %s A.toe x.mat y.mat 4\n",
+            prog_name, prog_name);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Read_operator
+ * Purpose:   Read A in the Toeplitz format, or a dense .mat into dense
+ *            for Detect_structure
+*/
+int Read_operator(char* filename) {
+    FILE* fp;
+    int first, status;
+
+    fp = fopen(filename, "rb");
+    if (fp == NULL) return -1;
+    if (fread(&first, sizeof(int), 1, fp) != 1) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (first == MAT_FORMAT_TOEPLITZ) {
+        rewind(fp);
+        status = Read_toeplitz(fp);
+        fclose(fp);
+        return status;
+    }
+
+    fclose(fp);
+    return Read_matrix(filename, &dense, &m, &n);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Read_toeplitz
+ * Purpose:   Read a Toeplitz file into col and row
+*/
+int Read_toeplitz(FILE* fp) {
+    Toeplitz_header header;
+
+    if (fread(&header, sizeof(header), 1, fp) != 1 ||
+        header.magic != MAT_FORMAT_TOEPLITZ || header.rows <= 0 || header.cols <= 0 ||
+        (header.kind != MAT_TOEPLITZ && header.kind != MAT_CIRCULANT) ||
+        (header.kind == MAT_CIRCULANT && header.rows != header.cols)) {
+        return -1;
+    }
+    m = header.rows;
+    n = header.cols;
+    kind = header.kind;
+
+    col = (double*)malloc(m * sizeof(double));
+    row = (double*)malloc(n * sizeof(double));
+    if (col == NULL || row == NULL ||
+        fread(col, sizeof(double), m, fp) != (size_t)m ||
+        (kind == MAT_TOEPLITZ && fread(row, sizeof(double), n, fp) != (size_t)n)) {
+        return -1;
+    }
+    row[0] = col[0];
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Write_toeplitz
+ * Purpose:   Write col and row in the Toeplitz format
+*/
+int Write_toeplitz(char* filename) {
+    FILE* fp;
+    Toeplitz_header header;
+
+    header.magic = MAT_FORMAT_TOEPLITZ;
+    header.rows = m;
+    header.cols = n;
+    header.kind = kind;
+
+    fp = fopen(filename, "wb");
+    if (fp == NULL) return -1;
+    if (fwrite(&header, sizeof(header), 1, fp) != 1 ||
+        fwrite(col, sizeof(double), m, fp) != (size_t)m ||
+        (kind == MAT_TOEPLITZ && fwrite(row, sizeof(double), n, fp) != (size_t)n)) {
+        fclose(fp);
+        return -1;
+    }
+    return fclose(fp) == 0 ? 0 : -1;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Read_matrix
+ * Purpose:   Read a binary matrix file
+*/
+int Read_matrix(char* filename, double** A_p, int* m_p, int* n_p) {
+    FILE* fp;
+    int rows, cols;
+    double* A;
+
+    fp = fopen(filename, "rb");
+    if (fp == NULL) return -1;
+
+    if (fread(&rows, sizeof(int), 1, fp) != 1 ||
+        fread(&cols, sizeof(int), 1, fp) != 1) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (rows <= 0 || cols <= 0) {
+        fclose(fp);
+        return -1;
+    }
+
+    A = (double*)malloc((size_t)rows * cols * sizeof(double));
+    if (A == NULL) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (fread(A, sizeof(double), (size_t)rows * cols, fp) != (size_t)rows * cols) {
+        free(A);
+        fclose(fp);
+        return -1;
+    }
+
+    fclose(fp);
+    *A_p = A;
+    *m_p = rows;
+    *n_p = cols;
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Write_vector
+ * Purpose:   Write a vector to a binary file
+*/
+int Write_vector(char* filename, double y[], int m) {
+    FILE* fp;
+    int cols = 1;
+
+    fp = fopen(filename, "wb");
+    if (fp == NULL) return -1;
+
+    if (fwrite(&m, sizeof(int), 1, fp) != 1 ||
+        fwrite(&cols, sizeof(int), 1, fp) != 1) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (fwrite(y, sizeof(double), m, fp) != m) {
+        fclose(fp);
+        return -1;
+    }
+
+    fclose(fp);
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Detect_structure
+ * Purpose:   Check the dense A for Toeplitz structure in parallel and
+ *            keep only its first row and column
+ * Return:    0 if A is Toeplitz, -1 otherwise
+*/
+int Detect_structure(void) {
+    pthread_t* thread_handles;
+    long thread;
+    int j, found = 1;
+
+    not_toeplitz = (int*)calloc(thread_count, sizeof(int));
+    thread_handles = (pthread_t*)malloc(thread_count * sizeof(pthread_t));
+    col = (double*)malloc(m * sizeof(double));
+    row = (double*)malloc(n * sizeof(double));
+    if (not_toeplitz == NULL || thread_handles == NULL || col == NULL || row == NULL) {
+        return -1;
+    }
+
+    for (thread = 0; thread < thread_count; thread++) {
+        pthread_create(&thread_handles[thread], NULL, Pth_detect, (void*)thread);
+    }
+    for (thread = 0; thread < thread_count; thread++) {
+        pthread_join(thread_handles[thread], NULL);
+        if (not_toeplitz[thread]) found = 0;
+    }
+
+    if (found) {
+        for (j = 0; j < m; j++) col[j] = dense[(size_t)j * n];
+        for (j = 0; j < n; j++) row[j] = dense[j];
+
+        /* Circulant: each row is the previous one rotated right */
+        kind = MAT_CIRCULANT;
+        if (m != n) kind = MAT_TOEPLITZ;
+        for (j = 1; j < n && kind == MAT_CIRCULANT; j++) {
+            if (fabs(row[j] - col[n - j]) > tolerance) kind = MAT_TOEPLITZ;
+        }
+    }
+
+    free(not_toeplitz);
+    free(thread_handles);
+    free(dense);
+    dense = NULL;
+    return found ? 0 : -1;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Pth_detect
+ * Purpose:   Thread function: check that each of this thread's rows is
+ *            the row above shifted right by one
+*/
+void* Pth_detect(void* rank) {
+    long my_rank = (long)rank;
+    int i, j;
+    int local_first_row = MAX(BLOCK_LOW(my_rank, thread_count, m), 1);
+    int local_last_row = BLOCK_HIGH(my_rank, thread_count, m);
+
+    for (i = local_first_row; i <= local_last_row; i++) {
+        const double* above = dense + (size_t)(i - 1) * n;
+        const double* cur = dense + (size_t)i * n;
+        for (j = 1; j < n; j++) {
+            if (fabs(cur[j] - above[j - 1]) > tolerance) {
+                not_toeplitz[my_rank] = 1;
+                return NULL;
+            }
+        }
+    }
+    return NULL;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Embedding
+ * Purpose:   Entry k of the first column of the circulant embedding:
+ *            A's first column, zeros, then A's first row reversed
+*/
+double Embedding(int k) {
+    if (kind == MAT_CIRCULANT) return col[k];
+    if (k < m) return col[k];
+    if (k > fft_size - n) return row[fft_size - k];
+    return 0.0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Bit_reverse
+ * Purpose:   Reverse the low log_size bits of k
+*/
+int Bit_reverse(int k) {
+    int r = 0, b;
+
+    for (b = 0; b < log_size; b++) {
+        r = (r << 1) | (k & 1);
+        k >>= 1;
+    }
+    return r;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Fft_stages
+ * Purpose:   Butterfly stages of an in-place radix-2 FFT of a (and b if
+ *            not NULL), whose input is in bit-reversed order. This
+ *            thread does its block of the N/2 butterflies of each stage.
+*/
+void Fft_stages(double complex* a, double complex* b, int inverse, long my_rank) {
+    int half, stride, k, i, j, pos;
+    int first = BLOCK_LOW(my_rank, thread_count, fft_size / 2);
+    int last = BLOCK_HIGH(my_rank, thread_count, fft_size / 2);
+    double complex w, t;
+
+    for (half = 1; half < fft_size; half <<= 1) {
+        stride = fft_size / (2 * half);
+        for (k = first; k <= last; k++) {
+            pos = k % half;
+            i = (k / half) * 2 * half + pos;
+            j = i + half;
+            w = inverse ? conj(twiddle[pos * stride]) : twiddle[pos * stride];
+
+            t = w * a[j];
+            a[j] = a[i] - t;
+            a[i] += t;
+            if (b != NULL) {
+                t = w * b[j];
+                b[j] = b[i] - t;
+                b[i] += t;
+            }
+        }
+        pthread_barrier_wait(&barrier);
+    }
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Pth_fft_matvec
+ * Purpose:   Thread function: transform the embedding and x together,
+ *            multiply pointwise, transform back and keep the first m
+*/
+void* Pth_fft_matvec(void* rank) {
+    long my_rank = (long)rank;
+    int k, r;
+    int first = BLOCK_LOW(my_rank, thread_count, fft_size);
+    int last = BLOCK_HIGH(my_rank, thread_count, fft_size);
+
+    /* Scatter inputs in bit-reversed order; build the twiddles */
+    for (k = first; k <= last; k++) {
+        r = Bit_reverse(k);
+        c_hat[r] = Embedding(k);
+        x_hat[r] = k < n ? x[k] : 0.0;
+        if (k < fft_size / 2) twiddle[k] = cexp(-2.0 * M_PI * I * k / fft_size);
+    }
+    pthread_barrier_wait(&barrier);
+
+    Fft_stages(c_hat, x_hat, 0, my_rank);
+
+    /* Pointwise product, scattered for the inverse transform */
+    for (k = first; k <= last; k++) {
+        z[Bit_reverse(k)] = c_hat[k] * x_hat[k];
+    }
+    pthread_barrier_wait(&barrier);
+
+    Fft_stages(z, NULL, 1, my_rank);
+
+    for (k = BLOCK_LOW(my_rank, thread_count, m); k <= BLOCK_HIGH(my_rank, thread_count, m); k++) {
+        y[k] = creal(z[k]) / fft_size;
+    }
+    return NULL;
+}
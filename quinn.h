@@ -21,6 +21,7 @@
 #define _QUINN_H_
 
 #define MIN(a,b) ((a)<(b)?(a):(b))
+#define MAX(a,b) ((a)>(b)?(a):(b))
 
 /* BLOCK_LOW: Calculate starting index for a given rank/thread
  * id: rank/thread id
@@ -0,0 +1,679 @@
+/**
+ * @file reorder_matrix.c
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Bandwidth-reducing reordering of a square sparse matrix.
+ *
+ * Computes a symmetric permutation B = P A P^T that brings the entries
+ * of each row close to the diagonal, so an SpMV reads x in nearby
+ * places instead of all over it. Orderings (on the pattern of A + A^T):
+ *   rcm    Reverse Cuthill-McKee: breadth-first from a pseudo-peripheral
+ *          vertex of each component, neighbors by increasing degree,
+ *          the whole order reversed
+ *   part   recursive bisection into k parts (default: the thread
+ *          count) by breadth-first level structures; each part holds
+ *          contiguous rows, so a thread's rows mostly use its own block
+ *          of x
+ *
+ * Writes B in A's format (dense, CSR or CSC) and the permutation as an
+ * N x 1 vector: perm[k] is the original index of new row k. Running
+ * pth_matrix_vector -p perm on B takes x and gives y in the original
+ * order.
+ *
+ * The bandwidth (max |i - j| over entries) and profile (sum over rows
+ * of the distance from the first entry to the diagonal) of A and B are
+ * printed to stdout with the time of a threaded CSR SpMV on each.
+ *
+ * Timing data is output to stderr in CSV format:
+ *   N,P,Ordering,Bandwidth_Before,Bandwidth_After,Profile_Before,
+ *   Profile_After,Time_Order,Time_SpMV_Before,Time_SpMV_After
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "quinn.h"
+#include "timer.h"
+#include "mat_format.h"
+#include "sparse.h"
+#include "semiring.h"
+
+/* A column and value of a row being sorted */
+typedef struct {
+    int col;
+    double val;
+} Pair;
+
+/* Rows longer than this are sorted with qsort rather than by insertion */
+#define INSERTION_MAX 32
+
+/* Orderings */
+#define ORDER_RCM  0
+#define ORDER_PART 1
+
+/* Global variables */
+int thread_count;
+int n;                         /* order of A */
+long* adj_ptr;                 /* pattern of A + A^T without the diagonal */
+int* adj;
+int* mark;                     /* BFS visit stamps */
+int stamp = 0;
+int* label;                    /* vertex subset ids for restricted searches */
+int next_label = 1;
+int* queue;
+Csr* spmv_A;                   /* operands of Pth_spmv */
+double *spmv_x, *spmv_y;
+Csr permuted;                  /* work shared with Pth_permute */
+Csr* original;
+int *perm, *inverse;
+
+/* Function prototypes */
+void Usage(char* prog_name);
+int Read_matrix(char* filename, double** A_p, int* m_p, int* n_p);
+int Write_matrix(char* filename, double* A, int rows, int cols);
+int Build_graph(Csr* A);
+int Degree(int v);
+int Compare_degree(const void* a, const void* b);
+int Compare_pairs(const void* a, const void* b);
+int Bfs(int root, int in_label, int sorted, int* count_p, int* last_level_p);
+int Pseudo_peripheral(int start, int in_label);
+void Order_rcm(void);
+void Bisect(int* members, int count, int parts);
+void Matrix_stats(Csr* A, long* bandwidth_p, long* profile_p);
+double Time_spmv(Csr* A, int reps);
+void* Pth_spmv(void* rank);
+void* Pth_permute(void* rank);
+
+int main(int argc, char* argv[]) {
+    int opt, ordering = ORDER_RCM, parts = 0, reps = 10, format, rows, cols, k;
+    long thread;
+    pthread_t* thread_handles;
+    double *dense = NULL, *dense_out, *perm_out;
+    double start_order, end_order, time_before, time_after;
+    long band_before, band_after, prof_before, prof_after, i, j;
+    Csr csr;
+    Csc csc;
+    int status;
+
+    /* Parse options */
+    while ((opt = getopt(argc, argv, "o:k:r:")) != -1) {
+        switch (opt) {
+            case 'o':
+                if (strcmp(optarg, "rcm") == 0) ordering = ORDER_RCM;
+                else if (strcmp(optarg, "part") == 0) ordering = ORDER_PART;
+                else {
+                    fprintf(stderr, "Error: Unknown ordering %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'k': parts = atoi(optarg); break;
+            case 'r': reps = atoi(optarg); break;
+            default:
+                Usage(argv[0]);
+                exit(1);
+        }
+    }
+
+    /* Check command line arguments */
+    if (argc - optind != 4 || reps <= 0 || parts < 0) {
+        Usage(argv[0]);
+        exit(1);
+    }
+
+    /* Get number of threads */
+    thread_count = atoi(argv[optind + 3]);
+    if (thread_count <= 0) {
+        fprintf(stderr, "Error: Number of threads must be positive\n");
+        exit(1);
+    }
+    if (parts == 0) parts = thread_count;
+    thread_handles = (pthread_t*)malloc(thread_count * sizeof(pthread_t));
+    if (thread_handles == NULL) {
+        fprintf(stderr, "Error: Cannot allocate memory for thread handles\n");
+        exit(1);
+    }
+
+    /* Read A as CSR */
+    format = Sparse_format(argv[optind]);
+    if (format == MAT_FORMAT_DENSE) {
+        status = Read_matrix(argv[optind], &dense, &rows, &cols);
+        if (status == 0) status = Csr_from_dense(dense, rows, cols, thread_count, &csr);
+    } else if (format == MAT_FORMAT_CSR) {
+        status = Csr_read(argv[optind], &csr);
+    } else if (format == MAT_FORMAT_CSC) {
+        status = Csc_read(argv[optind], &csc);
+        if (status == 0) {
+            status = Csr_from_csc(&csc, thread_count, &csr);
+            Csc_free(&csc);
+        }
+    } else {
+        status = -1;
+    }
+    if (status != 0) {
+        fprintf(stderr, "Error: Failed to read matrix A from %s\n", argv[optind]);
+        exit(1);
+    }
+    if (csr.rows != csr.cols) {
+        fprintf(stderr, "Error: Reordering needs a square matrix (%d x %d)\n", csr.rows, csr.cols);
+        exit(1);
+    }
+    n = csr.rows;
+
+    /* Order the vertices of A + A^T */
+    perm = (int*)malloc(n * sizeof(int));
+    inverse = (int*)malloc(n * sizeof(int));
+    mark = (int*)calloc(n, sizeof(int));
+    label = (int*)calloc(n, sizeof(int));
+    queue = (int*)malloc(n * sizeof(int));
+    if (perm == NULL || inverse == NULL || mark == NULL || label == NULL || queue == NULL ||
+        Build_graph(&csr) != 0) {
+        fprintf(stderr, "Error: Cannot allocate memory for the ordering\n");
+        exit(1);
+    }
+    GET_TIME(start_order);
+    if (ordering == ORDER_RCM) {
+        Order_rcm();
+    } else {
+        for (k = 0; k < n; k++) perm[k] = k;
+        Bisect(perm, n, MIN(parts, n));
+    }
+    GET_TIME(end_order);
+    for (k = 0; k < n; k++) inverse[perm[k]] = k;
+
+    /* B = P A P^T, a block of rows per thread */
+    if (Csr_alloc(&permuted, n, n, csr.nnz) != 0) {
+        fprintf(stderr, "Error: Cannot allocate memory for the permuted matrix\n");
+        exit(1);
+    }
+    permuted.row_ptr[0] = 0;
+    for (k = 0; k < n; k++) {
+        permuted.row_ptr[k + 1] = permuted.row_ptr[k] + csr.row_ptr[perm[k] + 1] - csr.row_ptr[perm[k]];
+    }
+    original = &csr;
+    for (thread = 0; thread < thread_count; thread++) {
+        pthread_create(&thread_handles[thread], NULL, Pth_permute, (void*)thread);
+    }
+    for (thread = 0; thread < thread_count; thread++) {
+        pthread_join(thread_handles[thread], NULL);
+    }
+
+    /* Compare A and B */
+    Matrix_stats(&csr, &band_before, &prof_before);
+    Matrix_stats(&permuted, &band_after, &prof_after);
+    time_before = Time_spmv(&csr, reps);
+    time_after = Time_spmv(&permuted, reps);
+
+    /* Write B in A's format, and the permutation */
+    if (format == MAT_FORMAT_DENSE) {
+        dense_out = (double*)malloc((size_t)n * n * sizeof(double));
+        if (dense_out == NULL) {
+            fprintf(stderr, "Error: Cannot allocate memory for the permuted matrix\n");
+            exit(1);
+        }
+        for (i = 0; i < n; i++) {
+            for (j = 0; j < n; j++) dense_out[i * n + j] = dense[(size_t)perm[i] * n + perm[j]];
+        }
+        status = Write_matrix(argv[optind + 1], dense_out, n, n);
+        free(dense_out);
+    } else if (format == MAT_FORMAT_CSR) {
+        status = Csr_write(argv[optind + 1], &permuted);
+    } else {
+        status = Csc_from_csr(&permuted, thread_count, &csc);
+        if (status == 0) {
+            status = Csc_write(argv[optind + 1], &csc);
+            Csc_free(&csc);
+        }
+    }
+    if (status != 0) {
+        fprintf(stderr, "Error: Failed to write %s\n", argv[optind + 1]);
+        exit(1);
+    }
+    perm_out = (double*)malloc(n * sizeof(double));
+    if (perm_out == NULL) {
+        fprintf(stderr, "Error: Cannot allocate memory for the permutation\n");
+        exit(1);
+    }
+    for (k = 0; k < n; k++) perm_out[k] = perm[k];
+    if (Write_matrix(argv[optind + 2], perm_out, n, 1) != 0) {
+        fprintf(stderr, "Error: Failed to write %s\n", argv[optind + 2]);
+        exit(1);
+    }
+
+    printf("%s: bandwidth %ld -> %ld, profile %ld -> %ld\n",
+           ordering == ORDER_RCM ? "rcm" : "part", band_before, band_after, prof_before, prof_after);
+    printf("SpMV: %e s -> %e s (%.2fx)\n", time_before, time_after, time_before / time_after);
+
+    /* Print timing results to stderr */
+    fprintf(stderr, "%d,%d,%s,%ld,%ld,%ld,%ld,%e,%e,%e\n", n, thread_count,
+            ordering == ORDER_RCM ? "rcm" : "part", band_before, band_after, prof_before,
+            prof_after, end_order - start_order, time_before, time_after);
+
+    /* Clean up */
+    free(dense);
+    free(perm_out);
+    Csr_free(&csr);
+    Csr_free(&permuted);
+    free(adj_ptr);
+    free(adj);
+    free(perm);
+    free(inverse);
+    free(mark);
+    free(label);
+    free(queue);
+    free(thread_handles);
+
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Usage
+ * Purpose:   Print usage message
+*/
+void Usage(char* prog_name) {
+    fprintf(stderr, "Usage: %s [-o ordering] [-k parts] [-r reps] <file_A> <file_out> <file_perm> <num_threads>\n",
+            prog_name);
+    fprintf(stderr, "  Reorders square matrix A to reduce its bandwidth\n");
+    fprintf(stderr, "  -o ordering  rcm (default) or part\n");
+    fprintf(stderr, "  -k parts     parts for -o part (default: num_threads)\n");
+    fprintf(stderr, "  -r reps      SpMV repetitions timed (default 10)\n");
+    fprintf(stderr, "  Example: %s A.csr B.csr perm.mat 4\n", prog_name);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Read_matrix
+ * Purpose:   Read a binary matrix file
+*/
+int Read_matrix(char* filename, double** A_p, int* m_p, int* n_p) {
+    FILE* fp;
+    int rows, cols;
+    double* A;
+
+    fp = fopen(filename, "rb");
+    if (fp == NULL) return -1;
+
+    if (fread(&rows, sizeof(int), 1, fp) != 1 ||
+        fread(&cols, sizeof(int), 1, fp) != 1) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (rows <= 0 || cols <= 0) {
+        fclose(fp);
+        return -1;
+    }
+
+    A = (double*)malloc((size_t)rows * cols * sizeof(double));
+    if (A == NULL) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (fread(A, sizeof(double), (size_t)rows * cols, fp) != (size_t)rows * cols) {
+        free(A);
+        fclose(fp);
+        return -1;
+    }
+
+    fclose(fp);
+    *A_p = A;
+    *m_p = rows;
+    *n_p = cols;
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Write_matrix
+ * Purpose:   Write a matrix to a binary file
+*/
+int Write_matrix(char* filename, double* A, int rows, int cols) {
+    FILE* fp;
+
+    fp = fopen(filename, "wb");
+    if (fp == NULL) return -1;
+
+    if (fwrite(&rows, sizeof(int), 1, fp) != 1 ||
+        fwrite(&cols, sizeof(int), 1, fp) != 1) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (fwrite(A, sizeof(double), (size_t)rows * cols, fp) != (size_t)rows * cols) {
+        fclose(fp);
+        return -1;
+    }
+
+    fclose(fp);
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Build_graph
+ * Purpose:   Adjacency lists of A + A^T without the diagonal: row i of
+ *            A merged with column i (row i of the transpose), both
+ *            sorted, dropping duplicates
+ * Return:    0 on success, -1 on allocation failure
+*/
+int Build_graph(Csr* A) {
+    Csc T;
+    long a, b, end_a, end_b, count;
+    int i, pass, v;
+
+    if (Csc_from_csr(A, thread_count, &T) != 0) return -1;
+    adj_ptr = (long*)malloc((n + 1) * sizeof(long));
+    if (adj_ptr == NULL) {
+        Csc_free(&T);
+        return -1;
+    }
+
+    /* Pass 0 counts, pass 1 fills */
+    adj = NULL;
+    for (pass = 0; pass < 2; pass++) {
+        adj_ptr[0] = 0;
+        for (i = 0; i < n; i++) {
+            a = A->row_ptr[i];
+            end_a = A->row_ptr[i + 1];
+            b = T.col_ptr[i];
+            end_b = T.col_ptr[i + 1];
+            count = adj_ptr[i];
+            while (a < end_a || b < end_b) {
+                if (b >= end_b || (a < end_a && A->col_idx[a] <= T.row_idx[b])) {
+                    v = A->col_idx[a++];
+                    if (b < end_b && T.row_idx[b] == v) b++;
+                } else {
+                    v = T.row_idx[b++];
+                }
+                if (v == i) continue;
+                if (pass == 1) adj[count] = v;
+                count++;
+            }
+            adj_ptr[i + 1] = count;
+        }
+        if (pass == 0) {
+            adj = (int*)malloc(MAX(adj_ptr[n], 1) * sizeof(int));
+            if (adj == NULL) {
+                Csc_free(&T);
+                return -1;
+            }
+        }
+    }
+
+    Csc_free(&T);
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Degree / Compare_degree / Compare_pairs
+ * Purpose:   Vertex degree in A + A^T, qsort order by it, and qsort
+ *            order of row entries by column
+*/
+int Degree(int v) {
+    return (int)(adj_ptr[v + 1] - adj_ptr[v]);
+}
+
+int Compare_degree(const void* a, const void* b) {
+    int da = Degree(*(const int*)a), db = Degree(*(const int*)b);
+    if (da != db) return da - db;
+    return *(const int*)a - *(const int*)b;
+}
+
+int Compare_pairs(const void* a, const void* b) {
+    int i = ((const Pair*)a)->col, j = ((const Pair*)b)->col;
+    return (i > j) - (i < j);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Bfs
+ * Purpose:   Breadth-first search from root over the vertices labeled
+ *            in_label, into queue[]; with sorted, each vertex's new
+ *            neighbors are queued by increasing degree (Cuthill-McKee)
+ * Return:    number of levels; *count_p = vertices reached, and
+ *            *last_level_p = index in queue[] of the last level's first
+*/
+int Bfs(int root, int in_label, int sorted, int* count_p, int* last_level_p) {
+    int head = 0, tail = 0, level_end, levels = 0, last_level = 0, v, w, before;
+    long k;
+
+    stamp++;
+    mark[root] = stamp;
+    queue[tail++] = root;
+    while (head < tail) {
+        /* One level */
+        last_level = head;
+        level_end = tail;
+        levels++;
+        while (head < level_end) {
+            v = queue[head++];
+            before = tail;
+            for (k = adj_ptr[v]; k < adj_ptr[v + 1]; k++) {
+                w = adj[k];
+                if (mark[w] != stamp && label[w] == in_label) {
+                    mark[w] = stamp;
+                    queue[tail++] = w;
+                }
+            }
+            if (sorted && tail - before > 1) {
+                qsort(&queue[before], tail - before, sizeof(int), Compare_degree);
+            }
+        }
+    }
+    *count_p = tail;
+    *last_level_p = last_level;
+    return levels;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Pseudo_peripheral
+ * Purpose:   George-Liu: move to a lowest-degree vertex of the last BFS
+ *            level while that makes the level structure deeper
+ * Return:    a vertex whose BFS levels are (nearly) as deep as any
+*/
+int Pseudo_peripheral(int start, int in_label) {
+    int root = start, levels, count, last, k, best, new_levels;
+
+    levels = Bfs(root, in_label, 0, &count, &last);
+    for (;;) {
+        best = queue[last];
+        for (k = last + 1; k < count; k++) {
+            if (Degree(queue[k]) < Degree(best)) best = queue[k];
+        }
+        new_levels = Bfs(best, in_label, 0, &count, &last);
+        if (new_levels <= levels) return root;
+        root = best;
+        levels = new_levels;
+    }
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Order_rcm
+ * Purpose:   Reverse Cuthill-McKee, component by component; numbered
+ *            vertices are relabeled -1 so later searches skip them
+*/
+void Order_rcm(void) {
+    int start, root, count, last, k, numbered = 0;
+
+    for (start = 0; start < n; start++) {
+        if (label[start] != 0) continue;
+        root = Pseudo_peripheral(start, 0);
+        Bfs(root, 0, 1, &count, &last);
+        for (k = 0; k < count; k++) {
+            label[queue[k]] = -1;
+            perm[n - 1 - numbered - k] = queue[k];
+        }
+        numbered += count;
+    }
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Bisect
+ * Purpose:   Split members[0..count-1] (all labeled alike) into parts
+ *            by BFS level structures: order them by BFS from a
+ *            pseudo-peripheral vertex, give the first share of the
+ *            order and the rest new labels, and recurse on each
+*/
+void Bisect(int* members, int count, int parts) {
+    int in_label, left, reached, last, root, k, m, total = 0, left_label, right_label;
+    int* order;
+
+    if (parts <= 1 || count <= 1) return;
+    in_label = label[members[0]];
+
+    /* BFS order over every component of the subset */
+    order = (int*)malloc(count * sizeof(int));
+    if (order == NULL) return;
+    for (k = 0; k < count && total < count; k++) {
+        if (label[members[k]] != in_label) continue;
+        root = Pseudo_peripheral(members[k], in_label);
+        Bfs(root, in_label, 0, &reached, &last);
+        for (m = 0; m < reached; m++) {
+            order[total++] = queue[m];
+            label[queue[m]] = -2;          /* placed */
+        }
+    }
+
+    /* First share to the left part */
+    left = (int)((long)count * (parts / 2) / parts);
+    left_label = next_label++;
+    right_label = next_label++;
+    for (k = 0; k < count; k++) {
+        members[k] = order[k];
+        label[order[k]] = k < left ? left_label : right_label;
+    }
+    free(order);
+
+    Bisect(members, left, parts / 2);
+    Bisect(members + left, count - left, parts - parts / 2);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Matrix_stats
+ * Purpose:   Bandwidth and profile of a square CSR matrix
+*/
+void Matrix_stats(Csr* A, long* bandwidth_p, long* profile_p) {
+    long bandwidth = 0, profile = 0, k, d;
+    int i;
+
+    for (i = 0; i < A->rows; i++) {
+        if (A->row_ptr[i] == A->row_ptr[i + 1]) continue;
+        for (k = A->row_ptr[i]; k < A->row_ptr[i + 1]; k++) {
+            d = A->col_idx[k] > i ? A->col_idx[k] - i : i - A->col_idx[k];
+            if (d > bandwidth) bandwidth = d;
+        }
+        if (A->col_idx[A->row_ptr[i]] < i) profile += i - A->col_idx[A->row_ptr[i]];
+    }
+    *bandwidth_p = bandwidth;
+    *profile_p = profile;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Time_spmv
+ * Purpose:   Average time of a threaded CSR y = A * x over reps runs
+*/
+double Time_spmv(Csr* A, int reps) {
+    pthread_t* thread_handles;
+    long thread;
+    int r, i;
+    double start, end;
+
+    spmv_A = A;
+    spmv_x = (double*)malloc(A->cols * sizeof(double));
+    spmv_y = (double*)malloc(A->rows * sizeof(double));
+    thread_handles = (pthread_t*)malloc(thread_count * sizeof(pthread_t));
+    if (spmv_x == NULL || spmv_y == NULL || thread_handles == NULL) {
+        fprintf(stderr, "Error: Cannot allocate memory for the SpMV\n");
+        exit(1);
+    }
+    for (i = 0; i < A->cols; i++) spmv_x[i] = 1.0 + (double)(i % 7);
+
+    GET_TIME(start);
+    for (r = 0; r < reps; r++) {
+        for (thread = 0; thread < thread_count; thread++) {
+            pthread_create(&thread_handles[thread], NULL, Pth_spmv, (void*)thread);
+        }
+        for (thread = 0; thread < thread_count; thread++) {
+            pthread_join(thread_handles[thread], NULL);
+        }
+    }
+    GET_TIME(end);
+
+    free(spmv_x);
+    free(spmv_y);
+    free(thread_handles);
+    return (end - start) / reps;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Pth_spmv
+ * Purpose:   Thread function: this thread's rows of spmv_y
+*/
+void* Pth_spmv(void* rank) {
+    long my_rank = (long)rank;
+
+    Semiring_csr_rows(SR_PLUS_TIMES, spmv_A, spmv_x, spmv_y,
+                      BLOCK_LOW(my_rank, thread_count, spmv_A->rows),
+                      BLOCK_HIGH(my_rank, thread_count, spmv_A->rows));
+    return NULL;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Pth_permute
+ * Purpose:   Thread function: fill this thread's rows of B = P A P^T,
+ *            renumbering columns and sorting each row (by insertion,
+ *            or with qsort for long rows)
+*/
+void* Pth_permute(void* rank) {
+    long my_rank = (long)rank;
+    int first_row = BLOCK_LOW(my_rank, thread_count, n);
+    int last_row = BLOCK_HIGH(my_rank, thread_count, n);
+    int i, col;
+    long k, dst, start, p, length;
+    double val;
+    Pair* pairs = NULL;
+    long capacity = 0;
+
+    for (i = first_row; i <= last_row; i++) {
+        start = permuted.row_ptr[i];
+        dst = start;
+        length = permuted.row_ptr[i + 1] - start;
+        if (length > INSERTION_MAX) {
+            if (length > capacity) {
+                free(pairs);
+                capacity = length;
+                pairs = (Pair*)malloc(capacity * sizeof(Pair));
+                if (pairs == NULL) {
+                    fprintf(stderr, "Error: Cannot allocate memory for row sorting\n");
+                    exit(1);
+                }
+            }
+            for (k = 0; k < length; k++) {
+                pairs[k].col = inverse[original->col_idx[original->row_ptr[perm[i]] + k]];
+                pairs[k].val = original->val[original->row_ptr[perm[i]] + k];
+            }
+            qsort(pairs, length, sizeof(Pair), Compare_pairs);
+            for (k = 0; k < length; k++) {
+                permuted.col_idx[start + k] = pairs[k].col;
+                permuted.val[start + k] = pairs[k].val;
+            }
+            continue;
+        }
+        for (k = original->row_ptr[perm[i]]; k < original->row_ptr[perm[i] + 1]; k++) {
+            col = inverse[original->col_idx[k]];
+            val = original->val[k];
+            for (p = dst; p > start && permuted.col_idx[p - 1] > col; p--) {
+                permuted.col_idx[p] = permuted.col_idx[p - 1];
+                permuted.val[p] = permuted.val[p - 1];
+            }
+            permuted.col_idx[p] = col;
+            permuted.val[p] = val;
+            dst++;
+        }
+    }
+    free(pairs);
+    return NULL;
+}
@@ -0,0 +1,112 @@
+/**
+ * @file semiring.c
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Matrix-vector kernels over semirings.
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "semiring.h"
+
+static const char* semiring_names[SR_COUNT] = {
+    "plus-times", "min-plus", "max-times", "or-and"
+};
+
+/* One specialized kernel per semiring and format */
+SR_DENSE_KERNEL(PLUS_TIMES)
+SR_DENSE_KERNEL(MIN_PLUS)
+SR_DENSE_KERNEL(MAX_TIMES)
+SR_DENSE_KERNEL(OR_AND)
+
+SR_CSR_KERNEL(PLUS_TIMES)
+SR_CSR_KERNEL(MIN_PLUS)
+SR_CSR_KERNEL(MAX_TIMES)
+SR_CSR_KERNEL(OR_AND)
+
+SR_DCSR_KERNEL(PLUS_TIMES)
+SR_DCSR_KERNEL(MIN_PLUS)
+SR_DCSR_KERNEL(MAX_TIMES)
+SR_DCSR_KERNEL(OR_AND)
+
+/*-------------------------------------------------------------------
+ * Function:  Semiring_parse
+ * Purpose:   Look up a semiring by name
+*/
+int Semiring_parse(const char* name) {
+    int sr;
+
+    for (sr = 0; sr < SR_COUNT; sr++) {
+        if (strcmp(name, semiring_names[sr]) == 0) return sr;
+    }
+    return -1;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Semiring_name
+ * Purpose:   Name of a semiring
+*/
+const char* Semiring_name(int sr) {
+    return sr >= 0 && sr < SR_COUNT ? semiring_names[sr] : "unknown";
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Semiring_zero
+ * Purpose:   Additive identity of a semiring
+*/
+double Semiring_zero(int sr) {
+    switch (sr) {
+        case SR_MIN_PLUS: return SR_MIN_PLUS_ZERO;
+        case SR_MAX_TIMES: return SR_MAX_TIMES_ZERO;
+        case SR_OR_AND: return SR_OR_AND_ZERO;
+        default: return SR_PLUS_TIMES_ZERO;
+    }
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Semiring_dense_rows
+ * Purpose:   Dispatch to the dense kernel for a semiring
+*/
+void Semiring_dense_rows(int sr, const double* A, int n, const double* x, double* y,
+                         int first_row, int last_row) {
+    switch (sr) {
+        case SR_MIN_PLUS: Sr_dense_MIN_PLUS(A, n, x, y, first_row, last_row); break;
+        case SR_MAX_TIMES: Sr_dense_MAX_TIMES(A, n, x, y, first_row, last_row); break;
+        case SR_OR_AND: Sr_dense_OR_AND(A, n, x, y, first_row, last_row); break;
+        default: Sr_dense_PLUS_TIMES(A, n, x, y, first_row, last_row); break;
+    }
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Semiring_csr_rows
+ * Purpose:   Dispatch to the CSR kernel for a semiring
+*/
+void Semiring_csr_rows(int sr, const Csr* A, const double* x, double* y,
+                       int first_row, int last_row) {
+    switch (sr) {
+        case SR_MIN_PLUS: Sr_csr_MIN_PLUS(A, x, y, first_row, last_row); break;
+        case SR_MAX_TIMES: Sr_csr_MAX_TIMES(A, x, y, first_row, last_row); break;
+        case SR_OR_AND: Sr_csr_OR_AND(A, x, y, first_row, last_row); break;
+        default: Sr_csr_PLUS_TIMES(A, x, y, first_row, last_row); break;
+    }
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Semiring_dcsr_rows
+ * Purpose:   Dispatch to the DCSR kernel for a semiring
+*/
+void Semiring_dcsr_rows(int sr, const Dcsr* A, const double* x, double* y,
+                        int first_row, int last_row) {
+    if (last_row < first_row) return;
+    switch (sr) {
+        case SR_MIN_PLUS: Sr_dcsr_MIN_PLUS(A, x, y, first_row, last_row); break;
+        case SR_MAX_TIMES: Sr_dcsr_MAX_TIMES(A, x, y, first_row, last_row); break;
+        case SR_OR_AND: Sr_dcsr_OR_AND(A, x, y, first_row, last_row); break;
+        default: Sr_dcsr_PLUS_TIMES(A, x, y, first_row, last_row); break;
+    }
+}
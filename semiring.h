@@ -0,0 +1,150 @@
+/**
+ * @file semiring.h
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Matrix-vector kernels over semirings.
+ *
+ * y = A * x over a semiring replaces + and * by the semiring's add and
+ * multiply, and starts each sum at the semiring's zero:
+ *   plus-times  ordinary arithmetic
+ *   min-plus    shortest paths: y_i = min_j (A_ij + x_j), zero = +inf
+ *   max-times   most reliable paths: y_i = max_j (A_ij * x_j), zero = 0
+ *   or-and      reachability on 0/1 values, zero = 0
+ *
+ * Each semiring is a set of macros, and the SR_*_KERNEL macros below
+ * expand a kernel body once per semiring, so every kernel is compiled
+ * with its operations inlined (the C counterpart of a template). The
+ * plus-times instances compile to the same loops as the plain kernels.
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#ifndef _SEMIRING_H_
+#define _SEMIRING_H_
+
+#include <math.h>
+#include "sparse.h"
+
+/* Semiring ids */
+#define SR_PLUS_TIMES 0
+#define SR_MIN_PLUS   1
+#define SR_MAX_TIMES  2
+#define SR_OR_AND     3
+#define SR_COUNT      4
+
+/* Operations of each semiring: ZERO, ADD(a,b) and MUL(a,b), and
+ * SKIP_ZEROS: whether dense kernels skip stored 0.0 entries. A dense
+ * 0.0 is an unstored entry (mat_format.h), which is the semiring zero,
+ * not the number 0; only plus-times gives the same sums either way.
+*/
+#define SR_PLUS_TIMES_ZERO      0.0
+#define SR_PLUS_TIMES_ADD(a,b)  ((a) + (b))
+#define SR_PLUS_TIMES_MUL(a,b)  ((a) * (b))
+#define SR_PLUS_TIMES_SKIP_ZEROS 0
+
+#define SR_MIN_PLUS_ZERO        INFINITY
+#define SR_MIN_PLUS_ADD(a,b)    ((b) < (a) ? (b) : (a))
+#define SR_MIN_PLUS_MUL(a,b)    ((a) + (b))
+#define SR_MIN_PLUS_SKIP_ZEROS  1
+
+#define SR_MAX_TIMES_ZERO       0.0
+#define SR_MAX_TIMES_ADD(a,b)   ((b) > (a) ? (b) : (a))
+#define SR_MAX_TIMES_MUL(a,b)   ((a) * (b))
+#define SR_MAX_TIMES_SKIP_ZEROS 1
+
+#define SR_OR_AND_ZERO          0.0
+#define SR_OR_AND_ADD(a,b)      ((a) != 0.0 || (b) != 0.0 ? 1.0 : 0.0)
+#define SR_OR_AND_MUL(a,b)      ((a) != 0.0 && (b) != 0.0 ? 1.0 : 0.0)
+#define SR_OR_AND_SKIP_ZEROS    1
+
+/* SR_DENSE_KERNEL(S): define Sr_dense_S, rows first_row..last_row of
+ * y = A * x for a dense row-major A with n columns over semiring S,
+ * with the same result as the CSR kernel on Csr_from_dense(A)
+*/
+#define SR_DENSE_KERNEL(S) \
+void Sr_dense_##S(const double* A, int n, const double* x, double* y, \
+                  int first_row, int last_row) { \
+    int i, j; \
+    for (i = first_row; i <= last_row; i++) { \
+        const double* row = A + (size_t)i * n; \
+        double sum = SR_##S##_ZERO; \
+        for (j = 0; j < n; j++) { \
+            if (SR_##S##_SKIP_ZEROS && row[j] == 0.0) continue; \
+            sum = SR_##S##_ADD(sum, SR_##S##_MUL(row[j], x[j])); \
+        } \
+        y[i] = sum; \
+    } \
+}
+
+/* SR_CSR_KERNEL(S): define Sr_csr_S, the same for a CSR matrix */
+#define SR_CSR_KERNEL(S) \
+void Sr_csr_##S(const Csr* A, const double* x, double* y, \
+                int first_row, int last_row) { \
+    int i; \
+    long k; \
+    for (i = first_row; i <= last_row; i++) { \
+        double sum = SR_##S##_ZERO; \
+        for (k = A->row_ptr[i]; k < A->row_ptr[i + 1]; k++) { \
+            sum = SR_##S##_ADD(sum, SR_##S##_MUL(A->val[k], x[A->col_idx[k]])); \
+        } \
+        y[i] = sum; \
+    } \
+}
+
+/* SR_DCSR_KERNEL(S): define Sr_dcsr_S, the same for a delta-compressed
+ * CSR matrix. The code is read in one sweep from the first row, each
+ * column rebuilt in a register from the previous one; rows coded in
+ * one byte per gap take a loop without escape checks.
+*/
+#define SR_DCSR_KERNEL(S) \
+void Sr_dcsr_##S(const Dcsr* A, const double* x, double* y, \
+                 int first_row, int last_row) { \
+    const unsigned char* p = A->code + A->code_ptr[first_row]; \
+    int i, j; \
+    long k, end; \
+    for (i = first_row; i <= last_row; i++) { \
+        double sum = SR_##S##_ZERO; \
+        k = A->row_ptr[i]; \
+        end = A->row_ptr[i + 1]; \
+        if (k < end) { \
+            j = A->first_col[i]; \
+            sum = SR_##S##_ADD(sum, SR_##S##_MUL(A->val[k], x[j])); \
+            if (A->code_ptr[i + 1] - A->code_ptr[i] == end - k - 1) { \
+                for (k++; k < end; k++) { \
+                    j += *p++; \
+                    sum = SR_##S##_ADD(sum, SR_##S##_MUL(A->val[k], x[j])); \
+                } \
+            } else { \
+                for (k++; k < end; k++) { \
+                    DCSR_NEXT(p, j); \
+                    sum = SR_##S##_ADD(sum, SR_##S##_MUL(A->val[k], x[j])); \
+                } \
+            } \
+        } \
+        y[i] = sum; \
+    } \
+}
+
+/* Semiring_parse: id for a name such as "min-plus", -1 if unknown */
+int Semiring_parse(const char* name);
+
+/* Semiring_name: name of a semiring id */
+const char* Semiring_name(int sr);
+
+/* Semiring_zero: additive identity of a semiring */
+double Semiring_zero(int sr);
+
+/* Semiring_dense_rows / _csr_rows / _dcsr_rows: rows first_row..last_row
+ * of y = A * x over semiring sr, dispatching to the specialized kernel
+*/
+void Semiring_dense_rows(int sr, const double* A, int n, const double* x, double* y,
+                         int first_row, int last_row);
+void Semiring_csr_rows(int sr, const Csr* A, const double* x, double* y,
+                       int first_row, int last_row);
+void Semiring_dcsr_rows(int sr, const Dcsr* A, const double* x, double* y,
+                        int first_row, int last_row);
+
+#endif /* _SEMIRING_H_ */
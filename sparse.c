@@ -0,0 +1,1450 @@
+/**
+ * @file sparse.c
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Sparse matrix storage and conversion.
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include "quinn.h"
+#include "mat_format.h"
+#include "sparse.h"
+
+/* Work shared with the compressing threads */
+typedef struct {
+    const double* A;
+    Csr* S;
+    int pass;          /* 0: count row nonzeros, 1: fill rows */
+    int thread_count;
+    long rank;
+} Compress_task;
+
+/* Work shared with the transposing threads. The source is compressed
+ * along "outer" (rows of a CSR) and indexes "inner" (its columns).
+*/
+typedef struct {
+    int outer, inner;
+    const long* ptr;
+    const int* idx;
+    const double* val;
+    long* t_ptr;       /* inner + 1 entries */
+    int* t_idx;
+    double* t_val;
+    long* hist;        /* thread_count x inner: entries per thread and inner index */
+    int thread_count;
+    pthread_barrier_t barrier;
+} Transpose_shared;
+
+typedef struct {
+    Transpose_shared* sh;
+    long rank;
+} Transpose_task;
+
+/* Work shared with the COO-compressing threads. Entries are keyed by
+ * row, or by column when building CSC; "outer" is the keyed dimension
+ * and each thread owns a block of it.
+*/
+typedef struct {
+    int fd;
+    int by_column;
+    int flags;
+    int rows, cols, outer;
+    long nnz;
+    long chunk_entries;
+    Coo_entry* chunk;      /* the chunk as read */
+    Coo_entry* grouped;    /* the chunk grouped by owning thread */
+    Coo_entry* scratch;    /* each group sorted by sub-block of lines */
+    long* sub_count;       /* thread_count x (SUB_BLOCKS_MAX + 1) */
+    long lines_per_sub;    /* lines per sub-block */
+    long* offset;          /* thread_count x thread_count: where thread t puts entries for owner b */
+    long* owner_start;     /* thread_count + 1: start of each owner's group */
+    long* block_total;     /* thread_count + 1: per-thread sums for prefix sums */
+    long* ptr;             /* outer + 1 */
+    long* cursor;          /* outer: next free slot, then length, of each line */
+    int* idx;
+    double* val;
+    int* new_idx;          /* compacted arrays when duplicates were summed */
+    double* new_val;
+    int thread_count;
+    int failed;
+    pthread_barrier_t barrier;
+} Coo_shared;
+
+typedef struct {
+    Coo_shared* sh;
+    long rank;
+} Coo_task;
+
+/* Work shared with the coding threads */
+typedef struct {
+    const Csr* S;
+    Dcsr* D;
+    int pass;          /* 0: size each row's code, 1: write it */
+    int thread_count;
+    long rank;
+    int failed;        /* a row's columns decrease */
+} Encode_task;
+
+/* An index and value of a line being sorted */
+typedef struct {
+    int idx;
+    double val;
+} Line_entry;
+
+/* Lines longer than this are sorted with qsort rather than by insertion */
+#define INSERTION_MAX 32
+
+/* Placing entries: a sub-block of lines receives about this many
+ * entries, so its slots of idx and val stay in cache (L2) while it is
+ * filled; a thread has at most SUB_BLOCKS_MAX sub-blocks
+*/
+#define SUB_BLOCK_ENTRIES 16384
+#define SUB_BLOCKS_MAX    4096
+
+/* Function prototypes */
+int Run_compress(const double* A, Csr* S, int pass, int thread_count);
+void* Pth_compress(void* arg);
+int Read_compressed(char* filename, int magic, int* rows_p, int* cols_p, long* nnz_p,
+                    long** ptr_p, int** idx_p, double** val_p);
+int Write_compressed(char* filename, int magic, int rows, int cols, long nnz,
+                     const long* ptr, const int* idx, const double* val);
+int Transpose(int outer, int inner, const long* ptr, const int* idx, const double* val,
+              long* t_ptr, int* t_idx, double* t_val, int thread_count);
+void* Pth_transpose(void* arg);
+int Compress_coo(char* filename, int by_column, int flags, size_t chunk_bytes, int thread_count,
+                 int* rows_p, int* cols_p, long* nnz_p, long** ptr_p, int** idx_p, double** val_p);
+int Read_entries(int fd, Coo_entry* buf, long count, long first);
+int Compare_line_entries(const void* a, const void* b);
+long Sort_line(int* idx, double* val, long length, int sum, Line_entry** buf_p, long* capacity_p);
+void Prefix_lines(Coo_shared* sh, long rank, long* counts);
+void* Pth_coo(void* arg);
+unsigned char* Put_gap(unsigned char* p, unsigned gap);
+int Run_encode(const Csr* S, Dcsr* D, int pass, int thread_count);
+void* Pth_encode(void* arg);
+
+/*-------------------------------------------------------------------
+ * Function:  Sparse_format
+ * Purpose:   Classify a matrix file by its first int
+*/
+int Sparse_format(char* filename) {
+    FILE* fp;
+    int first;
+
+    fp = fopen(filename, "rb");
+    if (fp == NULL) return MAT_FORMAT_INVALID;
+    if (fread(&first, sizeof(int), 1, fp) != 1) {
+        fclose(fp);
+        return MAT_FORMAT_INVALID;
+    }
+    fclose(fp);
+    return first > 0 ? MAT_FORMAT_DENSE : first;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Csr_alloc
+ * Purpose:   Allocate the arrays of a CSR matrix
+*/
+int Csr_alloc(Csr* S, int rows, int cols, long nnz) {
+    S->rows = rows;
+    S->cols = cols;
+    S->nnz = nnz;
+    S->row_ptr = (long*)malloc((rows + 1) * sizeof(long));
+    S->col_idx = (int*)malloc(MAX(nnz, 1) * sizeof(int));
+    S->val = (double*)malloc(MAX(nnz, 1) * sizeof(double));
+    if (S->row_ptr == NULL || S->col_idx == NULL || S->val == NULL) {
+        Csr_free(S);
+        return -1;
+    }
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Csr_free
+ * Purpose:   Release a CSR matrix
+*/
+void Csr_free(Csr* S) {
+    free(S->row_ptr);
+    free(S->col_idx);
+    free(S->val);
+    S->row_ptr = NULL;
+    S->col_idx = NULL;
+    S->val = NULL;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Csr_read
+ * Purpose:   Read a CSR file, checking that row_ptr is consistent
+*/
+int Csr_read(char* filename, Csr* S) {
+    memset(S, 0, sizeof(*S));
+    return Read_compressed(filename, MAT_FORMAT_CSR, &S->rows, &S->cols, &S->nnz,
+                           &S->row_ptr, &S->col_idx, &S->val);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Csr_write
+ * Purpose:   Write a CSR file
+*/
+int Csr_write(char* filename, Csr* S) {
+    return Write_compressed(filename, MAT_FORMAT_CSR, S->rows, S->cols, S->nnz,
+                            S->row_ptr, S->col_idx, S->val);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Csr_from_dense
+ * Purpose:   Count nonzeros per row in parallel, prefix-sum them into
+ *            row_ptr, then fill the rows in parallel
+*/
+int Csr_from_dense(const double* A, int rows, int cols, int thread_count, Csr* S) {
+    int i;
+
+    memset(S, 0, sizeof(*S));
+    S->rows = rows;
+    S->cols = cols;
+    S->row_ptr = (long*)malloc((rows + 1) * sizeof(long));
+    if (S->row_ptr == NULL) return -1;
+
+    /* row_ptr[i + 1] = nonzeros in row i */
+    if (Run_compress(A, S, 0, thread_count) != 0) {
+        Csr_free(S);
+        return -1;
+    }
+    S->row_ptr[0] = 0;
+    for (i = 0; i < rows; i++) S->row_ptr[i + 1] += S->row_ptr[i];
+    S->nnz = S->row_ptr[rows];
+
+    S->col_idx = (int*)malloc(MAX(S->nnz, 1) * sizeof(int));
+    S->val = (double*)malloc(MAX(S->nnz, 1) * sizeof(double));
+    if (S->col_idx == NULL || S->val == NULL || Run_compress(A, S, 1, thread_count) != 0) {
+        Csr_free(S);
+        return -1;
+    }
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Csr_to_dense
+ * Purpose:   Expand a CSR matrix; repeated entries add up, as they do
+ *            in a product
+*/
+double* Csr_to_dense(Csr* S) {
+    double* A;
+    long k;
+    int i;
+
+    A = (double*)calloc((size_t)S->rows * S->cols, sizeof(double));
+    if (A == NULL) return NULL;
+    for (i = 0; i < S->rows; i++) {
+        for (k = S->row_ptr[i]; k < S->row_ptr[i + 1]; k++) {
+            A[(size_t)i * S->cols + S->col_idx[k]] += S->val[k];
+        }
+    }
+    return A;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Csc_alloc
+ * Purpose:   Allocate the arrays of a CSC matrix
+*/
+int Csc_alloc(Csc* S, int rows, int cols, long nnz) {
+    S->rows = rows;
+    S->cols = cols;
+    S->nnz = nnz;
+    S->col_ptr = (long*)malloc((cols + 1) * sizeof(long));
+    S->row_idx = (int*)malloc(MAX(nnz, 1) * sizeof(int));
+    S->val = (double*)malloc(MAX(nnz, 1) * sizeof(double));
+    if (S->col_ptr == NULL || S->row_idx == NULL || S->val == NULL) {
+        Csc_free(S);
+        return -1;
+    }
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Csc_free
+ * Purpose:   Release a CSC matrix
+*/
+void Csc_free(Csc* S) {
+    free(S->col_ptr);
+    free(S->row_idx);
+    free(S->val);
+    S->col_ptr = NULL;
+    S->row_idx = NULL;
+    S->val = NULL;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Csc_read
+ * Purpose:   Read a CSC file, checking that col_ptr is consistent
+*/
+int Csc_read(char* filename, Csc* S) {
+    memset(S, 0, sizeof(*S));
+    return Read_compressed(filename, MAT_FORMAT_CSC, &S->rows, &S->cols, &S->nnz,
+                           &S->col_ptr, &S->row_idx, &S->val);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Csc_write
+ * Purpose:   Write a CSC file
+*/
+int Csc_write(char* filename, Csc* S) {
+    return Write_compressed(filename, MAT_FORMAT_CSC, S->rows, S->cols, S->nnz,
+                            S->col_ptr, S->row_idx, S->val);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Csc_from_csr
+ * Purpose:   Column-compress a CSR matrix
+*/
+int Csc_from_csr(const Csr* R, int thread_count, Csc* C) {
+    memset(C, 0, sizeof(*C));
+    if (Csc_alloc(C, R->rows, R->cols, R->nnz) != 0) return -1;
+    if (Transpose(R->rows, R->cols, R->row_ptr, R->col_idx, R->val,
+                  C->col_ptr, C->row_idx, C->val, thread_count) != 0) {
+        Csc_free(C);
+        return -1;
+    }
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Csr_from_csc
+ * Purpose:   Row-compress a CSC matrix
+*/
+int Csr_from_csc(const Csc* C, int thread_count, Csr* R) {
+    memset(R, 0, sizeof(*R));
+    if (Csr_alloc(R, C->rows, C->cols, C->nnz) != 0) return -1;
+    if (Transpose(C->cols, C->rows, C->col_ptr, C->row_idx, C->val,
+                  R->row_ptr, R->col_idx, R->val, thread_count) != 0) {
+        Csr_free(R);
+        return -1;
+    }
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Spvec_alloc
+ * Purpose:   Allocate the arrays of a sparse vector
+*/
+int Spvec_alloc(Spvec* v, int n, long nnz) {
+    v->n = n;
+    v->nnz = nnz;
+    v->idx = (int*)malloc(MAX(nnz, 1) * sizeof(int));
+    v->val = (double*)malloc(MAX(nnz, 1) * sizeof(double));
+    if (v->idx == NULL || v->val == NULL) {
+        Spvec_free(v);
+        return -1;
+    }
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Spvec_free
+ * Purpose:   Release a sparse vector
+*/
+void Spvec_free(Spvec* v) {
+    free(v->idx);
+    free(v->val);
+    v->idx = NULL;
+    v->val = NULL;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Spvec_read
+ * Purpose:   Read a sparse vector file, checking that the indices are
+ *            increasing and in range
+*/
+int Spvec_read(char* filename, Spvec* v) {
+    FILE* fp;
+    Sparse_header header;
+    long k;
+
+    memset(v, 0, sizeof(*v));
+    fp = fopen(filename, "rb");
+    if (fp == NULL) return -1;
+
+    if (fread(&header, sizeof(header), 1, fp) != 1 ||
+        header.magic != MAT_FORMAT_SPVEC || header.rows <= 0 || header.cols != 1 ||
+        header.nnz < 0 || header.nnz > header.rows ||
+        Spvec_alloc(v, header.rows, header.nnz) != 0) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (fread(v->idx, sizeof(int), v->nnz, fp) != (size_t)v->nnz ||
+        fread(v->val, sizeof(double), v->nnz, fp) != (size_t)v->nnz) {
+        Spvec_free(v);
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+
+    for (k = 0; k < v->nnz; k++) {
+        if (v->idx[k] < 0 || v->idx[k] >= v->n || (k > 0 && v->idx[k] <= v->idx[k - 1])) {
+            Spvec_free(v);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Spvec_write
+ * Purpose:   Write a sparse vector file
+*/
+int Spvec_write(char* filename, Spvec* v) {
+    FILE* fp;
+    Sparse_header header;
+
+    memset(&header, 0, sizeof(header));
+    header.magic = MAT_FORMAT_SPVEC;
+    header.rows = v->n;
+    header.cols = 1;
+    header.nnz = v->nnz;
+
+    fp = fopen(filename, "wb");
+    if (fp == NULL) return -1;
+    if (fwrite(&header, sizeof(header), 1, fp) != 1 ||
+        fwrite(v->idx, sizeof(int), v->nnz, fp) != (size_t)v->nnz ||
+        fwrite(v->val, sizeof(double), v->nnz, fp) != (size_t)v->nnz) {
+        fclose(fp);
+        return -1;
+    }
+    return fclose(fp) == 0 ? 0 : -1;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Spvec_from_dense
+ * Purpose:   Compress a dense vector
+*/
+int Spvec_from_dense(const double* x, int n, Spvec* v) {
+    long nnz = 0;
+    int i;
+
+    memset(v, 0, sizeof(*v));
+    for (i = 0; i < n; i++) {
+        if (x[i] != 0.0) nnz++;
+    }
+    if (Spvec_alloc(v, n, nnz) != 0) return -1;
+    nnz = 0;
+    for (i = 0; i < n; i++) {
+        if (x[i] != 0.0) {
+            v->idx[nnz] = i;
+            v->val[nnz] = x[i];
+            nnz++;
+        }
+    }
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Spvec_to_dense
+ * Purpose:   Expand a sparse vector
+*/
+double* Spvec_to_dense(Spvec* v) {
+    double* x;
+    long k;
+
+    x = (double*)calloc(v->n, sizeof(double));
+    if (x == NULL) return NULL;
+    for (k = 0; k < v->nnz; k++) x[v->idx[k]] = v->val[k];
+    return x;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Read_compressed
+ * Purpose:   Read a CSR or CSC file: header, pointers, indices, values.
+ *            The pointers must run from 0 to nnz without decreasing,
+ *            and every index must be in range.
+*/
+int Read_compressed(char* filename, int magic, int* rows_p, int* cols_p, long* nnz_p,
+                    long** ptr_p, int** idx_p, double** val_p) {
+    FILE* fp;
+    Sparse_header header;
+    int outer, inner, i;
+    long k, *ptr;
+    int* idx;
+    double* val;
+
+    fp = fopen(filename, "rb");
+    if (fp == NULL) return -1;
+
+    if (fread(&header, sizeof(header), 1, fp) != 1 || header.magic != magic ||
+        header.rows <= 0 || header.cols <= 0 || header.nnz < 0) {
+        fclose(fp);
+        return -1;
+    }
+    outer = magic == MAT_FORMAT_CSC ? header.cols : header.rows;
+    inner = magic == MAT_FORMAT_CSC ? header.rows : header.cols;
+
+    ptr = (long*)malloc((outer + 1) * sizeof(long));
+    idx = (int*)malloc(MAX(header.nnz, 1) * sizeof(int));
+    val = (double*)malloc(MAX(header.nnz, 1) * sizeof(double));
+    if (ptr == NULL || idx == NULL || val == NULL ||
+        fread(ptr, sizeof(long), outer + 1, fp) != (size_t)outer + 1 ||
+        fread(idx, sizeof(int), header.nnz, fp) != (size_t)header.nnz ||
+        fread(val, sizeof(double), header.nnz, fp) != (size_t)header.nnz) {
+        free(ptr);
+        free(idx);
+        free(val);
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+
+    for (i = 0; i < outer; i++) {
+        if (ptr[i] > ptr[i + 1]) break;
+    }
+    for (k = 0; k < header.nnz; k++) {
+        if (idx[k] < 0 || idx[k] >= inner) break;
+    }
+    if (ptr[0] != 0 || ptr[outer] != header.nnz || i < outer || k < header.nnz) {
+        free(ptr);
+        free(idx);
+        free(val);
+        return -1;
+    }
+
+    *rows_p = header.rows;
+    *cols_p = header.cols;
+    *nnz_p = header.nnz;
+    *ptr_p = ptr;
+    *idx_p = idx;
+    *val_p = val;
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Write_compressed
+ * Purpose:   Write a CSR or CSC file
+*/
+int Write_compressed(char* filename, int magic, int rows, int cols, long nnz,
+                     const long* ptr, const int* idx, const double* val) {
+    FILE* fp;
+    Sparse_header header;
+    int outer = magic == MAT_FORMAT_CSC ? cols : rows;
+
+    memset(&header, 0, sizeof(header));
+    header.magic = magic;
+    header.rows = rows;
+    header.cols = cols;
+    header.nnz = nnz;
+
+    fp = fopen(filename, "wb");
+    if (fp == NULL) return -1;
+    if (fwrite(&header, sizeof(header), 1, fp) != 1 ||
+        fwrite(ptr, sizeof(long), outer + 1, fp) != (size_t)outer + 1 ||
+        fwrite(idx, sizeof(int), nnz, fp) != (size_t)nnz ||
+        fwrite(val, sizeof(double), nnz, fp) != (size_t)nnz) {
+        fclose(fp);
+        return -1;
+    }
+    return fclose(fp) == 0 ? 0 : -1;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Transpose
+ * Purpose:   Recompress (ptr, idx, val) along the other dimension on a
+ *            team of threads, each owning a block of outer indices
+*/
+int Transpose(int outer, int inner, const long* ptr, const int* idx, const double* val,
+              long* t_ptr, int* t_idx, double* t_val, int thread_count) {
+    Transpose_shared sh;
+    Transpose_task* tasks;
+    pthread_t* thread_handles;
+    long thread;
+
+    thread_count = MAX(MIN(thread_count, outer), 1);
+    sh.outer = outer;
+    sh.inner = inner;
+    sh.ptr = ptr;
+    sh.idx = idx;
+    sh.val = val;
+    sh.t_ptr = t_ptr;
+    sh.t_idx = t_idx;
+    sh.t_val = t_val;
+    sh.thread_count = thread_count;
+    sh.hist = (long*)calloc((size_t)thread_count * inner, sizeof(long));
+    thread_handles = (pthread_t*)malloc(thread_count * sizeof(pthread_t));
+    tasks = (Transpose_task*)malloc(thread_count * sizeof(Transpose_task));
+    if (sh.hist == NULL || thread_handles == NULL || tasks == NULL) {
+        free(sh.hist);
+        free(thread_handles);
+        free(tasks);
+        return -1;
+    }
+
+    pthread_barrier_init(&sh.barrier, NULL, thread_count);
+    for (thread = 0; thread < thread_count; thread++) {
+        tasks[thread].sh = &sh;
+        tasks[thread].rank = thread;
+        pthread_create(&thread_handles[thread], NULL, Pth_transpose, &tasks[thread]);
+    }
+    for (thread = 0; thread < thread_count; thread++) {
+        pthread_join(thread_handles[thread], NULL);
+    }
+    pthread_barrier_destroy(&sh.barrier);
+
+    free(sh.hist);
+    free(thread_handles);
+    free(tasks);
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Pth_transpose
+ * Purpose:   Thread function: histogram this thread's entries by inner
+ *            index, turn the histograms into write offsets (each thread
+ *            sums a block of inner indices, then one thread prefix-sums
+ *            the totals), and scatter. Threads scatter their blocks in
+ *            order, so indices stay increasing within each output line.
+*/
+void* Pth_transpose(void* arg) {
+    Transpose_task* t = (Transpose_task*)arg;
+    Transpose_shared* sh = t->sh;
+    long* my_hist = sh->hist + (size_t)t->rank * sh->inner;
+    int first = BLOCK_LOW(t->rank, sh->thread_count, sh->outer);
+    int last = BLOCK_HIGH(t->rank, sh->thread_count, sh->outer);
+    int first_inner = BLOCK_LOW(t->rank, sh->thread_count, sh->inner);
+    int last_inner = BLOCK_HIGH(t->rank, sh->thread_count, sh->inner);
+    int i, c, thread;
+    long k, count, offset;
+
+    /* Count this thread's entries per inner index */
+    for (i = first; i <= last; i++) {
+        for (k = sh->ptr[i]; k < sh->ptr[i + 1]; k++) my_hist[sh->idx[k]]++;
+    }
+    pthread_barrier_wait(&sh->barrier);
+
+    /* Totals per inner index, for a block of them */
+    for (c = first_inner; c <= last_inner; c++) {
+        count = 0;
+        for (thread = 0; thread < sh->thread_count; thread++) {
+            count += sh->hist[(size_t)thread * sh->inner + c];
+        }
+        sh->t_ptr[c + 1] = count;
+    }
+    if (pthread_barrier_wait(&sh->barrier) == PTHREAD_BARRIER_SERIAL_THREAD) {
+        sh->t_ptr[0] = 0;
+        for (c = 0; c < sh->inner; c++) sh->t_ptr[c + 1] += sh->t_ptr[c];
+    }
+    pthread_barrier_wait(&sh->barrier);
+
+    /* Each thread's write offset within each output line */
+    for (c = first_inner; c <= last_inner; c++) {
+        offset = sh->t_ptr[c];
+        for (thread = 0; thread < sh->thread_count; thread++) {
+            count = sh->hist[(size_t)thread * sh->inner + c];
+            sh->hist[(size_t)thread * sh->inner + c] = offset;
+            offset += count;
+        }
+    }
+    pthread_barrier_wait(&sh->barrier);
+
+    /* Scatter */
+    for (i = first; i <= last; i++) {
+        for (k = sh->ptr[i]; k < sh->ptr[i + 1]; k++) {
+            offset = my_hist[sh->idx[k]]++;
+            sh->t_idx[offset] = i;
+            sh->t_val[offset] = sh->val[k];
+        }
+    }
+    return NULL;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Csr_from_coo
+ * Purpose:   Row-compress a COO file
+*/
+int Csr_from_coo(char* filename, int flags, size_t chunk_bytes, int thread_count, Csr* S) {
+    memset(S, 0, sizeof(*S));
+    return Compress_coo(filename, 0, flags, chunk_bytes, thread_count, &S->rows, &S->cols,
+                        &S->nnz, &S->row_ptr, &S->col_idx, &S->val);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Csc_from_coo
+ * Purpose:   Column-compress a COO file
+*/
+int Csc_from_coo(char* filename, int flags, size_t chunk_bytes, int thread_count, Csc* S) {
+    memset(S, 0, sizeof(*S));
+    return Compress_coo(filename, 1, flags, chunk_bytes, thread_count, &S->rows, &S->cols,
+                        &S->nnz, &S->col_ptr, &S->row_idx, &S->val);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Csr_write_coo
+ * Purpose:   Write a CSR matrix as COO triplets
+*/
+int Csr_write_coo(char* filename, Csr* S) {
+    FILE* fp;
+    Sparse_header header;
+    Coo_entry e;
+    long k;
+    int i;
+
+    memset(&header, 0, sizeof(header));
+    header.magic = MAT_FORMAT_COO;
+    header.rows = S->rows;
+    header.cols = S->cols;
+    header.nnz = S->nnz;
+
+    fp = fopen(filename, "wb");
+    if (fp == NULL) return -1;
+    if (fwrite(&header, sizeof(header), 1, fp) != 1) {
+        fclose(fp);
+        return -1;
+    }
+    for (i = 0; i < S->rows; i++) {
+        for (k = S->row_ptr[i]; k < S->row_ptr[i + 1]; k++) {
+            e.row = i;
+            e.col = S->col_idx[k];
+            e.val = S->val[k];
+            if (fwrite(&e, sizeof(e), 1, fp) != 1) {
+                fclose(fp);
+                return -1;
+            }
+        }
+    }
+    return fclose(fp) == 0 ? 0 : -1;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Compress_coo
+ * Purpose:   Set up the shared work for a COO file and run Pth_coo on
+ *            a team of threads
+*/
+int Compress_coo(char* filename, int by_column, int flags, size_t chunk_bytes, int thread_count,
+                 int* rows_p, int* cols_p, long* nnz_p, long** ptr_p, int** idx_p, double** val_p) {
+    Coo_shared sh;
+    Coo_task* tasks = NULL;
+    pthread_t* thread_handles = NULL;
+    Sparse_header header;
+    long thread;
+
+    memset(&sh, 0, sizeof(sh));
+    sh.fd = open(filename, O_RDONLY);
+    if (sh.fd < 0) return -1;
+    if (pread(sh.fd, &header, sizeof(header), 0) != sizeof(header) ||
+        header.magic != MAT_FORMAT_COO || header.rows <= 0 || header.cols <= 0 || header.nnz < 0) {
+        close(sh.fd);
+        return -1;
+    }
+
+    if (flags & COO_SUM_DUPLICATES) flags |= COO_SORT;
+    sh.by_column = by_column;
+    sh.flags = flags;
+    sh.rows = header.rows;
+    sh.cols = header.cols;
+    sh.outer = by_column ? header.cols : header.rows;
+    sh.nnz = header.nnz;
+    thread_count = MAX(MIN(thread_count, sh.outer), 1);
+    sh.thread_count = thread_count;
+    if (chunk_bytes == 0) chunk_bytes = COO_DEFAULT_CHUNK_BYTES;
+    sh.chunk_entries = MAX((long)(chunk_bytes / sizeof(Coo_entry)), thread_count);
+    sh.chunk_entries = MIN(sh.chunk_entries, MAX(sh.nnz, 1));
+
+    sh.chunk = (Coo_entry*)malloc(sh.chunk_entries * sizeof(Coo_entry));
+    sh.grouped = (Coo_entry*)malloc(sh.chunk_entries * sizeof(Coo_entry));
+    sh.scratch = (Coo_entry*)malloc(sh.chunk_entries * sizeof(Coo_entry));
+    sh.sub_count = (long*)malloc((size_t)thread_count * (SUB_BLOCKS_MAX + 1) * sizeof(long));
+    sh.lines_per_sub = MAX((long)((double)SUB_BLOCK_ENTRIES * sh.outer / MAX(sh.nnz, 1)), 1);
+    sh.offset = (long*)malloc((size_t)thread_count * thread_count * sizeof(long));
+    sh.owner_start = (long*)malloc((thread_count + 1) * sizeof(long));
+    sh.block_total = (long*)malloc((thread_count + 1) * sizeof(long));
+    sh.ptr = (long*)calloc(sh.outer + 1, sizeof(long));
+    sh.cursor = (long*)malloc(sh.outer * sizeof(long));
+    thread_handles = (pthread_t*)malloc(thread_count * sizeof(pthread_t));
+    tasks = (Coo_task*)malloc(thread_count * sizeof(Coo_task));
+    if (sh.chunk == NULL || sh.grouped == NULL || sh.scratch == NULL || sh.sub_count == NULL ||
+        sh.offset == NULL || sh.owner_start == NULL ||
+        sh.block_total == NULL || sh.ptr == NULL || sh.cursor == NULL ||
+        thread_handles == NULL || tasks == NULL) {
+        sh.failed = 1;
+    } else {
+        pthread_barrier_init(&sh.barrier, NULL, thread_count);
+        for (thread = 0; thread < thread_count; thread++) {
+            tasks[thread].sh = &sh;
+            tasks[thread].rank = thread;
+            pthread_create(&thread_handles[thread], NULL, Pth_coo, &tasks[thread]);
+        }
+        for (thread = 0; thread < thread_count; thread++) {
+            pthread_join(thread_handles[thread], NULL);
+        }
+        pthread_barrier_destroy(&sh.barrier);
+    }
+    close(sh.fd);
+
+    free(sh.chunk);
+    free(sh.grouped);
+    free(sh.scratch);
+    free(sh.sub_count);
+    free(sh.offset);
+    free(sh.owner_start);
+    free(sh.block_total);
+    free(sh.cursor);
+    free(thread_handles);
+    free(tasks);
+    if (sh.failed) {
+        free(sh.ptr);
+        free(sh.idx);
+        free(sh.val);
+        return -1;
+    }
+
+    *rows_p = sh.rows;
+    *cols_p = sh.cols;
+    *nnz_p = sh.ptr[sh.outer];
+    *ptr_p = sh.ptr;
+    *idx_p = sh.idx;
+    *val_p = sh.val;
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Read_entries
+ * Purpose:   Read count triplets starting at triplet first of a COO file
+*/
+int Read_entries(int fd, Coo_entry* buf, long count, long first) {
+    size_t bytes = count * sizeof(Coo_entry), done = 0;
+    off_t offset = sizeof(Sparse_header) + (off_t)first * sizeof(Coo_entry);
+    ssize_t got;
+
+    while (done < bytes) {
+        got = pread(fd, (char*)buf + done, bytes - done, offset + done);
+        if (got <= 0) return -1;
+        done += got;
+    }
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Compare_line_entries
+ * Purpose:   qsort order of line entries by index
+*/
+int Compare_line_entries(const void* a, const void* b) {
+    int i = ((const Line_entry*)a)->idx, j = ((const Line_entry*)b)->idx;
+    return (i > j) - (i < j);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Sort_line
+ * Purpose:   Sort one row (or column) by index, by insertion or with
+ *            qsort for long lines, and with sum add up repeated indices
+ * Return:    the line's new length
+*/
+long Sort_line(int* idx, double* val, long length, int sum, Line_entry** buf_p, long* capacity_p) {
+    long k, p, kept;
+    int key;
+    double v;
+
+    if (length > INSERTION_MAX) {
+        if (length > *capacity_p) {
+            free(*buf_p);
+            *capacity_p = length;
+            *buf_p = (Line_entry*)malloc(length * sizeof(Line_entry));
+            if (*buf_p == NULL) return -1;
+        }
+        for (k = 0; k < length; k++) {
+            (*buf_p)[k].idx = idx[k];
+            (*buf_p)[k].val = val[k];
+        }
+        qsort(*buf_p, length, sizeof(Line_entry), Compare_line_entries);
+        for (k = 0; k < length; k++) {
+            idx[k] = (*buf_p)[k].idx;
+            val[k] = (*buf_p)[k].val;
+        }
+    } else {
+        for (k = 1; k < length; k++) {
+            key = idx[k];
+            v = val[k];
+            for (p = k; p > 0 && idx[p - 1] > key; p--) {
+                idx[p] = idx[p - 1];
+                val[p] = val[p - 1];
+            }
+            idx[p] = key;
+            val[p] = v;
+        }
+    }
+    if (!sum) return length;
+
+    kept = 0;
+    for (k = 0; k < length; k++) {
+        if (kept > 0 && idx[kept - 1] == idx[k]) {
+            val[kept - 1] += val[k];
+        } else {
+            idx[kept] = idx[k];
+            val[kept] = val[k];
+            kept++;
+        }
+    }
+    return kept;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Prefix_lines
+ * Purpose:   Inclusive prefix sum of counts[] over the lines, in place:
+ *            each thread sums its block, one thread prefix-sums the
+ *            block totals into block_total[], each thread finishes its
+ *            block. Ends with all threads past a barrier.
+*/
+void Prefix_lines(Coo_shared* sh, long rank, long* counts) {
+    int first = BLOCK_LOW(rank, sh->thread_count, sh->outer);
+    int last = BLOCK_HIGH(rank, sh->thread_count, sh->outer);
+    long sum = 0;
+    int i, thread;
+
+    for (i = first; i <= last; i++) sum += counts[i];
+    sh->block_total[rank + 1] = sum;
+    if (pthread_barrier_wait(&sh->barrier) == PTHREAD_BARRIER_SERIAL_THREAD) {
+        sh->block_total[0] = 0;
+        for (thread = 0; thread < sh->thread_count; thread++) {
+            sh->block_total[thread + 1] += sh->block_total[thread];
+        }
+    }
+    pthread_barrier_wait(&sh->barrier);
+
+    sum = sh->block_total[rank];
+    for (i = first; i <= last; i++) {
+        sum += counts[i];
+        counts[i] = sum;
+    }
+    pthread_barrier_wait(&sh->barrier);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Pth_coo
+ * Purpose:   Thread function: two passes over the chunks of the file.
+ *            Per chunk, read a slice, group it by owning thread (a
+ *            counting sort over the threads, laid out by one thread),
+ *            then handle the owned group: count entries per line in the
+ *            first pass; in the second, counting-sort the group by
+ *            sub-block of lines and place it. Then sort, and sum
+ *            duplicates, in the owned lines. sh->failed is only read
+ *            right after barriers, so all threads stop together.
+*/
+void* Pth_coo(void* arg) {
+    Coo_task* t = (Coo_task*)arg;
+    Coo_shared* sh = t->sh;
+    int p = sh->thread_count;
+    long* my_offset = sh->offset + t->rank * p;
+    int first_line = BLOCK_LOW(t->rank, p, sh->outer);
+    int last_line = BLOCK_HIGH(t->rank, p, sh->outer);
+    long start, count, lo, hi, k, pos, total;
+    int pass, b, thread, i, key;
+    Coo_entry e;
+    Line_entry* buf = NULL;
+    long capacity = 0, length;
+    long* sub_count = sh->sub_count + t->rank * (SUB_BLOCKS_MAX + 1);
+    long lines_per_sub = MAX(sh->lines_per_sub, CEILING(last_line - first_line + 1, SUB_BLOCKS_MAX));
+    int subs = CEILING(last_line - first_line + 1, lines_per_sub), sub;
+    long g0, g1;
+    Coo_entry* src;
+
+    for (pass = 0; pass < 2; pass++) {
+        for (start = 0; start < sh->nnz; start += sh->chunk_entries) {
+            count = MIN(sh->chunk_entries, sh->nnz - start);
+            lo = BLOCK_LOW(t->rank, p, count);
+            hi = BLOCK_LOW(t->rank + 1, p, count);
+
+            /* Read this thread's slice and count it per owner */
+            for (b = 0; b < p; b++) my_offset[b] = 0;
+            if (hi > lo && Read_entries(sh->fd, sh->chunk + lo, hi - lo, start + lo) != 0) {
+                sh->failed = 1;
+                hi = lo;
+            }
+            for (k = lo; k < hi; k++) {
+                e = sh->chunk[k];
+                if (e.row < 0 || e.row >= sh->rows || e.col < 0 || e.col >= sh->cols) {
+                    sh->failed = 1;
+                    continue;
+                }
+                key = sh->by_column ? e.col : e.row;
+                my_offset[BLOCK_OWNER((long)key, p, sh->outer)]++;
+            }
+
+            /* Lay out the groups: owner b's entries from thread 0, 1, ... */
+            if (pthread_barrier_wait(&sh->barrier) == PTHREAD_BARRIER_SERIAL_THREAD) {
+                pos = 0;
+                for (b = 0; b < p; b++) {
+                    sh->owner_start[b] = pos;
+                    for (thread = 0; thread < p; thread++) {
+                        total = sh->offset[thread * p + b];
+                        sh->offset[thread * p + b] = pos;
+                        pos += total;
+                    }
+                }
+                sh->owner_start[p] = pos;
+            }
+            pthread_barrier_wait(&sh->barrier);
+            if (sh->failed) break;
+
+            /* Group */
+            for (k = lo; k < hi; k++) {
+                e = sh->chunk[k];
+                key = sh->by_column ? e.col : e.row;
+                sh->grouped[my_offset[BLOCK_OWNER((long)key, p, sh->outer)]++] = e;
+            }
+            pthread_barrier_wait(&sh->barrier);
+
+            /* Count or place the owned group */
+            g0 = sh->owner_start[t->rank];
+            g1 = sh->owner_start[t->rank + 1];
+            src = sh->grouped;
+            if (pass == 1 && subs > 1) {
+                for (sub = 0; sub <= subs; sub++) sub_count[sub] = 0;
+                for (k = g0; k < g1; k++) {
+                    key = sh->by_column ? sh->grouped[k].col : sh->grouped[k].row;
+                    sub_count[(key - first_line) / lines_per_sub + 1]++;
+                }
+                sub_count[0] = g0;
+                for (sub = 0; sub < subs; sub++) sub_count[sub + 1] += sub_count[sub];
+                for (k = g0; k < g1; k++) {
+                    key = sh->by_column ? sh->grouped[k].col : sh->grouped[k].row;
+                    sh->scratch[sub_count[(key - first_line) / lines_per_sub]++] = sh->grouped[k];
+                }
+                src = sh->scratch;
+            }
+            for (k = g0; k < g1; k++) {
+                e = src[k];
+                if (sh->by_column) {
+                    key = e.col;
+                    i = e.row;
+                } else {
+                    key = e.row;
+                    i = e.col;
+                }
+                if (pass == 0) {
+                    sh->ptr[key + 1]++;
+                } else {
+                    pos = sh->cursor[key]++;
+                    sh->idx[pos] = i;
+                    sh->val[pos] = e.val;
+                }
+            }
+        }
+        if (sh->failed) break;
+        if (pass == 1) break;
+
+        /* Counts to pointers; one thread allocates the arrays */
+        Prefix_lines(sh, t->rank, sh->ptr + 1);
+        if (pthread_barrier_wait(&sh->barrier) == PTHREAD_BARRIER_SERIAL_THREAD) {
+            sh->idx = (int*)malloc(MAX(sh->nnz, 1) * sizeof(int));
+            sh->val = (double*)malloc(MAX(sh->nnz, 1) * sizeof(double));
+            if (sh->idx == NULL || sh->val == NULL) sh->failed = 1;
+        }
+        pthread_barrier_wait(&sh->barrier);
+        if (sh->failed) break;
+        for (i = first_line; i <= last_line; i++) sh->cursor[i] = sh->ptr[i];
+    }
+    if (sh->failed || !(sh->flags & COO_SORT)) return NULL;
+
+    /* Sort the owned lines, keeping their new lengths */
+    for (i = first_line; i <= last_line; i++) {
+        length = Sort_line(sh->idx + sh->ptr[i], sh->val + sh->ptr[i], sh->ptr[i + 1] - sh->ptr[i],
+                           sh->flags & COO_SUM_DUPLICATES, &buf, &capacity);
+        if (length < 0) {
+            sh->failed = 1;
+            length = sh->ptr[i + 1] - sh->ptr[i];
+        }
+        sh->cursor[i] = length;
+    }
+    free(buf);
+    if (!(sh->flags & COO_SUM_DUPLICATES)) return NULL;
+
+    /* Compact when duplicates were summed: each thread moves its lines
+       to their new place in new arrays */
+    Prefix_lines(sh, t->rank, sh->cursor);
+    if (sh->block_total[p] == sh->nnz) return NULL;
+    if (pthread_barrier_wait(&sh->barrier) == PTHREAD_BARRIER_SERIAL_THREAD) {
+        sh->new_idx = (int*)malloc(MAX(sh->block_total[p], 1) * sizeof(int));
+        sh->new_val = (double*)malloc(MAX(sh->block_total[p], 1) * sizeof(double));
+        if (sh->new_idx == NULL || sh->new_val == NULL) sh->failed = 1;
+    }
+    pthread_barrier_wait(&sh->barrier);
+    if (sh->failed) return NULL;
+
+    pos = sh->block_total[t->rank];
+    for (i = first_line; i <= last_line; i++) {
+        length = sh->cursor[i] - pos;
+        memcpy(sh->new_idx + pos, sh->idx + sh->ptr[i], length * sizeof(int));
+        memcpy(sh->new_val + pos, sh->val + sh->ptr[i], length * sizeof(double));
+        sh->ptr[i] = pos;
+        pos += length;
+    }
+    if (pthread_barrier_wait(&sh->barrier) == PTHREAD_BARRIER_SERIAL_THREAD) {
+        sh->ptr[sh->outer] = sh->block_total[p];
+        free(sh->idx);
+        free(sh->val);
+        sh->idx = sh->new_idx;
+        sh->val = sh->new_val;
+    }
+    return NULL;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Run_compress
+ * Purpose:   Run one pass of Pth_compress on a team of threads
+*/
+int Run_compress(const double* A, Csr* S, int pass, int thread_count) {
+    pthread_t* thread_handles;
+    Compress_task* tasks;
+    long thread;
+
+    thread_count = MAX(MIN(thread_count, S->rows), 1);
+    thread_handles = (pthread_t*)malloc(thread_count * sizeof(pthread_t));
+    tasks = (Compress_task*)malloc(thread_count * sizeof(Compress_task));
+    if (thread_handles == NULL || tasks == NULL) {
+        free(thread_handles);
+        free(tasks);
+        return -1;
+    }
+
+    for (thread = 0; thread < thread_count; thread++) {
+        tasks[thread].A = A;
+        tasks[thread].S = S;
+        tasks[thread].pass = pass;
+        tasks[thread].thread_count = thread_count;
+        tasks[thread].rank = thread;
+        pthread_create(&thread_handles[thread], NULL, Pth_compress, &tasks[thread]);
+    }
+    for (thread = 0; thread < thread_count; thread++) {
+        pthread_join(thread_handles[thread], NULL);
+    }
+
+    free(thread_handles);
+    free(tasks);
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Pth_compress
+ * Purpose:   Thread function: count or fill this thread's rows
+*/
+void* Pth_compress(void* arg) {
+    Compress_task* t = (Compress_task*)arg;
+    Csr* S = t->S;
+    int first_row = BLOCK_LOW(t->rank, t->thread_count, S->rows);
+    int last_row = BLOCK_HIGH(t->rank, t->thread_count, S->rows);
+    int i, j;
+    long k, count;
+
+    for (i = first_row; i <= last_row; i++) {
+        const double* row = t->A + (size_t)i * S->cols;
+        if (t->pass == 0) {
+            count = 0;
+            for (j = 0; j < S->cols; j++) {
+                if (row[j] != 0.0) count++;
+            }
+            S->row_ptr[i + 1] = count;
+        } else {
+            k = S->row_ptr[i];
+            for (j = 0; j < S->cols; j++) {
+                if (row[j] != 0.0) {
+                    S->col_idx[k] = j;
+                    S->val[k] = row[j];
+                    k++;
+                }
+            }
+        }
+    }
+    return NULL;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Dcsr_read
+ * Purpose:   Read a DCSR file and decode each row to check that its
+ *            code ends where code_ptr says, with columns in range
+*/
+int Dcsr_read(char* filename, Dcsr* D) {
+    FILE* fp;
+    Sparse_header header;
+    const unsigned char *p, *end;
+    long k;
+    int i, j;
+
+    memset(D, 0, sizeof(*D));
+    fp = fopen(filename, "rb");
+    if (fp == NULL) return -1;
+
+    if (fread(&header, sizeof(header), 1, fp) != 1 || header.magic != MAT_FORMAT_DCSR ||
+        header.rows <= 0 || header.cols <= 0 || header.nnz < 0) {
+        fclose(fp);
+        return -1;
+    }
+    D->rows = header.rows;
+    D->cols = header.cols;
+    D->nnz = header.nnz;
+    D->row_ptr = (long*)malloc((D->rows + 1) * sizeof(long));
+    D->code_ptr = (long*)malloc((D->rows + 1) * sizeof(long));
+    D->first_col = (int*)malloc(D->rows * sizeof(int));
+    if (D->row_ptr == NULL || D->code_ptr == NULL || D->first_col == NULL ||
+        fread(D->row_ptr, sizeof(long), D->rows + 1, fp) != (size_t)D->rows + 1 ||
+        fread(D->code_ptr, sizeof(long), D->rows + 1, fp) != (size_t)D->rows + 1 ||
+        fread(D->first_col, sizeof(int), D->rows, fp) != (size_t)D->rows ||
+        D->code_ptr[0] != 0 || D->code_ptr[D->rows] < 0) {
+        Dcsr_free(D);
+        fclose(fp);
+        return -1;
+    }
+    /* 4 spare bytes, so a corrupt code cannot be decoded past the end */
+    D->code = (unsigned char*)calloc(D->code_ptr[D->rows] + 4, 1);
+    D->val = (double*)malloc(MAX(D->nnz, 1) * sizeof(double));
+    if (D->code == NULL || D->val == NULL ||
+        fread(D->code, 1, D->code_ptr[D->rows], fp) != (size_t)D->code_ptr[D->rows] ||
+        fread(D->val, sizeof(double), D->nnz, fp) != (size_t)D->nnz) {
+        Dcsr_free(D);
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+
+    if (D->row_ptr[0] != 0 || D->row_ptr[D->rows] != D->nnz) {
+        Dcsr_free(D);
+        return -1;
+    }
+    for (i = 0; i < D->rows; i++) {
+        if (D->row_ptr[i] > D->row_ptr[i + 1] || D->code_ptr[i] > D->code_ptr[i + 1]) break;
+        p = D->code + D->code_ptr[i];
+        end = D->code + D->code_ptr[i + 1];
+        j = D->first_col[i];
+        if (j < 0 || j >= D->cols) break;
+        for (k = D->row_ptr[i] + 1; k < D->row_ptr[i + 1] && p < end; k++) {
+            DCSR_NEXT(p, j);
+            if (j < 0 || j >= D->cols) break;
+        }
+        if (k < D->row_ptr[i + 1] || p != end) break;
+    }
+    if (i < D->rows) {
+        Dcsr_free(D);
+        return -1;
+    }
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Dcsr_write
+ * Purpose:   Write a DCSR file
+*/
+int Dcsr_write(char* filename, Dcsr* D) {
+    FILE* fp;
+    Sparse_header header;
+
+    memset(&header, 0, sizeof(header));
+    header.magic = MAT_FORMAT_DCSR;
+    header.rows = D->rows;
+    header.cols = D->cols;
+    header.nnz = D->nnz;
+
+    fp = fopen(filename, "wb");
+    if (fp == NULL) return -1;
+    if (fwrite(&header, sizeof(header), 1, fp) != 1 ||
+        fwrite(D->row_ptr, sizeof(long), D->rows + 1, fp) != (size_t)D->rows + 1 ||
+        fwrite(D->code_ptr, sizeof(long), D->rows + 1, fp) != (size_t)D->rows + 1 ||
+        fwrite(D->first_col, sizeof(int), D->rows, fp) != (size_t)D->rows ||
+        fwrite(D->code, 1, D->code_ptr[D->rows], fp) != (size_t)D->code_ptr[D->rows] ||
+        fwrite(D->val, sizeof(double), D->nnz, fp) != (size_t)D->nnz) {
+        fclose(fp);
+        return -1;
+    }
+    return fclose(fp) == 0 ? 0 : -1;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Dcsr_from_csr
+ * Purpose:   Size each row's code in parallel, prefix-sum the sizes
+ *            into code_ptr, then write the rows in parallel
+*/
+int Dcsr_from_csr(const Csr* S, int thread_count, Dcsr* D) {
+    int i;
+
+    memset(D, 0, sizeof(*D));
+    D->rows = S->rows;
+    D->cols = S->cols;
+    D->nnz = S->nnz;
+    D->row_ptr = (long*)malloc((S->rows + 1) * sizeof(long));
+    D->code_ptr = (long*)malloc((S->rows + 1) * sizeof(long));
+    D->first_col = (int*)malloc(S->rows * sizeof(int));
+    D->val = (double*)malloc(MAX(S->nnz, 1) * sizeof(double));
+    if (D->row_ptr == NULL || D->code_ptr == NULL || D->first_col == NULL || D->val == NULL) {
+        Dcsr_free(D);
+        return -1;
+    }
+    memcpy(D->row_ptr, S->row_ptr, (S->rows + 1) * sizeof(long));
+    memcpy(D->val, S->val, S->nnz * sizeof(double));
+
+    /* code_ptr[i + 1] = bytes of row i */
+    if (Run_encode(S, D, 0, thread_count) != 0) {
+        Dcsr_free(D);
+        return -1;
+    }
+    D->code_ptr[0] = 0;
+    for (i = 0; i < S->rows; i++) D->code_ptr[i + 1] += D->code_ptr[i];
+
+    D->code = (unsigned char*)malloc(MAX(D->code_ptr[S->rows], 1));
+    if (D->code == NULL || Run_encode(S, D, 1, thread_count) != 0) {
+        Dcsr_free(D);
+        return -1;
+    }
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Dcsr_to_csr
+ * Purpose:   Decode the columns of a DCSR matrix
+*/
+int Dcsr_to_csr(const Dcsr* D, Csr* S) {
+    const unsigned char* p = D->code;
+    long k;
+    int i, j;
+
+    if (Csr_alloc(S, D->rows, D->cols, D->nnz) != 0) return -1;
+    memcpy(S->row_ptr, D->row_ptr, (D->rows + 1) * sizeof(long));
+    memcpy(S->val, D->val, D->nnz * sizeof(double));
+    for (i = 0; i < D->rows; i++) {
+        j = D->first_col[i];
+        for (k = D->row_ptr[i]; k < D->row_ptr[i + 1]; k++) {
+            if (k > D->row_ptr[i]) DCSR_NEXT(p, j);
+            S->col_idx[k] = j;
+        }
+    }
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Dcsr_gap_bytes
+ * Purpose:   Bytes taken by the code of a gap
+*/
+int Dcsr_gap_bytes(unsigned gap) {
+    if (gap < DCSR_ESCAPE16) return 1;
+    if (gap <= 0xFFFF) return 3;
+    return 5;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Dcsr_free
+ * Purpose:   Release a DCSR matrix
+*/
+void Dcsr_free(Dcsr* D) {
+    free(D->row_ptr);
+    free(D->code_ptr);
+    free(D->first_col);
+    free(D->code);
+    free(D->val);
+    D->row_ptr = NULL;
+    D->code_ptr = NULL;
+    D->first_col = NULL;
+    D->code = NULL;
+    D->val = NULL;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Put_gap
+ * Purpose:   Write the code of a gap at p, returning the byte after it
+*/
+unsigned char* Put_gap(unsigned char* p, unsigned gap) {
+    unsigned short short_gap;
+
+    if (gap < DCSR_ESCAPE16) {
+        *p++ = (unsigned char)gap;
+    } else if (gap <= 0xFFFF) {
+        *p++ = DCSR_ESCAPE16;
+        short_gap = (unsigned short)gap;
+        memcpy(p, &short_gap, 2);
+        p += 2;
+    } else {
+        *p++ = DCSR_ESCAPE32;
+        memcpy(p, &gap, 4);
+        p += 4;
+    }
+    return p;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Run_encode
+ * Purpose:   Run one pass of Pth_encode on a team of threads
+ * Return:    0 on success, -1 on allocation failure or a decreasing row
+*/
+int Run_encode(const Csr* S, Dcsr* D, int pass, int thread_count) {
+    pthread_t* thread_handles;
+    Encode_task* tasks;
+    long thread;
+    int failed = 0;
+
+    thread_count = MAX(MIN(thread_count, S->rows), 1);
+    thread_handles = (pthread_t*)malloc(thread_count * sizeof(pthread_t));
+    tasks = (Encode_task*)malloc(thread_count * sizeof(Encode_task));
+    if (thread_handles == NULL || tasks == NULL) {
+        free(thread_handles);
+        free(tasks);
+        return -1;
+    }
+
+    for (thread = 0; thread < thread_count; thread++) {
+        tasks[thread].S = S;
+        tasks[thread].D = D;
+        tasks[thread].pass = pass;
+        tasks[thread].thread_count = thread_count;
+        tasks[thread].rank = thread;
+        tasks[thread].failed = 0;
+        pthread_create(&thread_handles[thread], NULL, Pth_encode, &tasks[thread]);
+    }
+    for (thread = 0; thread < thread_count; thread++) {
+        pthread_join(thread_handles[thread], NULL);
+        if (tasks[thread].failed) failed = 1;
+    }
+
+    free(thread_handles);
+    free(tasks);
+    return failed ? -1 : 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Pth_encode
+ * Purpose:   Thread function: size or write the code of this thread's
+ *            rows
+*/
+void* Pth_encode(void* arg) {
+    Encode_task* t = (Encode_task*)arg;
+    const Csr* S = t->S;
+    int first_row = BLOCK_LOW(t->rank, t->thread_count, S->rows);
+    int last_row = BLOCK_HIGH(t->rank, t->thread_count, S->rows);
+    int i, prev;
+    long k, first, bytes;
+    unsigned char* p;
+
+    for (i = first_row; i <= last_row; i++) {
+        first = S->row_ptr[i];
+        prev = first < S->row_ptr[i + 1] ? S->col_idx[first] : 0;
+        if (t->pass == 0) {
+            t->D->first_col[i] = prev;
+            bytes = 0;
+            for (k = first + 1; k < S->row_ptr[i + 1]; k++) {
+                if (S->col_idx[k] < prev) {
+                    t->failed = 1;
+                    return NULL;
+                }
+                bytes += Dcsr_gap_bytes(S->col_idx[k] - prev);
+                prev = S->col_idx[k];
+            }
+            t->D->code_ptr[i + 1] = bytes;
+        } else {
+            p = t->D->code + t->D->code_ptr[i];
+            for (k = first + 1; k < S->row_ptr[i + 1]; k++) {
+                p = Put_gap(p, S->col_idx[k] - prev);
+                prev = S->col_idx[k];
+            }
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,207 @@
+/**
+ * @file sparse.h
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Sparse matrix storage and conversion.
+ *
+ * Sparse matrices are held in memory in the same layout as their files
+ * (see mat_format.h), so reading one is a header check and three
+ * freads. Conversions from dense are threaded over row blocks with
+ * Quinn's macros: each thread counts its rows' nonzeros, the counts are
+ * prefix-summed into row_ptr, and each thread fills its own rows.
+ * Transposing CSR to CSC (or back) is the same count, prefix and fill,
+ * with per-thread column histograms so the fills never collide.
+ *
+ * COO files are streamed in chunks, twice: each thread reads a slice
+ * of a chunk and groups it by the thread owning each row (a block of
+ * rows), then every owner counts (first pass) or places (second pass)
+ * the entries of its own rows, so no two threads touch the same row.
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#ifndef _SPARSE_H_
+#define _SPARSE_H_
+
+#include <stddef.h>
+#include <string.h>
+
+/* Flags for the COO conversions */
+#define COO_SORT            1   /* sort each row (column) by index */
+#define COO_SUM_DUPLICATES  2   /* add up repeated entries; implies COO_SORT */
+
+/* Default chunk of a COO file read at a time */
+#define COO_DEFAULT_CHUNK_BYTES ((size_t)64 << 20)
+
+/* Compressed sparse rows */
+typedef struct {
+    int rows, cols;
+    long nnz;
+    long* row_ptr;     /* rows + 1 entries */
+    int* col_idx;      /* nnz entries */
+    double* val;       /* nnz entries */
+} Csr;
+
+/* Compressed sparse columns */
+typedef struct {
+    int rows, cols;
+    long nnz;
+    long* col_ptr;     /* cols + 1 entries */
+    int* row_idx;      /* nnz entries */
+    double* val;       /* nnz entries */
+} Csc;
+
+/* Sparse vector: nonzeros by increasing index */
+typedef struct {
+    int n;
+    long nnz;
+    int* idx;          /* nnz entries */
+    double* val;       /* nnz entries */
+} Spvec;
+
+/* Delta-compressed CSR: the first column of each row is kept whole,
+ * the others are coded as the gaps between them, a byte per gap below
+ * DCSR_ESCAPE16; a larger gap is an escape byte followed by the gap in
+ * 2 bytes (DCSR_ESCAPE16) or 4 (DCSR_ESCAPE32), little-endian. Rows
+ * whose entries are close together then take about a byte per index
+ * instead of four, and a row whose code is one byte per gap is decoded
+ * without checking for escapes.
+*/
+#define DCSR_ESCAPE16 0xFE
+#define DCSR_ESCAPE32 0xFF
+
+typedef struct {
+    int rows, cols;
+    long nnz;
+    long* row_ptr;          /* rows + 1 entries, into val */
+    long* code_ptr;         /* rows + 1 entries, into code */
+    int* first_col;         /* rows entries; 0 for an empty row */
+    unsigned char* code;    /* code_ptr[rows] bytes */
+    double* val;            /* nnz entries */
+} Dcsr;
+
+/* DCSR_NEXT(p, j): add the gap coded at p to column j and move p past
+ * it; the common one-byte gap costs a load and a predicted branch
+*/
+#define DCSR_NEXT(p, j) \
+    do { \
+        unsigned gap_ = *(p)++; \
+        if (gap_ >= DCSR_ESCAPE16) { \
+            if (gap_ == DCSR_ESCAPE16) { \
+                unsigned short short_; \
+                memcpy(&short_, (p), 2); \
+                gap_ = short_; \
+                (p) += 2; \
+            } else { \
+                memcpy(&gap_, (p), 4); \
+                (p) += 4; \
+            } \
+        } \
+        (j) += gap_; \
+    } while (0)
+
+/* Sparse_format: format of a matrix file from its first int
+ * Returns: MAT_FORMAT_DENSE, a format magic, or MAT_FORMAT_INVALID
+*/
+int Sparse_format(char* filename);
+
+/* Csr_read / Csr_write: CSR file I/O
+ * Returns: 0 on success, -1 on error
+*/
+int Csr_read(char* filename, Csr* S);
+int Csr_write(char* filename, Csr* S);
+
+/* Csr_from_dense: compress a dense rows x cols matrix, dropping zeros
+ * Returns: 0 on success, -1 on allocation failure
+*/
+int Csr_from_dense(const double* A, int rows, int cols, int thread_count, Csr* S);
+
+/* Csr_to_dense: expand to a newly allocated dense matrix, NULL on error */
+double* Csr_to_dense(Csr* S);
+
+/* Csr_alloc: allocate arrays for rows and nnz entries
+ * Returns: 0 on success, -1 on allocation failure
+*/
+int Csr_alloc(Csr* S, int rows, int cols, long nnz);
+
+/* Csr_free: release a CSR matrix */
+void Csr_free(Csr* S);
+
+/* Csc_read / Csc_write: CSC file I/O
+ * Returns: 0 on success, -1 on error
+*/
+int Csc_read(char* filename, Csc* S);
+int Csc_write(char* filename, Csc* S);
+
+/* Csc_from_csr / Csr_from_csc: threaded transposition of the storage
+ * Returns: 0 on success, -1 on allocation failure
+*/
+int Csc_from_csr(const Csr* R, int thread_count, Csc* C);
+int Csr_from_csc(const Csc* C, int thread_count, Csr* R);
+
+/* Csc_alloc / Csc_free: as for CSR */
+int Csc_alloc(Csc* S, int rows, int cols, long nnz);
+void Csc_free(Csc* S);
+
+/* Spvec_read / Spvec_write: sparse vector file I/O
+ * Returns: 0 on success, -1 on error
+*/
+int Spvec_read(char* filename, Spvec* v);
+int Spvec_write(char* filename, Spvec* v);
+
+/* Spvec_from_dense: compress a dense vector of length n, dropping zeros
+ * Returns: 0 on success, -1 on allocation failure
+*/
+int Spvec_from_dense(const double* x, int n, Spvec* v);
+
+/* Spvec_to_dense: expand to a newly allocated dense vector, NULL on error */
+double* Spvec_to_dense(Spvec* v);
+
+/* Csr_from_coo / Csc_from_coo: compress a COO file, reading it in
+ * chunks of chunk_bytes with thread_count threads
+ * flags: COO_SORT, COO_SUM_DUPLICATES (without them, entries keep
+ *        their file order within each row or column)
+ * Returns: 0 on success, -1 on a read error, an index out of range or
+ *          allocation failure
+*/
+int Csr_from_coo(char* filename, int flags, size_t chunk_bytes, int thread_count, Csr* S);
+int Csc_from_coo(char* filename, int flags, size_t chunk_bytes, int thread_count, Csc* S);
+
+/* Csr_write_coo: write a CSR matrix as a COO file, row by row
+ * Returns: 0 on success, -1 on error
+*/
+int Csr_write_coo(char* filename, Csr* S);
+
+/* Dcsr_read / Dcsr_write: DCSR file I/O; reading decodes every row to
+ * check it against row_ptr and the column count
+ * Returns: 0 on success, -1 on error
+*/
+int Dcsr_read(char* filename, Dcsr* D);
+int Dcsr_write(char* filename, Dcsr* D);
+
+/* Dcsr_from_csr: code the columns of S, sizing then filling the rows
+ * in parallel
+ * Returns: 0 on success, -1 on allocation failure or a row whose
+ *          columns decrease
+*/
+int Dcsr_from_csr(const Csr* S, int thread_count, Dcsr* D);
+
+/* Dcsr_to_csr: decode to a newly allocated CSR matrix
+ * Returns: 0 on success, -1 on allocation failure
+*/
+int Dcsr_to_csr(const Dcsr* D, Csr* S);
+
+/* Dcsr_gap_bytes: bytes taken by the code of a gap */
+int Dcsr_gap_bytes(unsigned gap);
+
+/* Dcsr_free: release a DCSR matrix */
+void Dcsr_free(Dcsr* D);
+
+/* Spvec_alloc / Spvec_free: allocate or release the arrays for nnz entries */
+int Spvec_alloc(Spvec* v, int n, long nnz);
+void Spvec_free(Spvec* v);
+
+#endif /* _SPARSE_H_ */
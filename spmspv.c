@@ -0,0 +1,304 @@
+/**
+ * @file spmspv.c
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Sparse matrix times sparse vector over a semiring.
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "quinn.h"
+#include "semiring.h"
+#include "spmspv.h"
+
+/* One product a_ij * x_j headed for y_i */
+typedef struct {
+    int idx;
+    double val;
+} Entry;
+
+/* Work shared with the threads */
+typedef struct {
+    int sr;
+    const Csc* A;
+    const Spvec* x;
+    const char* mask;
+    Spvec* y;
+    int thread_count;
+    long* work;        /* x->nnz + 1: entries of A in the columns of x's first k nonzeros */
+    long* offset;      /* thread_count x thread_count: where thread t writes into bucket b */
+    long* bucket;      /* thread_count + 1: start of each bucket in entries */
+    long* merged;      /* thread_count + 1: merged entries per bucket, then their start in y */
+    Entry* entries;
+    int failed;
+    pthread_barrier_t barrier;
+} Spmspv_shared;
+
+typedef struct {
+    Spmspv_shared* sh;
+    long rank;
+} Spmspv_task;
+
+/* SPMSPV_KERNELS(S): define Scatter_S, which writes the products of
+ * x's nonzeros first..last-1 into the buckets at offset[] (advancing
+ * it), and Merge_S, which adds up entries with equal rows in place,
+ * using slots[] (capacity a power of two) as an open-addressing table
+ * of positions. Merge_S returns the number of distinct rows.
+*/
+#define SPMSPV_KERNELS(S) \
+void Scatter_##S(Spmspv_shared* sh, long first, long last, long* offset) { \
+    const Csc* A = sh->A; \
+    long k, p; \
+    int i; \
+    for (k = first; k < last; k++) { \
+        int j = sh->x->idx[k]; \
+        double xj = sh->x->val[k]; \
+        for (p = A->col_ptr[j]; p < A->col_ptr[j + 1]; p++) { \
+            i = A->row_idx[p]; \
+            if (sh->mask != NULL && sh->mask[i]) continue; \
+            Entry* e = &sh->entries[offset[BLOCK_OWNER((long)i, sh->thread_count, A->rows)]++]; \
+            e->idx = i; \
+            e->val = SR_##S##_MUL(A->val[p], xj); \
+        } \
+    } \
+} \
+long Merge_##S(Entry* e, long count, long* slots, long capacity) { \
+    long p, h, distinct = 0; \
+    for (p = 0; p < count; p++) { \
+        h = Hash(e[p].idx, capacity); \
+        while (slots[h] >= 0 && e[slots[h]].idx != e[p].idx) h = (h + 1) & (capacity - 1); \
+        if (slots[h] >= 0) { \
+            e[slots[h]].val = SR_##S##_ADD(e[slots[h]].val, e[p].val); \
+        } else { \
+            slots[h] = distinct; \
+            e[distinct++] = e[p]; \
+        } \
+    } \
+    return distinct; \
+}
+
+/* Function prototypes */
+long Hash(int idx, long capacity);
+long Work_start(Spmspv_shared* sh, long w);
+int Compare_entries(const void* a, const void* b);
+void Scatter(Spmspv_shared* sh, long first, long last, long* offset);
+long Merge(int sr, Entry* e, long count, long* slots, long capacity);
+void* Pth_spmspv(void* arg);
+
+/*-------------------------------------------------------------------
+ * Function:  Hash
+ * Purpose:   Slot of a row index in a table of capacity 2^k
+*/
+long Hash(int idx, long capacity) {
+    return (long)(((unsigned long)(unsigned)idx * 0x9E3779B97F4A7C15UL) >> 32) & (capacity - 1);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Work_start
+ * Purpose:   First nonzero of x at which at least w entries of A come
+ *            before it (binary search of the work prefix sums)
+*/
+long Work_start(Spmspv_shared* sh, long w) {
+    long lo = 0, hi = sh->x->nnz, mid;
+
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (sh->work[mid] < w) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+SPMSPV_KERNELS(PLUS_TIMES)
+SPMSPV_KERNELS(MIN_PLUS)
+SPMSPV_KERNELS(MAX_TIMES)
+SPMSPV_KERNELS(OR_AND)
+
+/*-------------------------------------------------------------------
+ * Function:  Spmspv
+ * Purpose:   Set up the shared work and run Pth_spmspv on a team
+*/
+int Spmspv(int sr, const Csc* A, const Spvec* x, const char* mask, int thread_count,
+           Spvec* y) {
+    Spmspv_shared sh;
+    Spmspv_task* tasks;
+    pthread_t* thread_handles;
+    long thread, k;
+
+    memset(y, 0, sizeof(*y));
+    memset(&sh, 0, sizeof(sh));
+    thread_count = MAX(MIN(thread_count, A->rows), 1);
+    sh.sr = sr;
+    sh.A = A;
+    sh.x = x;
+    sh.mask = mask;
+    sh.y = y;
+    sh.thread_count = thread_count;
+    sh.work = (long*)malloc((x->nnz + 1) * sizeof(long));
+    sh.offset = (long*)calloc((size_t)thread_count * thread_count, sizeof(long));
+    sh.bucket = (long*)malloc((thread_count + 1) * sizeof(long));
+    sh.merged = (long*)malloc((thread_count + 1) * sizeof(long));
+    thread_handles = (pthread_t*)malloc(thread_count * sizeof(pthread_t));
+    tasks = (Spmspv_task*)malloc(thread_count * sizeof(Spmspv_task));
+    if (sh.work == NULL || sh.offset == NULL || sh.bucket == NULL || sh.merged == NULL ||
+        thread_handles == NULL || tasks == NULL) {
+        sh.failed = 1;
+    } else {
+        /* Balance threads by the entries they will visit */
+        sh.work[0] = 0;
+        for (k = 0; k < x->nnz; k++) {
+            sh.work[k + 1] = sh.work[k] + A->col_ptr[x->idx[k] + 1] - A->col_ptr[x->idx[k]];
+        }
+
+        pthread_barrier_init(&sh.barrier, NULL, thread_count);
+        for (thread = 0; thread < thread_count; thread++) {
+            tasks[thread].sh = &sh;
+            tasks[thread].rank = thread;
+            pthread_create(&thread_handles[thread], NULL, Pth_spmspv, &tasks[thread]);
+        }
+        for (thread = 0; thread < thread_count; thread++) {
+            pthread_join(thread_handles[thread], NULL);
+        }
+        pthread_barrier_destroy(&sh.barrier);
+    }
+
+    free(sh.work);
+    free(sh.offset);
+    free(sh.bucket);
+    free(sh.merged);
+    free(sh.entries);
+    free(thread_handles);
+    free(tasks);
+    if (sh.failed) {
+        Spvec_free(y);
+        return -1;
+    }
+    return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Compare_entries
+ * Purpose:   qsort order of entries by row
+*/
+int Compare_entries(const void* a, const void* b) {
+    int i = ((const Entry*)a)->idx, j = ((const Entry*)b)->idx;
+    return (i > j) - (i < j);
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Scatter / Merge
+ * Purpose:   Dispatch to the kernels of the semiring
+*/
+void Scatter(Spmspv_shared* sh, long first, long last, long* offset) {
+    switch (sh->sr) {
+        case SR_MIN_PLUS: Scatter_MIN_PLUS(sh, first, last, offset); break;
+        case SR_MAX_TIMES: Scatter_MAX_TIMES(sh, first, last, offset); break;
+        case SR_OR_AND: Scatter_OR_AND(sh, first, last, offset); break;
+        default: Scatter_PLUS_TIMES(sh, first, last, offset); break;
+    }
+}
+
+long Merge(int sr, Entry* e, long count, long* slots, long capacity) {
+    switch (sr) {
+        case SR_MIN_PLUS: return Merge_MIN_PLUS(e, count, slots, capacity);
+        case SR_MAX_TIMES: return Merge_MAX_TIMES(e, count, slots, capacity);
+        case SR_OR_AND: return Merge_OR_AND(e, count, slots, capacity);
+        default: return Merge_PLUS_TIMES(e, count, slots, capacity);
+    }
+}
+
+/*-------------------------------------------------------------------
+ * Function:  Pth_spmspv
+ * Purpose:   Thread function: count, scatter, merge one bucket, and copy
+ *            it into y, with barriers between the stages
+*/
+void* Pth_spmspv(void* arg) {
+    Spmspv_task* t = (Spmspv_task*)arg;
+    Spmspv_shared* sh = t->sh;
+    const Csc* A = sh->A;
+    int p = sh->thread_count;
+    long* my_offset = sh->offset + t->rank * p;
+    long first, last, k, q, count, capacity, distinct, pos;
+    long* slots = NULL;
+    Entry* e;
+    int b, thread;
+
+    /* This thread's nonzeros of x: a block of the total work */
+    first = Work_start(sh, BLOCK_LOW(t->rank, p, sh->work[sh->x->nnz]));
+    if (t->rank == p - 1) last = sh->x->nnz;
+    else last = Work_start(sh, BLOCK_LOW(t->rank + 1, p, sh->work[sh->x->nnz]));
+
+    /* Count products per bucket */
+    for (k = first; k < last; k++) {
+        int j = sh->x->idx[k];
+        for (q = A->col_ptr[j]; q < A->col_ptr[j + 1]; q++) {
+            int i = A->row_idx[q];
+            if (sh->mask == NULL || !sh->mask[i]) my_offset[BLOCK_OWNER((long)i, p, A->rows)]++;
+        }
+    }
+
+    /* One thread lays out the buckets: bucket b holds thread 0's
+       products for it, then thread 1's, ... */
+    if (pthread_barrier_wait(&sh->barrier) == PTHREAD_BARRIER_SERIAL_THREAD) {
+        pos = 0;
+        for (b = 0; b < p; b++) {
+            sh->bucket[b] = pos;
+            for (thread = 0; thread < p; thread++) {
+                count = sh->offset[thread * p + b];
+                sh->offset[thread * p + b] = pos;
+                pos += count;
+            }
+        }
+        sh->bucket[p] = pos;
+        sh->entries = (Entry*)malloc(MAX(pos, 1) * sizeof(Entry));
+        if (sh->entries == NULL) sh->failed = 1;
+    }
+    pthread_barrier_wait(&sh->barrier);
+
+    /* Scatter, then merge this thread's bucket */
+    distinct = 0;
+    if (!sh->failed) {
+        Scatter(sh, first, last, my_offset);
+    }
+    pthread_barrier_wait(&sh->barrier);
+    if (!sh->failed) {
+        e = sh->entries + sh->bucket[t->rank];
+        count = sh->bucket[t->rank + 1] - sh->bucket[t->rank];
+        capacity = 1;
+        while (capacity < 2 * count) capacity <<= 1;
+        slots = (long*)malloc(capacity * sizeof(long));
+        if (slots == NULL) sh->failed = 1;
+        else {
+            memset(slots, 0xff, capacity * sizeof(long));
+            distinct = Merge(sh->sr, e, count, slots, capacity);
+            qsort(e, distinct, sizeof(Entry), Compare_entries);
+        }
+        free(slots);
+    }
+    sh->merged[t->rank + 1] = distinct;
+
+    /* One thread sizes y */
+    if (pthread_barrier_wait(&sh->barrier) == PTHREAD_BARRIER_SERIAL_THREAD) {
+        sh->merged[0] = 0;
+        for (b = 0; b < p; b++) sh->merged[b + 1] += sh->merged[b];
+        if (!sh->failed && Spvec_alloc(sh->y, A->rows, sh->merged[p]) != 0) sh->failed = 1;
+    }
+    pthread_barrier_wait(&sh->barrier);
+
+    /* Copy this bucket into place */
+    if (!sh->failed) {
+        e = sh->entries + sh->bucket[t->rank];
+        pos = sh->merged[t->rank];
+        for (k = 0; k < distinct; k++) {
+            sh->y->idx[pos + k] = e[k].idx;
+            sh->y->val[pos + k] = e[k].val;
+        }
+    }
+    return NULL;
+}
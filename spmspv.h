@@ -0,0 +1,38 @@
+/**
+ * @file spmspv.h
+ * @author Mason Dizick (mpdizick@coastal.edu)
+ * @brief Sparse matrix times sparse vector over a semiring.
+ *
+ * y = A * x for a CSC matrix A and a sparse x visits only the columns
+ * of A at x's nonzeros, so the work is proportional to the entries in
+ * those columns (the "frontier" of a graph search), not to the rows of
+ * A. The nonzeros of x are divided among the threads by the number of
+ * entries in their columns. Each thread scatters its products into
+ * buckets, one per thread, that cover blocks of rows (Quinn's macros);
+ * the buckets are sized by a counting pass so they are written without
+ * locks. Each thread then merges one bucket with a hash accumulator
+ * sized to the bucket, sorts it, and the buckets are concatenated in
+ * row order into y.
+ *
+ * @version 1.0
+ * @date 2026-02-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+*/
+
+#ifndef _SPMSPV_H_
+#define _SPMSPV_H_
+
+#include "sparse.h"
+
+/* Spmspv: y = A * x over semiring sr (semiring.h)
+ * mask:  NULL, or A->rows flags; rows with a nonzero flag are left out
+ *        of y (e.g. vertices a search has already visited)
+ * y:     newly allocated; rows that receive no product are not stored
+ * Returns: 0 on success, -1 on allocation failure
+*/
+int Spmspv(int sr, const Csc* A, const Spvec* x, const char* mask, int thread_count,
+           Spvec* y);
+
+#endif /* _SPMSPV_H_ */